@@ -0,0 +1,134 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/*=========================================================================
+Calculate DRR from a CT dataset with the distance-driven method, which maps
+the boundaries of the voxels and of the detector pixels onto a common axis
+and integrates their overlaps slice by slice.
+
+-------------------------------------------------------------------------
+References:
+
+B. De Man and S. Basu, "Distance-driven projection and backprojection in
+three dimensions," Physics in Medicine and Biology 49, 2463-2475 (2004).
+
+=========================================================================*/
+#ifndef itkDistanceDrivenProjectionImageFilter_h
+#define itkDistanceDrivenProjectionImageFilter_h
+
+#include "itkProjectionImageFilter.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class DistanceDrivenProjectionImageFilter
+ * \brief Compute a DRR with the distance-driven projector.
+ *
+ * The volume is cut into slices perpendicular to the axis that is closest
+ * to the central ray. For each slice, the boundaries of every detector
+ * pixel are projected from the source onto the central plane of the slice,
+ * and the overlap of the resulting footprint with the voxels of the slice
+ * is integrated exactly with a summed-area table. The contribution of the
+ * slice is weighted by the length of the ray across it, which gives the
+ * same scale as SiddonJacobsRayCastInterpolateImageFunction.
+ *
+ * Contrary to the ray casters, the volume is traversed slice by slice in
+ * memory order and each slice is reduced to a table that stays in cache
+ * while all the detector pixels are accumulated, so the cost does not
+ * depend on the access pattern of the rays. The slices are spread over the
+ * work units of the filter, each one accumulating into its own copy of the
+ * detector which are summed at the end.
+ *
+ * The thresholded volume is reordered into slices once and kept until the
+ * input, the Threshold or the slicing axis changes, so repeated projections
+ * of the same volume (e.g. during a registration) only pay for the
+ * projection itself. The memory used is the size of the volume in float.
+ *
+ * The footprint of a pixel is approximated by an axis-aligned rectangle in
+ * each slice, so the projection is slightly smoother than the exact
+ * radiological path computed by the Siddon-Jacobs ray caster.
+ *
+ * \sa SiddonJacobsRayCastInterpolateImageFunction
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage>
+class DistanceDrivenProjectionImageFilter : public ProjectionImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(DistanceDrivenProjectionImageFilter);
+
+  /** Standard class type alias. */
+  using Self = DistanceDrivenProjectionImageFilter;
+  using Superclass = ProjectionImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(DistanceDrivenProjectionImageFilter, ProjectionImageFilter);
+
+  using InputImageType = typename Superclass::InputImageType;
+  using InputPixelType = typename Superclass::InputPixelType;
+  using OutputImageType = typename Superclass::OutputImageType;
+  using OutputPixelType = typename Superclass::OutputPixelType;
+  using TransformType = typename Superclass::TransformType;
+  using PointType = typename Superclass::PointType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = Superclass::ImageDimension;
+
+protected:
+  DistanceDrivenProjectionImageFilter() = default;
+  ~DistanceDrivenProjectionImageFilter() override = default;
+
+  void
+  GenerateData() override;
+
+private:
+  /** Footprint of a detector pixel, as the slopes of its boundaries with
+   * respect to the slicing axis, and length of its central ray per slice. */
+  struct Footprint
+  {
+    double MinSlopeB;
+    double MaxSlopeB;
+    double MinSlopeC;
+    double MaxSlopeC;
+    double Weight;
+  };
+
+  /** Reorder the thresholded volume into slices perpendicular to axis. */
+  void
+  BuildSlices(unsigned int axis);
+
+  std::vector<float>     m_Slices;
+  unsigned int           m_SliceAxis{ 0 };
+  double                 m_SliceThreshold{ 0.0 };
+  const InputImageType * m_SlicedInput{ nullptr };
+  TimeStamp              m_SlicesTime;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkDistanceDrivenProjectionImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,307 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkDistanceDrivenProjectionImageFilter_hxx
+#define itkDistanceDrivenProjectionImageFilter_hxx
+
+#include "itkDistanceDrivenProjectionImageFilter.h"
+
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreaderBase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceDrivenProjectionImageFilter<TInputImage, TOutputImage>::BuildSlices(unsigned int axis)
+{
+  const InputImageType *                  inputPtr = this->GetInput();
+  const typename InputImageType::SizeType size = inputPtr->GetBufferedRegion().GetSize();
+  const InputPixelType *                  buffer = inputPtr->GetBufferPointer();
+  const double                            threshold = this->GetThreshold();
+  const unsigned int                      b = (axis + 1) % 3;
+  const unsigned int                      c = (axis + 2) % 3;
+  const SizeValueType                     sliceSize = size[b] * size[c];
+
+  m_Slices.resize(size[0] * size[1] * size[2]);
+  float * slices = m_Slices.data();
+
+  // The input is read in memory order, one z plane per work item.
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    size[2],
+    [&](SizeValueType z) {
+      SizeValueType index[3];
+      index[2] = z;
+      const InputPixelType * voxel = buffer + z * size[0] * size[1];
+      for (index[1] = 0; index[1] < size[1]; ++index[1])
+      {
+        for (index[0] = 0; index[0] < size[0]; ++index[0], ++voxel)
+        {
+          const double value = static_cast<double>(*voxel) - threshold;
+          slices[index[axis] * sliceSize + index[c] * size[b] + index[b]] =
+            static_cast<float>(std::max(value, 0.0));
+        }
+      }
+    },
+    nullptr);
+
+  m_SliceAxis = axis;
+  m_SliceThreshold = threshold;
+  m_SlicedInput = inputPtr;
+  m_SlicesTime.Modified();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceDrivenProjectionImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  this->AllocateOutputs();
+  this->UpdateProjectionGeometry();
+
+  const InputImageType * inputPtr = this->GetInput();
+  OutputImageType *      outputPtr = this->GetOutput();
+  const TransformType *  inverseTransform = this->GetInverseTransform();
+  const PointType &      sourceWorld = this->GetSourceWorld();
+
+  const typename InputImageType::SpacingType ctPixelSpacing = inputPtr->GetSpacing();
+  const typename InputImageType::SizeType    sizeCT = inputPtr->GetBufferedRegion().GetSize();
+
+  const typename OutputImageType::RegionType outputRegion = outputPtr->GetRequestedRegion();
+  const typename OutputImageType::IndexType  outputStart = outputRegion.GetIndex();
+  const SizeValueType                        sizeU = outputRegion.GetSize()[0];
+  const SizeValueType                        sizeV = outputRegion.GetSize()[1];
+  const SizeValueType                        numberOfPixels = sizeU * sizeV;
+
+  // Position of the source and of the detector pixels in continuous index
+  // units of the volume, with voxel i spanning [i, i+1). The detector is
+  // planar, so the rays are an affine function of the pixel index.
+  double sourceIndex[3];
+  double firstRay[3];
+  double stepU[3];
+  double stepV[3];
+  {
+    typename OutputImageType::PointType     p00, p10, p01;
+    ContinuousIndex<double, ImageDimension> index;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      index[i] = outputStart[i];
+    }
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p00);
+    index[0] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p10);
+    index[0] -= 1.0;
+    index[1] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p01);
+
+    const PointType w00 = inverseTransform->TransformPoint(p00);
+    const PointType w10 = inverseTransform->TransformPoint(p10);
+    const PointType w01 = inverseTransform->TransformPoint(p01);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      sourceIndex[i] = sourceWorld[i] / ctPixelSpacing[i];
+      firstRay[i] = (w00[i] - sourceWorld[i]) / ctPixelSpacing[i];
+      stepU[i] = (w10[i] - w00[i]) / ctPixelSpacing[i];
+      stepV[i] = (w01[i] - w00[i]) / ctPixelSpacing[i];
+    }
+  }
+
+  // The volume is sliced perpendicular to the axis closest to the central ray.
+  double centralRay[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    centralRay[i] = firstRay[i] + 0.5 * (sizeU - 1.0) * stepU[i] + 0.5 * (sizeV - 1.0) * stepV[i];
+  }
+  unsigned int a = 0;
+  if (std::fabs(centralRay[1]) > std::fabs(centralRay[a]))
+  {
+    a = 1;
+  }
+  if (std::fabs(centralRay[2]) > std::fabs(centralRay[a]))
+  {
+    a = 2;
+  }
+  const unsigned int b = (a + 1) % 3;
+  const unsigned int c = (a + 2) % 3;
+
+  if (m_Slices.empty() || m_SliceAxis != a || m_SliceThreshold != this->GetThreshold() || m_SlicedInput != inputPtr ||
+      m_SlicesTime.GetMTime() < inputPtr->GetMTime())
+  {
+    this->BuildSlices(a);
+  }
+
+  // The footprint of a pixel on a slice is the bounding rectangle of the
+  // projections of the midpoints of its four edges.
+  std::vector<Footprint> footprints(numberOfPixels);
+  for (SizeValueType v = 0; v < sizeV; ++v)
+  {
+    for (SizeValueType u = 0; u < sizeU; ++u)
+    {
+      double center[3];
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        center[i] = firstRay[i] + u * stepU[i] + v * stepV[i];
+      }
+
+      Footprint & footprint = footprints[v * sizeU + u];
+      footprint.MinSlopeB = footprint.MinSlopeC = NumericTraits<double>::max();
+      footprint.MaxSlopeB = footprint.MaxSlopeC = NumericTraits<double>::NonpositiveMin();
+      footprint.Weight = 0.0;
+
+      const double offsets[4][2] = { { -0.5, 0.0 }, { 0.5, 0.0 }, { 0.0, -0.5 }, { 0.0, 0.5 } };
+      bool         parallel = false;
+      for (unsigned int k = 0; k < 4; ++k)
+      {
+        double edge[3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          edge[i] = center[i] + offsets[k][0] * stepU[i] + offsets[k][1] * stepV[i];
+        }
+        if (edge[a] == 0)
+        {
+          parallel = true;
+          break;
+        }
+        const double slopeB = edge[b] / edge[a];
+        const double slopeC = edge[c] / edge[a];
+        footprint.MinSlopeB = std::min(footprint.MinSlopeB, slopeB);
+        footprint.MaxSlopeB = std::max(footprint.MaxSlopeB, slopeB);
+        footprint.MinSlopeC = std::min(footprint.MinSlopeC, slopeC);
+        footprint.MaxSlopeC = std::max(footprint.MaxSlopeC, slopeC);
+      }
+      if (!parallel && center[a] != 0)
+      {
+        // Each slice accounts for a step of 1/|ray[a]| of the ray parameter,
+        // as the voxel intersection lengths do in the Siddon-Jacobs traversal.
+        footprint.Weight = 1.0 / std::fabs(center[a]);
+      }
+    }
+  }
+
+  const IndexValueType sizeA = static_cast<IndexValueType>(sizeCT[a]);
+  const IndexValueType sizeB = static_cast<IndexValueType>(sizeCT[b]);
+  const IndexValueType sizeC = static_cast<IndexValueType>(sizeCT[c]);
+  const SizeValueType  sliceSize = sizeB * sizeC;
+  const SizeValueType  tableWidth = sizeB + 1;
+  const float *        slices = m_Slices.data();
+
+  // Each work unit projects a contiguous range of slices into its own detector.
+  const SizeValueType numberOfChunks =
+    std::max<SizeValueType>(1, std::min<SizeValueType>(this->GetNumberOfWorkUnits(), sizeA));
+  std::vector<std::vector<double>> detectors(numberOfChunks);
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    numberOfChunks,
+    [&](SizeValueType chunk) {
+      std::vector<double> & detector = detectors[chunk];
+      detector.assign(numberOfPixels, 0.0);
+
+      // Summed-area table of the current slice: table[q * tableWidth + p] is
+      // the integral of the slice over [0, p) x [0, q).
+      std::vector<double> table(tableWidth * (sizeC + 1), 0.0);
+      double *            sat = table.data();
+
+      // Integral of the slice over [0, x) x [0, y). It is bilinear within
+      // each voxel because the slice is constant there.
+      auto integral = [=](double x, double y) -> double {
+        const IndexValueType p = std::min(static_cast<IndexValueType>(x), sizeB - 1);
+        const IndexValueType q = std::min(static_cast<IndexValueType>(y), sizeC - 1);
+        const double         s = x - p;
+        const double         t = y - q;
+        const double *       row = sat + q * tableWidth + p;
+        const double         f00 = row[0];
+        const double         f10 = row[1];
+        const double         f01 = row[tableWidth];
+        const double         f11 = row[tableWidth + 1];
+        return f00 + s * (f10 - f00) + t * (f01 - f00) + s * t * (f11 - f10 - f01 + f00);
+      };
+
+      const IndexValueType firstSlice = static_cast<IndexValueType>(chunk * sizeA / numberOfChunks);
+      const IndexValueType lastSlice = static_cast<IndexValueType>((chunk + 1) * sizeA / numberOfChunks);
+      for (IndexValueType k = firstSlice; k < lastSlice; ++k)
+      {
+        const float * slice = slices + k * sliceSize;
+        for (IndexValueType q = 0; q < sizeC; ++q)
+        {
+          double         rowSum = 0.0;
+          const double * previous = sat + q * tableWidth;
+          double *       current = sat + (q + 1) * tableWidth;
+          for (IndexValueType p = 0; p < sizeB; ++p)
+          {
+            rowSum += slice[q * sizeB + p];
+            current[p + 1] = previous[p + 1] + rowSum;
+          }
+        }
+        if (sat[tableWidth * (sizeC + 1) - 1] == 0.0)
+        {
+          // Nothing above the threshold in this slice
+          continue;
+        }
+
+        // Distance from the source to the central plane of the slice
+        const double depth = k + 0.5 - sourceIndex[a];
+        const bool   forward = depth > 0;
+        for (SizeValueType pixel = 0; pixel < numberOfPixels; ++pixel)
+        {
+          const Footprint & footprint = footprints[pixel];
+          const double      b0 = sourceIndex[b] + depth * (forward ? footprint.MinSlopeB : footprint.MaxSlopeB);
+          const double      b1 = sourceIndex[b] + depth * (forward ? footprint.MaxSlopeB : footprint.MinSlopeB);
+          const double      c0 = sourceIndex[c] + depth * (forward ? footprint.MinSlopeC : footprint.MaxSlopeC);
+          const double      c1 = sourceIndex[c] + depth * (forward ? footprint.MaxSlopeC : footprint.MinSlopeC);
+
+          const double area = (b1 - b0) * (c1 - c0);
+          if (!(area > 0.0) || b1 <= 0.0 || c1 <= 0.0 || b0 >= sizeB || c0 >= sizeC)
+          {
+            continue;
+          }
+          const double x0 = std::max(b0, 0.0);
+          const double x1 = std::min(b1, static_cast<double>(sizeB));
+          const double y0 = std::max(c0, 0.0);
+          const double y1 = std::min(c1, static_cast<double>(sizeC));
+
+          const double overlap = integral(x1, y1) - integral(x0, y1) - integral(x1, y0) + integral(x0, y0);
+          detector[pixel] += overlap / area * footprint.Weight;
+        }
+      }
+    },
+    nullptr);
+
+  // Sum the detectors of the work units into the output.
+  const double minOutputValue = NumericTraits<OutputPixelType>::NonpositiveMin();
+  const double maxOutputValue = NumericTraits<OutputPixelType>::max();
+
+  ImageRegionIterator<OutputImageType> it(outputPtr, outputRegion);
+  for (SizeValueType pixel = 0; !it.IsAtEnd(); ++it, ++pixel)
+  {
+    double d12 = 0.0;
+    for (SizeValueType chunk = 0; chunk < numberOfChunks; ++chunk)
+    {
+      d12 += detectors[chunk][pixel];
+    }
+    d12 = std::min(std::max(d12, minOutputValue), maxOutputValue);
+    it.Set(static_cast<OutputPixelType>(d12));
+  }
+}
+
+} // namespace itk
+
+#endif
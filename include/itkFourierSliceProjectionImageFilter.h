@@ -0,0 +1,144 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/*=========================================================================
+Calculate approximate DRR from a CT dataset with the projection-slice
+theorem: the 2D Fourier transform of a parallel projection is a central
+slice of the 3D Fourier transform of the volume.
+
+-------------------------------------------------------------------------
+References:
+
+T. Malzbender, "Fourier volume rendering," ACM Transactions on Graphics
+12, 233-250 (1993).
+
+=========================================================================*/
+#ifndef itkFourierSliceProjectionImageFilter_h
+#define itkFourierSliceProjectionImageFilter_h
+
+#include "itkProjectionImageFilter.h"
+#include <complex>
+#include <vector>
+
+namespace itk
+{
+
+/** \class FourierSliceProjectionImageFilter
+ * \brief Compute an approximate DRR from a central slice of the 3D spectrum of the volume.
+ *
+ * The 3D Fourier transform of the thresholded volume is computed once.
+ * For each pose, the spectrum is interpolated on the plane perpendicular
+ * to the central ray and the 2D inverse transform gives the parallel
+ * projection of the volume along the central ray, on a plane through the
+ * center of the volume. The detector pixels are then resampled from that
+ * projection: each ray is intersected with the plane, which accounts for
+ * the magnification of the cone beam, and the value is divided by the
+ * cosine of its angle with the central ray. The cost of a DRR is
+ * O(N^2 log N) for an N x N slice, independent of the depth of the volume.
+ *
+ * The projection is parallel, so the approximation is only valid for small
+ * cone angles, i.e. detectors small compared with the source distance. It
+ * is meant for the coarse stages of a registration.
+ *
+ * The volume is centred and zero padded by PaddingFactor before the
+ * transform, and divided by the apodization of the trilinear interpolation
+ * of the spectrum. The padding reduces the interpolation error at the cost
+ * of memory: the spectrum takes 8 bytes per voxel of the padded volume.
+ * The image sizes are rounded up to products of 2, 3 and 5.
+ *
+ * \sa SiddonJacobsRayCastInterpolateImageFunction
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage>
+class FourierSliceProjectionImageFilter : public ProjectionImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(FourierSliceProjectionImageFilter);
+
+  /** Standard class type alias. */
+  using Self = FourierSliceProjectionImageFilter;
+  using Superclass = ProjectionImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(FourierSliceProjectionImageFilter, ProjectionImageFilter);
+
+  using InputImageType = typename Superclass::InputImageType;
+  using InputPixelType = typename Superclass::InputPixelType;
+  using OutputImageType = typename Superclass::OutputImageType;
+  using OutputPixelType = typename Superclass::OutputPixelType;
+  using TransformType = typename Superclass::TransformType;
+  using PointType = typename Superclass::PointType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = Superclass::ImageDimension;
+
+  using ComplexType = std::complex<float>;
+  using SpectrumImageType = Image<ComplexType, 3>;
+  using SliceImageType = Image<ComplexType, 2>;
+
+  /** Set and get the ratio between the padded and the original size of the
+   * volume along each axis. */
+  itkSetClampMacro(PaddingFactor, double, 1.0, NumericTraits<double>::max());
+  itkGetConstMacro(PaddingFactor, double);
+
+  /** Spectrum of the volume, valid after an update. */
+  itkGetConstObjectMacro(Spectrum, SpectrumImageType);
+
+protected:
+  FourierSliceProjectionImageFilter();
+  ~FourierSliceProjectionImageFilter() override = default;
+
+  void
+  GenerateData() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Compute the spectrum of the padded, pre-compensated volume. */
+  void
+  ComputeSpectrum();
+
+  /** Smallest size larger or equal to n whose prime factors are 2, 3 and 5 */
+  static SizeValueType
+  GetGoodFFTSize(SizeValueType n);
+
+  double m_PaddingFactor;
+
+  typename SpectrumImageType::Pointer m_Spectrum;
+
+  // Shift, in voxels, applied to centre the volume on the origin of the transform
+  IndexValueType         m_VolumeShift[3];
+  double                 m_SpectrumThreshold{ 0.0 };
+  double                 m_SpectrumPaddingFactor{ 0.0 };
+  const InputImageType * m_SpectrumInput{ nullptr };
+  TimeStamp              m_SpectrumTime;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkFourierSliceProjectionImageFilter.hxx"
+#endif
+
+#endif
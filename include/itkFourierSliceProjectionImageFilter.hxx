@@ -0,0 +1,410 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFourierSliceProjectionImageFilter_hxx
+#define itkFourierSliceProjectionImageFilter_hxx
+
+#include "itkFourierSliceProjectionImageFilter.h"
+
+#include "itkMultiThreaderBase.h"
+#include "itkVnlComplexToComplexFFTImageFilter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+FourierSliceProjectionImageFilter<TInputImage, TOutputImage>::FourierSliceProjectionImageFilter()
+{
+  m_PaddingFactor = 1.5;
+  std::fill(m_VolumeShift, m_VolumeShift + 3, 0);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+SizeValueType
+FourierSliceProjectionImageFilter<TInputImage, TOutputImage>::GetGoodFFTSize(SizeValueType n)
+{
+  for (SizeValueType candidate = std::max<SizeValueType>(n, 1);; ++candidate)
+  {
+    SizeValueType remainder = candidate;
+    for (SizeValueType factor : { 2, 3, 5 })
+    {
+      while (remainder % factor == 0)
+      {
+        remainder /= factor;
+      }
+    }
+    if (remainder == 1)
+    {
+      return candidate;
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+FourierSliceProjectionImageFilter<TInputImage, TOutputImage>::ComputeSpectrum()
+{
+  const InputImageType *                  inputPtr = this->GetInput();
+  const typename InputImageType::SizeType size = inputPtr->GetBufferedRegion().GetSize();
+  const InputPixelType *                  buffer = inputPtr->GetBufferPointer();
+  const double                            threshold = this->GetThreshold();
+
+  typename SpectrumImageType::SizeType paddedSize;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    paddedSize[i] = GetGoodFFTSize(static_cast<SizeValueType>(std::ceil(m_PaddingFactor * size[i])));
+    m_VolumeShift[i] = static_cast<IndexValueType>(size[i] / 2);
+  }
+
+  typename SpectrumImageType::RegionType region;
+  region.SetSize(paddedSize);
+  typename SpectrumImageType::Pointer padded = SpectrumImageType::New();
+  padded->SetRegions(region);
+  padded->Allocate(true);
+  ComplexType * paddedBuffer = padded->GetBufferPointer();
+
+  // Linear interpolation of the spectrum multiplies the volume by
+  // sinc^2(x / L) along each axis, x being the distance to the origin of the
+  // transform and L the padded length; the volume is divided by it first.
+  std::vector<double> apodization[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    apodization[i].resize(size[i]);
+    for (SizeValueType n = 0; n < size[i]; ++n)
+    {
+      const double x = (static_cast<double>(n) - m_VolumeShift[i]) / paddedSize[i];
+      const double sinc = (x == 0) ? 1.0 : std::sin(Math::pi * x) / (Math::pi * x);
+      apodization[i][n] = 1.0 / (sinc * sinc);
+    }
+  }
+
+  // The volume is centred on the origin: voxel n is stored at n - shift,
+  // modulo the padded size.
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    size[2],
+    [&](SizeValueType z) {
+      const SizeValueType pz = (z + paddedSize[2] - m_VolumeShift[2]) % paddedSize[2];
+      for (SizeValueType y = 0; y < size[1]; ++y)
+      {
+        const SizeValueType    py = (y + paddedSize[1] - m_VolumeShift[1]) % paddedSize[1];
+        const InputPixelType * voxel = buffer + (z * size[1] + y) * size[0];
+        ComplexType *          row = paddedBuffer + (pz * paddedSize[1] + py) * paddedSize[0];
+        const double           weight = apodization[2][z] * apodization[1][y];
+        for (SizeValueType x = 0; x < size[0]; ++x)
+        {
+          const double        value = std::max(static_cast<double>(voxel[x]) - threshold, 0.0);
+          const SizeValueType px = (x + paddedSize[0] - m_VolumeShift[0]) % paddedSize[0];
+          row[px] = ComplexType(static_cast<float>(value * weight * apodization[0][x]), 0.0f);
+        }
+      }
+    },
+    nullptr);
+
+  using FFTFilterType = VnlComplexToComplexFFTImageFilter<SpectrumImageType>;
+  typename FFTFilterType::Pointer fft = FFTFilterType::New();
+  fft->SetInput(padded);
+  fft->SetTransformDirection(FFTFilterType::FORWARD);
+  fft->Update();
+
+  m_Spectrum = fft->GetOutput();
+  m_Spectrum->DisconnectPipeline();
+
+  m_SpectrumThreshold = threshold;
+  m_SpectrumPaddingFactor = m_PaddingFactor;
+  m_SpectrumInput = inputPtr;
+  m_SpectrumTime.Modified();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+FourierSliceProjectionImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  this->AllocateOutputs();
+  this->UpdateProjectionGeometry();
+
+  const InputImageType * inputPtr = this->GetInput();
+  OutputImageType *      outputPtr = this->GetOutput();
+
+  if (!m_Spectrum || m_SpectrumInput != inputPtr || m_SpectrumThreshold != this->GetThreshold() ||
+      m_SpectrumPaddingFactor != m_PaddingFactor || m_SpectrumTime.GetMTime() < inputPtr->GetMTime())
+  {
+    this->ComputeSpectrum();
+  }
+
+  const TransformType * inverseTransform = this->GetInverseTransform();
+  const PointType &     sourceWorld = this->GetSourceWorld();
+
+  const typename InputImageType::SpacingType    ctPixelSpacing = inputPtr->GetSpacing();
+  const typename InputImageType::SizeType       sizeCT = inputPtr->GetBufferedRegion().GetSize();
+  const typename SpectrumImageType::SizeType    paddedSize = m_Spectrum->GetBufferedRegion().GetSize();
+  const typename OutputImageType::RegionType    outputRegion = outputPtr->GetRequestedRegion();
+  const typename OutputImageType::DirectionType detectorDirection = outputPtr->GetDirection();
+  const SizeValueType                           sizeU = outputRegion.GetSize()[0];
+  const SizeValueType                           sizeV = outputRegion.GetSize()[1];
+
+  // The detector pixels, as rays from the source in the volume
+  double firstRay[3];
+  double stepU[3];
+  double stepV[3];
+  double centralRay[3];
+  {
+    typename OutputImageType::PointType     p00, p10, p01;
+    ContinuousIndex<double, ImageDimension> index;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      index[i] = outputRegion.GetIndex()[i];
+    }
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p00);
+    index[0] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p10);
+    index[0] -= 1.0;
+    index[1] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p01);
+
+    const PointType w00 = inverseTransform->TransformPoint(p00);
+    const PointType w10 = inverseTransform->TransformPoint(p10);
+    const PointType w01 = inverseTransform->TransformPoint(p01);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      firstRay[i] = w00[i] - sourceWorld[i];
+      stepU[i] = w10[i] - w00[i];
+      stepV[i] = w01[i] - w00[i];
+      centralRay[i] = firstRay[i] + 0.5 * (sizeU - 1.0) * stepU[i] + 0.5 * (sizeV - 1.0) * stepV[i];
+    }
+  }
+
+  // Orthonormal frame of the parallel projection: d along the central ray,
+  // e1 and e2 along the detector axes.
+  Vector<double, 3> d, e1, e2;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    d[i] = centralRay[i];
+  }
+  d.Normalize();
+  {
+    typename TransformType::InputVectorType axisU;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      axisU[i] = detectorDirection[i][0];
+    }
+    const typename TransformType::OutputVectorType axisUWorld = inverseTransform->TransformVector(axisU);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      e1[i] = axisUWorld[i];
+    }
+  }
+  e1 -= (e1 * d) * d;
+  e1.Normalize();
+  e2 = CrossProduct(d, e1);
+
+  // The projection plane goes through the point of the central ray closest
+  // to the center of the volume.
+  Vector<double, 3> planeOrigin;
+  {
+    Vector<double, 3> center;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      center[i] = 0.5 * sizeCT[i] * ctPixelSpacing[i] - sourceWorld[i];
+    }
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      planeOrigin[i] = sourceWorld[i] + (center * d) * d[i];
+    }
+  }
+
+  // The 2D grid of the projection: period T large enough for the projected
+  // volume, samples no coarser than the voxels.
+  double period = 0.0;
+  double diagonal = 0.0;
+  double sampleSpacing = NumericTraits<double>::max();
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    period = std::max(period, paddedSize[i] * ctPixelSpacing[i]);
+    diagonal += (sizeCT[i] * ctPixelSpacing[i]) * (sizeCT[i] * ctPixelSpacing[i]);
+    sampleSpacing = std::min(sampleSpacing, ctPixelSpacing[i]);
+  }
+  period = std::max(period, std::sqrt(diagonal));
+  const SizeValueType sliceSize = GetGoodFFTSize(static_cast<SizeValueType>(std::ceil(period / sampleSpacing)));
+  sampleSpacing = period / sliceSize;
+
+  // Interpolate the central slice of the spectrum. The frequency m / T of
+  // the slice is k = (m1 e1 + m2 e2) / T in the volume, i.e. the continuous
+  // frequency index k_i * L_i of the spectrum. The phase moves the origin
+  // from the voxel at the origin of the transform to the projection plane.
+  typename SliceImageType::Pointer slice = SliceImageType::New();
+  {
+    typename SliceImageType::RegionType region;
+    typename SliceImageType::SizeType   size;
+    size.Fill(sliceSize);
+    region.SetSize(size);
+    slice->SetRegions(region);
+    slice->Allocate();
+  }
+  ComplexType *       sliceBuffer = slice->GetBufferPointer();
+  const ComplexType * spectrum = m_Spectrum->GetBufferPointer();
+
+  double length[3];
+  double voxelOrigin[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    length[i] = paddedSize[i] * ctPixelSpacing[i];
+    voxelOrigin[i] = (m_VolumeShift[i] + 0.5) * ctPixelSpacing[i];
+  }
+  const double voxelVolume = ctPixelSpacing[0] * ctPixelSpacing[1] * ctPixelSpacing[2];
+  const auto   halfSlice = static_cast<IndexValueType>(sliceSize / 2);
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    sliceSize,
+    [&](SizeValueType row) {
+      const IndexValueType m2 = static_cast<IndexValueType>(row) - halfSlice;
+      for (IndexValueType m1 = -halfSlice; m1 < static_cast<IndexValueType>(sliceSize) - halfSlice; ++m1)
+      {
+        double k[3];
+        double phase = 0.0;
+        double frequencyIndex[3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          k[i] = (m1 * e1[i] + m2 * e2[i]) / period;
+          frequencyIndex[i] = k[i] * length[i];
+          phase += k[i] * (planeOrigin[i] - voxelOrigin[i]);
+        }
+
+        // Trilinear interpolation in the periodic spectrum
+        IndexValueType base[3];
+        double         weight[3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          const double floorIndex = std::floor(frequencyIndex[i]);
+          weight[i] = frequencyIndex[i] - floorIndex;
+          const auto n = static_cast<IndexValueType>(paddedSize[i]);
+          base[i] = ((static_cast<IndexValueType>(floorIndex) % n) + n) % n;
+        }
+        std::complex<double> value(0.0, 0.0);
+        for (unsigned int corner = 0; corner < 8; ++corner)
+        {
+          double         w = 1.0;
+          IndexValueType index[3];
+          for (unsigned int i = 0; i < 3; ++i)
+          {
+            const bool upper = (corner >> i) & 1;
+            w *= upper ? weight[i] : 1.0 - weight[i];
+            index[i] = upper ? (base[i] + 1) % static_cast<IndexValueType>(paddedSize[i]) : base[i];
+          }
+          const ComplexType & sample = spectrum[(index[2] * paddedSize[1] + index[1]) * paddedSize[0] + index[0]];
+          value += w * std::complex<double>(sample.real(), sample.imag());
+        }
+        value *= voxelVolume * std::polar(1.0, 2.0 * Math::pi * phase);
+
+        const auto          n = static_cast<IndexValueType>(sliceSize);
+        const SizeValueType column = static_cast<SizeValueType>((m1 + n) % n);
+        const SizeValueType line = static_cast<SizeValueType>((m2 + n) % n);
+        sliceBuffer[line * sliceSize + column] =
+          ComplexType(static_cast<float>(value.real()), static_cast<float>(value.imag()));
+      }
+    },
+    nullptr);
+
+  // The inverse transform of the slice is the parallel projection; the FFT
+  // filter divides by the number of pixels, hence the 1 / h^2 scaling.
+  using FFTFilterType = VnlComplexToComplexFFTImageFilter<SliceImageType>;
+  typename FFTFilterType::Pointer ifft = FFTFilterType::New();
+  ifft->SetInput(slice);
+  ifft->SetTransformDirection(FFTFilterType::INVERSE);
+  ifft->Update();
+
+  const ComplexType * projectionBuffer = ifft->GetOutput()->GetBufferPointer();
+  const double        projectionScale = 1.0 / (sampleSpacing * sampleSpacing);
+
+  // Resample the detector from the projection.
+  const double minOutputValue = NumericTraits<OutputPixelType>::NonpositiveMin();
+  const double maxOutputValue = NumericTraits<OutputPixelType>::max();
+  const double planeDistance = (planeOrigin - sourceWorld.GetVectorFromOrigin()) * d;
+
+  OutputPixelType * output = outputPtr->GetBufferPointer();
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    sizeV,
+    [&](SizeValueType v) {
+      for (SizeValueType u = 0; u < sizeU; ++u)
+      {
+        Vector<double, 3> ray;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          ray[i] = firstRay[i] + u * stepU[i] + v * stepV[i];
+        }
+        const double cosine = ray * d;
+
+        double d12 = 0.0;
+        if (cosine > 0)
+        {
+          // Intersection of the ray with the projection plane, in samples
+          Vector<double, 3> position;
+          for (unsigned int i = 0; i < 3; ++i)
+          {
+            position[i] = sourceWorld[i] + planeDistance / cosine * ray[i] - planeOrigin[i];
+          }
+          const double   x = (position * e1) / sampleSpacing;
+          const double   y = (position * e2) / sampleSpacing;
+          const double   xFloor = std::floor(x);
+          const double   yFloor = std::floor(y);
+          const double   wx = x - xFloor;
+          const double   wy = y - yFloor;
+          const auto     n = static_cast<IndexValueType>(sliceSize);
+          IndexValueType x0 = ((static_cast<IndexValueType>(xFloor) % n) + n) % n;
+          IndexValueType y0 = ((static_cast<IndexValueType>(yFloor) % n) + n) % n;
+          IndexValueType x1 = (x0 + 1) % n;
+          IndexValueType y1 = (y0 + 1) % n;
+
+          const double p00 = projectionBuffer[y0 * n + x0].real();
+          const double p10 = projectionBuffer[y0 * n + x1].real();
+          const double p01 = projectionBuffer[y1 * n + x0].real();
+          const double p11 = projectionBuffer[y1 * n + x1].real();
+          const double p = (1.0 - wy) * ((1.0 - wx) * p00 + wx * p10) + wy * ((1.0 - wx) * p01 + wx * p11);
+
+          // The line integral along the ray is the parallel one divided by
+          // the cosine, and the Siddon-Jacobs scale divides it by |ray|.
+          d12 = p * projectionScale / cosine;
+        }
+        d12 = std::min(std::max(d12, minOutputValue), maxOutputValue);
+        output[v * sizeU + u] = static_cast<OutputPixelType>(d12);
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+FourierSliceProjectionImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "PaddingFactor: " << m_PaddingFactor << std::endl;
+  os << indent << "Spectrum: " << m_Spectrum.GetPointer() << std::endl;
+}
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,167 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkIncrementalProjectionImageFilter_h
+#define itkIncrementalProjectionImageFilter_h
+
+#include "itkProjectionImageFilter.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class IncrementalProjectionImageFilter
+ * \brief Update a DRR for small pose changes by warping the last exact projection.
+ *
+ * When the volume moves only slightly between two updates, as in tracking,
+ * this filter does not cast the rays again. The last DRR rendered with the
+ * exact Siddon-Jacobs ray caster is kept as a reference along with its
+ * pose, and the relative motion of the volume since then is applied as a
+ * 2D warp of that reference. The warp is the homography induced by the
+ * plane through the center of the volume parallel to the detector: it is
+ * exact for rotations about the central axis and accounts, to first
+ * order, for in-plane translations and the change of magnification due to
+ * translations along the central axis. The values are scaled by the ratio
+ * of the lengths of the rays, as in the Siddon-Jacobs ray caster.
+ *
+ * A new reference is rendered when the central axis rotated relative to
+ * the volume by more than MaximumOutOfPlaneRotation (radians), when the
+ * source moved relative to the volume by more than MaximumTranslation (mm)
+ * since the reference, or when the input, the Threshold or the projection
+ * geometry changed. Pixels mapped outside of the reference take the value
+ * of its nearest border pixel.
+ *
+ * Only out-of-plane rotations make the warp wrong in principle, but the
+ * translation limit is kept on purpose: translations are only accounted
+ * for at the center plane, and the parallax of the structures in front of
+ * and behind it grows with the displacement. Rotations about the central
+ * axis do not move the source and always reuse the reference. Set
+ * MaximumTranslation to a large value to render again on out-of-plane
+ * rotations only.
+ *
+ * \sa SiddonJacobsRayCastInterpolateImageFunction
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage>
+class IncrementalProjectionImageFilter : public ProjectionImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(IncrementalProjectionImageFilter);
+
+  /** Standard class type alias. */
+  using Self = IncrementalProjectionImageFilter;
+  using Superclass = ProjectionImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(IncrementalProjectionImageFilter, ProjectionImageFilter);
+
+  using InputImageType = typename Superclass::InputImageType;
+  using InputPixelType = typename Superclass::InputPixelType;
+  using OutputImageType = typename Superclass::OutputImageType;
+  using OutputPixelType = typename Superclass::OutputPixelType;
+  using TransformType = typename Superclass::TransformType;
+  using TransformPointer = typename Superclass::TransformPointer;
+  using PointType = typename Superclass::PointType;
+
+  /** Ray caster used to render the reference projections. */
+  using RayCasterType = SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = Superclass::ImageDimension;
+
+  /** Set and get the rotation of the central axis relative to the volume,
+   * in radians, above which the reference is rendered again. */
+  itkSetMacro(MaximumOutOfPlaneRotation, double);
+  itkGetConstMacro(MaximumOutOfPlaneRotation, double);
+
+  /** Set and get the displacement of the source relative to the volume, in
+   * mm, above which the reference is rendered again. */
+  itkSetMacro(MaximumTranslation, double);
+  itkGetConstMacro(MaximumTranslation, double);
+
+  /** Render a new reference on the next update. */
+  void
+  ResetReference();
+
+  /** Number of updates that rendered a new reference, and that warped it. */
+  itkGetConstMacro(NumberOfRenderings, SizeValueType);
+  itkGetConstMacro(NumberOfWarps, SizeValueType);
+
+protected:
+  IncrementalProjectionImageFilter();
+  ~IncrementalProjectionImageFilter() override = default;
+
+  void
+  GenerateData() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Settings the reference was rendered for, besides the pose. */
+  struct ReferenceKey
+  {
+    const InputImageType *                  Input{ nullptr };
+    double                                  Threshold{ 0.0 };
+    double                                  ProjectionAngle{ 0.0 };
+    double                                  FocalPointToIsocenterDistance{ 0.0 };
+    typename OutputImageType::RegionType    Region;
+    typename OutputImageType::SpacingType   Spacing;
+    typename OutputImageType::PointType     Origin;
+    typename OutputImageType::DirectionType Direction;
+  };
+
+  ReferenceKey
+  GetCurrentKey() const;
+
+  bool
+  IsReferenceValid() const;
+
+  /** Cast the rays of all the pixels into the reference and the output. */
+  void
+  RenderReference();
+
+  /** Warp the reference into the output for the relative motion delta,
+   * mapping the current projection geometry to the reference one. */
+  void
+  WarpReference(const TransformType * delta);
+
+  std::vector<float> m_Reference;
+  TransformPointer   m_ReferenceForwardTransform;
+  ReferenceKey       m_Key;
+  TimeStamp          m_ReferenceTime;
+
+  double        m_MaximumOutOfPlaneRotation;
+  double        m_MaximumTranslation;
+  SizeValueType m_NumberOfRenderings{ 0 };
+  SizeValueType m_NumberOfWarps{ 0 };
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkIncrementalProjectionImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,291 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkIncrementalProjectionImageFilter_hxx
+#define itkIncrementalProjectionImageFilter_hxx
+
+#include "itkIncrementalProjectionImageFilter.h"
+
+#include "itkMultiThreaderBase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+IncrementalProjectionImageFilter<TInputImage, TOutputImage>::IncrementalProjectionImageFilter()
+{
+  m_MaximumOutOfPlaneRotation = 0.5 * Math::pi / 180.0;
+  m_MaximumTranslation = 2.0;
+
+  m_ReferenceForwardTransform = TransformType::New();
+  m_ReferenceForwardTransform->SetComputeZYX(true);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+IncrementalProjectionImageFilter<TInputImage, TOutputImage>::ResetReference()
+{
+  m_Reference.clear();
+  this->Modified();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+typename IncrementalProjectionImageFilter<TInputImage, TOutputImage>::ReferenceKey
+IncrementalProjectionImageFilter<TInputImage, TOutputImage>::GetCurrentKey() const
+{
+  const OutputImageType * outputPtr = this->GetOutput();
+
+  ReferenceKey key;
+  key.Input = this->GetInput();
+  key.Threshold = this->GetThreshold();
+  key.ProjectionAngle = this->GetProjectionAngle();
+  key.FocalPointToIsocenterDistance = this->GetFocalPointToIsocenterDistance();
+  key.Region = outputPtr->GetRequestedRegion();
+  key.Spacing = outputPtr->GetSpacing();
+  key.Origin = outputPtr->GetOrigin();
+  key.Direction = outputPtr->GetDirection();
+  return key;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+bool
+IncrementalProjectionImageFilter<TInputImage, TOutputImage>::IsReferenceValid() const
+{
+  const ReferenceKey key = this->GetCurrentKey();
+  return !m_Reference.empty() && key.Input == m_Key.Input && m_ReferenceTime.GetMTime() >= key.Input->GetMTime() &&
+         key.Threshold == m_Key.Threshold && key.ProjectionAngle == m_Key.ProjectionAngle &&
+         key.FocalPointToIsocenterDistance == m_Key.FocalPointToIsocenterDistance && key.Region == m_Key.Region &&
+         key.Spacing == m_Key.Spacing && key.Origin == m_Key.Origin && key.Direction == m_Key.Direction;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+IncrementalProjectionImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  this->AllocateOutputs();
+  this->UpdateProjectionGeometry();
+
+  if (this->IsReferenceValid())
+  {
+    // Relative motion since the reference: the current projection geometry
+    // is mapped into the volume, then into the reference geometry.
+    TransformPointer delta = TransformType::New();
+    delta->SetComputeZYX(true);
+    delta->SetIdentity();
+    delta->Compose(this->GetInverseTransform(), false);
+    delta->Compose(m_ReferenceForwardTransform, false);
+
+    // Rotation of the central axis and displacement of the source
+    const double outOfPlaneRotation = std::acos(std::min(std::max(delta->GetMatrix()[2][2], -1.0), 1.0));
+    const double translation = delta->GetOffset().GetNorm();
+
+    if (outOfPlaneRotation <= m_MaximumOutOfPlaneRotation && translation <= m_MaximumTranslation)
+    {
+      this->WarpReference(delta);
+      ++m_NumberOfWarps;
+      return;
+    }
+  }
+
+  this->RenderReference();
+  ++m_NumberOfRenderings;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+IncrementalProjectionImageFilter<TInputImage, TOutputImage>::RenderReference()
+{
+  const InputImageType * inputPtr = this->GetInput();
+  OutputImageType *      outputPtr = this->GetOutput();
+  const TransformType *  inverseTransform = this->GetInverseTransform();
+  const PointType &      sourceWorld = this->GetSourceWorld();
+
+  typename RayCasterType::Pointer rayCaster = RayCasterType::New();
+  rayCaster->SetInputImage(inputPtr);
+  rayCaster->SetThreshold(this->GetThreshold());
+
+  const typename OutputImageType::RegionType outputRegion = outputPtr->GetRequestedRegion();
+  const SizeValueType                        sizeU = outputRegion.GetSize()[0];
+  const SizeValueType                        sizeV = outputRegion.GetSize()[1];
+
+  const double minOutputValue = NumericTraits<OutputPixelType>::NonpositiveMin();
+  const double maxOutputValue = NumericTraits<OutputPixelType>::max();
+
+  m_Reference.resize(sizeU * sizeV);
+  OutputPixelType * output = outputPtr->GetBufferPointer();
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    sizeV,
+    [&](SizeValueType v) {
+      typename OutputImageType::IndexType index = outputRegion.GetIndex();
+      index[1] += v;
+      for (SizeValueType u = 0; u < sizeU; ++u)
+      {
+        typename OutputImageType::PointType point;
+        outputPtr->TransformIndexToPhysicalPoint(index, point);
+        ++index[0];
+
+        const PointType                          pixelWorld = inverseTransform->TransformPoint(point);
+        const typename RayCasterType::VectorType ray = pixelWorld - sourceWorld;
+
+        double d12 = rayCaster->EvaluateRay(sourceWorld, ray);
+        d12 = std::min(std::max(d12, minOutputValue), maxOutputValue);
+        m_Reference[v * sizeU + u] = static_cast<float>(d12);
+        output[v * sizeU + u] = static_cast<OutputPixelType>(d12);
+      }
+    },
+    nullptr);
+
+  inverseTransform->GetInverse(m_ReferenceForwardTransform);
+  m_Key = this->GetCurrentKey();
+  m_ReferenceTime.Modified();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+IncrementalProjectionImageFilter<TInputImage, TOutputImage>::WarpReference(const TransformType * delta)
+{
+  const InputImageType * inputPtr = this->GetInput();
+  OutputImageType *      outputPtr = this->GetOutput();
+
+  const typename OutputImageType::RegionType outputRegion = outputPtr->GetRequestedRegion();
+  const SizeValueType                        sizeU = outputRegion.GetSize()[0];
+  const SizeValueType                        sizeV = outputRegion.GetSize()[1];
+
+  // Detector plane in the projection geometry, with the source at the origin
+  using VectorType = Vector<double, 3>;
+  VectorType firstPixel, stepU, stepV;
+  {
+    typename OutputImageType::PointType     p00, p10, p01;
+    ContinuousIndex<double, ImageDimension> index;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      index[i] = outputRegion.GetIndex()[i];
+    }
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p00);
+    index[0] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p10);
+    index[0] -= 1.0;
+    index[1] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p01);
+
+    firstPixel = p00.GetVectorFromOrigin();
+    stepU = p10 - p00;
+    stepV = p01 - p00;
+  }
+  const VectorType normal = CrossProduct(stepU, stepV);
+  const double     planeOffset = normal * firstPixel;
+  const double     inverseStepU = 1.0 / stepU.GetSquaredNorm();
+  const double     inverseStepV = 1.0 / stepV.GetSquaredNorm();
+
+  // Depth of the plane through the center of the volume, parallel to the
+  // detector, in the current projection geometry.
+  double depth;
+  {
+    TransformPointer forwardTransform = TransformType::New();
+    this->GetInverseTransform()->GetInverse(forwardTransform);
+
+    const typename InputImageType::SpacingType ctPixelSpacing = inputPtr->GetSpacing();
+    const typename InputImageType::SizeType    sizeCT = inputPtr->GetBufferedRegion().GetSize();
+    PointType                                  center;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      center[i] = 0.5 * sizeCT[i] * ctPixelSpacing[i];
+    }
+    depth = forwardTransform->TransformPoint(center)[2];
+  }
+
+  const typename TransformType::MatrixType       rotation = delta->GetMatrix();
+  const typename TransformType::OutputVectorType offset = delta->GetOffset();
+
+  const double  minOutputValue = NumericTraits<OutputPixelType>::NonpositiveMin();
+  const double  maxOutputValue = NumericTraits<OutputPixelType>::max();
+  const float * reference = m_Reference.data();
+
+  OutputPixelType * output = outputPtr->GetBufferPointer();
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    sizeV,
+    [&](SizeValueType v) {
+      for (SizeValueType u = 0; u < sizeU; ++u)
+      {
+        const VectorType pixel = firstPixel + stepU * static_cast<double>(u) + stepV * static_cast<double>(v);
+
+        // Point of the ray on the central plane of the volume, moved into
+        // the reference geometry, and projected onto the detector
+        const VectorType plane = pixel * (depth / pixel[2]);
+        const VectorType moved = rotation * plane + offset;
+        const double     denominator = normal * moved;
+
+        double d12 = 0.0;
+        if (denominator != 0)
+        {
+          const VectorType referencePixel = moved * (planeOffset / denominator);
+          const VectorType relative = referencePixel - firstPixel;
+
+          // Bilinear interpolation in the reference, clamped to its border
+          const double x = std::min(std::max((relative * stepU) * inverseStepU, 0.0), sizeU - 1.0);
+          const double y = std::min(std::max((relative * stepV) * inverseStepV, 0.0), sizeV - 1.0);
+          const auto   x0 = static_cast<SizeValueType>(x);
+          const auto   y0 = static_cast<SizeValueType>(y);
+          const auto   x1 = std::min(x0 + 1, sizeU - 1);
+          const auto   y1 = std::min(y0 + 1, sizeV - 1);
+          const double wx = x - x0;
+          const double wy = y - y0;
+
+          const float * row0 = reference + y0 * sizeU;
+          const float * row1 = reference + y1 * sizeU;
+          const double  value =
+            (1.0 - wy) * ((1.0 - wx) * row0[x0] + wx * row0[x1]) + wy * ((1.0 - wx) * row1[x0] + wx * row1[x1]);
+
+          // The Siddon-Jacobs ray caster divides the line integral by the
+          // length of the ray vector.
+          d12 = value * referencePixel.GetNorm() / pixel.GetNorm();
+        }
+        d12 = std::min(std::max(d12, minOutputValue), maxOutputValue);
+        output[v * sizeU + u] = static_cast<OutputPixelType>(d12);
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+IncrementalProjectionImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "MaximumOutOfPlaneRotation: " << m_MaximumOutOfPlaneRotation << std::endl;
+  os << indent << "MaximumTranslation: " << m_MaximumTranslation << std::endl;
+  os << indent << "NumberOfRenderings: " << m_NumberOfRenderings << std::endl;
+  os << indent << "NumberOfWarps: " << m_NumberOfWarps << std::endl;
+}
+
+} // namespace itk
+
+#endif
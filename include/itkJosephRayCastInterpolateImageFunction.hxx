@@ -0,0 +1,259 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkJosephRayCastInterpolateImageFunction_hxx
+#define itkJosephRayCastInterpolateImageFunction_hxx
+
+#include "itkJosephRayCastInterpolateImageFunction.h"
+
+#include "itkMath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TCoordRep>
+typename JosephRayCastInterpolateImageFunction<TInputImage, TCoordRep>::OutputType
+JosephRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(const PointType & point) const
+{
+  RayCastParameters parameters;
+  this->InitializeRayCastParameters(parameters);
+
+  // Coordinate of a DRR pixel in the world coordinate system
+  const PointType drrPixelWorld = this->m_InverseTransform->TransformPoint(point);
+
+  double rayVector[3];
+  rayVector[0] = drrPixelWorld[0] - parameters.SourceWorld[0];
+  rayVector[1] = drrPixelWorld[1] - parameters.SourceWorld[1];
+  rayVector[2] = drrPixelWorld[2] - parameters.SourceWorld[2];
+
+  return this->CastRay(parameters, rayVector);
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+void
+JosephRayCastInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateScanline(const PointType &  firstPoint,
+                                                                                const VectorType & pointStep,
+                                                                                SizeValueType      length,
+                                                                                OutputType *       values) const
+{
+  RayCastParameters parameters;
+  this->InitializeRayCastParameters(parameters);
+
+  // The inverse transform is affine, so the world-space rays of a scanline
+  // differ from the first one by a multiple of the transformed pixel step.
+  const PointType firstPixelWorld = this->m_InverseTransform->TransformPoint(firstPoint);
+  const typename TransformType::OutputVectorType stepWorld =
+    this->m_InverseTransform->TransformVector(pointStep);
+
+  double rayVector[3];
+  for (SizeValueType k = 0; k < length; ++k)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      rayVector[i] = firstPixelWorld[i] - parameters.SourceWorld[i] + k * stepWorld[i];
+    }
+    values[k] = this->CastRay(parameters, rayVector);
+  }
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+void
+JosephRayCastInterpolateImageFunction<TInputImage, TCoordRep>::InitializeRayCastParameters(
+  RayCastParameters & parameters) const
+{
+  if (this->GetBrickedVolume())
+  {
+    itkExceptionMacro(<< "Bricked volumes are not supported; use SiddonJacobsRayCastInterpolateImageFunction");
+  }
+
+  const PointType sourceWorld = this->UpdateProjectionGeometry();
+
+  const InputImageType * inputPtr = this->GetInputImage();
+
+  const typename InputImageType::SpacingType ctPixelSpacing = inputPtr->GetSpacing();
+  const typename InputImageType::SizeType    sizeCT = inputPtr->GetLargestPossibleRegion().GetSize();
+  const OffsetValueType *                    offsetTable = inputPtr->GetOffsetTable();
+
+  parameters.Buffer = inputPtr->GetBufferPointer();
+  parameters.Threshold = this->m_Threshold;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    parameters.Stride[i] = offsetTable[i];
+    parameters.Size[i] = static_cast<IndexValueType>(sizeCT[i]);
+    parameters.SourceWorld[i] = sourceWorld[i];
+    parameters.InverseSpacing[i] = 1.0 / ctPixelSpacing[i];
+    parameters.SourceIndex[i] = sourceWorld[i] * parameters.InverseSpacing[i];
+  }
+
+  parameters.Context = this->GetValidVolumeContext();
+  parameters.Attenuation = parameters.Context ? parameters.Context->GetAttenuationBuffer() : nullptr;
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+typename JosephRayCastInterpolateImageFunction<TInputImage, TCoordRep>::OutputType
+JosephRayCastInterpolateImageFunction<TInputImage, TCoordRep>::CastRay(const RayCastParameters & parameters,
+                                                                       const double rayVector[3]) const
+{
+  // Min/max values of the output pixel type AND these values
+  // represented as the output type of the interpolator
+  const OutputType minOutputValue = itk::NumericTraits<OutputType>::NonpositiveMin();
+  const OutputType maxOutputValue = itk::NumericTraits<OutputType>::max();
+
+  // The voxels outside of the bounding box are below the threshold, and
+  // the interpolation reaches one voxel away from the ray.
+  if (parameters.Context && !parameters.Context->RayIntersectsBoundingBox(parameters.SourceWorld, rayVector, 1.0))
+  {
+    return NumericTraits<OutputType>::ZeroValue();
+  }
+
+  // Ray direction in continuous index units
+  double ray[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    ray[i] = rayVector[i] * parameters.InverseSpacing[i];
+  }
+
+  // The ray is sampled once per slice perpendicular to its dominant axis a.
+  unsigned int a = 0;
+  if (std::fabs(ray[1]) > std::fabs(ray[a]))
+  {
+    a = 1;
+  }
+  if (std::fabs(ray[2]) > std::fabs(ray[a]))
+  {
+    a = 2;
+  }
+  if (ray[a] == 0)
+  {
+    return NumericTraits<OutputType>::ZeroValue();
+  }
+  const unsigned int b = (a + 1) % 3;
+  const unsigned int c = (a + 2) % 3;
+
+  const double inverseRay = 1.0 / ray[a];
+  const double slopeB = ray[b] * inverseRay;
+  const double slopeC = ray[c] * inverseRay;
+
+  // The ray crosses the central plane of slice i (at i + 0.5 along a) at
+  // the voxel-centred continuous index (u0 + i * slopeB, v0 + i * slopeC).
+  const double centerOffset = 0.5 - parameters.SourceIndex[a];
+  const double u0 = parameters.SourceIndex[b] + centerOffset * slopeB - 0.5;
+  const double v0 = parameters.SourceIndex[c] + centerOffset * slopeC - 0.5;
+
+  // Restrict the slices to those where at least one of the four
+  // interpolation neighbours lies inside the volume.
+  double firstSlice = 0.0;
+  double lastSlice = parameters.Size[a] - 1.0;
+
+  const double start[2] = { u0, v0 };
+  const double slope[2] = { slopeB, slopeC };
+  const double extent[2] = { static_cast<double>(parameters.Size[b]), static_cast<double>(parameters.Size[c]) };
+  for (unsigned int j = 0; j < 2; ++j)
+  {
+    if (slope[j] == 0)
+    {
+      if (start[j] <= -1.0 || start[j] >= extent[j])
+      {
+        return NumericTraits<OutputType>::ZeroValue();
+      }
+      continue;
+    }
+    double enter = (-1.0 - start[j]) / slope[j];
+    double leave = (extent[j] - start[j]) / slope[j];
+    if (enter > leave)
+    {
+      std::swap(enter, leave);
+    }
+    firstSlice = std::max(firstSlice, enter);
+    lastSlice = std::min(lastSlice, leave);
+  }
+  if (firstSlice > lastSlice)
+  {
+    return NumericTraits<OutputType>::ZeroValue();
+  }
+
+  const IndexValueType    sliceBegin = static_cast<IndexValueType>(std::ceil(firstSlice));
+  const IndexValueType    sliceEnd = static_cast<IndexValueType>(std::floor(lastSlice));
+  const IndexValueType    sizeB = parameters.Size[b];
+  const IndexValueType    sizeC = parameters.Size[c];
+  const OffsetValueType   strideA = parameters.Stride[a];
+  const OffsetValueType   strideB = parameters.Stride[b];
+  const OffsetValueType   strideC = parameters.Stride[c];
+  const PixelType * const buffer = parameters.Buffer;
+  const float * const     attenuation = parameters.Attenuation;
+  const double            threshold = parameters.Threshold;
+
+  // Thresholded voxel value, zero outside of the slice
+  auto sample = [=](OffsetValueType slice, IndexValueType iu, IndexValueType iv) -> double {
+    if ((iu < 0) || (iu >= sizeB) || (iv < 0) || (iv >= sizeC))
+    {
+      return 0.0;
+    }
+    const OffsetValueType offset = slice + iu * strideB + iv * strideC;
+    if (attenuation)
+    {
+      return attenuation[offset];
+    }
+    return std::max(static_cast<double>(buffer[offset]) - threshold, 0.0);
+  };
+
+  double sum = 0.0;
+  for (IndexValueType i = sliceBegin; i <= sliceEnd; ++i)
+  {
+    const double u = u0 + i * slopeB;
+    const double v = v0 + i * slopeC;
+    const double uFloor = std::floor(u);
+    const double vFloor = std::floor(v);
+    const double wu = u - uFloor;
+    const double wv = v - vFloor;
+
+    const IndexValueType iu = static_cast<IndexValueType>(uFloor);
+    const IndexValueType iv = static_cast<IndexValueType>(vFloor);
+
+    const OffsetValueType slice = i * strideA;
+
+    const double p00 = sample(slice, iu, iv);
+    const double p10 = sample(slice, iu + 1, iv);
+    const double p01 = sample(slice, iu, iv + 1);
+    const double p11 = sample(slice, iu + 1, iv + 1);
+
+    sum += (1.0 - wv) * ((1.0 - wu) * p00 + wu * p10) + wv * ((1.0 - wu) * p01 + wu * p11);
+  }
+
+  // Each slice accounts for a step of 1/|ray[a]| of the ray parameter, as
+  // the voxel intersection lengths do in the Siddon-Jacobs traversal.
+  const double d12 = sum * std::fabs(inverseRay);
+
+  if (d12 < minOutputValue)
+  {
+    return minOutputValue;
+  }
+  if (d12 > maxOutputValue)
+  {
+    return maxOutputValue;
+  }
+  return static_cast<OutputType>(d12);
+}
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,442 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkLightFieldProjectionImageFilter_hxx
+#define itkLightFieldProjectionImageFilter_hxx
+
+#include "itkLightFieldProjectionImageFilter.h"
+
+#include "itkMultiThreaderBase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+LightFieldProjectionImageFilter<TInputImage, TOutputImage>::LightFieldProjectionImageFilter()
+{
+  // Default range: 2 degrees and 5 mm about the planned setup
+  m_ParametersRange = ParametersType(6);
+  const double dtr = (std::atan(1.0) * 4.0) / 180.0;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    m_ParametersRange[i] = 2.0 * dtr;
+    m_ParametersRange[i + 3] = 5.0;
+  }
+
+  m_MemoryBudget = 128 * 1024 * 1024;
+
+  m_LightFieldSize.Fill(0);
+  std::fill(m_LightFieldOrigin, m_LightFieldOrigin + 4, 0.0);
+  m_PlanePosition[0] = m_PlanePosition[1] = 0.0;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+typename LightFieldProjectionImageFilter<TInputImage, TOutputImage>::LightFieldKey
+LightFieldProjectionImageFilter<TInputImage, TOutputImage>::GetCurrentKey() const
+{
+  LightFieldKey key;
+  key.Input = this->GetInput();
+  key.Threshold = this->GetThreshold();
+  key.ProjectionAngle = this->GetProjectionAngle();
+  key.FocalPointToIsocenterDistance = this->GetFocalPointToIsocenterDistance();
+  key.Size = this->GetSize();
+  key.Spacing = this->GetOutputSpacing();
+  key.Origin = this->GetOutputOrigin();
+  key.Direction = this->GetOutputDirection();
+  key.Center.Fill(0.0);
+  if (const TransformType * transform = this->GetTransform())
+  {
+    key.Center = transform->GetCenter();
+    key.ComputeZYX = transform->GetComputeZYX();
+  }
+  key.ParametersRange = m_ParametersRange;
+  key.MemoryBudget = m_MemoryBudget;
+  return key;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+bool
+LightFieldProjectionImageFilter<TInputImage, TOutputImage>::IsLightFieldValid() const
+{
+  const LightFieldKey key = this->GetCurrentKey();
+  return !m_LightField.empty() && key.Input == m_Key.Input && m_LightFieldTime.GetMTime() >= key.Input->GetMTime() &&
+         key.Threshold == m_Key.Threshold && key.ProjectionAngle == m_Key.ProjectionAngle &&
+         key.FocalPointToIsocenterDistance == m_Key.FocalPointToIsocenterDistance && key.Size == m_Key.Size &&
+         key.Spacing == m_Key.Spacing && key.Origin == m_Key.Origin && key.Direction == m_Key.Direction &&
+         key.Center == m_Key.Center && key.ComputeZYX == m_Key.ComputeZYX &&
+         key.ParametersRange == m_Key.ParametersRange && key.MemoryBudget == m_Key.MemoryBudget;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+LightFieldProjectionImageFilter<TInputImage, TOutputImage>::PrecomputeLightField()
+{
+  const InputImageType * inputPtr = this->GetInput();
+  const TransformType *  transform = this->GetTransform();
+  if (!inputPtr)
+  {
+    itkExceptionMacro(<< "Input image is not present");
+  }
+  if (!transform)
+  {
+    itkExceptionMacro(<< "Transform is not present");
+  }
+  if (m_ParametersRange.Size() != transform->GetNumberOfParameters())
+  {
+    itkExceptionMacro(<< "ParametersRange must have " << transform->GetNumberOfParameters() << " elements");
+  }
+
+  const typename InputImageType::SpacingType ctPixelSpacing = inputPtr->GetSpacing();
+  const typename InputImageType::SizeType    sizeCT = inputPtr->GetLargestPossibleRegion().GetSize();
+
+  const typename OutputImageType::SizeType      size = this->GetSize();
+  const typename OutputImageType::SpacingType   spacing = this->GetOutputSpacing();
+  const typename OutputImageType::PointType     origin = this->GetOutputOrigin();
+  const typename OutputImageType::DirectionType direction = this->GetOutputDirection();
+
+  // Corners of the detector, on the outer edges of the corner pixels
+  std::vector<PointType> detectorCorners;
+  for (unsigned int corner = 0; corner < 4; ++corner)
+  {
+    const double index[2] = { (corner & 1) ? size[0] - 0.5 : -0.5, (corner & 2) ? size[1] - 0.5 : -0.5 };
+    PointType    point = origin;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      point[i] += direction[i][0] * spacing[0] * index[0] + direction[i][1] * spacing[1] * index[1];
+    }
+    detectorCorners.push_back(point);
+  }
+
+  // The planes are perpendicular to the axis closest to the central ray of
+  // the planned setup, half a voxel outside of the volume.
+  const ParametersType nominalParameters = transform->GetParameters();
+
+  typename TransformType::Pointer pose = TransformType::New();
+  pose->SetComputeZYX(transform->GetComputeZYX());
+  pose->SetCenter(transform->GetCenter());
+  typename TransformType::Pointer inverse = TransformType::New();
+
+  pose->SetParameters(nominalParameters);
+  GeometryType::ComputeProjectionInverseTransform(
+    pose, this->GetProjectionAngle(), this->GetFocalPointToIsocenterDistance(), inverse);
+  {
+    const PointType source = inverse->TransformPoint(GeometryType::GetSourcePoint());
+    PointType       center = origin;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      center[i] += direction[i][0] * spacing[0] * 0.5 * (size[0] - 1.0) +
+                   direction[i][1] * spacing[1] * 0.5 * (size[1] - 1.0);
+    }
+    const typename PointType::VectorType centralRay = inverse->TransformPoint(center) - source;
+    m_PlaneAxis = 0;
+    for (unsigned int i = 1; i < 3; ++i)
+    {
+      if (std::fabs(centralRay[i]) > std::fabs(centralRay[m_PlaneAxis]))
+      {
+        m_PlaneAxis = i;
+      }
+    }
+  }
+  const unsigned int a = m_PlaneAxis;
+  const unsigned int b = (a + 1) % 3;
+  const unsigned int c = (a + 2) % 3;
+  m_PlanePosition[0] = -0.5 * ctPixelSpacing[a];
+  m_PlanePosition[1] = (sizeCT[a] + 0.5) * ctPixelSpacing[a];
+
+  // Extent of the intersections of the rays with the planes over the
+  // corners of the range of parameters.
+  double lower[4];
+  double upper[4];
+  std::fill(lower, lower + 4, NumericTraits<double>::max());
+  std::fill(upper, upper + 4, NumericTraits<double>::NonpositiveMin());
+
+  const unsigned int numberOfParameters = nominalParameters.Size();
+  for (unsigned int corner = 0; corner < (1u << numberOfParameters); ++corner)
+  {
+    ParametersType parameters = nominalParameters;
+    for (unsigned int p = 0; p < numberOfParameters; ++p)
+    {
+      parameters[p] += ((corner >> p) & 1) ? m_ParametersRange[p] : -m_ParametersRange[p];
+    }
+    pose->SetParameters(parameters);
+    GeometryType::ComputeProjectionInverseTransform(
+      pose, this->GetProjectionAngle(), this->GetFocalPointToIsocenterDistance(), inverse);
+
+    const PointType source = inverse->TransformPoint(GeometryType::GetSourcePoint());
+    for (const PointType & detectorCorner : detectorCorners)
+    {
+      const typename PointType::VectorType ray = inverse->TransformPoint(detectorCorner) - source;
+      if (ray[a] == 0)
+      {
+        continue;
+      }
+      for (unsigned int plane = 0; plane < 2; ++plane)
+      {
+        const double alpha = (m_PlanePosition[plane] - source[a]) / ray[a];
+        const double coordinates[2] = { source[b] + alpha * ray[b], source[c] + alpha * ray[c] };
+        for (unsigned int k = 0; k < 2; ++k)
+        {
+          lower[2 * plane + k] = std::min(lower[2 * plane + k], coordinates[k]);
+          upper[2 * plane + k] = std::max(upper[2 * plane + k], coordinates[k]);
+        }
+      }
+    }
+  }
+
+  // The rotations are not linear in the parameters, so the extents are
+  // widened by a few percent.
+  double extent[4];
+  double product = 1.0;
+  for (unsigned int k = 0; k < 4; ++k)
+  {
+    const double margin = 0.05 * (upper[k] - lower[k]) + 0.5 * ctPixelSpacing[(k % 2) ? c : b];
+    lower[k] -= margin;
+    upper[k] += margin;
+    extent[k] = upper[k] - lower[k];
+    product *= extent[k];
+  }
+
+  // Largest common step fitting in the memory budget
+  const double maximumNumberOfSamples = static_cast<double>(m_MemoryBudget) / sizeof(float);
+  if (maximumNumberOfSamples < 16)
+  {
+    itkExceptionMacro(<< "MemoryBudget is too small for a light field");
+  }
+  double step = std::pow(product / maximumNumberOfSamples, 0.25);
+  while (true)
+  {
+    double numberOfSamples = 1.0;
+    for (unsigned int k = 0; k < 4; ++k)
+    {
+      m_LightFieldSize[k] = static_cast<SizeValueType>(std::ceil(extent[k] / step)) + 1;
+      numberOfSamples *= m_LightFieldSize[k];
+    }
+    if (numberOfSamples <= maximumNumberOfSamples)
+    {
+      break;
+    }
+    step *= 1.02;
+  }
+  m_SampleSpacing = step;
+  for (unsigned int k = 0; k < 4; ++k)
+  {
+    m_LightFieldOrigin[k] = lower[k];
+  }
+
+  // Sample the line integrals with the exact ray caster.
+  typename RayCasterType::Pointer rayCaster = RayCasterType::New();
+  rayCaster->SetInputImage(inputPtr);
+  rayCaster->SetThreshold(this->GetThreshold());
+
+  const SizeValueType sizeS = m_LightFieldSize[0];
+  const SizeValueType sizeT = m_LightFieldSize[1];
+  const SizeValueType sizeU = m_LightFieldSize[2];
+  const SizeValueType sizeV = m_LightFieldSize[3];
+  m_LightField.assign(sizeS * sizeT * sizeU * sizeV, 0.0f);
+  float * lightField = m_LightField.data();
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    sizeS * sizeT,
+    [&](SizeValueType st) {
+      PointType first;
+      first[a] = m_PlanePosition[0];
+      first[b] = m_LightFieldOrigin[0] + (st / sizeT) * step;
+      first[c] = m_LightFieldOrigin[1] + (st % sizeT) * step;
+
+      typename RayCasterType::VectorType ray;
+      ray[a] = m_PlanePosition[1] - m_PlanePosition[0];
+
+      float * sample = lightField + st * sizeU * sizeV;
+      for (SizeValueType iu = 0; iu < sizeU; ++iu)
+      {
+        ray[b] = m_LightFieldOrigin[2] + iu * step - first[b];
+        for (SizeValueType iv = 0; iv < sizeV; ++iv, ++sample)
+        {
+          ray[c] = m_LightFieldOrigin[3] + iv * step - first[c];
+          // The ray caster divides by the length of the ray vector.
+          *sample = static_cast<float>(rayCaster->EvaluateRay(first, ray) * ray.GetNorm());
+        }
+      }
+    },
+    nullptr);
+
+  m_Key = this->GetCurrentKey();
+  m_LightFieldTime.Modified();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+double
+LightFieldProjectionImageFilter<TInputImage, TOutputImage>::InterpolateLightField(const double x[4]) const
+{
+  SizeValueType base[4];
+  double        weight[4];
+  for (unsigned int k = 0; k < 4; ++k)
+  {
+    const double clamped = std::min(std::max(x[k], 0.0), m_LightFieldSize[k] - 1.0);
+    base[k] = std::min(static_cast<SizeValueType>(clamped), m_LightFieldSize[k] - 2);
+    weight[k] = clamped - base[k];
+  }
+
+  const SizeValueType strideV = 1;
+  const SizeValueType strideU = m_LightFieldSize[3];
+  const SizeValueType strideT = strideU * m_LightFieldSize[2];
+  const SizeValueType strideS = strideT * m_LightFieldSize[1];
+  const SizeValueType strides[4] = { strideS, strideT, strideU, strideV };
+  const float *       sample =
+    m_LightField.data() + base[0] * strideS + base[1] * strideT + base[2] * strideU + base[3] * strideV;
+
+  double value = 0.0;
+  for (unsigned int corner = 0; corner < 16; ++corner)
+  {
+    double        w = 1.0;
+    SizeValueType offset = 0;
+    for (unsigned int k = 0; k < 4; ++k)
+    {
+      if ((corner >> k) & 1)
+      {
+        w *= weight[k];
+        offset += strides[k];
+      }
+      else
+      {
+        w *= 1.0 - weight[k];
+      }
+    }
+    value += w * sample[offset];
+  }
+  return value;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+LightFieldProjectionImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  this->AllocateOutputs();
+
+  if (!this->IsLightFieldValid())
+  {
+    this->PrecomputeLightField();
+  }
+  this->UpdateProjectionGeometry();
+
+  OutputImageType *     outputPtr = this->GetOutput();
+  const TransformType * inverseTransform = this->GetInverseTransform();
+  const PointType &     sourceWorld = this->GetSourceWorld();
+
+  const typename OutputImageType::RegionType outputRegion = outputPtr->GetRequestedRegion();
+  const SizeValueType                        sizeU = outputRegion.GetSize()[0];
+  const SizeValueType                        sizeV = outputRegion.GetSize()[1];
+
+  // The rays are an affine function of the pixel index.
+  double firstRay[3];
+  double stepU[3];
+  double stepV[3];
+  {
+    typename OutputImageType::PointType     p00, p10, p01;
+    ContinuousIndex<double, ImageDimension> index;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      index[i] = outputRegion.GetIndex()[i];
+    }
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p00);
+    index[0] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p10);
+    index[0] -= 1.0;
+    index[1] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p01);
+
+    const PointType w00 = inverseTransform->TransformPoint(p00);
+    const PointType w10 = inverseTransform->TransformPoint(p10);
+    const PointType w01 = inverseTransform->TransformPoint(p01);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      firstRay[i] = w00[i] - sourceWorld[i];
+      stepU[i] = w10[i] - w00[i];
+      stepV[i] = w01[i] - w00[i];
+    }
+  }
+
+  const unsigned int a = m_PlaneAxis;
+  const unsigned int b = (a + 1) % 3;
+  const unsigned int c = (a + 2) % 3;
+  const double       inverseStep = 1.0 / m_SampleSpacing;
+
+  const double minOutputValue = NumericTraits<OutputPixelType>::NonpositiveMin();
+  const double maxOutputValue = NumericTraits<OutputPixelType>::max();
+
+  OutputPixelType * output = outputPtr->GetBufferPointer();
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    sizeV,
+    [&](SizeValueType v) {
+      for (SizeValueType u = 0; u < sizeU; ++u)
+      {
+        double ray[3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          ray[i] = firstRay[i] + u * stepU[i] + v * stepV[i];
+        }
+
+        double d12 = 0.0;
+        if (ray[a] != 0)
+        {
+          // Intersections of the ray with the two planes, as table indices
+          double x[4];
+          for (unsigned int plane = 0; plane < 2; ++plane)
+          {
+            const double alpha = (m_PlanePosition[plane] - sourceWorld[a]) / ray[a];
+            x[2 * plane] = (sourceWorld[b] + alpha * ray[b] - m_LightFieldOrigin[2 * plane]) * inverseStep;
+            x[2 * plane + 1] = (sourceWorld[c] + alpha * ray[c] - m_LightFieldOrigin[2 * plane + 1]) * inverseStep;
+          }
+          // The table holds line integrals in mm; the Siddon-Jacobs ray
+          // caster scales them by the inverse length of the ray vector.
+          const double rayLength = std::sqrt(ray[0] * ray[0] + ray[1] * ray[1] + ray[2] * ray[2]);
+          d12 = this->InterpolateLightField(x) / rayLength;
+        }
+        d12 = std::min(std::max(d12, minOutputValue), maxOutputValue);
+        output[v * sizeU + u] = static_cast<OutputPixelType>(d12);
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+LightFieldProjectionImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "ParametersRange: " << m_ParametersRange << std::endl;
+  os << indent << "MemoryBudget: " << m_MemoryBudget << std::endl;
+  os << indent << "LightFieldSize: " << m_LightFieldSize << std::endl;
+  os << indent << "SampleSpacing: " << m_SampleSpacing << std::endl;
+  os << indent << "PlaneAxis: " << m_PlaneAxis << std::endl;
+}
+
+} // namespace itk
+
+#endif
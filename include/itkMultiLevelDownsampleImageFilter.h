@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMultiLevelDownsampleImageFilter_h
+#define itkMultiLevelDownsampleImageFilter_h
+
+#include "itkArray2D.h"
+#include "itkImageToImageFilter.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class MultiLevelDownsampleImageFilter
+ * \brief Downsample a volume to several levels in a single streamed pass.
+ *
+ * The output of index l is the input reduced by the integer factors of row
+ * l of the Schedule along each dimension. SetNumberOfLevels() sets the
+ * schedule 2, 4, 8, ... along all dimensions. The size of an output is the
+ * size of the input divided by the factors, rounded down, and its voxels
+ * are centred on the blocks of input voxels they replace, as in
+ * BinShrinkImageFilter.
+ *
+ * Each output voxel is a weighted sum of the input voxels, separable along
+ * the dimensions. By default it is the mean of the block of input voxels it
+ * covers. If UseGaussianReduction is on, the weights are those of a Gaussian
+ * of standard deviation half the factor, in voxels, as in
+ * MultiResolutionPyramidImageFilter, truncated at three standard deviations
+ * and normalized at the boundaries. The sums are computed in double
+ * precision, and rounded for images of integer pixels.
+ *
+ * The input is requested from the pipeline in NumberOfStreamDivisions slabs
+ * along its last dimension, so that a reader streams the volume with
+ * bounded memory. Every output slice whose support is complete is computed
+ * as soon as its slab is read, for all the levels at once, the slices being
+ * distributed over the threads of the MultiThreader. Only the outputs are
+ * held in memory, and the input is read once whatever the number of levels.
+ *
+ * \warning This filter works for 3-dimensional images only.
+ *
+ * \sa MultiResolutionPyramidImageFilter, BinShrinkImageFilter
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage = TInputImage>
+class MultiLevelDownsampleImageFilter : public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(MultiLevelDownsampleImageFilter);
+
+  /** Standard class type alias. */
+  using Self = MultiLevelDownsampleImageFilter;
+  using Superclass = ImageToImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MultiLevelDownsampleImageFilter, ImageToImageFilter);
+
+  using InputImageType = TInputImage;
+  using InputPixelType = typename InputImageType::PixelType;
+  using InputRegionType = typename InputImageType::RegionType;
+  using OutputImageType = TOutputImage;
+  using OutputPixelType = typename OutputImageType::PixelType;
+  using OutputRegionType = typename OutputImageType::RegionType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Reduction factors: one row per level, one column per dimension. */
+  using ScheduleType = Array2D<unsigned int>;
+
+  /** Set the number of levels, with the default schedule. */
+  void
+  SetNumberOfLevels(unsigned int numberOfLevels);
+  itkGetConstMacro(NumberOfLevels, unsigned int);
+
+  /** Set and get the reduction factors of the levels. The number of levels
+   * is the number of rows of the schedule. */
+  void
+  SetSchedule(const ScheduleType & schedule);
+  itkGetConstReferenceMacro(Schedule, ScheduleType);
+
+  /** Set and get whether the voxels are reduced with Gaussian rather than
+   * box weights. */
+  itkSetMacro(UseGaussianReduction, bool);
+  itkGetConstMacro(UseGaussianReduction, bool);
+  itkBooleanMacro(UseGaussianReduction);
+
+  /** Set and get the number of slabs the input is requested in. */
+  itkSetClampMacro(NumberOfStreamDivisions, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(NumberOfStreamDivisions, unsigned int);
+
+  /** All the levels are produced by a single pass over the input, whichever
+   * output is updated. */
+  void
+  UpdateOutputData(DataObject * output) override;
+
+protected:
+  MultiLevelDownsampleImageFilter();
+  ~MultiLevelDownsampleImageFilter() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Set the grid of every level. */
+  void
+  GenerateOutputInformation() override;
+
+  /** The input is requested by slabs in GenerateData(). */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** The levels are computed whole. */
+  void
+  EnlargeOutputRequestedRegion(DataObject * output) override;
+
+  void
+  GenerateData() override;
+
+private:
+  /** Input voxels contributing to an output voxel along one dimension: the
+   * weights apply to consecutive voxels from First, relative to the start
+   * of the largest possible region of the input. */
+  struct Reduction
+  {
+    IndexValueType      First;
+    std::vector<double> Weights;
+
+    IndexValueType
+    End() const
+    {
+      return First + static_cast<IndexValueType>(Weights.size());
+    }
+  };
+  using ReductionTableType = std::vector<Reduction>;
+
+  /** Reductions of the outputSize voxels of a level along a dimension of
+   * inputSize voxels, for a factor. */
+  ReductionTableType
+  ComputeReductions(SizeValueType inputSize, SizeValueType outputSize, unsigned int factor) const;
+
+  /** Compute the slice z of an output from the buffered input, given the
+   * reductions of its level along the three dimensions. */
+  void
+  ComputeSlice(const InputImageType *     input,
+               OutputImageType *          output,
+               const ReductionTableType * reductions,
+               SizeValueType              z) const;
+
+  void
+  SetNumberOfOutputLevels(unsigned int numberOfLevels);
+
+  unsigned int m_NumberOfLevels;
+  ScheduleType m_Schedule;
+  bool         m_UseGaussianReduction;
+  unsigned int m_NumberOfStreamDivisions;
+  bool         m_Streaming;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkMultiLevelDownsampleImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,443 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMultiLevelDownsampleImageFilter_hxx
+#define itkMultiLevelDownsampleImageFilter_hxx
+
+#include "itkMultiLevelDownsampleImageFilter.h"
+
+#include "itkContinuousIndex.h"
+#include "itkImageRegionSplitterSlowDimension.h"
+#include "itkMath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::MultiLevelDownsampleImageFilter()
+{
+  static_assert(ImageDimension == 3, "MultiLevelDownsampleImageFilter works for 3-dimensional images only");
+
+  m_NumberOfLevels = 0;
+  m_UseGaussianReduction = false;
+  m_NumberOfStreamDivisions = 16;
+  m_Streaming = false;
+
+  this->SetNumberOfLevels(1);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::SetNumberOfLevels(unsigned int numberOfLevels)
+{
+  numberOfLevels = std::max(numberOfLevels, 1u);
+
+  ScheduleType schedule(numberOfLevels, ImageDimension);
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      schedule(level, i) = 1u << (level + 1);
+    }
+  }
+  this->SetSchedule(schedule);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::SetSchedule(const ScheduleType & schedule)
+{
+  if (schedule.rows() < 1 || schedule.cols() != ImageDimension)
+  {
+    itkExceptionMacro(<< "The schedule must have at least one row and " << ImageDimension << " columns");
+  }
+  for (unsigned int level = 0; level < schedule.rows(); ++level)
+  {
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      if (schedule(level, i) < 1)
+      {
+        itkExceptionMacro(<< "The reduction factors must be at least 1");
+      }
+    }
+  }
+
+  if (schedule.rows() == m_Schedule.rows() && schedule.cols() == m_Schedule.cols() && schedule == m_Schedule)
+  {
+    return;
+  }
+  m_Schedule = schedule;
+  this->SetNumberOfOutputLevels(schedule.rows());
+  this->Modified();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::SetNumberOfOutputLevels(unsigned int numberOfLevels)
+{
+  m_NumberOfLevels = numberOfLevels;
+
+  this->SetNumberOfIndexedOutputs(numberOfLevels);
+  this->SetNumberOfRequiredOutputs(numberOfLevels);
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    if (!this->ProcessObject::GetOutput(level))
+    {
+      typename DataObject::Pointer output = this->MakeOutput(level);
+      this->SetNthOutput(level, output.GetPointer());
+    }
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfLevels: " << m_NumberOfLevels << std::endl;
+  os << indent << "Schedule: " << std::endl << m_Schedule << std::endl;
+  os << indent << "UseGaussianReduction: " << m_UseGaussianReduction << std::endl;
+  os << indent << "NumberOfStreamDivisions: " << m_NumberOfStreamDivisions << std::endl;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  const InputImageType * input = this->GetInput();
+  if (!input)
+  {
+    return;
+  }
+
+  const InputRegionType largest = input->GetLargestPossibleRegion();
+  for (unsigned int level = 0; level < m_NumberOfLevels; ++level)
+  {
+    typename OutputImageType::SizeType      size;
+    typename OutputImageType::SpacingType   spacing;
+    ContinuousIndex<double, ImageDimension> blockCenter;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const unsigned int factor = m_Schedule(level, i);
+      size[i] = std::max<SizeValueType>(largest.GetSize(i) / factor, 1);
+      spacing[i] = input->GetSpacing()[i] * factor;
+      blockCenter[i] = largest.GetIndex(i) + 0.5 * (factor - 1);
+    }
+
+    // The first output voxel lies at the center of the first block.
+    typename OutputImageType::PointType origin;
+    input->TransformContinuousIndexToPhysicalPoint(blockCenter, origin);
+
+    OutputImageType * output = this->GetOutput(level);
+    output->SetLargestPossibleRegion(OutputRegionType(size));
+    output->SetSpacing(spacing);
+    output->SetOrigin(origin);
+    output->SetDirection(input->GetDirection());
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
+{
+  auto * input = const_cast<InputImageType *>(this->GetInput());
+  if (input)
+  {
+    input->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::EnlargeOutputRequestedRegion(DataObject *)
+{
+  for (unsigned int level = 0; level < m_NumberOfLevels; ++level)
+  {
+    this->GetOutput(level)->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::UpdateOutputData(DataObject * itkNotUsed(output))
+{
+  // Updating an output from GenerateData() must not start another pass.
+  if (m_Streaming)
+  {
+    return;
+  }
+
+  this->PrepareOutputs();
+
+  if (this->GetNumberOfValidRequiredInputs() < this->GetNumberOfRequiredInputs())
+  {
+    itkExceptionMacro(<< "At least " << this->GetNumberOfRequiredInputs() << " inputs are required but only "
+                      << this->GetNumberOfValidRequiredInputs() << " are specified.");
+  }
+
+  this->SetAbortGenerateData(false);
+  this->UpdateProgress(0.0f);
+  m_Streaming = true;
+  this->InvokeEvent(StartEvent());
+  try
+  {
+    this->GenerateData();
+  }
+  catch (...)
+  {
+    m_Streaming = false;
+    throw;
+  }
+  this->InvokeEvent(EndEvent());
+
+  for (unsigned int level = 0; level < m_NumberOfLevels; ++level)
+  {
+    this->GetOutput(level)->DataHasBeenGenerated();
+  }
+  this->ReleaseInputs();
+  m_Streaming = false;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+typename MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::ReductionTableType
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::ComputeReductions(SizeValueType inputSize,
+                                                                              SizeValueType outputSize,
+                                                                              unsigned int  factor) const
+{
+  ReductionTableType reductions(outputSize);
+  for (SizeValueType o = 0; o < outputSize; ++o)
+  {
+    Reduction & reduction = reductions[o];
+    if (!m_UseGaussianReduction || factor == 1)
+    {
+      // Mean of the block, which may be cut by the end of the input.
+      reduction.First = static_cast<IndexValueType>(o * factor);
+      const SizeValueType count = std::min<SizeValueType>(factor, inputSize - o * factor);
+      reduction.Weights.assign(count, 1.0 / count);
+      continue;
+    }
+
+    const double sigma = 0.5 * factor;
+    const double center = o * factor + 0.5 * (factor - 1);
+    const double radius = 3.0 * sigma;
+    reduction.First = std::max<IndexValueType>(static_cast<IndexValueType>(std::ceil(center - radius)), 0);
+    const IndexValueType last = std::min<IndexValueType>(static_cast<IndexValueType>(std::floor(center + radius)),
+                                                         static_cast<IndexValueType>(inputSize) - 1);
+    double sum = 0.0;
+    for (IndexValueType i = reduction.First; i <= last; ++i)
+    {
+      const double distance = (i - center) / sigma;
+      reduction.Weights.push_back(std::exp(-0.5 * distance * distance));
+      sum += reduction.Weights.back();
+    }
+    for (double & weight : reduction.Weights)
+    {
+      weight /= sum;
+    }
+  }
+  return reductions;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  auto *                input = const_cast<InputImageType *>(this->GetInput());
+  const InputRegionType largest = input->GetLargestPossibleRegion();
+  const IndexValueType  lastStart = largest.GetIndex(ImageDimension - 1);
+
+  std::vector<OutputImageType *>  outputs(m_NumberOfLevels);
+  std::vector<ReductionTableType> reductions(m_NumberOfLevels * ImageDimension);
+  for (unsigned int level = 0; level < m_NumberOfLevels; ++level)
+  {
+    outputs[level] = this->GetOutput(level);
+    outputs[level]->SetBufferedRegion(outputs[level]->GetRequestedRegion());
+    outputs[level]->Allocate();
+
+    const typename OutputImageType::SizeType size = outputs[level]->GetBufferedRegion().GetSize();
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      reductions[level * ImageDimension + i] =
+        this->ComputeReductions(largest.GetSize(i), size[i], m_Schedule(level, i));
+    }
+  }
+
+  // Next slice of every level to compute
+  std::vector<SizeValueType> nextSlice(m_NumberOfLevels, 0);
+
+  ImageRegionSplitterSlowDimension::Pointer splitter = ImageRegionSplitterSlowDimension::New();
+  const unsigned int                        numberOfSlabs =
+    splitter->GetNumberOfSplits(largest, m_NumberOfStreamDivisions);
+  for (unsigned int piece = 0; piece < numberOfSlabs; ++piece)
+  {
+    InputRegionType slab = largest;
+    splitter->GetSplit(piece, numberOfSlabs, slab);
+    const IndexValueType slabEnd = slab.GetIndex(ImageDimension - 1) +
+                                   static_cast<IndexValueType>(slab.GetSize(ImageDimension - 1)) - lastStart;
+
+    // The slices whose support ends within the slab are computed now; the
+    // slab is extended back to the first input slice they need.
+    std::vector<std::pair<unsigned int, SizeValueType>> slices;
+    IndexValueType                                      requestStart = slabEnd;
+    for (unsigned int level = 0; level < m_NumberOfLevels; ++level)
+    {
+      const ReductionTableType & alongLast = reductions[level * ImageDimension + ImageDimension - 1];
+      SizeValueType              z = nextSlice[level];
+      if (z < alongLast.size() && alongLast[z].End() <= slabEnd)
+      {
+        requestStart = std::min(requestStart, alongLast[z].First);
+      }
+      for (; z < alongLast.size() && alongLast[z].End() <= slabEnd; ++z)
+      {
+        slices.emplace_back(level, z);
+      }
+      nextSlice[level] = z;
+    }
+
+    if (!slices.empty())
+    {
+      InputRegionType request = largest;
+      request.SetIndex(ImageDimension - 1, lastStart + requestStart);
+      request.SetSize(ImageDimension - 1, static_cast<SizeValueType>(slabEnd - requestStart));
+      input->SetRequestedRegion(request);
+      input->PropagateRequestedRegion();
+      input->UpdateOutputData();
+
+      this->GetMultiThreader()->ParallelizeArray(
+        0,
+        slices.size(),
+        [&](SizeValueType s) {
+          const unsigned int level = slices[s].first;
+          this->ComputeSlice(input, outputs[level], &reductions[level * ImageDimension], slices[s].second);
+        },
+        nullptr);
+    }
+
+    this->UpdateProgress(static_cast<float>(piece + 1) / numberOfSlabs);
+  }
+
+  input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiLevelDownsampleImageFilter<TInputImage, TOutputImage>::ComputeSlice(const InputImageType *     input,
+                                                                         OutputImageType *          output,
+                                                                         const ReductionTableType * reductions,
+                                                                         SizeValueType              z) const
+{
+  const ReductionTableType & alongX = reductions[0];
+  const ReductionTableType & alongY = reductions[1];
+  const Reduction &          alongZ = reductions[2][z];
+
+  // Input rows and columns covered by the supports of the slice
+  const IndexValueType x0 = alongX.front().First;
+  const IndexValueType y0 = alongY.front().First;
+  const SizeValueType  width = static_cast<SizeValueType>(alongX.back().End() - x0);
+  const SizeValueType  height = static_cast<SizeValueType>(alongY.back().End() - y0);
+  const SizeValueType  outputWidth = alongX.size();
+  const SizeValueType  outputHeight = alongY.size();
+
+  // The buffered region of the input may be larger than the requested slab.
+  const typename InputImageType::IndexType start = input->GetLargestPossibleRegion().GetIndex();
+  const typename InputImageType::IndexType bufferStart = input->GetBufferedRegion().GetIndex();
+  const OffsetValueType *                  offsetTable = input->GetOffsetTable();
+
+  const OffsetValueType offset = (start[0] + x0 - bufferStart[0]) + (start[1] + y0 - bufferStart[1]) * offsetTable[1] +
+                                 (start[2] - bufferStart[2]) * offsetTable[2];
+  const InputPixelType * const buffer = input->GetBufferPointer() + offset;
+
+  // Reduce along z, then x, then y.
+  std::vector<double> plane(width * height, 0.0);
+  for (SizeValueType k = 0; k < alongZ.Weights.size(); ++k)
+  {
+    const double                 weight = alongZ.Weights[k];
+    const InputPixelType * const slice = buffer + (alongZ.First + static_cast<IndexValueType>(k)) * offsetTable[2];
+    for (SizeValueType y = 0; y < height; ++y)
+    {
+      const InputPixelType * row = slice + static_cast<OffsetValueType>(y) * offsetTable[1];
+      double *               sum = &plane[y * width];
+      for (SizeValueType x = 0; x < width; ++x)
+      {
+        sum[x] += weight * static_cast<double>(row[x]);
+      }
+    }
+  }
+
+  std::vector<double> rows(outputWidth * height);
+  for (SizeValueType y = 0; y < height; ++y)
+  {
+    const double * planeRow = &plane[y * width];
+    for (SizeValueType ox = 0; ox < outputWidth; ++ox)
+    {
+      const Reduction & reduction = alongX[ox];
+      const double *    values = planeRow + (reduction.First - x0);
+      double            sum = 0.0;
+      for (SizeValueType k = 0; k < reduction.Weights.size(); ++k)
+      {
+        sum += reduction.Weights[k] * values[k];
+      }
+      rows[y * outputWidth + ox] = sum;
+    }
+  }
+
+  const double lowest = static_cast<double>(NumericTraits<OutputPixelType>::NonpositiveMin());
+  const double highest = static_cast<double>(NumericTraits<OutputPixelType>::max());
+  const bool   isInteger = std::numeric_limits<OutputPixelType>::is_integer;
+
+  OutputPixelType * out = output->GetBufferPointer() + z * outputWidth * outputHeight;
+  for (SizeValueType oy = 0; oy < outputHeight; ++oy)
+  {
+    const Reduction & reduction = alongY[oy];
+    for (SizeValueType ox = 0; ox < outputWidth; ++ox)
+    {
+      const double * values = &rows[(reduction.First - y0) * outputWidth + ox];
+      double         sum = 0.0;
+      for (SizeValueType k = 0; k < reduction.Weights.size(); ++k)
+      {
+        sum += reduction.Weights[k] * values[k * outputWidth];
+      }
+      if (isInteger)
+      {
+        sum = std::round(sum);
+      }
+      out[oy * outputWidth + ox] = static_cast<OutputPixelType>(std::min(std::max(sum, lowest), highest));
+    }
+  }
+}
+
+} // namespace itk
+
+#endif
@@ -21,6 +21,7 @@
 #include "itkTwoImageToOneImageMetric.h"
 #include "itkCovariantVector.h"
 #include "itkPoint.h"
+#include <type_traits>
 
 
 namespace itk
@@ -74,6 +75,11 @@ public:
   using MovingImageType = typename Superclass::MovingImageType;
   using FixedImageConstPointer = typename Superclass::FixedImageConstPointer;
   using MovingImageConstPointer = typename Superclass::MovingImageConstPointer;
+  using FixedImageRegionType = typename Superclass::FixedImageRegionType;
+  using FixedImageMaskType = typename Superclass::FixedImageMaskType;
+  using InterpolatorType = typename Superclass::InterpolatorType;
+  using TileSchedulerType = typename Superclass::TileSchedulerType;
+  using InputPointType = typename Superclass::InputPointType;
 
 
   /** Get the derivatives of the match measure. */
@@ -105,6 +111,96 @@ protected:
   PrintSelf(std::ostream & os, Indent indent) const override;
 
 private:
+  using AccumulateType = typename NumericTraits<MeasureType>::AccumulateType;
+
+  /** Running sums of the normalized correlation over a set of samples. */
+  struct ScanlineStatistics
+  {
+    AccumulateType sff{ 0 };
+    AccumulateType smm{ 0 };
+    AccumulateType sfm{ 0 };
+    AccumulateType sf{ 0 };
+    AccumulateType sm{ 0 };
+
+    ScanlineStatistics &
+    operator+=(const ScanlineStatistics & other)
+    {
+      sff += other.sff;
+      smm += other.smm;
+      sfm += other.sfm;
+      sf += other.sf;
+      sm += other.sm;
+      return *this;
+    }
+  };
+
+  /** Compute the measure between one fixed image and its projection of the
+   * moving image. The region is split into tiles evaluated in parallel by
+   * the TileScheduler. The moving values of each scanline of a tile are
+   * first collected into a contiguous buffer, then reduced against the
+   * fixed row. */
+  MeasureType
+  ComputeMeasure(const FixedImageType *       fixedImage,
+                 const FixedImageRegionType & fixedRegion,
+                 const InterpolatorType *     interpolator,
+                 const FixedImageMaskType *   fixedImageMask) const;
+
+  /** Accumulate the five correlation sums of a scanline. The loop keeps
+   * several independent partial sums so that it vectorizes, and long
+   * scanlines are split recursively (pairwise summation) to limit the
+   * round-off error of the accumulation. */
+  template <typename TFixedValue>
+  static ScanlineStatistics
+  AccumulateScanline(const TFixedValue * fixedValues, const RealType * movingValues, SizeValueType length);
+
+  /** Interpolate the moving image at numberOfPoints points, in a single
+   * batch when the interpolator is the Siddon-Jacobs ray caster. The
+   * projection interpolators work for 3-dimensional moving images only. */
+  static void
+  EvaluatePoints(const InterpolatorType * interpolator,
+                 const InputPointType *   points,
+                 SizeValueType            numberOfPoints,
+                 RealType *               values,
+                 std::true_type);
+  static void
+  EvaluatePoints(const InterpolatorType * interpolator,
+                 const InputPointType *   points,
+                 SizeValueType            numberOfPoints,
+                 RealType *               values,
+                 std::false_type);
+
+  /** Project length points of a scanline, from firstPoint and pointStep
+   * apart, at once if the interpolator is a projection interpolator.
+   * Returns whether it is; the projection interpolators work for
+   * 3-dimensional moving images only. */
+  static bool
+  EvaluateScanline(const InterpolatorType *                    interpolator,
+                   const InputPointType &                      firstPoint,
+                   const typename InputPointType::VectorType & pointStep,
+                   SizeValueType                               length,
+                   RealType *                                  values,
+                   std::true_type);
+  static bool
+  EvaluateScanline(const InterpolatorType *,
+                   const InputPointType &,
+                   const typename InputPointType::VectorType &,
+                   SizeValueType,
+                   RealType *,
+                   std::false_type)
+  {
+    return false;
+  }
+
+  /** Update the projection geometry of a projection interpolator before it
+   * is used from several threads. */
+  static void
+  UpdateProjectionGeometry(const InterpolatorType * interpolator, std::true_type);
+  static void
+  UpdateProjectionGeometry(const InterpolatorType *, std::false_type)
+  {}
+
+  using IsThreeDimensional = std::integral_constant<bool, Superclass::MovingImageDimension == 3>;
+
   bool m_SubtractMean;
 };
 
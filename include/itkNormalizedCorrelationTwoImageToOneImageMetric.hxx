@@ -19,7 +19,12 @@
 #define itkNormalizedCorrelationTwoImageToOneImageMetric_hxx
 
 #include "itkNormalizedCorrelationTwoImageToOneImageMetric.h"
-#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageScanlineConstIterator.h"
+#include "itkProjectionInterpolateImageFunction.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace itk
 {
@@ -52,163 +57,300 @@ NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::GetVal
     itkExceptionMacro(<< "Fixed image2 has not been assigned");
   }
 
-  using FixedIteratorType = itk::ImageRegionConstIteratorWithIndex<FixedImageType>;
+  this->SetTransformParameters(parameters);
 
-  using AccumulateType = typename NumericTraits<MeasureType>::AccumulateType;
+  // Calculate the measure value between fixed image 1 and the moving image
+  const MeasureType measure1 = this->ComputeMeasure(
+    fixedImage1, this->GetFixedImageRegion1(), this->m_Interpolator1, this->m_FixedImageMask1);
 
+  // Calculate the measure value between fixed image 2 and the moving image
+  const MeasureType measure2 = this->ComputeMeasure(
+    fixedImage2, this->GetFixedImageRegion2(), this->m_Interpolator2, this->m_FixedImageMask2);
 
-  // Calculate the measure value between fixed image 1 and the moving image
+  return (measure1 + measure2) / 2.0;
+}
 
-  FixedIteratorType ti1(fixedImage1, this->GetFixedImageRegion1());
 
-  typename FixedImageType::IndexType index;
+template <typename TFixedImage, typename TMovingImage>
+typename NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::MeasureType
+NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::ComputeMeasure(
+  const FixedImageType *       fixedImage,
+  const FixedImageRegionType & fixedRegion,
+  const InterpolatorType *     interpolator,
+  const FixedImageMaskType *   fixedImageMask) const
+{
+  using FixedIteratorType = ImageScanlineConstIterator<FixedImageType>;
+  using FixedPixelType = typename FixedImageType::PixelType;
 
-  MeasureType measure1;
+  // Without masks every pixel is used, and a ray casting interpolator can
+  // project a whole scanline at once.
+  const bool projectScanlines = !fixedImageMask && !this->m_MovingImageMask;
 
-  this->m_NumberOfPixelsCounted = 0;
+  // Update the projection geometry for the current parameters before the
+  // rays are cast from several threads.
+  UpdateProjectionGeometry(interpolator, IsThreeDimensional());
 
-  this->SetTransformParameters(parameters);
+  // The region is evaluated in small tiles shared by the threads. The sums
+  // of each tile are kept apart and added in tile order, so that the
+  // measure does not depend on the scheduling.
+  TileSchedulerType * scheduler = this->m_TileScheduler;
+  const SizeValueType numberOfTiles = scheduler->SplitRegion(fixedRegion);
 
-  AccumulateType                      sff = NumericTraits<AccumulateType>::ZeroValue();
-  AccumulateType                      smm = NumericTraits<AccumulateType>::ZeroValue();
-  AccumulateType                      sfm = NumericTraits<AccumulateType>::ZeroValue();
-  AccumulateType                      sf = NumericTraits<AccumulateType>::ZeroValue();
-  AccumulateType                      sm = NumericTraits<AccumulateType>::ZeroValue();
-  typename Superclass::InputPointType inputPoint;
+  std::vector<ScanlineStatistics> tileStats(numberOfTiles);
+  std::vector<SizeValueType>      tileCounts(numberOfTiles, 0);
 
-  while (!ti1.IsAtEnd())
-  {
+  // Scanline buffers of each work unit. The fixed values are only copied
+  // when masking or the interpolator rejects part of a row; otherwise the
+  // fixed row is read in place from the image buffer.
+  std::vector<std::vector<RealType>>       movingLines(scheduler->GetNumberOfWorkUnits());
+  std::vector<std::vector<RealType>>       fixedLines(scheduler->GetNumberOfWorkUnits());
+  std::vector<std::vector<InputPointType>> pointLines(scheduler->GetNumberOfWorkUnits());
 
-    index = ti1.GetIndex();
+  scheduler->Execute([&](SizeValueType tile, const FixedImageRegionType & tileRegion, ThreadIdType workUnit) {
+    const SizeValueType lineLength = tileRegion.GetSize(0);
 
-    fixedImage1->TransformIndexToPhysicalPoint(index, inputPoint);
+    std::vector<RealType> &       movingLine = movingLines[workUnit];
+    std::vector<RealType> &       fixedLine = fixedLines[workUnit];
+    std::vector<InputPointType> & pointLine = pointLines[workUnit];
+    movingLine.resize(std::max<SizeValueType>(movingLine.size(), lineLength));
+    fixedLine.resize(std::max<SizeValueType>(fixedLine.size(), lineLength));
+    pointLine.resize(std::max<SizeValueType>(pointLine.size(), lineLength));
 
-    if (this->m_FixedImageMask1 && !this->m_FixedImageMask1->IsInsideInWorldSpace(inputPoint))
-    {
-      ++ti1;
-      continue;
-    }
+    ScanlineStatistics & stats = tileStats[tile];
+    SizeValueType &      count = tileCounts[tile];
 
-    //    typename Superclass::OutputPointType transformedPoint = this->m_Transform->TransformPoint( inputPoint );
+    FixedIteratorType ti(fixedImage, tileRegion);
 
-    if (this->m_MovingImageMask && !this->m_MovingImageMask->IsInsideInWorldSpace(inputPoint))
+    while (!ti.IsAtEnd())
     {
-      ++ti1;
-      continue;
-    }
+      const typename FixedImageType::IndexType lineIndex = ti.GetIndex();
+      typename FixedImageType::IndexType       nextIndex = lineIndex;
+      ++nextIndex[0];
+
+      // The physical position is affine in the index, so consecutive pixels
+      // of a row are a constant step apart.
+      InputPointType inputPoint;
+      InputPointType nextPoint;
+      fixedImage->TransformIndexToPhysicalPoint(lineIndex, inputPoint);
+      fixedImage->TransformIndexToPhysicalPoint(nextIndex, nextPoint);
+      const typename InputPointType::VectorType pointStep = nextPoint - inputPoint;
+
+      const FixedPixelType * fixedRow = fixedImage->GetBufferPointer() + fixedImage->ComputeOffset(lineIndex);
+
+      if (projectScanlines &&
+          EvaluateScanline(interpolator, inputPoint, pointStep, lineLength, movingLine.data(), IsThreeDimensional()))
+      {
+        stats += AccumulateScanline(fixedRow, movingLine.data(), lineLength);
+        count += lineLength;
 
-    if (this->m_Interpolator1->IsInsideBuffer(inputPoint))
-    {
-      const RealType movingValue = this->m_Interpolator1->Evaluate(inputPoint);
-      const RealType fixedValue = ti1.Get();
-      sff += fixedValue * fixedValue;
-      smm += movingValue * movingValue;
-      sfm += fixedValue * movingValue;
-      if (this->m_SubtractMean)
+        ti.NextLine();
+        continue;
+      }
+
+      SizeValueType numberOfSamples = 0;
+      bool          compacted = false;
+
+      for (SizeValueType k = 0; k < lineLength; ++k, inputPoint += pointStep)
       {
-        sf += fixedValue;
-        sm += movingValue;
+        const bool inside = (!fixedImageMask || fixedImageMask->IsInsideInWorldSpace(inputPoint)) &&
+                            (!this->m_MovingImageMask || this->m_MovingImageMask->IsInsideInWorldSpace(inputPoint)) &&
+                            interpolator->IsInsideBuffer(inputPoint);
+        if (!inside)
+        {
+          if (!compacted)
+          {
+            std::copy(fixedRow, fixedRow + numberOfSamples, fixedLine.begin());
+            compacted = true;
+          }
+          continue;
+        }
+
+        if (compacted)
+        {
+          fixedLine[numberOfSamples] = fixedRow[k];
+        }
+        pointLine[numberOfSamples] = inputPoint;
+        ++numberOfSamples;
       }
-      this->m_NumberOfPixelsCounted++;
+
+      EvaluatePoints(interpolator, pointLine.data(), numberOfSamples, movingLine.data(), IsThreeDimensional());
+
+      if (compacted)
+      {
+        stats += AccumulateScanline(fixedLine.data(), movingLine.data(), numberOfSamples);
+      }
+      else
+      {
+        stats += AccumulateScanline(fixedRow, movingLine.data(), numberOfSamples);
+      }
+      count += numberOfSamples;
+
+      ti.NextLine();
     }
+  });
 
-    ++ti1;
+  ScanlineStatistics stats;
+  this->m_NumberOfPixelsCounted = 0;
+  for (SizeValueType tile = 0; tile < numberOfTiles; ++tile)
+  {
+    stats += tileStats[tile];
+    this->m_NumberOfPixelsCounted += tileCounts[tile];
   }
 
+  AccumulateType sff = stats.sff;
+  AccumulateType smm = stats.smm;
+  AccumulateType sfm = stats.sfm;
+
   if (this->m_SubtractMean && this->m_NumberOfPixelsCounted > 0)
   {
-    sff -= (sf * sf / this->m_NumberOfPixelsCounted);
-    smm -= (sm * sm / this->m_NumberOfPixelsCounted);
-    sfm -= (sf * sm / this->m_NumberOfPixelsCounted);
+    sff -= (stats.sf * stats.sf / this->m_NumberOfPixelsCounted);
+    smm -= (stats.sm * stats.sm / this->m_NumberOfPixelsCounted);
+    sfm -= (stats.sf * stats.sm / this->m_NumberOfPixelsCounted);
   }
 
-  RealType denom = -1.0 * sqrt(sff * smm);
+  const RealType denom = -1.0 * std::sqrt(sff * smm);
 
   if (this->m_NumberOfPixelsCounted > 0 && denom != 0.0)
   {
-    measure1 = sfm / denom;
+    return sfm / denom;
   }
-  else
-  {
-    measure1 = NumericTraits<MeasureType>::Zero;
-  }
-
-
-  // Calculate the measure value between fixed image 2 and the moving image
-
-  FixedIteratorType ti2(fixedImage2, this->GetFixedImageRegion2());
+  return NumericTraits<MeasureType>::Zero;
+}
 
-  MeasureType measure2;
 
-  this->m_NumberOfPixelsCounted = 0;
-
-  this->SetTransformParameters(parameters);
-
-  sff = NumericTraits<AccumulateType>::ZeroValue();
-  smm = NumericTraits<AccumulateType>::ZeroValue();
-  sfm = NumericTraits<AccumulateType>::ZeroValue();
-  sf = NumericTraits<AccumulateType>::ZeroValue();
-  sm = NumericTraits<AccumulateType>::ZeroValue();
+template <typename TFixedImage, typename TMovingImage>
+template <typename TFixedValue>
+typename NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::ScanlineStatistics
+NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::AccumulateScanline(
+  const TFixedValue * fixedValues,
+  const RealType *    movingValues,
+  SizeValueType       length)
+{
+  constexpr SizeValueType BlockLength = 256;
+  constexpr unsigned int  Lanes = 4;
 
-  while (!ti2.IsAtEnd())
+  if (length > BlockLength)
   {
+    const SizeValueType half = length / 2;
+    ScanlineStatistics  stats = AccumulateScanline(fixedValues, movingValues, half);
+    stats += AccumulateScanline(fixedValues + half, movingValues + half, length - half);
+    return stats;
+  }
 
-    index = ti2.GetIndex();
-
-    //    typename Superclass::InputPointType inputPoint;
-    fixedImage2->TransformIndexToPhysicalPoint(index, inputPoint);
+  AccumulateType sff[Lanes] = {};
+  AccumulateType smm[Lanes] = {};
+  AccumulateType sfm[Lanes] = {};
+  AccumulateType sf[Lanes] = {};
+  AccumulateType sm[Lanes] = {};
 
-    if (this->m_FixedImageMask2 && !this->m_FixedImageMask2->IsInsideInWorldSpace(inputPoint))
+  SizeValueType i = 0;
+  for (; i + Lanes <= length; i += Lanes)
+  {
+    for (unsigned int lane = 0; lane < Lanes; ++lane)
     {
-      ++ti2;
-      continue;
+      const AccumulateType f = static_cast<AccumulateType>(fixedValues[i + lane]);
+      const AccumulateType m = static_cast<AccumulateType>(movingValues[i + lane]);
+      sff[lane] += f * f;
+      smm[lane] += m * m;
+      sfm[lane] += f * m;
+      sf[lane] += f;
+      sm[lane] += m;
     }
+  }
+  for (unsigned int lane = 0; i < length; ++i, ++lane)
+  {
+    const AccumulateType f = static_cast<AccumulateType>(fixedValues[i]);
+    const AccumulateType m = static_cast<AccumulateType>(movingValues[i]);
+    sff[lane] += f * f;
+    smm[lane] += m * m;
+    sfm[lane] += f * m;
+    sf[lane] += f;
+    sm[lane] += m;
+  }
 
-    //    typename Superclass::OutputPointType transformedPoint = this->m_Transform->TransformPoint( inputPoint );
+  ScanlineStatistics stats;
+  stats.sff = (sff[0] + sff[1]) + (sff[2] + sff[3]);
+  stats.smm = (smm[0] + smm[1]) + (smm[2] + smm[3]);
+  stats.sfm = (sfm[0] + sfm[1]) + (sfm[2] + sfm[3]);
+  stats.sf = (sf[0] + sf[1]) + (sf[2] + sf[3]);
+  stats.sm = (sm[0] + sm[1]) + (sm[2] + sm[3]);
+  return stats;
+}
 
-    if (this->m_MovingImageMask && !this->m_MovingImageMask->IsInsideInWorldSpace(inputPoint))
-    {
-      ++ti2;
-      continue;
-    }
 
-    if (this->m_Interpolator2->IsInsideBuffer(inputPoint))
-    {
-      const RealType movingValue = this->m_Interpolator2->Evaluate(inputPoint);
-      const RealType fixedValue = ti2.Get();
-      sff += fixedValue * fixedValue;
-      smm += movingValue * movingValue;
-      sfm += fixedValue * movingValue;
-      if (this->m_SubtractMean)
-      {
-        sf += fixedValue;
-        sm += movingValue;
-      }
-      this->m_NumberOfPixelsCounted++;
-    }
+template <typename TFixedImage, typename TMovingImage>
+void
+NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::EvaluatePoints(
+  const InterpolatorType * interpolator,
+  const InputPointType *   points,
+  SizeValueType            numberOfPoints,
+  RealType *               values,
+  std::true_type)
+{
+  using SiddonInterpolatorType =
+    SiddonJacobsRayCastInterpolateImageFunction<MovingImageType, typename Superclass::CoordinateRepresentationType>;
 
-    ++ti2;
+  if (const auto * siddon = dynamic_cast<const SiddonInterpolatorType *>(interpolator))
+  {
+    siddon->EvaluateRays(points, numberOfPoints, values);
+    return;
   }
+  EvaluatePoints(interpolator, points, numberOfPoints, values, std::false_type());
+}
 
-  if (this->m_SubtractMean && this->m_NumberOfPixelsCounted > 0)
+
+template <typename TFixedImage, typename TMovingImage>
+void
+NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::EvaluatePoints(
+  const InterpolatorType * interpolator,
+  const InputPointType *   points,
+  SizeValueType            numberOfPoints,
+  RealType *               values,
+  std::false_type)
+{
+  for (SizeValueType k = 0; k < numberOfPoints; ++k)
   {
-    sff -= (sf * sf / this->m_NumberOfPixelsCounted);
-    smm -= (sm * sm / this->m_NumberOfPixelsCounted);
-    sfm -= (sf * sm / this->m_NumberOfPixelsCounted);
+    values[k] = interpolator->Evaluate(points[k]);
   }
+}
 
-  denom = -1.0 * sqrt(sff * smm);
 
-  if (this->m_NumberOfPixelsCounted > 0 && denom != 0.0)
+template <typename TFixedImage, typename TMovingImage>
+bool
+NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::EvaluateScanline(
+  const InterpolatorType *                    interpolator,
+  const InputPointType &                      firstPoint,
+  const typename InputPointType::VectorType & pointStep,
+  SizeValueType                               length,
+  RealType *                                  values,
+  std::true_type)
+{
+  using RayCastInterpolatorType =
+    ProjectionInterpolateImageFunction<MovingImageType, typename Superclass::CoordinateRepresentationType>;
+
+  const auto * rayCaster = dynamic_cast<const RayCastInterpolatorType *>(interpolator);
+  if (!rayCaster)
   {
-    measure2 = sfm / denom;
+    return false;
   }
-  else
+  rayCaster->EvaluateScanline(firstPoint, pointStep, length, values);
+  return true;
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+void
+NormalizedCorrelationTwoImageToOneImageMetric<TFixedImage, TMovingImage>::UpdateProjectionGeometry(
+  const InterpolatorType * interpolator,
+  std::true_type)
+{
+  using RayCastInterpolatorType =
+    ProjectionInterpolateImageFunction<MovingImageType, typename Superclass::CoordinateRepresentationType>;
+
+  if (const auto * rayCaster = dynamic_cast<const RayCastInterpolatorType *>(interpolator))
   {
-    measure2 = NumericTraits<MeasureType>::Zero;
+    rayCaster->UpdateProjectionGeometry();
   }
-
-  return (measure1 + measure2) / 2.0;
 }
 
 
@@ -0,0 +1,147 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionAlignedImageContainer_h
+#define itkProjectionAlignedImageContainer_h
+
+#include "itkImportImageContainer.h"
+#include "itkProjectionHugePageAllocator.h"
+#include <map>
+#include <type_traits>
+
+namespace itk
+{
+
+/** \class ProjectionAlignedImageContainer
+ * \brief Pixel container allocating its buffer with ProjectionHugePageAllocator.
+ *
+ * This container is set on the images read by the projectors with
+ * Image::SetPixelContainer() before Allocate(). Its buffer is aligned, and
+ * backed by huge pages when UseHugePages is set, which spares the TLB
+ * misses of the rays crossing a large volume. GetHugePageBytes() tells how
+ * much of the buffer the kernel actually placed in huge pages.
+ *
+ * The buffer is zero-filled by the allocator, so the pixels must be of a
+ * trivial type. As with the default container, the pages are placed in
+ * memory by the thread writing them first.
+ *
+ * \sa ProjectionVolumeContext
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TElementIdentifier, typename TElement>
+class ProjectionAlignedImageContainer : public ImportImageContainer<TElementIdentifier, TElement>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionAlignedImageContainer);
+
+  /** Standard class type alias. */
+  using Self = ProjectionAlignedImageContainer;
+  using Superclass = ImportImageContainer<TElementIdentifier, TElement>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  using ElementIdentifier = TElementIdentifier;
+  using Element = TElement;
+
+  static_assert(std::is_trivial<TElement>::value, "The pixels of an aligned container must be of a trivial type");
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionAlignedImageContainer, ImportImageContainer);
+
+  /** Set and get whether the buffers allocated next are backed by huge
+   * pages. */
+  itkSetMacro(UseHugePages, bool);
+  itkGetConstMacro(UseHugePages, bool);
+  itkBooleanMacro(UseHugePages);
+
+  /** Number of bytes of the buffer lying in huge pages. */
+  SizeValueType
+  GetHugePageBytes() const
+  {
+    // GetImportPointer() is not const in the superclass.
+    const TElement * data = const_cast<Self *>(this)->GetImportPointer();
+    return ProjectionHugePageAllocator::GetHugePageBytes(data, this->Capacity() * sizeof(TElement));
+  }
+
+protected:
+  ProjectionAlignedImageContainer() = default;
+
+  ~ProjectionAlignedImageContainer() override
+  {
+    // The destructor of the superclass would delete[] the buffer.
+    this->DeallocateManagedMemory();
+  }
+
+  TElement *
+  AllocateElements(ElementIdentifier size, bool) const override
+  {
+    auto * data =
+      static_cast<TElement *>(ProjectionHugePageAllocator::Allocate(size * sizeof(TElement), m_UseHugePages));
+    if (!data)
+    {
+      throw MemoryAllocationError(__FILE__, __LINE__, "Failed to allocate memory for image.", ITK_LOCATION);
+    }
+    m_Buffers[data] = m_UseHugePages;
+    return data;
+  }
+
+  void
+  DeallocateManagedMemory() override
+  {
+    TElement * data = this->GetImportPointer();
+    if (data && this->GetContainerManageMemory())
+    {
+      const typename BufferMapType::iterator buffer = m_Buffers.find(data);
+      if (buffer != m_Buffers.end())
+      {
+        ProjectionHugePageAllocator::Deallocate(data, this->Capacity() * sizeof(TElement), buffer->second);
+        m_Buffers.erase(buffer);
+        // The superclass only resets the container.
+        this->SetContainerManageMemory(false);
+        Superclass::DeallocateManagedMemory();
+        this->SetContainerManageMemory(true);
+        return;
+      }
+    }
+    Superclass::DeallocateManagedMemory();
+  }
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override
+  {
+    Superclass::PrintSelf(os, indent);
+
+    os << indent << "UseHugePages: " << m_UseHugePages << std::endl;
+    os << indent << "HugePageBytes: " << this->GetHugePageBytes() << std::endl;
+  }
+
+private:
+  // Huge page setting of the buffers allocated and not released yet: while
+  // Reserve() grows the container, the old buffer and the new one coexist.
+  using BufferMapType = std::map<const TElement *, bool>;
+
+  bool                  m_UseHugePages{ false };
+  mutable BufferMapType m_Buffers;
+};
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,251 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionBatchCalculator_h
+#define itkProjectionBatchCalculator_h
+
+#include "itkImage.h"
+#include "itkMultiThreaderBase.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkProjectionThreadPool.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+
+namespace itk
+{
+
+/** \class ProjectionBatchCalculator
+ * \brief Compute the DRRs of a volume for a batch of poses into a single image.
+ *
+ * Training data for learning-based registration is made of thousands of
+ * DRRs of the same volume in different poses. Driving a
+ * RayCastProjectionImageFilter per pose allocates a new image for each
+ * DRR and, from Python, copies each of them into a NumPy array. This
+ * calculator computes all the DRRs in a single call to Compute() and
+ * writes them into one image of DetectorSize[0] x DetectorSize[1] x N
+ * pixels, DRR k being the slice k.
+ *
+ * The poses are given as a float image of 6 x N pixels, each row holding
+ * the parameters of the Euler3DTransform of the volume for one DRR: the
+ * rotations about x, y and z in radians and the translation in mm, as
+ * returned by a registration. The rotations are about the Center, the
+ * center of the volume if UseVolumeCenter is on. The other settings of
+ * the projection geometry are shared by all the DRRs and are those of
+ * ProjectionInterpolateImageFunction. The central axis passes through the
+ * pixel CentralAxisPosition of the detector, its center if
+ * UseDetectorCenter is on. The rows of the DRRs are in the order of the
+ * detector grid, as computed by RayCastProjectionImageFilter without
+ * flipped axes.
+ *
+ * The DRRs are written into the buffer of the Output image if one is set,
+ * which must then have the size of the batch; otherwise a new image is
+ * allocated. Neither the poses nor the output are copied, so from Python
+ * both can be views of float32 NumPy arrays:
+ *
+ * \code
+ * drrs = np.empty((len(poses), height, width), np.float32)
+ * calculator.SetPoses(itk.image_view_from_array(poses))
+ * calculator.SetOutput(itk.image_view_from_array(drrs))
+ * calculator.Compute()
+ * \endcode
+ *
+ * The rays are cast by copies of the Interpolator, by default a
+ * SiddonJacobsRayCastInterpolateImageFunction, made with CreateAnother(),
+ * one per DRR computed at once. The work units take the rows of as many
+ * DRRs as there are work units at a time, so that the threads are busy
+ * whether the batch holds many small DRRs or a few large ones. They run on
+ * the ThreadPool if one is set, otherwise on the MultiThreader. As with
+ * RayCastProjectionImageFilter, the projection angle, the source distance
+ * and the Threshold of the copies are those of the calculator. The copies
+ * share the BrickedVolume of the Interpolator, and its VolumeContext
+ * unless one is set on the calculator; they read the volume from the
+ * context if it is up to date for the input image and Threshold.
+ *
+ * From Python, Compute() releases the global interpreter lock, so that
+ * other Python threads, e.g. those loading training data, run meanwhile.
+ * Its errors are raised as RuntimeError once the lock is taken back.
+ *
+ * \sa RayCastProjectionImageFilter
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputPixel = float>
+class ProjectionBatchCalculator : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionBatchCalculator);
+
+  /** Standard class type alias. */
+  using Self = ProjectionBatchCalculator;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionBatchCalculator, Object);
+
+  using InputImageType = TInputImage;
+  using OutputPixelType = TOutputPixel;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** The DRRs, one per slice */
+  using OutputImageType = Image<OutputPixelType, 3>;
+
+  /** The parameters of the transform of the volume, one pose per row. They
+   * are float, as the images wrapped for Python by default. */
+  using PoseImageType = Image<float, 2>;
+
+  /** Projector casting the rays, and its geometry. */
+  using InterpolatorType = ProjectionInterpolateImageFunction<InputImageType, double>;
+  using DefaultInterpolatorType = SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
+  using TransformType = typename InterpolatorType::TransformType;
+  using PointType = typename TransformType::InputPointType;
+  using VolumeContextType = typename InterpolatorType::VolumeContextType;
+  using BrickedVolumeType = typename InterpolatorType::BrickedVolumeType;
+
+  using DetectorSizeType = Size<2>;
+  using DetectorSpacingType = Vector<double, 2>;
+  using CentralAxisPositionType = FixedArray<double, 2>;
+
+  /** Set and get the volume. */
+  itkSetConstObjectMacro(InputImage, InputImageType);
+  itkGetConstObjectMacro(InputImage, InputImageType);
+
+  /** Set and get the poses of the volume, an image of 6 x N pixels. */
+  itkSetConstObjectMacro(Poses, PoseImageType);
+  itkGetConstObjectMacro(Poses, PoseImageType);
+
+  /** Set and get the image the DRRs are written into. Compute() allocates
+   * it if it is not set; it must be set to nullptr before the DRRs of a
+   * batch of another size are computed into a new image. */
+  itkSetObjectMacro(Output, OutputImageType);
+  itkGetModifiableObjectMacro(Output, OutputImageType);
+
+  /** Set and get the projector casting the rays, copied for each DRR
+   * computed at once. */
+  itkSetObjectMacro(Interpolator, InterpolatorType);
+  itkGetModifiableObjectMacro(Interpolator, InterpolatorType);
+
+  /** Set and get the context holding the data derived from the volume, used
+   * instead of that of the Interpolator. */
+  itkSetObjectMacro(VolumeContext, VolumeContextType);
+  itkGetModifiableObjectMacro(VolumeContext, VolumeContextType);
+
+  /** Set and get the focal point to isocenter distance in mm */
+  itkSetMacro(FocalPointToIsocenterDistance, double);
+  itkGetConstMacro(FocalPointToIsocenterDistance, double);
+
+  /** Set and get the Lianc grantry rotation angle in radians */
+  itkSetMacro(ProjectionAngle, double);
+  itkGetConstMacro(ProjectionAngle, double);
+
+  /** Set and get the Threshold */
+  itkSetMacro(Threshold, double);
+  itkGetConstMacro(Threshold, double);
+
+  /** Set and get the center of rotation of the volume, the isocenter. */
+  itkSetMacro(Center, PointType);
+  itkGetConstReferenceMacro(Center, PointType);
+
+  /** Set and get whether the isocenter is the center of the volume. */
+  itkSetMacro(UseVolumeCenter, bool);
+  itkGetConstMacro(UseVolumeCenter, bool);
+  itkBooleanMacro(UseVolumeCenter);
+
+  /** Set and get the size of the DRRs in pixels. */
+  itkSetMacro(DetectorSize, DetectorSizeType);
+  itkGetConstReferenceMacro(DetectorSize, DetectorSizeType);
+
+  /** Set and get the pixel spacing of the DRRs in mm. */
+  itkSetMacro(DetectorSpacing, DetectorSpacingType);
+  itkGetConstReferenceMacro(DetectorSpacing, DetectorSpacingType);
+
+  /** Set and get the position of the central axis in continuous indices of
+   * the DRRs. */
+  itkSetMacro(CentralAxisPosition, CentralAxisPositionType);
+  itkGetConstReferenceMacro(CentralAxisPosition, CentralAxisPositionType);
+
+  /** Set and get whether the central axis passes through the center of the
+   * DRRs. */
+  itkSetMacro(UseDetectorCenter, bool);
+  itkGetConstMacro(UseDetectorCenter, bool);
+  itkBooleanMacro(UseDetectorCenter);
+
+  /** Set and get the number of work units. With a ThreadPool, there is one
+   * work unit per thread of the pool and this setting is ignored. */
+  itkSetClampMacro(NumberOfWorkUnits, ThreadIdType, 1, ITK_MAX_THREADS);
+  ThreadIdType
+  GetNumberOfWorkUnits() const
+  {
+    return m_ThreadPool ? m_ThreadPool->GetNumberOfWorkUnits() : m_NumberOfWorkUnits;
+  }
+
+  /** Set and get the multithreader running the work units. */
+  itkSetObjectMacro(MultiThreader, MultiThreaderBase);
+  itkGetModifiableObjectMacro(MultiThreader, MultiThreaderBase);
+
+  /** Set and get the persistent pool running the work units, if any. */
+  itkSetObjectMacro(ThreadPool, ProjectionThreadPool);
+  itkGetModifiableObjectMacro(ThreadPool, ProjectionThreadPool);
+
+  /** Compute the DRRs of all the poses into the Output. */
+  void
+  Compute();
+
+protected:
+  ProjectionBatchCalculator();
+  ~ProjectionBatchCalculator() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  typename InputImageType::ConstPointer m_InputImage;
+  typename PoseImageType::ConstPointer  m_Poses;
+  typename OutputImageType::Pointer     m_Output;
+  typename InterpolatorType::Pointer    m_Interpolator;
+  typename VolumeContextType::Pointer   m_VolumeContext;
+
+  double m_FocalPointToIsocenterDistance;
+  double m_ProjectionAngle;
+  double m_Threshold;
+
+  PointType m_Center;
+  bool      m_UseVolumeCenter;
+
+  DetectorSizeType        m_DetectorSize;
+  DetectorSpacingType     m_DetectorSpacing;
+  CentralAxisPositionType m_CentralAxisPosition;
+  bool                    m_UseDetectorCenter;
+
+  ThreadIdType                  m_NumberOfWorkUnits;
+  MultiThreaderBase::Pointer    m_MultiThreader;
+  ProjectionThreadPool::Pointer m_ThreadPool;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkProjectionBatchCalculator.hxx"
+#endif
+
+#endif
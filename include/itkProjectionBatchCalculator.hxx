@@ -0,0 +1,261 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionBatchCalculator_hxx
+#define itkProjectionBatchCalculator_hxx
+
+#include "itkProjectionBatchCalculator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputPixel>
+ProjectionBatchCalculator<TInputImage, TOutputPixel>::ProjectionBatchCalculator()
+{
+  m_Interpolator = DefaultInterpolatorType::New();
+
+  m_FocalPointToIsocenterDistance = 1000.;
+  m_ProjectionAngle = 0.;
+  m_Threshold = 0.;
+
+  m_Center.Fill(0.0);
+  m_UseVolumeCenter = true;
+
+  m_DetectorSize.Fill(512);
+  m_DetectorSpacing.Fill(0.51);
+  m_CentralAxisPosition.Fill(0.0);
+  m_UseDetectorCenter = true;
+
+  m_MultiThreader = MultiThreaderBase::New();
+  m_NumberOfWorkUnits = m_MultiThreader->GetNumberOfWorkUnits();
+}
+
+
+template <typename TInputImage, typename TOutputPixel>
+void
+ProjectionBatchCalculator<TInputImage, TOutputPixel>::Compute()
+{
+  if (!m_InputImage)
+  {
+    itkExceptionMacro(<< "InputImage is not present");
+  }
+  if (!m_Poses)
+  {
+    itkExceptionMacro(<< "Poses are not present");
+  }
+  if (!m_Interpolator)
+  {
+    itkExceptionMacro(<< "Interpolator is not present");
+  }
+
+  const typename PoseImageType::SizeType poseSize = m_Poses->GetBufferedRegion().GetSize();
+  if (poseSize[0] != TransformType::ParametersDimension)
+  {
+    itkExceptionMacro(<< "The poses must have " << TransformType::ParametersDimension << " parameters, not "
+                      << poseSize[0]);
+  }
+  const SizeValueType numberOfPoses = poseSize[1];
+  const SizeValueType width = m_DetectorSize[0];
+  const SizeValueType height = m_DetectorSize[1];
+
+  // The DRRs are written into the given image, or a new one.
+  typename OutputImageType::SizeType outputSize;
+  outputSize[0] = width;
+  outputSize[1] = height;
+  outputSize[2] = numberOfPoses;
+  if (!m_Output)
+  {
+    m_Output = OutputImageType::New();
+    m_Output->SetRegions(outputSize);
+    m_Output->Allocate();
+  }
+  else if (m_Output->GetBufferedRegion().GetSize() != outputSize)
+  {
+    itkExceptionMacro(<< "The Output must have a size of " << outputSize << " to hold the DRRs, not "
+                      << m_Output->GetBufferedRegion().GetSize());
+  }
+
+  // Position of the pixels of the DRRs in the projection geometry
+  double detectorOrigin[2];
+  for (unsigned int i = 0; i < 2; ++i)
+  {
+    const double centralAxis =
+      m_UseDetectorCenter ? (static_cast<double>(m_DetectorSize[i]) - 1.0) / 2.0 : m_CentralAxisPosition[i];
+    detectorOrigin[i] = -m_DetectorSpacing[i] * centralAxis;
+  }
+
+  typename OutputImageType::SpacingType outputSpacing;
+  typename OutputImageType::PointType   outputOrigin;
+  outputSpacing[0] = m_DetectorSpacing[0];
+  outputSpacing[1] = m_DetectorSpacing[1];
+  outputSpacing[2] = 1.0;
+  outputOrigin[0] = detectorOrigin[0];
+  outputOrigin[1] = detectorOrigin[1];
+  outputOrigin[2] = 0.0;
+  m_Output->SetSpacing(outputSpacing);
+  m_Output->SetOrigin(outputOrigin);
+
+  PointType center = m_Center;
+  if (m_UseVolumeCenter)
+  {
+    const typename InputImageType::RegionType region = m_InputImage->GetLargestPossibleRegion();
+    ContinuousIndex<double, ImageDimension>   centerIndex;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      // The voxel i spans [i, i+1) in the projection geometry.
+      centerIndex[i] = region.GetIndex(i) + static_cast<double>(region.GetSize(i)) / 2.0;
+    }
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      center[i] = m_InputImage->GetOrigin()[i] + m_InputImage->GetSpacing()[i] * centerIndex[i];
+    }
+  }
+
+  // The copies of the Interpolator read the volume as it does.
+  VolumeContextType * volumeContext =
+    m_VolumeContext ? m_VolumeContext.GetPointer() : m_Interpolator->GetModifiableVolumeContext();
+  if (volumeContext)
+  {
+    volumeContext->Update();
+  }
+  BrickedVolumeType * brickedVolume = m_Interpolator->GetModifiableBrickedVolume();
+
+  // One interpolator per DRR computed at once
+  const ThreadIdType  numberOfWorkUnits = this->GetNumberOfWorkUnits();
+  const SizeValueType numberOfConcurrentPoses = std::min<SizeValueType>(numberOfPoses, numberOfWorkUnits);
+
+  std::vector<typename InterpolatorType::Pointer> interpolators(numberOfConcurrentPoses);
+  std::vector<typename TransformType::Pointer>    transforms(numberOfConcurrentPoses);
+  for (SizeValueType g = 0; g < numberOfConcurrentPoses; ++g)
+  {
+    const LightObject::Pointer another = m_Interpolator->CreateAnother();
+    interpolators[g] = dynamic_cast<InterpolatorType *>(another.GetPointer());
+    if (!interpolators[g])
+    {
+      itkExceptionMacro(<< "The Interpolator can not be copied");
+    }
+    transforms[g] = TransformType::New();
+    transforms[g]->SetComputeZYX(true);
+    transforms[g]->SetCenter(center);
+
+    interpolators[g]->SetInputImage(m_InputImage);
+    interpolators[g]->SetTransform(transforms[g]);
+    interpolators[g]->SetProjectionAngle(m_ProjectionAngle);
+    interpolators[g]->SetFocalPointToIsocenterDistance(m_FocalPointToIsocenterDistance);
+    interpolators[g]->SetThreshold(m_Threshold);
+    interpolators[g]->SetVolumeContext(volumeContext);
+    interpolators[g]->SetBrickedVolume(brickedVolume);
+  }
+
+  using RayOutputType = typename InterpolatorType::OutputType;
+
+  typename InterpolatorType::VectorType pointStep;
+  pointStep.Fill(0.0);
+  pointStep[0] = m_DetectorSpacing[0];
+
+  const typename PoseImageType::PixelType * poses = m_Poses->GetBufferPointer();
+  OutputPixelType *                         output = m_Output->GetBufferPointer();
+
+  for (SizeValueType firstPose = 0; firstPose < numberOfPoses; firstPose += numberOfConcurrentPoses)
+  {
+    const SizeValueType numberOfGroupPoses = std::min(numberOfConcurrentPoses, numberOfPoses - firstPose);
+
+    // The inverse transforms are computed here, once, rather than by the
+    // first ray of each thread.
+    for (SizeValueType g = 0; g < numberOfGroupPoses; ++g)
+    {
+      typename TransformType::ParametersType parameters(TransformType::ParametersDimension);
+      for (unsigned int p = 0; p < TransformType::ParametersDimension; ++p)
+      {
+        parameters[p] = poses[(firstPose + g) * TransformType::ParametersDimension + p];
+      }
+      transforms[g]->SetParameters(parameters);
+      interpolators[g]->Initialize();
+    }
+
+    // The work units take the next row of the DRRs of the group until
+    // there is none left.
+    const SizeValueType        numberOfRows = numberOfGroupPoses * height;
+    std::atomic<SizeValueType> nextRow{ 0 };
+    auto                       workUnit = [&](SizeValueType) {
+      std::vector<RayOutputType> values(width);
+      for (SizeValueType row = nextRow++; row < numberOfRows; row = nextRow++)
+      {
+        const SizeValueType g = row / height;
+        const SizeValueType j = row % height;
+
+        PointType rowPoint;
+        rowPoint[0] = detectorOrigin[0];
+        rowPoint[1] = detectorOrigin[1] + m_DetectorSpacing[1] * static_cast<double>(j);
+        rowPoint[2] = -m_FocalPointToIsocenterDistance;
+        interpolators[g]->EvaluateScanline(rowPoint, pointStep, width, values.data());
+
+        OutputPixelType * out = output + ((firstPose + g) * height + j) * width;
+        for (SizeValueType k = 0; k < width; ++k)
+        {
+          out[k] = static_cast<OutputPixelType>(values[k]);
+        }
+      }
+    };
+
+    if (m_ThreadPool)
+    {
+      m_ThreadPool->Run(numberOfWorkUnits, workUnit);
+    }
+    else
+    {
+      m_MultiThreader->SetNumberOfWorkUnits(numberOfWorkUnits);
+      m_MultiThreader->ParallelizeArray(0, numberOfWorkUnits, workUnit, nullptr);
+    }
+  }
+
+  m_Output->Modified();
+}
+
+
+template <typename TInputImage, typename TOutputPixel>
+void
+ProjectionBatchCalculator<TInputImage, TOutputPixel>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "InputImage: " << m_InputImage.GetPointer() << std::endl;
+  os << indent << "Poses: " << m_Poses.GetPointer() << std::endl;
+  os << indent << "Output: " << m_Output.GetPointer() << std::endl;
+  os << indent << "Interpolator: " << m_Interpolator.GetPointer() << std::endl;
+  os << indent << "VolumeContext: " << m_VolumeContext.GetPointer() << std::endl;
+  os << indent << "FocalPointToIsocenterDistance: " << m_FocalPointToIsocenterDistance << std::endl;
+  os << indent << "ProjectionAngle: " << m_ProjectionAngle << std::endl;
+  os << indent << "Threshold: " << m_Threshold << std::endl;
+  os << indent << "Center: " << m_Center << std::endl;
+  os << indent << "UseVolumeCenter: " << m_UseVolumeCenter << std::endl;
+  os << indent << "DetectorSize: " << m_DetectorSize << std::endl;
+  os << indent << "DetectorSpacing: " << m_DetectorSpacing << std::endl;
+  os << indent << "CentralAxisPosition: " << m_CentralAxisPosition << std::endl;
+  os << indent << "UseDetectorCenter: " << m_UseDetectorCenter << std::endl;
+  os << indent << "NumberOfWorkUnits: " << m_NumberOfWorkUnits << std::endl;
+  os << indent << "MultiThreader: " << m_MultiThreader.GetPointer() << std::endl;
+  os << indent << "ThreadPool: " << m_ThreadPool.GetPointer() << std::endl;
+}
+
+} // namespace itk
+
+#endif
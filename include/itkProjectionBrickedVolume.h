@@ -0,0 +1,264 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionBrickedVolume_h
+#define itkProjectionBrickedVolume_h
+
+#include "itkImage.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include <atomic>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ProjectionBrickedVolume
+ * \brief Thresholded volume stored out of core in bricks, read on demand by the projectors.
+ *
+ * A high resolution CT cast to float may not fit in memory next to the
+ * other data of a registration. This object stores the voxel values minus
+ * the Threshold, clamped to zero, as cubic bricks of BrickSize voxels in a
+ * backing file, and keeps the bricks read last in memory, up to
+ * MemoryLimit bytes. The least recently used bricks are dropped first.
+ *
+ * Update() writes the bricks, one layer of bricks at a time: it requests
+ * the slab of the input image covering the layer from the pipeline, so
+ * that an input read by a streaming ImageFileReader is never loaded whole.
+ * The bricks where all the voxels are below the Threshold are not stored;
+ * GetBrick() returns nullptr for them.
+ *
+ * The backing file is BackingFileName, or an anonymous temporary file if
+ * it is empty, and it is removed when the volume is destroyed.
+ *
+ * A projection interpolator given a bricked volume with
+ * ProjectionInterpolateImageFunction::SetBrickedVolume() reads the voxels
+ * from it instead of the buffer of its input image, which then only needs
+ * its geometry. A registration on such a volume is given a moving image
+ * holding the information of the CT but no pixels.
+ *
+ * GetBrick() may be called from several threads. A brick stays valid as
+ * long as its pointer is held, even if it is dropped from the cache
+ * meanwhile, so the memory in use may exceed MemoryLimit by the bricks
+ * being read by the threads.
+ *
+ * \sa ProjectionVolumeContext, SiddonJacobsRayCastInterpolateImageFunction
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage>
+class ProjectionBrickedVolume : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionBrickedVolume);
+
+  /** Standard class type alias. */
+  using Self = ProjectionBrickedVolume;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionBrickedVolume, Object);
+
+  using InputImageType = TInputImage;
+  using InputPixelType = typename InputImageType::PixelType;
+  using RegionType = typename InputImageType::RegionType;
+  using SizeType = typename InputImageType::SizeType;
+  using IndexType = typename InputImageType::IndexType;
+  using SpacingType = typename InputImageType::SpacingType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Thresholded voxels of a brick, x fastest, and a shared pointer to it */
+  using BrickType = std::vector<float>;
+  using BrickPointer = std::shared_ptr<const BrickType>;
+
+  /** Set and get the volume. */
+  itkSetConstObjectMacro(InputImage, InputImageType);
+  itkGetConstObjectMacro(InputImage, InputImageType);
+
+  /** Set and get the threshold below which the voxels are ignored. */
+  itkSetMacro(Threshold, double);
+  itkGetConstMacro(Threshold, double);
+
+  /** Set and get the number of voxels along each side of the bricks. */
+  itkSetClampMacro(BrickSize, unsigned int, 1, 1024);
+  itkGetConstMacro(BrickSize, unsigned int);
+
+  /** Set and get the memory taken by the cached bricks, in bytes. */
+  itkSetMacro(MemoryLimit, SizeValueType);
+  itkGetConstMacro(MemoryLimit, SizeValueType);
+
+  /** Set and get the backing file of the bricks. */
+  itkSetStringMacro(BackingFileName);
+  itkGetStringMacro(BackingFileName);
+
+  /** Write the bricks if the volume or the settings changed since the last
+   * update. */
+  void
+  Update();
+
+  /** Whether the bricks match the current volume and settings. */
+  bool
+  IsUpToDate() const;
+
+  /** Size and spacing of the volume, valid after Update(). */
+  itkGetConstReferenceMacro(Size, SizeType);
+  itkGetConstReferenceMacro(Spacing, SpacingType);
+
+  /** Number of bricks along each axis. */
+  itkGetConstReferenceMacro(BrickGridSize, SizeType);
+
+  /** Number of the brick holding a voxel, given by its index relative to
+   * the start of the largest possible region of the volume. */
+  SizeValueType
+  ComputeBrickNumber(const IndexType & index) const
+  {
+    SizeValueType number = 0;
+    for (unsigned int i = ImageDimension; i > 0; --i)
+    {
+      number = number * m_BrickGridSize[i - 1] + static_cast<SizeValueType>(index[i - 1]) / m_BrickSize;
+    }
+    return number;
+  }
+
+  /** Position of a voxel in its brick. */
+  SizeValueType
+  ComputeOffsetInBrick(const IndexType & index) const
+  {
+    SizeValueType offset = 0;
+    for (unsigned int i = ImageDimension; i > 0; --i)
+    {
+      offset = offset * m_BrickSize + static_cast<SizeValueType>(index[i - 1]) % m_BrickSize;
+    }
+    return offset;
+  }
+
+  /** Voxels of a brick, read from the backing file unless it is cached, or
+   * nullptr if all its voxels are below the Threshold. */
+  BrickPointer
+  GetBrick(SizeValueType number) const;
+
+  /** Drop all the bricks from the cache. */
+  void
+  ClearCache();
+
+  /** Number of bricks of the volume and number of those stored in the
+   * backing file. */
+  SizeValueType
+  GetNumberOfBricks() const
+  {
+    return m_BrickSlots.size();
+  }
+  itkGetConstMacro(NumberOfStoredBricks, SizeValueType);
+
+  /** Memory taken by the cached bricks, in bytes. */
+  SizeValueType
+  GetCachedMemorySize() const;
+
+  /** Number of bricks read from the backing file and number of requests
+   * served by the cache since the last update. */
+  SizeValueType
+  GetNumberOfBrickReads() const
+  {
+    return m_NumberOfBrickReads;
+  }
+  SizeValueType
+  GetNumberOfCacheHits() const
+  {
+    return m_NumberOfCacheHits;
+  }
+
+protected:
+  ProjectionBrickedVolume();
+  ~ProjectionBrickedVolume() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  void
+  OpenBackingFile();
+
+  void
+  CloseBackingFile();
+
+  /** Number of voxels of a brick */
+  SizeValueType
+  GetBrickVoxels() const;
+
+  BrickPointer
+  ReadBrick(OffsetValueType slot) const;
+
+  int
+  SeekBackingFile(OffsetValueType position) const;
+
+  typename InputImageType::ConstPointer m_InputImage;
+
+  double        m_Threshold;
+  unsigned int  m_BrickSize;
+  SizeValueType m_MemoryLimit;
+  std::string   m_BackingFileName;
+
+  SizeType    m_Size;
+  SpacingType m_Spacing;
+  SizeType    m_BrickGridSize;
+
+  // Position of each brick in the backing file, in bricks, or -1 for the
+  // bricks not stored
+  std::vector<OffsetValueType> m_BrickSlots;
+  SizeValueType                m_NumberOfStoredBricks;
+
+  // Backing file open, and its name if it is to be removed
+  std::FILE *        m_BackingFile;
+  std::string        m_OpenFileName;
+  mutable std::mutex m_FileMutex;
+
+  // Cached bricks, the most recently used first
+  struct CacheEntry
+  {
+    BrickPointer                       Brick;
+    std::list<SizeValueType>::iterator Position;
+  };
+  mutable std::mutex                                    m_CacheMutex;
+  mutable std::list<SizeValueType>                      m_LeastRecentlyUsed;
+  mutable std::unordered_map<SizeValueType, CacheEntry> m_Cache;
+
+  mutable std::atomic<SizeValueType> m_NumberOfBrickReads;
+  mutable std::atomic<SizeValueType> m_NumberOfCacheHits;
+
+  TimeStamp m_UpdateTime;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkProjectionBrickedVolume.hxx"
+#endif
+
+#endif
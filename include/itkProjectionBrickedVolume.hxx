@@ -0,0 +1,347 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionBrickedVolume_hxx
+#define itkProjectionBrickedVolume_hxx
+
+#include "itkProjectionBrickedVolume.h"
+
+#include "itkImageScanlineConstIterator.h"
+#include <algorithm>
+
+namespace itk
+{
+
+template <typename TInputImage>
+ProjectionBrickedVolume<TInputImage>::ProjectionBrickedVolume()
+{
+  m_Threshold = 0.0;
+  m_BrickSize = 32;
+  m_MemoryLimit = 256 * 1024 * 1024;
+
+  m_Size.Fill(0);
+  m_Spacing.Fill(1.0);
+  m_BrickGridSize.Fill(0);
+  m_NumberOfStoredBricks = 0;
+
+  m_BackingFile = nullptr;
+  m_NumberOfBrickReads = 0;
+  m_NumberOfCacheHits = 0;
+}
+
+
+template <typename TInputImage>
+ProjectionBrickedVolume<TInputImage>::~ProjectionBrickedVolume()
+{
+  this->CloseBackingFile();
+}
+
+
+template <typename TInputImage>
+bool
+ProjectionBrickedVolume<TInputImage>::IsUpToDate() const
+{
+  return m_InputImage && m_BackingFile && m_UpdateTime.GetMTime() > this->GetMTime() &&
+         m_UpdateTime.GetMTime() >= m_InputImage->GetMTime();
+}
+
+
+template <typename TInputImage>
+void
+ProjectionBrickedVolume<TInputImage>::Update()
+{
+  if (!m_InputImage)
+  {
+    itkExceptionMacro(<< "InputImage is not present");
+  }
+  if (this->IsUpToDate())
+  {
+    return;
+  }
+
+  // The slabs of the volume are requested from the pipeline, as
+  // StreamingImageFilter does.
+  auto * input = const_cast<InputImageType *>(m_InputImage.GetPointer());
+  input->UpdateOutputInformation();
+
+  const RegionType    largest = input->GetLargestPossibleRegion();
+  const IndexType     start = largest.GetIndex();
+  const unsigned int  last = ImageDimension - 1;
+  const SizeValueType brickSize = m_BrickSize;
+  SizeValueType       bricksPerLayer = 1;
+  SizeValueType       numberOfBricks = 1;
+  m_Size = largest.GetSize();
+  m_Spacing = input->GetSpacing();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    m_BrickGridSize[i] = (m_Size[i] + brickSize - 1) / brickSize;
+    numberOfBricks *= m_BrickGridSize[i];
+    if (i < last)
+    {
+      bricksPerLayer *= m_BrickGridSize[i];
+    }
+  }
+
+  this->ClearCache();
+  this->CloseBackingFile();
+  this->OpenBackingFile();
+  m_BrickSlots.assign(numberOfBricks, -1);
+  m_NumberOfStoredBricks = 0;
+  m_NumberOfBrickReads = 0;
+  m_NumberOfCacheHits = 0;
+
+  const double threshold = m_Threshold;
+  BrickType    brick(this->GetBrickVoxels());
+  for (SizeValueType layer = 0; layer < m_BrickGridSize[last]; ++layer)
+  {
+    RegionType slab = largest;
+    slab.SetIndex(last, start[last] + static_cast<IndexValueType>(layer * brickSize));
+    slab.SetSize(last, std::min(brickSize, static_cast<SizeValueType>(m_Size[last]) - layer * brickSize));
+
+    input->SetRequestedRegion(slab);
+    input->PropagateRequestedRegion();
+    input->UpdateOutputData();
+    if (!input->GetBufferedRegion().IsInside(slab))
+    {
+      itkExceptionMacro(<< "The input image does not hold the requested slab " << slab);
+    }
+
+    for (SizeValueType k = 0; k < bricksPerLayer; ++k)
+    {
+      // Region of the brick, clipped to the volume
+      RegionType    region = slab;
+      SizeValueType rest = k;
+      for (unsigned int i = 0; i < last; ++i)
+      {
+        const SizeValueType brickIndex = rest % m_BrickGridSize[i];
+        rest /= m_BrickGridSize[i];
+        region.SetIndex(i, start[i] + static_cast<IndexValueType>(brickIndex * brickSize));
+        region.SetSize(i, std::min(brickSize, static_cast<SizeValueType>(m_Size[i]) - brickIndex * brickSize));
+      }
+
+      std::fill(brick.begin(), brick.end(), 0.0f);
+      bool occupied = false;
+
+      ImageScanlineConstIterator<InputImageType> it(input, region);
+      while (!it.IsAtEnd())
+      {
+        IndexType index = it.GetIndex();
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          index[i] -= start[i];
+        }
+        SizeValueType offset = this->ComputeOffsetInBrick(index);
+        while (!it.IsAtEndOfLine())
+        {
+          const double value = static_cast<double>(it.Get()) - threshold;
+          if (value > 0)
+          {
+            brick[offset] = static_cast<float>(value);
+            occupied = true;
+          }
+          ++offset;
+          ++it;
+        }
+        it.NextLine();
+      }
+
+      // The bricks are appended to the file, those below the threshold
+      // are not stored.
+      if (occupied)
+      {
+        if (std::fwrite(brick.data(), sizeof(float), brick.size(), m_BackingFile) != brick.size())
+        {
+          itkExceptionMacro(<< "Cannot write to the backing file " << m_OpenFileName);
+        }
+        m_BrickSlots[layer * bricksPerLayer + k] = static_cast<OffsetValueType>(m_NumberOfStoredBricks++);
+      }
+    }
+  }
+  std::fflush(m_BackingFile);
+  input->SetRequestedRegionToLargestPossibleRegion();
+
+  m_UpdateTime.Modified();
+}
+
+
+template <typename TInputImage>
+typename ProjectionBrickedVolume<TInputImage>::BrickPointer
+ProjectionBrickedVolume<TInputImage>::GetBrick(SizeValueType number) const
+{
+  if (number >= m_BrickSlots.size() || m_BrickSlots[number] < 0)
+  {
+    return nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_CacheMutex);
+    const auto                  found = m_Cache.find(number);
+    if (found != m_Cache.end())
+    {
+      m_LeastRecentlyUsed.splice(m_LeastRecentlyUsed.begin(), m_LeastRecentlyUsed, found->second.Position);
+      ++m_NumberOfCacheHits;
+      return found->second.Brick;
+    }
+  }
+
+  // The file is read without holding the cache, so that the other threads
+  // keep finding their bricks meanwhile.
+  const BrickPointer brick = this->ReadBrick(m_BrickSlots[number]);
+  ++m_NumberOfBrickReads;
+
+  std::lock_guard<std::mutex> lock(m_CacheMutex);
+  const auto                  found = m_Cache.find(number);
+  if (found != m_Cache.end())
+  {
+    // Read by another thread in the meantime
+    m_LeastRecentlyUsed.splice(m_LeastRecentlyUsed.begin(), m_LeastRecentlyUsed, found->second.Position);
+    return found->second.Brick;
+  }
+  m_LeastRecentlyUsed.push_front(number);
+  m_Cache[number] = CacheEntry{ brick, m_LeastRecentlyUsed.begin() };
+
+  // Drop the least recently used bricks beyond the limit, always keeping
+  // the brick just read.
+  const SizeValueType brickBytes = this->GetBrickVoxels() * sizeof(float);
+  while (m_Cache.size() > 1 && m_Cache.size() * brickBytes > m_MemoryLimit)
+  {
+    m_Cache.erase(m_LeastRecentlyUsed.back());
+    m_LeastRecentlyUsed.pop_back();
+  }
+  return brick;
+}
+
+
+template <typename TInputImage>
+void
+ProjectionBrickedVolume<TInputImage>::ClearCache()
+{
+  std::lock_guard<std::mutex> lock(m_CacheMutex);
+  m_Cache.clear();
+  m_LeastRecentlyUsed.clear();
+}
+
+
+template <typename TInputImage>
+SizeValueType
+ProjectionBrickedVolume<TInputImage>::GetCachedMemorySize() const
+{
+  std::lock_guard<std::mutex> lock(m_CacheMutex);
+  return m_Cache.size() * this->GetBrickVoxels() * sizeof(float);
+}
+
+
+template <typename TInputImage>
+SizeValueType
+ProjectionBrickedVolume<TInputImage>::GetBrickVoxels() const
+{
+  SizeValueType voxels = 1;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    voxels *= m_BrickSize;
+  }
+  return voxels;
+}
+
+
+template <typename TInputImage>
+typename ProjectionBrickedVolume<TInputImage>::BrickPointer
+ProjectionBrickedVolume<TInputImage>::ReadBrick(OffsetValueType slot) const
+{
+  auto brick = std::make_shared<BrickType>(this->GetBrickVoxels());
+
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+  if (this->SeekBackingFile(slot * static_cast<OffsetValueType>(brick->size() * sizeof(float))) != 0 ||
+      std::fread(brick->data(), sizeof(float), brick->size(), m_BackingFile) != brick->size())
+  {
+    itkExceptionMacro(<< "Cannot read brick " << slot << " from the backing file");
+  }
+  return brick;
+}
+
+
+template <typename TInputImage>
+int
+ProjectionBrickedVolume<TInputImage>::SeekBackingFile(OffsetValueType position) const
+{
+#if defined(_WIN32)
+  return _fseeki64(m_BackingFile, position, SEEK_SET);
+#else
+  return fseeko(m_BackingFile, static_cast<off_t>(position), SEEK_SET);
+#endif
+}
+
+
+template <typename TInputImage>
+void
+ProjectionBrickedVolume<TInputImage>::OpenBackingFile()
+{
+  if (m_BackingFileName.empty())
+  {
+    // Removed by the system when closed
+    m_BackingFile = std::tmpfile();
+  }
+  else
+  {
+    m_BackingFile = std::fopen(m_BackingFileName.c_str(), "w+b");
+    m_OpenFileName = m_BackingFileName;
+  }
+  if (!m_BackingFile)
+  {
+    itkExceptionMacro(<< "Cannot create the backing file " << m_BackingFileName);
+  }
+}
+
+
+template <typename TInputImage>
+void
+ProjectionBrickedVolume<TInputImage>::CloseBackingFile()
+{
+  if (m_BackingFile)
+  {
+    std::fclose(m_BackingFile);
+    m_BackingFile = nullptr;
+  }
+  if (!m_OpenFileName.empty())
+  {
+    std::remove(m_OpenFileName.c_str());
+    m_OpenFileName.clear();
+  }
+}
+
+
+template <typename TInputImage>
+void
+ProjectionBrickedVolume<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "InputImage: " << m_InputImage.GetPointer() << std::endl;
+  os << indent << "Threshold: " << m_Threshold << std::endl;
+  os << indent << "BrickSize: " << m_BrickSize << std::endl;
+  os << indent << "MemoryLimit: " << m_MemoryLimit << std::endl;
+  os << indent << "BackingFileName: " << m_BackingFileName << std::endl;
+  os << indent << "BrickGridSize: " << m_BrickGridSize << std::endl;
+  os << indent << "NumberOfStoredBricks: " << m_NumberOfStoredBricks << " of " << m_BrickSlots.size() << std::endl;
+  os << indent << "CachedMemorySize: " << this->GetCachedMemorySize() << std::endl;
+  os << indent << "NumberOfBrickReads: " << m_NumberOfBrickReads << std::endl;
+  os << indent << "NumberOfCacheHits: " << m_NumberOfCacheHits << std::endl;
+}
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,253 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionHugePageAllocator_h
+#define itkProjectionHugePageAllocator_h
+
+#include "itkIntTypes.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#if defined(__linux__)
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+namespace itk
+{
+
+/** \class ProjectionHugePageAllocator
+ * \brief Aligned allocation of large buffers, optionally on huge pages.
+ *
+ * The rays of a projector read the volume at addresses spread over the
+ * whole buffer, and with 4 kB pages nearly every step of a ray misses the
+ * TLB once the volume exceeds a few megabytes. Backing the buffer with huge
+ * pages (2 MB on x86-64) divides the number of pages by 512.
+ *
+ * On Linux, the buffers are mapped anonymously and aligned on a huge page
+ * when huge pages are requested, on a page otherwise. A huge page buffer is
+ * taken from the reserved hugetlbfs pages of GetHugePageSize() bytes
+ * (MAP_HUGETLB) if there are enough of them; otherwise it is advised for
+ * transparent huge pages (madvise MADV_HUGEPAGE), which the kernel may or
+ * may not grant. Elsewhere the buffers are only aligned on Alignment bytes.
+ *
+ * Since the kernel may fall back to small pages silently,
+ * GetHugePageBytes() reports how many bytes of a buffer actually lie in
+ * huge pages, once the buffer has been written.
+ *
+ * \sa ProjectionAlignedImageContainer
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+class ProjectionHugePageAllocator
+{
+public:
+  /** Alignment of the buffers, in bytes, at least a cache line. */
+  static constexpr SizeValueType Alignment = 64;
+
+  /** Allocate a zero-filled buffer of the given size. The pages are only
+   * placed in memory when first written, by the NUMA node of the writing
+   * thread. Returns nullptr on failure. */
+  static void *
+  Allocate(SizeValueType size, bool hugePages)
+  {
+    if (size == 0)
+    {
+      size = 1;
+    }
+#if defined(__linux__)
+    const SizeValueType pageSize = hugePages ? GetHugePageSize() : static_cast<SizeValueType>(sysconf(_SC_PAGESIZE));
+    const SizeValueType length = RoundUp(size, pageSize);
+
+    if (hugePages)
+    {
+#  if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+      // The page size is requested explicitly, as the default hugetlbfs
+      // page size (Hugepagesize in /proc/meminfo) may be larger, e.g. 1 GB,
+      // and Deallocate() unmaps whole pages of GetHugePageSize() bytes.
+      const int hugePageFlags = MAP_HUGETLB | (Log2(pageSize) << MAP_HUGE_SHIFT);
+      void *    reserved =
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | hugePageFlags, -1, 0);
+      if (reserved != MAP_FAILED)
+      {
+        return reserved;
+      }
+#  endif
+      // Map one huge page more and trim the ends, so that the buffer starts
+      // on a huge page boundary.
+      void * mapping = mmap(nullptr, length + pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mapping == MAP_FAILED)
+      {
+        return nullptr;
+      }
+      const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(mapping);
+      const std::uintptr_t aligned = RoundUp(start, pageSize);
+      if (aligned > start)
+      {
+        munmap(mapping, aligned - start);
+      }
+      munmap(reinterpret_cast<void *>(aligned + length), start + pageSize - aligned);
+      void * buffer = reinterpret_cast<void *>(aligned);
+#  if defined(MADV_HUGEPAGE)
+      madvise(buffer, length, MADV_HUGEPAGE);
+#  endif
+      return buffer;
+    }
+
+    void * buffer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return buffer == MAP_FAILED ? nullptr : buffer;
+#else
+    (void)hugePages;
+    // The address returned by calloc is kept just before the aligned buffer.
+    void * block = std::calloc(1, size + Alignment + sizeof(void *));
+    if (!block)
+    {
+      return nullptr;
+    }
+    const std::uintptr_t aligned = RoundUp(reinterpret_cast<std::uintptr_t>(block) + sizeof(void *), Alignment);
+    reinterpret_cast<void **>(aligned)[-1] = block;
+    return reinterpret_cast<void *>(aligned);
+#endif
+  }
+
+  /** Release a buffer returned by Allocate() with the same size and
+   * hugePages. */
+  static void
+  Deallocate(void * buffer, SizeValueType size, bool hugePages)
+  {
+    if (!buffer)
+    {
+      return;
+    }
+#if defined(__linux__)
+    if (size == 0)
+    {
+      size = 1;
+    }
+    const SizeValueType pageSize = hugePages ? GetHugePageSize() : static_cast<SizeValueType>(sysconf(_SC_PAGESIZE));
+    munmap(buffer, RoundUp(size, pageSize));
+#else
+    (void)size;
+    (void)hugePages;
+    std::free(reinterpret_cast<void **>(buffer)[-1]);
+#endif
+  }
+
+  /** Size of a huge page in bytes, that of the transparent huge pages
+   * (hpage_pmd_size), 2 MB if it cannot be read. The hugetlbfs buffers use
+   * pages of the same size. */
+  static SizeValueType
+  GetHugePageSize()
+  {
+    static const SizeValueType hugePageSize = ReadHugePageSize();
+    return hugePageSize;
+  }
+
+  /** Number of bytes of the buffer [buffer, buffer + size) lying in huge
+   * pages, as reported by the kernel in /proc/self/smaps. Pages that were
+   * never written are not counted. Zero where it cannot be known. */
+  static SizeValueType
+  GetHugePageBytes(const void * buffer, SizeValueType size)
+  {
+    SizeValueType hugePageBytes = 0;
+#if defined(__linux__)
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(buffer);
+    const std::uintptr_t end = begin + size;
+
+    std::ifstream file("/proc/self/smaps");
+    std::string   line;
+    SizeValueType overlap = 0;
+    while (std::getline(file, line))
+    {
+      std::istringstream stream(line);
+      std::string        field;
+      stream >> field;
+      const std::string::size_type dash = field.find('-');
+      if (dash != std::string::npos && field.find(':') == std::string::npos)
+      {
+        // Header of a mapping: "start-end perms offset device inode path"
+        std::uintptr_t start = 0;
+        std::uintptr_t stop = 0;
+        std::istringstream(field.substr(0, dash)) >> std::hex >> start;
+        std::istringstream(field.substr(dash + 1)) >> std::hex >> stop;
+        overlap = (start < end && stop > begin) ? std::min(stop, end) - std::max(start, begin) : 0;
+        continue;
+      }
+      if (overlap == 0)
+      {
+        continue;
+      }
+      SizeValueType kilobytes = 0;
+      stream >> kilobytes;
+      if (field == "AnonHugePages:")
+      {
+        hugePageBytes += std::min<SizeValueType>(kilobytes * 1024, overlap);
+      }
+      else if (field == "KernelPageSize:" && kilobytes * 1024 >= GetHugePageSize())
+      {
+        // hugetlbfs mapping
+        hugePageBytes += overlap;
+      }
+    }
+#else
+    (void)buffer;
+    (void)size;
+#endif
+    return hugePageBytes;
+  }
+
+private:
+  static std::uintptr_t
+  RoundUp(std::uintptr_t value, std::uintptr_t multiple)
+  {
+    return (value + multiple - 1) / multiple * multiple;
+  }
+
+  static int
+  Log2(SizeValueType value)
+  {
+    int exponent = 0;
+    while (value > 1)
+    {
+      value >>= 1;
+      ++exponent;
+    }
+    return exponent;
+  }
+
+  static SizeValueType
+  ReadHugePageSize()
+  {
+    SizeValueType hugePageSize = 2 * 1024 * 1024;
+#if defined(__linux__)
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+    SizeValueType size = 0;
+    if (file >> size && size > 0)
+    {
+      hugePageSize = size;
+    }
+#endif
+    return hugePageSize;
+  }
+};
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,181 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionImageFilter_h
+#define itkProjectionImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkProjectionInterpolateImageFunction.h"
+
+namespace itk
+{
+
+/** \class ProjectionImageFilter
+ * \brief Base class of the filters projecting a volume onto a 2D image.
+ *
+ * The projection interpolators compute one ray at a time and are driven by
+ * a ResampleImageFilter. The filters derived from this class compute the
+ * whole projection image at once, which lets them traverse the volume in
+ * the order that suits their algorithm rather than ray by ray.
+ *
+ * The projection geometry is the one of ProjectionInterpolateImageFunction:
+ * the volume is displaced by the Transform and rotated by the
+ * ProjectionAngle about the center of the Transform, the source lies at
+ * FocalPointToIsocenterDistance from that center, and only the voxels above
+ * the Threshold contribute to the projection. The origin of the input
+ * volume must be (0,0,0). The output image is 3-dimensional with a single
+ * slice, located at z = -FocalPointToIsocenterDistance, and its grid is
+ * given by Size, OutputSpacing and OutputOrigin as for ResampleImageFilter,
+ * so that the same parameters produce the same image with both paths.
+ *
+ * \sa ProjectionInterpolateImageFunction
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage>
+class ProjectionImageFilter : public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionImageFilter);
+
+  /** Standard class type alias. */
+  using Self = ProjectionImageFilter;
+  using Superclass = ImageToImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionImageFilter, ImageToImageFilter);
+
+  using InputImageType = TInputImage;
+  using InputPixelType = typename InputImageType::PixelType;
+  using OutputImageType = TOutputImage;
+  using OutputPixelType = typename OutputImageType::PixelType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using SizeType = typename OutputImageType::SizeType;
+  using SpacingType = typename OutputImageType::SpacingType;
+  using OriginPointType = typename OutputImageType::PointType;
+  using DirectionType = typename OutputImageType::DirectionType;
+
+  /** The projection geometry, shared with the projection interpolators. */
+  using GeometryType = ProjectionInterpolateImageFunction<InputImageType, double>;
+  using TransformType = typename GeometryType::TransformType;
+  using TransformPointer = typename TransformType::Pointer;
+  using PointType = typename GeometryType::PointType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Connect the Transform. */
+  itkSetObjectMacro(Transform, TransformType);
+  /** Get a pointer to the Transform.  */
+  itkGetModifiableObjectMacro(Transform, TransformType);
+
+  /** Set and get the focal point to isocenter distance in mm */
+  itkSetMacro(FocalPointToIsocenterDistance, double);
+  itkGetConstMacro(FocalPointToIsocenterDistance, double);
+
+  /** Set and get the Lianc grantry rotation angle in radians */
+  itkSetMacro(ProjectionAngle, double);
+  itkGetConstMacro(ProjectionAngle, double);
+
+  /** Set and get the Threshold */
+  itkSetMacro(Threshold, double);
+  itkGetConstMacro(Threshold, double);
+
+  /** Set and get the size of the projection image. */
+  itkSetMacro(Size, SizeType);
+  itkGetConstReferenceMacro(Size, SizeType);
+
+  /** Set the output image spacing. */
+  itkSetMacro(OutputSpacing, SpacingType);
+  virtual void
+  SetOutputSpacing(const double * spacing);
+  itkGetConstReferenceMacro(OutputSpacing, SpacingType);
+
+  /** Set the output image origin. */
+  itkSetMacro(OutputOrigin, OriginPointType);
+  virtual void
+  SetOutputOrigin(const double * origin);
+  itkGetConstReferenceMacro(OutputOrigin, OriginPointType);
+
+  /** Set the output direction cosine matrix. */
+  itkSetMacro(OutputDirection, DirectionType);
+  itkGetConstReferenceMacro(OutputDirection, DirectionType);
+
+  /** The projection depends on the Transform as well. */
+  ModifiedTimeType
+  GetMTime() const override;
+
+protected:
+  ProjectionImageFilter();
+  ~ProjectionImageFilter() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Set the grid of the projection image. */
+  void
+  GenerateOutputInformation() override;
+
+  /** Every ray may cross the whole volume. */
+  void
+  GenerateInputRequestedRegion() override;
+
+  /** The projectors compute the whole projection image at once. */
+  void
+  EnlargeOutputRequestedRegion(DataObject * output) override;
+
+  /** Compute the transform mapping the points of the projection image into
+   * the volume, and the position of the source in the volume. */
+  void
+  UpdateProjectionGeometry();
+
+  /** Valid after UpdateProjectionGeometry(). */
+  const TransformType *
+  GetInverseTransform() const
+  {
+    return m_InverseTransform.GetPointer();
+  }
+  const PointType &
+  GetSourceWorld() const
+  {
+    return m_SourceWorld;
+  }
+
+private:
+  TransformPointer m_Transform;
+  TransformPointer m_InverseTransform;
+  PointType        m_SourceWorld;
+
+  double m_FocalPointToIsocenterDistance;
+  double m_ProjectionAngle;
+  double m_Threshold;
+
+  SizeType        m_Size;
+  SpacingType     m_OutputSpacing;
+  OriginPointType m_OutputOrigin;
+  DirectionType   m_OutputDirection;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkProjectionImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionImageFilter_hxx
+#define itkProjectionImageFilter_hxx
+
+#include "itkProjectionImageFilter.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+ProjectionImageFilter<TInputImage, TOutputImage>::ProjectionImageFilter()
+{
+  m_FocalPointToIsocenterDistance = 1000.; // Focal point to isocenter distance in mm.
+  m_ProjectionAngle = 0.;                  // Angle in radians betweeen projection central axis and reference axis
+  m_Threshold = 0.;                        // Intensity threshold, below which is ignored.
+
+  m_InverseTransform = TransformType::New();
+  m_InverseTransform->SetComputeZYX(true);
+  m_SourceWorld.Fill(0.0);
+
+  m_Size.Fill(0);
+  m_OutputSpacing.Fill(1.0);
+  m_OutputOrigin.Fill(0.0);
+  m_OutputDirection.SetIdentity();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionImageFilter<TInputImage, TOutputImage>::SetOutputSpacing(const double * spacing)
+{
+  SpacingType s;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    s[i] = spacing[i];
+  }
+  this->SetOutputSpacing(s);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionImageFilter<TInputImage, TOutputImage>::SetOutputOrigin(const double * origin)
+{
+  OriginPointType p(origin);
+  this->SetOutputOrigin(p);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+ModifiedTimeType
+ProjectionImageFilter<TInputImage, TOutputImage>::GetMTime() const
+{
+  ModifiedTimeType latestTime = Superclass::GetMTime();
+
+  if (m_Transform)
+  {
+    latestTime = std::max(latestTime, m_Transform->GetMTime());
+  }
+  return latestTime;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionImageFilter<TInputImage, TOutputImage>::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  OutputImageType * outputPtr = this->GetOutput();
+  if (!outputPtr)
+  {
+    return;
+  }
+
+  typename OutputImageType::RegionType outputLargestPossibleRegion;
+  outputLargestPossibleRegion.SetSize(m_Size);
+  outputPtr->SetLargestPossibleRegion(outputLargestPossibleRegion);
+
+  outputPtr->SetSpacing(m_OutputSpacing);
+  outputPtr->SetOrigin(m_OutputOrigin);
+  outputPtr->SetDirection(m_OutputDirection);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * inputPtr = const_cast<InputImageType *>(this->GetInput());
+  if (inputPtr)
+  {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionImageFilter<TInputImage, TOutputImage>::EnlargeOutputRequestedRegion(DataObject * output)
+{
+  Superclass::EnlargeOutputRequestedRegion(output);
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionImageFilter<TInputImage, TOutputImage>::UpdateProjectionGeometry()
+{
+  if (!m_Transform)
+  {
+    itkExceptionMacro(<< "Transform is not present");
+  }
+
+  GeometryType::ComputeProjectionInverseTransform(
+    m_Transform, m_ProjectionAngle, m_FocalPointToIsocenterDistance, m_InverseTransform);
+  m_SourceWorld = m_InverseTransform->TransformPoint(GeometryType::GetSourcePoint());
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Threshold: " << m_Threshold << std::endl;
+  os << indent << "FocalPointToIsocenterDistance: " << m_FocalPointToIsocenterDistance << std::endl;
+  os << indent << "ProjectionAngle: " << m_ProjectionAngle << std::endl;
+  os << indent << "Transform: " << m_Transform.GetPointer() << std::endl;
+  os << indent << "Size: " << m_Size << std::endl;
+  os << indent << "OutputSpacing: " << m_OutputSpacing << std::endl;
+  os << indent << "OutputOrigin: " << m_OutputOrigin << std::endl;
+  os << indent << "OutputDirection: " << m_OutputDirection << std::endl;
+}
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,285 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionInterpolateImageFunction_h
+#define itkProjectionInterpolateImageFunction_h
+
+#include "itkInterpolateImageFunction.h"
+#include "itkTransform.h"
+#include "itkVector.h"
+#include "itkEuler3DTransform.h"
+#include "itkProjectionVolumeContext.h"
+#include "itkProjectionBrickedVolume.h"
+
+namespace itk
+{
+
+/** \class ProjectionInterpolateImageFunction
+ * \brief Base class of the interpolators projecting a volume onto a 2D image.
+ *
+ * The interpolators derived from this class compute the line integral of
+ * a 3-dimensional image along the ray joining the X-ray source to the
+ * position being interpolated, which is a pixel of the projection image.
+ *
+ * This class holds the projection geometry shared by all the projectors:
+ * the rigid transform of the volume, the source to isocenter distance and
+ * the gantry angle. The source lies at FocalPointToIsocenterDistance from
+ * the isocenter (the center of the transform) and the projection image is
+ * perpendicular to the central axis. Only the voxels whose intensity is
+ * above the Threshold contribute to the projection.
+ *
+ * The data derived from the volume by the projectors may be shared with
+ * other interpolators through a ProjectionVolumeContext. It is used only
+ * while the context is up to date for the input image and the Threshold.
+ *
+ * A volume too large for memory may be given as a ProjectionBrickedVolume,
+ * stored out of core. The projectors supporting it read the voxels from its
+ * bricks instead of the buffer of the input image, which then only needs
+ * the geometry of the volume.
+ *
+ * \warning These interpolators work for 3-dimensional images only.
+ *
+ * \ingroup ImageFunctions
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TCoordRep = float>
+class ProjectionInterpolateImageFunction : public InterpolateImageFunction<TInputImage, TCoordRep>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionInterpolateImageFunction);
+
+  /** Standard class type alias. */
+  using Self = ProjectionInterpolateImageFunction;
+  using Superclass = InterpolateImageFunction<TInputImage, TCoordRep>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int InputImageDimension = TInputImage::ImageDimension;
+
+  using TransformType = Euler3DTransform<TCoordRep>;
+
+  using TransformPointer = typename TransformType::Pointer;
+  using InputPointType = typename TransformType::InputPointType;
+  using OutputPointType = typename TransformType::OutputPointType;
+  using TransformParametersType = typename TransformType::ParametersType;
+  using TransformJacobianType = typename TransformType::JacobianType;
+
+  using PixelType = typename Superclass::InputPixelType;
+
+  using SizeType = typename TInputImage::SizeType;
+
+  using DirectionType = Vector<TCoordRep, 3>;
+
+  /**  Type of the Interpolator Base class */
+  using InterpolatorType = InterpolateImageFunction<TInputImage, TCoordRep>;
+
+  using InterpolatorPointer = typename InterpolatorType::Pointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionInterpolateImageFunction, InterpolateImageFunction);
+
+  /** OutputType type alias support. */
+  using OutputType = typename Superclass::OutputType;
+
+  /** InputImageType type alias support. */
+  using InputImageType = typename Superclass::InputImageType;
+
+  /** InputImageConstPointer type alias support. */
+  using InputImageConstPointer = typename Superclass::InputImageConstPointer;
+
+  /** RealType type alias support. */
+  using RealType = typename Superclass::RealType;
+
+  /** Dimension underlying input image. */
+  static constexpr unsigned int ImageDimension = Superclass::ImageDimension;
+
+  /** Point type alias support. */
+  using PointType = typename Superclass::PointType;
+
+  /** Index type alias support. */
+  using IndexType = typename Superclass::IndexType;
+
+  /** ContinuousIndex type alias support. */
+  using ContinuousIndexType = typename Superclass::ContinuousIndexType;
+
+  /** Vector type alias support. */
+  using VectorType = typename PointType::VectorType;
+
+  /** Data derived from the volume, shared between the interpolators */
+  using VolumeContextType = ProjectionVolumeContext<TInputImage>;
+
+  /** Volume stored out of core */
+  using BrickedVolumeType = ProjectionBrickedVolume<TInputImage>;
+
+  /** Interpolate the image at a continuous index position
+   *
+   * The continuous index is converted to a physical point, which is then
+   * projected by Evaluate().
+   */
+  OutputType
+  EvaluateAtContinuousIndex(const ContinuousIndexType & index) const override;
+
+  /** Cast the rays of a detector scanline.
+   *
+   * The rays pass through the points firstPoint + k * pointStep for
+   * k = 0 .. length-1, i.e. consecutive pixels of a row of the projection
+   * image, and their projections are written to values[k]. The default
+   * implementation calls Evaluate() for each pixel; the projectors override
+   * it to share the per-pose setup between the rays of the scanline. */
+  virtual void
+  EvaluateScanline(const PointType &  firstPoint,
+                   const VectorType & pointStep,
+                   SizeValueType      length,
+                   OutputType *       values) const;
+
+  virtual void
+  Initialize();
+
+  /** Compute the transform mapping the points of the projection geometry
+   * (source at the origin, projecting along the negative z-axis) into the
+   * coordinate system of the volume. The volume is displaced by transform,
+   * rotated by the gantry angle projectionAngle about the center of
+   * transform, and the source lies at focalPointToIsocenterDistance from
+   * that center. This is shared with the image-based projectors. */
+  static void
+  ComputeProjectionInverseTransform(const TransformType * transform,
+                                    double                projectionAngle,
+                                    double                focalPointToIsocenterDistance,
+                                    TransformType *       inverseTransform);
+
+  /** Coordinate of the source in the projection geometry */
+  static PointType
+  GetSourcePoint()
+  {
+    PointType sourcePoint;
+    sourcePoint.Fill(0.0);
+    return sourcePoint;
+  }
+
+  /** Connect the Transform. */
+  itkSetObjectMacro(Transform, TransformType);
+  /** Get a pointer to the Transform.  */
+  itkGetConstObjectMacro(Transform, TransformType);
+
+  /** Set and get the focal point to isocenter distance in mm */
+  itkSetMacro(FocalPointToIsocenterDistance, double);
+  itkGetMacro(FocalPointToIsocenterDistance, double);
+
+  /** Set and get the Lianc grantry rotation angle in radians */
+  itkSetMacro(ProjectionAngle, double);
+  itkGetMacro(ProjectionAngle, double);
+
+  /** Set and get the Threshold */
+  itkSetMacro(Threshold, double);
+  itkGetMacro(Threshold, double);
+
+  /** Set and get the context holding the data derived from the volume. */
+  itkSetObjectMacro(VolumeContext, VolumeContextType);
+  itkGetModifiableObjectMacro(VolumeContext, VolumeContextType);
+
+  /** Set and get the volume stored out of core, read instead of the input
+   * image. It must be up to date for the Threshold when rays are cast. */
+  itkSetObjectMacro(BrickedVolume, BrickedVolumeType);
+  itkGetModifiableObjectMacro(BrickedVolume, BrickedVolumeType);
+
+  /** Recompute the overall inverse transform if the volume was moved since
+   * the last computation, and return the position of the source in the
+   * coordinate system of the volume. The rays call it as well, so call it
+   * once before casting rays from several threads after a change of the
+   * Transform. */
+  PointType
+  UpdateProjectionGeometry() const;
+
+  /** Check if a point is inside the image buffer.
+   * \warning For efficiency, no validity checking of
+   * the input image pointer is done. */
+  inline bool
+  IsInsideBuffer(const PointType &) const override
+  {
+    return true;
+  }
+  bool
+  IsInsideBuffer(const ContinuousIndexType &) const override
+  {
+    return true;
+  }
+  bool
+  IsInsideBuffer(const IndexType &) const override
+  {
+    return true;
+  }
+
+#if !defined(ITKV4_COMPATIBILITY)
+  SizeType
+  GetRadius() const override
+  {
+    const InputImageType * input = this->GetInputImage();
+    if (!input)
+    {
+      itkExceptionMacro("Input image required!");
+    }
+    return input->GetLargestPossibleRegion().GetSize();
+  }
+#endif
+
+protected:
+  ProjectionInterpolateImageFunction();
+
+  ~ProjectionInterpolateImageFunction() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The volume context if it is up to date for the input image and the
+   * Threshold, nullptr otherwise. */
+  const VolumeContextType *
+  GetValidVolumeContext() const;
+
+  /** The bricked volume, nullptr if none is set. An exception is thrown if
+   * it is not up to date for the Threshold. */
+  const BrickedVolumeType *
+  GetValidBrickedVolume() const;
+
+  /// Transformation used to calculate the new focal point position
+  TransformPointer m_Transform; // Displacement of the volume
+  // Overall inverse transform used to calculate the ray position in the input space
+  TransformPointer m_InverseTransform;
+
+  // The threshold above which voxels along the ray path are integrated
+  double m_Threshold;
+  double m_FocalPointToIsocenterDistance; // Focal point to isocenter distance
+  double m_ProjectionAngle;               // Linac gantry rotation angle in radians
+
+  typename VolumeContextType::Pointer m_VolumeContext;
+  typename BrickedVolumeType::Pointer m_BrickedVolume;
+
+private:
+  void
+  ComputeInverseTransform() const;
+
+  PointType m_SourcePoint; // Coordinate of the source in the standard Z projection geometry
+  PointType m_SourceWorld; // Coordinate of the source in the world coordinate system
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkProjectionInterpolateImageFunction.hxx"
+#endif
+
+#endif
@@ -0,0 +1,209 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionInterpolateImageFunction_hxx
+#define itkProjectionInterpolateImageFunction_hxx
+
+#include "itkProjectionInterpolateImageFunction.h"
+
+#include "itkMath.h"
+
+namespace itk
+{
+
+template <typename TInputImage, typename TCoordRep>
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::ProjectionInterpolateImageFunction()
+{
+  m_FocalPointToIsocenterDistance = 1000.; // Focal point to isocenter distance in mm.
+  m_ProjectionAngle = 0.;                  // Angle in radians betweeen projection central axis and reference axis
+  m_Threshold = 0.;                        // Intensity threshold, below which is ignored.
+
+  m_SourcePoint = GetSourcePoint();
+
+  m_InverseTransform = TransformType::New();
+  m_InverseTransform->SetComputeZYX(true);
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+void
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Threshold: " << m_Threshold << std::endl;
+  os << indent << "FocalPointToIsocenterDistance: " << m_FocalPointToIsocenterDistance << std::endl;
+  os << indent << "ProjectionAngle: " << m_ProjectionAngle << std::endl;
+  os << indent << "Transform: " << m_Transform.GetPointer() << std::endl;
+  os << indent << "VolumeContext: " << m_VolumeContext.GetPointer() << std::endl;
+  os << indent << "BrickedVolume: " << m_BrickedVolume.GetPointer() << std::endl;
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+typename ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::OutputType
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateAtContinuousIndex(
+  const ContinuousIndexType & index) const
+{
+  OutputPointType point;
+  this->m_Image->TransformContinuousIndexToPhysicalPoint(index, point);
+
+  return this->Evaluate(point);
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+void
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateScanline(const PointType &  firstPoint,
+                                                                             const VectorType & pointStep,
+                                                                             SizeValueType      length,
+                                                                             OutputType *       values) const
+{
+  PointType point = firstPoint;
+  for (SizeValueType k = 0; k < length; ++k, point += pointStep)
+  {
+    values[k] = this->Evaluate(point);
+  }
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+typename ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::PointType
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::UpdateProjectionGeometry() const
+{
+  // If the volume was shifted, recalculate the overall inverse transform
+  unsigned long int interpMTime = this->GetMTime();
+  unsigned long int vTransformMTime = m_Transform->GetMTime();
+
+  if (interpMTime < vTransformMTime)
+  {
+    this->ComputeInverseTransform();
+    // The m_SourceWorld should be computed here to avoid the repeatedly calculation
+    // for each projection ray. However, we are in a const function, which prohibits
+    // the modification of class member variables. So the world coordiate of the source
+    // point is calculated for each call as below.
+    // m_SourceWorld = m_InverseTransform->TransformPoint(m_SourcePoint);
+  }
+
+  return m_InverseTransform->TransformPoint(m_SourcePoint);
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+const typename ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::VolumeContextType *
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::GetValidVolumeContext() const
+{
+  if (m_VolumeContext && m_VolumeContext->GetInputImage() == this->GetInputImage() &&
+      m_VolumeContext->GetThreshold() == m_Threshold && m_VolumeContext->IsUpToDate())
+  {
+    return m_VolumeContext.GetPointer();
+  }
+  return nullptr;
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+const typename ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::BrickedVolumeType *
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::GetValidBrickedVolume() const
+{
+  if (!m_BrickedVolume)
+  {
+    return nullptr;
+  }
+  // The input image may have no pixels: there is no fallback.
+  if (m_BrickedVolume->GetThreshold() != m_Threshold || !m_BrickedVolume->IsUpToDate())
+  {
+    itkExceptionMacro(<< "The BrickedVolume is not up to date for the Threshold " << m_Threshold);
+  }
+  return m_BrickedVolume.GetPointer();
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+void
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::ComputeInverseTransform() const
+{
+  ComputeProjectionInverseTransform(
+    m_Transform, m_ProjectionAngle, m_FocalPointToIsocenterDistance, m_InverseTransform);
+  this->Modified();
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+void
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::ComputeProjectionInverseTransform(
+  const TransformType * transform,
+  double                projectionAngle,
+  double                focalPointToIsocenterDistance,
+  TransformType *       inverseTransform)
+{
+  TransformPointer composedTransform = TransformType::New();
+  composedTransform->SetComputeZYX(true);
+  composedTransform->SetIdentity();
+  composedTransform->Compose(transform, 0);
+
+  typename TransformType::InputPointType isocenter;
+  isocenter = transform->GetCenter();
+  // An Euler 3D transform is used to rotate the volume to simulate the roation of the linac gantry.
+  // The rotation is about z-axis. After the transform, a AP projection geometry (projecting
+  // towards positive y direction) is established.
+  TransformPointer gantryRotTransform = TransformType::New();
+  gantryRotTransform->SetComputeZYX(true);
+  gantryRotTransform->SetIdentity();
+  gantryRotTransform->SetRotation(0.0, 0.0, -projectionAngle);
+  gantryRotTransform->SetCenter(isocenter);
+  composedTransform->Compose(gantryRotTransform, 0);
+
+  // An Euler 3D transfrom is used to shift the source to the origin.
+  TransformPointer camShiftTransform = TransformType::New();
+  camShiftTransform->SetComputeZYX(true);
+  camShiftTransform->SetIdentity();
+  typename TransformType::OutputVectorType focalpointtranslation;
+  focalpointtranslation[0] = -isocenter[0];
+  focalpointtranslation[1] = focalPointToIsocenterDistance - isocenter[1];
+  focalpointtranslation[2] = -isocenter[2];
+  camShiftTransform->SetTranslation(focalpointtranslation);
+  composedTransform->Compose(camShiftTransform, 0);
+
+  // A Euler 3D transform is used to establish the standard negative z-axis projection geometry. (By
+  // default, the camera is situated at the origin, points down the negative z-axis, and has an up-
+  // vector of (0, 1, 0).)
+  TransformPointer camRotTransform = TransformType::New();
+  camRotTransform->SetComputeZYX(true);
+  camRotTransform->SetIdentity();
+  // constant for converting degrees into radians
+  const float dtr = (atan(1.0) * 4.0) / 180.0;
+  camRotTransform->SetRotation(dtr * (-90.0), 0.0, 0.0);
+  composedTransform->Compose(camRotTransform, 0);
+
+  // The overall inverse transform is computed. The inverse transform will be used by the interpolation
+  // procedure.
+  composedTransform->GetInverse(inverseTransform);
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+void
+ProjectionInterpolateImageFunction<TInputImage, TCoordRep>::Initialize()
+{
+  this->ComputeInverseTransform();
+  m_SourceWorld = m_InverseTransform->TransformPoint(m_SourcePoint);
+}
+
+} // namespace itk
+
+#endif
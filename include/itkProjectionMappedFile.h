@@ -0,0 +1,173 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionMappedFile_h
+#define itkProjectionMappedFile_h
+
+#include "itkMacro.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace itk
+{
+
+/** \class ProjectionMappedFile
+ * \brief Read-only mapping of a whole file into memory.
+ *
+ * Map() maps the file with mmap, shared and read-only: no byte is read
+ * before it is first accessed, and the pages are those of the page cache,
+ * shared by all the processes mapping the same file. The mapping lasts
+ * until the object is destroyed or another file is mapped. Where mmap is
+ * not available, the file is read into memory instead.
+ *
+ * \sa ProjectionVolumeContext::ReadCacheFile
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+class ProjectionMappedFile : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionMappedFile);
+
+  /** Standard class type alias. */
+  using Self = ProjectionMappedFile;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionMappedFile, Object);
+
+  /** Map the file. An exception is thrown if it cannot be opened. */
+  void
+  Map(const std::string & fileName)
+  {
+    this->Unmap();
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0)
+    {
+      if (fd >= 0)
+      {
+        close(fd);
+      }
+      itkExceptionMacro(<< "Cannot open " << fileName);
+    }
+    m_Size = static_cast<SizeValueType>(status.st_size);
+    if (m_Size > 0)
+    {
+      void * data = mmap(nullptr, m_Size, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if (data == MAP_FAILED)
+      {
+        m_Size = 0;
+        itkExceptionMacro(<< "Cannot map " << fileName);
+      }
+      m_Data = data;
+    }
+    else
+    {
+      close(fd);
+    }
+#else
+    FILE * file = fopen(fileName.c_str(), "rb");
+    if (!file)
+    {
+      itkExceptionMacro(<< "Cannot open " << fileName);
+    }
+    char   chunk[1 << 16];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+      m_Copy.insert(m_Copy.end(), chunk, chunk + count);
+    }
+    fclose(file);
+    m_Size = m_Copy.size();
+    m_Data = m_Copy.data();
+#endif
+    m_FileName = fileName;
+    this->Modified();
+  }
+
+  /** First byte of the file, nullptr if no file is mapped or it is empty. */
+  const void *
+  GetData() const
+  {
+    return m_Data;
+  }
+
+  /** Size of the file, in bytes. */
+  itkGetConstMacro(Size, SizeValueType);
+
+  /** Name of the mapped file. */
+  itkGetStringMacro(FileName);
+
+protected:
+  ProjectionMappedFile() = default;
+  ~ProjectionMappedFile() override
+  {
+    this->Unmap();
+  }
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override
+  {
+    Superclass::PrintSelf(os, indent);
+
+    os << indent << "FileName: " << m_FileName << std::endl;
+    os << indent << "Size: " << m_Size << std::endl;
+  }
+
+private:
+  void
+  Unmap()
+  {
+#if defined(__unix__) || defined(__APPLE__)
+    if (m_Data)
+    {
+      munmap(m_Data, m_Size);
+    }
+#else
+    m_Copy.clear();
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+    m_FileName.clear();
+  }
+
+  void *            m_Data{ nullptr };
+  SizeValueType     m_Size{ 0 };
+  std::string       m_FileName;
+  std::vector<char> m_Copy;
+};
+
+} // namespace itk
+
+#endif
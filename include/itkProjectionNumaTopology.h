@@ -0,0 +1,189 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionNumaTopology_h
+#define itkProjectionNumaTopology_h
+
+#include "itkIntTypes.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace itk
+{
+
+/** \class ProjectionNumaTopology
+ * \brief NUMA nodes of the machine, as seen by the projectors.
+ *
+ * On a machine with several sockets, each socket reads its own memory
+ * faster than the memory of the others. This class lists the NUMA nodes and
+ * their cores, tells on which node the calling thread runs and binds a
+ * thread to the cores of a node, so that the data read by the threads of a
+ * node can be placed in the memory of that node.
+ *
+ * The topology is read once from /sys/devices/system/node on Linux.
+ * Elsewhere, or if it cannot be read, the machine is a single node and the
+ * binding does nothing.
+ *
+ * \sa ProjectionVolumeContext, ProjectionThreadPool
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+class ProjectionNumaTopology
+{
+public:
+  /** Number of NUMA nodes, at least one. */
+  static unsigned int
+  GetNumberOfNodes()
+  {
+    return static_cast<unsigned int>(GetTopology().NodeCores.size());
+  }
+
+  /** Cores of a node. */
+  static const std::vector<unsigned int> &
+  GetNodeCores(unsigned int node)
+  {
+    return GetTopology().NodeCores[node % GetNumberOfNodes()];
+  }
+
+  /** Node of the core running the calling thread. The thread may move to
+   * another node afterwards unless it is bound to one. */
+  static unsigned int
+  GetCurrentNode()
+  {
+#if defined(__linux__)
+    const Topology & topology = GetTopology();
+    const int        core = sched_getcpu();
+    if (core >= 0 && static_cast<SizeValueType>(core) < topology.CoreNodes.size())
+    {
+      return topology.CoreNodes[core];
+    }
+#endif
+    return 0;
+  }
+
+  /** Bind the calling thread to the cores of a node. Returns false if the
+   * thread could not be bound. */
+  static bool
+  BindCurrentThreadToNode(unsigned int node)
+  {
+#if defined(__linux__)
+    const std::vector<unsigned int> & cores = GetNodeCores(node);
+    if (GetNumberOfNodes() < 2 || cores.empty())
+    {
+      return false;
+    }
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (unsigned int core : cores)
+    {
+      CPU_SET(core, &cpuSet);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+  }
+
+private:
+  struct Topology
+  {
+    std::vector<std::vector<unsigned int>> NodeCores;
+    std::vector<unsigned int>              CoreNodes;
+  };
+
+  static const Topology &
+  GetTopology()
+  {
+    // Read once, by the first caller
+    static const Topology topology = ReadTopology();
+    return topology;
+  }
+
+  static Topology
+  ReadTopology()
+  {
+    Topology topology;
+#if defined(__linux__)
+    for (unsigned int node = 0;; ++node)
+    {
+      std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      std::string   list;
+      if (!file || !std::getline(file, list))
+      {
+        break;
+      }
+      topology.NodeCores.push_back(ParseCoreList(list));
+    }
+#endif
+    if (topology.NodeCores.empty())
+    {
+      topology.NodeCores.resize(1);
+      return topology;
+    }
+    for (unsigned int node = 0; node < topology.NodeCores.size(); ++node)
+    {
+      for (unsigned int core : topology.NodeCores[node])
+      {
+        if (core >= topology.CoreNodes.size())
+        {
+          topology.CoreNodes.resize(core + 1, 0);
+        }
+        topology.CoreNodes[core] = node;
+      }
+    }
+    return topology;
+  }
+
+  /** Parse a list of cores such as "0-3,8-11". */
+  static std::vector<unsigned int>
+  ParseCoreList(const std::string & list)
+  {
+    std::vector<unsigned int> cores;
+    std::stringstream         stream(list);
+    std::string               range;
+    while (std::getline(stream, range, ','))
+    {
+      const std::string::size_type dash = range.find('-');
+      try
+      {
+        const unsigned long first = std::stoul(range.substr(0, dash));
+        const unsigned long last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+        for (unsigned long core = first; core <= last; ++core)
+        {
+          cores.push_back(static_cast<unsigned int>(core));
+        }
+      }
+      catch (const std::exception &)
+      {
+        // Blank or malformed entry
+      }
+    }
+    return cores;
+  }
+};
+
+} // namespace itk
+
+#endif
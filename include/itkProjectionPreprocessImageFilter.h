@@ -0,0 +1,164 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionPreprocessImageFilter_h
+#define itkProjectionPreprocessImageFilter_h
+
+#include "itkFixedArray.h"
+#include "itkImageToImageFilter.h"
+
+namespace itk
+{
+
+/** \class ProjectionPreprocessImageFilter
+ * \brief Prepare an X-ray image as a fixed image of the two projection registration.
+ *
+ * The X-ray images are read as 3-dimensional images with a single slice.
+ * Before the registration they are flipped, their intensities rescaled and
+ * they are placed in the projection geometry. This filter does it in one
+ * pass, reading the input once and writing a single output buffer, with
+ * the rows in the order in which the metrics scan the fixed images,
+ * instead of a FlipImageFilter and a RescaleIntensityImageFilter each
+ * allocating an image followed by changes of the origin of their outputs.
+ *
+ * The axes of FlipAxes are reversed, as by FlipImageFilter: the images are
+ * stored from superior to inferior, while the projections are computed
+ * from inferior to superior, so the y-axis is flipped by default. The
+ * intensities are mapped linearly onto [OutputMinimum, OutputMaximum], as
+ * by RescaleIntensityImageFilter, or to a zero mean and a unit variance if
+ * NormalizeIntensity is on, as by NormalizeImageFilter.
+ *
+ * The output has the spacing of the input, or OutputSpacing if
+ * ChangeSpacing is on, and an identity direction. It lies in the plane
+ * z = -FocalPointToIsocenterDistance, perpendicular to the central axis,
+ * which crosses it at CentralAxisPosition, a continuous index relative to
+ * the first pixel of the output. By default the central axis crosses the
+ * center of the image.
+ *
+ * Images of other dimensions are flipped and rescaled alike; the distance
+ * to the source only applies to 3-dimensional images.
+ *
+ * \sa TwoProjectionImageRegistrationMethod
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage = TInputImage>
+class ProjectionPreprocessImageFilter : public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionPreprocessImageFilter);
+
+  /** Standard class type alias. */
+  using Self = ProjectionPreprocessImageFilter;
+  using Superclass = ImageToImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionPreprocessImageFilter, ImageToImageFilter);
+
+  using InputImageType = TInputImage;
+  using InputPixelType = typename InputImageType::PixelType;
+  using OutputImageType = TOutputImage;
+  using OutputPixelType = typename OutputImageType::PixelType;
+  using RegionType = typename OutputImageType::RegionType;
+  using SpacingType = typename OutputImageType::SpacingType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  using FlipAxesArrayType = FixedArray<bool, ImageDimension>;
+  using CentralAxisPositionType = FixedArray<double, 2>;
+
+  /** Set and get the axes to flip. */
+  itkSetMacro(FlipAxes, FlipAxesArrayType);
+  itkGetConstReferenceMacro(FlipAxes, FlipAxesArrayType);
+
+  /** Set and get the range the intensities are rescaled to. */
+  itkSetMacro(OutputMinimum, double);
+  itkGetConstMacro(OutputMinimum, double);
+  itkSetMacro(OutputMaximum, double);
+  itkGetConstMacro(OutputMaximum, double);
+
+  /** Set and get whether the intensities are normalized rather than
+   * rescaled. */
+  itkSetMacro(NormalizeIntensity, bool);
+  itkGetConstMacro(NormalizeIntensity, bool);
+  itkBooleanMacro(NormalizeIntensity);
+
+  /** Set and get the spacing of the output, used if ChangeSpacing is on. */
+  itkSetMacro(OutputSpacing, SpacingType);
+  itkGetConstReferenceMacro(OutputSpacing, SpacingType);
+  itkSetMacro(ChangeSpacing, bool);
+  itkGetConstMacro(ChangeSpacing, bool);
+  itkBooleanMacro(ChangeSpacing);
+
+  /** Set and get the position of the central axis in the output, used if
+   * UseImageCenter is off. */
+  itkSetMacro(CentralAxisPosition, CentralAxisPositionType);
+  itkGetConstReferenceMacro(CentralAxisPosition, CentralAxisPositionType);
+  itkSetMacro(UseImageCenter, bool);
+  itkGetConstMacro(UseImageCenter, bool);
+  itkBooleanMacro(UseImageCenter);
+
+  /** Set and get the focal point to isocenter distance in mm */
+  itkSetMacro(FocalPointToIsocenterDistance, double);
+  itkGetConstMacro(FocalPointToIsocenterDistance, double);
+
+protected:
+  ProjectionPreprocessImageFilter();
+  ~ProjectionPreprocessImageFilter() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Place the output in the projection geometry. */
+  void
+  GenerateOutputInformation() override;
+
+  /** The intensities are rescaled from the range of the whole input. */
+  void
+  GenerateInputRequestedRegion() override;
+
+  void
+  EnlargeOutputRequestedRegion(DataObject * output) override;
+
+  void
+  GenerateData() override;
+
+private:
+  FlipAxesArrayType       m_FlipAxes;
+  double                  m_OutputMinimum;
+  double                  m_OutputMaximum;
+  bool                    m_NormalizeIntensity;
+  SpacingType             m_OutputSpacing;
+  bool                    m_ChangeSpacing;
+  CentralAxisPositionType m_CentralAxisPosition;
+  bool                    m_UseImageCenter;
+  double                  m_FocalPointToIsocenterDistance;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkProjectionPreprocessImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,235 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionPreprocessImageFilter_hxx
+#define itkProjectionPreprocessImageFilter_hxx
+
+#include "itkProjectionPreprocessImageFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+ProjectionPreprocessImageFilter<TInputImage, TOutputImage>::ProjectionPreprocessImageFilter()
+{
+  m_FlipAxes.Fill(false);
+  m_FlipAxes[1] = true;
+  m_OutputMinimum = 0.0;
+  m_OutputMaximum = 255.0;
+  m_NormalizeIntensity = false;
+  m_OutputSpacing.Fill(1.0);
+  m_ChangeSpacing = false;
+  m_CentralAxisPosition.Fill(0.0);
+  m_UseImageCenter = true;
+  m_FocalPointToIsocenterDistance = 1000.0;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionPreprocessImageFilter<TInputImage, TOutputImage>::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+  if (!input || !output)
+  {
+    return;
+  }
+
+  const RegionType  region = input->GetLargestPossibleRegion();
+  const SpacingType spacing = m_ChangeSpacing ? m_OutputSpacing : input->GetSpacing();
+
+  // The central axis crosses the detector plane at the origin of x and y,
+  // and the plane lies at the focal point to isocenter distance along z.
+  typename OutputImageType::PointType origin;
+  origin.Fill(0.0);
+  for (unsigned int i = 0; i < ImageDimension && i < 3; ++i)
+  {
+    if (i == 2)
+    {
+      origin[i] = -m_FocalPointToIsocenterDistance;
+      continue;
+    }
+    const double center =
+      m_UseImageCenter ? 0.5 * (static_cast<double>(region.GetSize(i)) - 1.0) : m_CentralAxisPosition[i];
+    origin[i] = -spacing[i] * (region.GetIndex(i) + center);
+  }
+
+  typename OutputImageType::DirectionType direction;
+  direction.SetIdentity();
+
+  output->SetLargestPossibleRegion(region);
+  output->SetSpacing(spacing);
+  output->SetOrigin(origin);
+  output->SetDirection(direction);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionPreprocessImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  auto * input = const_cast<InputImageType *>(this->GetInput());
+  if (input)
+  {
+    input->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionPreprocessImageFilter<TInputImage, TOutputImage>::EnlargeOutputRequestedRegion(DataObject * output)
+{
+  Superclass::EnlargeOutputRequestedRegion(output);
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionPreprocessImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+
+  const RegionType region = output->GetRequestedRegion();
+  output->SetBufferedRegion(region);
+  output->Allocate();
+
+  const typename RegionType::IndexType start = region.GetIndex();
+  const typename RegionType::SizeType  size = region.GetSize();
+  const SizeValueType                  numberOfRows = region.GetNumberOfPixels() / size[0];
+
+  // The input row read for an output row, flipped along the other axes.
+  auto inputRow = [&](SizeValueType row) -> const InputPixelType * {
+    typename RegionType::IndexType index = start;
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      const SizeValueType position = row % size[i];
+      row /= size[i];
+      index[i] += static_cast<IndexValueType>(m_FlipAxes[i] ? size[i] - 1 - position : position);
+    }
+    return input->GetBufferPointer() + input->ComputeOffset(index);
+  };
+
+  // Intensity statistics, accumulated by row
+  struct RowStatistics
+  {
+    double Minimum;
+    double Maximum;
+    double Sum;
+    double SumOfSquares;
+  };
+  std::vector<RowStatistics> rowStatistics(numberOfRows);
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    numberOfRows,
+    [&](SizeValueType row) {
+      const InputPixelType * values = inputRow(row);
+      RowStatistics          statistics{ NumericTraits<double>::max(), NumericTraits<double>::NonpositiveMin(), 0, 0 };
+      for (SizeValueType x = 0; x < size[0]; ++x)
+      {
+        const auto value = static_cast<double>(values[x]);
+        statistics.Minimum = std::min(statistics.Minimum, value);
+        statistics.Maximum = std::max(statistics.Maximum, value);
+        statistics.Sum += value;
+        statistics.SumOfSquares += value * value;
+      }
+      rowStatistics[row] = statistics;
+    },
+    nullptr);
+
+  RowStatistics total{ NumericTraits<double>::max(), NumericTraits<double>::NonpositiveMin(), 0, 0 };
+  for (const RowStatistics & statistics : rowStatistics)
+  {
+    total.Minimum = std::min(total.Minimum, statistics.Minimum);
+    total.Maximum = std::max(total.Maximum, statistics.Maximum);
+    total.Sum += statistics.Sum;
+    total.SumOfSquares += statistics.SumOfSquares;
+  }
+
+  // The intensities are mapped by value * scale + shift.
+  double scale = 0.0;
+  double shift = 0.0;
+  if (m_NormalizeIntensity)
+  {
+    const double count = static_cast<double>(region.GetNumberOfPixels());
+    const double mean = total.Sum / count;
+    const double variance = count > 1 ? (total.SumOfSquares - count * mean * mean) / (count - 1) : 0.0;
+    scale = variance > 0 ? 1.0 / std::sqrt(variance) : 1.0;
+    shift = -mean * scale;
+  }
+  else
+  {
+    if (total.Maximum > total.Minimum)
+    {
+      scale = (m_OutputMaximum - m_OutputMinimum) / (total.Maximum - total.Minimum);
+    }
+    shift = m_OutputMinimum - total.Minimum * scale;
+  }
+
+  const double lowest = static_cast<double>(NumericTraits<OutputPixelType>::NonpositiveMin());
+  const double highest = static_cast<double>(NumericTraits<OutputPixelType>::max());
+  const bool   flipX = m_FlipAxes[0];
+
+  // The output rows are contiguous, as the metrics scan them.
+  OutputPixelType * const outputBuffer = output->GetBufferPointer();
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    numberOfRows,
+    [&](SizeValueType row) {
+      const InputPixelType * values = inputRow(row);
+      OutputPixelType *      out = outputBuffer + row * size[0];
+      for (SizeValueType x = 0; x < size[0]; ++x)
+      {
+        const double value = values[flipX ? size[0] - 1 - x : x] * scale + shift;
+        out[x] = static_cast<OutputPixelType>(std::min(std::max(value, lowest), highest));
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+ProjectionPreprocessImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FlipAxes: " << m_FlipAxes << std::endl;
+  os << indent << "OutputMinimum: " << m_OutputMinimum << std::endl;
+  os << indent << "OutputMaximum: " << m_OutputMaximum << std::endl;
+  os << indent << "NormalizeIntensity: " << m_NormalizeIntensity << std::endl;
+  os << indent << "OutputSpacing: " << m_OutputSpacing << std::endl;
+  os << indent << "ChangeSpacing: " << m_ChangeSpacing << std::endl;
+  os << indent << "CentralAxisPosition: " << m_CentralAxisPosition << std::endl;
+  os << indent << "UseImageCenter: " << m_UseImageCenter << std::endl;
+  os << indent << "FocalPointToIsocenterDistance: " << m_FocalPointToIsocenterDistance << std::endl;
+}
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,376 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionThreadPool_h
+#define itkProjectionThreadPool_h
+
+#include "itkMultiThreaderBase.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkProjectionNumaTopology.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace itk
+{
+
+/** \class ProjectionThreadPool
+ * \brief Persistent pool of threads for the short parallel loops of a registration.
+ *
+ * A registration evaluates its metric hundreds of times, and at the
+ * coarse levels each evaluation takes a few milliseconds only. Waking up
+ * or creating the threads for each evaluation then takes a visible share
+ * of the time. The threads of this pool are created once and kept for the
+ * lifetime of the pool. Between two loops they spin for SpinCount
+ * iterations, so that a loop following closely on the previous one starts
+ * without a system call, then sleep until the next loop.
+ *
+ * The thread calling Run() takes part in the loop, so a pool of
+ * NumberOfThreads threads runs NumberOfThreads + 1 work units at once. By
+ * default, it runs as many work units as the ITK global default number of
+ * threads, so that ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS limits the pool as
+ * it limits the MultiThreader.
+ *
+ * With PinThreads, thread i is bound to the core i + 1 on Linux, leaving
+ * the first core to the calling thread; it is ignored elsewhere. With
+ * BindThreadsToNumaNodes, the threads are spread over the NUMA nodes,
+ * thread i being bound to the cores of node (i + 1) modulo the number of
+ * nodes, so that each thread reads the data replicated in the memory of
+ * its node (see ProjectionVolumeContext::ReplicatePerNumaNode). PinThreads
+ * takes precedence.
+ *
+ * The threads are started by the first Run() after a change of
+ * NumberOfThreads, PinThreads or BindThreadsToNumaNodes. Only one loop
+ * runs at a time: concurrent calls to Run() are serialized.
+ *
+ * \sa ProjectionTileScheduler
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+class ProjectionThreadPool : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionThreadPool);
+
+  /** Standard class type alias. */
+  using Self = ProjectionThreadPool;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionThreadPool, Object);
+
+  /** Function called for each index of a loop. */
+  using FunctionType = std::function<void(SizeValueType)>;
+
+  /** Set and get the number of threads of the pool, besides the calling
+   * thread. Defaults to MultiThreaderBase::GetGlobalDefaultNumberOfThreads()
+   * minus one. */
+  itkSetMacro(NumberOfThreads, unsigned int);
+  itkGetConstMacro(NumberOfThreads, unsigned int);
+
+  /** Set and get the number of times an idle thread checks for a new loop
+   * before it goes to sleep. */
+  itkSetMacro(SpinCount, SizeValueType);
+  itkGetConstMacro(SpinCount, SizeValueType);
+
+  /** Set and get whether the threads are bound to a core each. */
+  itkSetMacro(PinThreads, bool);
+  itkGetConstMacro(PinThreads, bool);
+  itkBooleanMacro(PinThreads);
+
+  /** Set and get whether the threads are bound to the cores of a NUMA node,
+   * spreading them over the nodes. */
+  itkSetMacro(BindThreadsToNumaNodes, bool);
+  itkGetConstMacro(BindThreadsToNumaNodes, bool);
+  itkBooleanMacro(BindThreadsToNumaNodes);
+
+  /** Call function for each index in [0, n), on the threads of the pool and
+   * the calling thread. Returns when all the calls are complete. The first
+   * exception thrown by function is rethrown here. */
+  void
+  Run(SizeValueType n, const FunctionType & function);
+
+  /** Number of work units running a loop at once. */
+  unsigned int
+  GetNumberOfWorkUnits() const
+  {
+    return m_NumberOfThreads + 1;
+  }
+
+protected:
+  ProjectionThreadPool()
+  {
+    m_NumberOfThreads = std::max(MultiThreaderBase::GetGlobalDefaultNumberOfThreads(), 1u) - 1;
+  }
+  ~ProjectionThreadPool() override
+  {
+    this->StopThreads();
+  }
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override
+  {
+    Superclass::PrintSelf(os, indent);
+
+    os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+    os << indent << "SpinCount: " << m_SpinCount << std::endl;
+    os << indent << "PinThreads: " << m_PinThreads << std::endl;
+    os << indent << "BindThreadsToNumaNodes: " << m_BindThreadsToNumaNodes << std::endl;
+    os << indent << "NumberOfRunningThreads: " << m_Threads.size() << std::endl;
+  }
+
+private:
+  void
+  StartThreads();
+
+  void
+  StopThreads();
+
+  void
+  ThreadLoop(unsigned int threadId, bool pin, bool bindToNode, std::uint64_t generation);
+
+  /** Busy wait until condition holds or SpinCount checks were made, giving
+   * the core away from time to time. Returns the last value of condition. */
+  template <typename TCondition>
+  bool
+  Spin(TCondition condition) const
+  {
+    const SizeValueType spinCount = m_SpinCount;
+    for (SizeValueType spin = 0; spin < spinCount; ++spin)
+    {
+      if (condition())
+      {
+        return true;
+      }
+      if ((spin & 63) == 63)
+      {
+        std::this_thread::yield();
+      }
+    }
+    return condition();
+  }
+
+  /** Run the indices of the current loop until there are none left. */
+  void
+  RunIndices();
+
+  unsigned int               m_NumberOfThreads;
+  std::atomic<SizeValueType> m_SpinCount{ 20000 };
+  bool                       m_PinThreads{ false };
+  bool                       m_BindThreadsToNumaNodes{ false };
+
+  std::vector<std::thread> m_Threads;
+  bool                     m_ThreadsPinned{ false };
+  bool                     m_ThreadsBoundToNodes{ false };
+
+  // Serializes the calls to Run()
+  std::mutex m_RunMutex;
+
+  // Guards the sleeping threads and the end of the pool
+  std::mutex              m_Mutex;
+  std::condition_variable m_WakeUp;
+  std::condition_variable m_Done;
+  unsigned int            m_NumberOfSleepingThreads{ 0 };
+  std::atomic<bool>       m_Stop{ false };
+
+  // The current loop, numbered by m_Generation
+  std::atomic<std::uint64_t> m_Generation{ 0 };
+  const FunctionType *       m_Function{ nullptr };
+  SizeValueType              m_Size{ 0 };
+  std::atomic<SizeValueType> m_NextIndex{ 0 };
+  std::atomic<unsigned int>  m_NumberOfBusyThreads{ 0 };
+  std::exception_ptr         m_Exception;
+  std::mutex                 m_ExceptionMutex;
+};
+
+
+inline void
+ProjectionThreadPool::Run(SizeValueType n, const FunctionType & function)
+{
+  std::lock_guard<std::mutex> runLock(m_RunMutex);
+
+  if (m_Threads.size() != m_NumberOfThreads || m_ThreadsPinned != m_PinThreads ||
+      m_ThreadsBoundToNodes != m_BindThreadsToNumaNodes)
+  {
+    this->StopThreads();
+    this->StartThreads();
+  }
+
+  if (m_Threads.empty() || n <= 1)
+  {
+    for (SizeValueType i = 0; i < n; ++i)
+    {
+      function(i);
+    }
+    return;
+  }
+
+  m_Function = &function;
+  m_Size = n;
+  m_NextIndex = 0;
+  m_Exception = nullptr;
+  m_NumberOfBusyThreads = static_cast<unsigned int>(m_Threads.size());
+
+  // The spinning threads see the new generation without a system call; the
+  // sleeping ones are notified.
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ++m_Generation;
+    notify = m_NumberOfSleepingThreads > 0;
+  }
+  if (notify)
+  {
+    m_WakeUp.notify_all();
+  }
+
+  this->RunIndices();
+
+  // Every thread has to leave the loop before function goes out of scope.
+  if (!this->Spin([this] { return m_NumberOfBusyThreads == 0; }))
+  {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Done.wait(lock, [this] { return m_NumberOfBusyThreads == 0; });
+  }
+  m_Function = nullptr;
+
+  if (m_Exception)
+  {
+    std::rethrow_exception(m_Exception);
+  }
+}
+
+
+inline void
+ProjectionThreadPool::RunIndices()
+{
+  for (SizeValueType i = m_NextIndex++; i < m_Size; i = m_NextIndex++)
+  {
+    try
+    {
+      (*m_Function)(i);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(m_ExceptionMutex);
+      if (!m_Exception)
+      {
+        m_Exception = std::current_exception();
+      }
+    }
+  }
+}
+
+
+inline void
+ProjectionThreadPool::ThreadLoop(unsigned int threadId, bool pin, bool bindToNode, std::uint64_t generation)
+{
+#if defined(__linux__)
+  if (pin)
+  {
+    const unsigned int numberOfCores = std::max(std::thread::hardware_concurrency(), 1u);
+    cpu_set_t          cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET((threadId + 1) % numberOfCores, &cpuSet);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+  }
+#else
+  (void)pin;
+#endif
+  if (bindToNode && !pin)
+  {
+    ProjectionNumaTopology::BindCurrentThreadToNode(threadId + 1);
+  }
+
+  // generation is the one current when the pool was started: a loop may
+  // have started before this thread.
+  while (true)
+  {
+    if (!this->Spin([this, generation] { return m_Generation != generation; }))
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      ++m_NumberOfSleepingThreads;
+      m_WakeUp.wait(lock, [this, generation] { return m_Generation != generation || m_Stop; });
+      --m_NumberOfSleepingThreads;
+    }
+    if (m_Stop)
+    {
+      return;
+    }
+    generation = m_Generation;
+
+    this->RunIndices();
+
+    if (--m_NumberOfBusyThreads == 0)
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_Done.notify_one();
+    }
+  }
+}
+
+
+inline void
+ProjectionThreadPool::StartThreads()
+{
+  m_Stop = false;
+  m_ThreadsPinned = m_PinThreads;
+  m_ThreadsBoundToNodes = m_BindThreadsToNumaNodes;
+  m_Threads.reserve(m_NumberOfThreads);
+  for (unsigned int t = 0; t < m_NumberOfThreads; ++t)
+  {
+    m_Threads.emplace_back(
+      &ProjectionThreadPool::ThreadLoop, this, t, m_ThreadsPinned, m_ThreadsBoundToNodes, m_Generation.load());
+  }
+}
+
+
+inline void
+ProjectionThreadPool::StopThreads()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stop = true;
+    ++m_Generation;
+  }
+  m_WakeUp.notify_all();
+  for (std::thread & thread : m_Threads)
+  {
+    thread.join();
+  }
+  m_Threads.clear();
+}
+
+} // namespace itk
+
+#endif
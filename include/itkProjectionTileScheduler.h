@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionTileScheduler_h
+#define itkProjectionTileScheduler_h
+
+#include "itkImageRegion.h"
+#include "itkMultiThreaderBase.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkProjectionThreadPool.h"
+#include <functional>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ProjectionTileScheduler
+ * \brief Distribute the tiles of a detector region over threads with work stealing.
+ *
+ * The cost of a ray varies widely across a projection: rays through bone
+ * are long, rays through air are trivial. Splitting the detector into one
+ * slab of rows per thread leaves threads idle at the end. This scheduler
+ * splits the region into small tiles of TileSize pixels along the first
+ * two axes, which also keeps neighbouring rays together, and gives each
+ * work unit a contiguous range of tiles. A work unit that has processed
+ * its own range takes the next tiles of the other ranges.
+ *
+ * The work units run on the ThreadPool if one is set, otherwise on the
+ * pool of the MultiThreader. The time spent on each tile and by each work
+ * unit is recorded by Execute(), so that the balance of the load can be
+ * checked.
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <unsigned int VImageDimension = 3>
+class ProjectionTileScheduler : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionTileScheduler);
+
+  /** Standard class type alias. */
+  using Self = ProjectionTileScheduler;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionTileScheduler, Object);
+
+  static constexpr unsigned int ImageDimension = VImageDimension;
+
+  using RegionType = ImageRegion<VImageDimension>;
+  using TileSizeType = Size<2>;
+
+  /** Function processing one tile: the tile number, the tile region and
+   * the work unit running it, from 0 to GetNumberOfWorkUnits() - 1. */
+  using TileFunctionType = std::function<void(SizeValueType, const RegionType &, ThreadIdType)>;
+
+  /** Set and get the size of the tiles along the first two axes. */
+  itkSetMacro(TileSize, TileSizeType);
+  itkGetConstReferenceMacro(TileSize, TileSizeType);
+
+  /** Set and get the number of work units. With a ThreadPool, there is one
+   * work unit per thread of the pool and this setting is ignored. */
+  itkSetClampMacro(NumberOfWorkUnits, ThreadIdType, 1, ITK_MAX_THREADS);
+  ThreadIdType
+  GetNumberOfWorkUnits() const
+  {
+    return m_ThreadPool ? m_ThreadPool->GetNumberOfWorkUnits() : m_NumberOfWorkUnits;
+  }
+
+  /** Set and get the multithreader running the work units. */
+  itkSetObjectMacro(MultiThreader, MultiThreaderBase);
+  itkGetModifiableObjectMacro(MultiThreader, MultiThreaderBase);
+
+  /** Set and get the persistent pool running the work units, if any. */
+  itkSetObjectMacro(ThreadPool, ProjectionThreadPool);
+  itkGetModifiableObjectMacro(ThreadPool, ProjectionThreadPool);
+
+  /** Split region into tiles and return their number. */
+  SizeValueType
+  SplitRegion(const RegionType & region);
+
+  SizeValueType
+  GetNumberOfTiles() const
+  {
+    return m_Tiles.size();
+  }
+
+  const RegionType &
+  GetTile(SizeValueType tileNumber) const
+  {
+    return m_Tiles[tileNumber];
+  }
+
+  /** Run function on all the tiles of the last split region. */
+  void
+  Execute(const TileFunctionType & function);
+
+  /** Time spent on each tile and by each work unit during the last
+   * execution, in seconds. */
+  const std::vector<double> &
+  GetTileTimes() const
+  {
+    return m_TileTimes;
+  }
+  const std::vector<double> &
+  GetWorkUnitTimes() const
+  {
+    return m_WorkUnitTimes;
+  }
+
+  /** Number of tiles processed by another work unit than the one they were
+   * assigned to during the last execution. */
+  itkGetConstMacro(NumberOfStolenTiles, SizeValueType);
+
+  /** Ratio between the longest and the average time of the work units
+   * during the last execution; 1 means a perfect balance. */
+  double
+  GetLoadImbalance() const;
+
+protected:
+  ProjectionTileScheduler();
+  ~ProjectionTileScheduler() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  TileSizeType                  m_TileSize;
+  ThreadIdType                  m_NumberOfWorkUnits;
+  MultiThreaderBase::Pointer    m_MultiThreader;
+  ProjectionThreadPool::Pointer m_ThreadPool;
+
+  std::vector<RegionType> m_Tiles;
+  std::vector<double>     m_TileTimes;
+  std::vector<double>     m_WorkUnitTimes;
+  SizeValueType           m_NumberOfStolenTiles{ 0 };
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkProjectionTileScheduler.hxx"
+#endif
+
+#endif
@@ -0,0 +1,185 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionTileScheduler_hxx
+#define itkProjectionTileScheduler_hxx
+
+#include "itkProjectionTileScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace itk
+{
+
+template <unsigned int VImageDimension>
+ProjectionTileScheduler<VImageDimension>::ProjectionTileScheduler()
+{
+  m_TileSize.Fill(16);
+  m_MultiThreader = MultiThreaderBase::New();
+  m_NumberOfWorkUnits = m_MultiThreader->GetNumberOfWorkUnits();
+}
+
+
+template <unsigned int VImageDimension>
+SizeValueType
+ProjectionTileScheduler<VImageDimension>::SplitRegion(const RegionType & region)
+{
+  m_Tiles.clear();
+  if (region.GetNumberOfPixels() == 0)
+  {
+    return 0;
+  }
+
+  const unsigned int tiledDimension = std::min(VImageDimension, 2u);
+
+  SizeValueType tileSize[2] = { 1, 1 };
+  SizeValueType numberOfTiles[2] = { 1, 1 };
+  for (unsigned int i = 0; i < tiledDimension; ++i)
+  {
+    tileSize[i] = std::max<SizeValueType>(m_TileSize[i], 1);
+    numberOfTiles[i] = (region.GetSize(i) + tileSize[i] - 1) / tileSize[i];
+  }
+
+  // Row-major order, so that the contiguous ranges of the work units cover
+  // bands of neighbouring rays.
+  m_Tiles.reserve(numberOfTiles[0] * numberOfTiles[1]);
+  for (SizeValueType ty = 0; ty < numberOfTiles[1]; ++ty)
+  {
+    for (SizeValueType tx = 0; tx < numberOfTiles[0]; ++tx)
+    {
+      RegionType          tile = region;
+      const SizeValueType tileIndex[2] = { tx, ty };
+      for (unsigned int i = 0; i < tiledDimension; ++i)
+      {
+        const SizeValueType begin = tileIndex[i] * tileSize[i];
+        tile.SetIndex(i, region.GetIndex(i) + static_cast<IndexValueType>(begin));
+        tile.SetSize(i, std::min(tileSize[i], region.GetSize(i) - begin));
+      }
+      m_Tiles.push_back(tile);
+    }
+  }
+  return m_Tiles.size();
+}
+
+
+template <unsigned int VImageDimension>
+void
+ProjectionTileScheduler<VImageDimension>::Execute(const TileFunctionType & function)
+{
+  const SizeValueType numberOfTiles = m_Tiles.size();
+  const ThreadIdType  numberOfWorkUnits = static_cast<ThreadIdType>(
+    std::max<SizeValueType>(std::min<SizeValueType>(this->GetNumberOfWorkUnits(), numberOfTiles), 1));
+
+  m_TileTimes.assign(numberOfTiles, 0.0);
+  m_WorkUnitTimes.assign(numberOfWorkUnits, 0.0);
+  m_NumberOfStolenTiles = 0;
+  if (numberOfTiles == 0)
+  {
+    return;
+  }
+
+  // Work unit w owns the tiles [w * n / W, (w + 1) * n / W). The next tile
+  // of each range is claimed atomically, by its owner or by a thief.
+  std::vector<SizeValueType>                    ends(numberOfWorkUnits);
+  std::unique_ptr<std::atomic<SizeValueType>[]> next(new std::atomic<SizeValueType>[numberOfWorkUnits]);
+  for (ThreadIdType w = 0; w < numberOfWorkUnits; ++w)
+  {
+    next[w] = w * numberOfTiles / numberOfWorkUnits;
+    ends[w] = (w + 1) * numberOfTiles / numberOfWorkUnits;
+  }
+  std::atomic<SizeValueType> stolen(0);
+
+  using ClockType = std::chrono::steady_clock;
+
+  auto workUnit = [&](SizeValueType index) {
+    const auto    workUnitId = static_cast<ThreadIdType>(index);
+    const auto    workUnitStart = ClockType::now();
+    SizeValueType numberOfStolen = 0;
+
+    // Own range first, then the other ranges in turn.
+    for (ThreadIdType k = 0; k < numberOfWorkUnits; ++k)
+    {
+      const ThreadIdType victim = (workUnitId + k) % numberOfWorkUnits;
+      for (SizeValueType tile = next[victim]++; tile < ends[victim]; tile = next[victim]++)
+      {
+        const auto tileStart = ClockType::now();
+        function(tile, m_Tiles[tile], workUnitId);
+        m_TileTimes[tile] = std::chrono::duration<double>(ClockType::now() - tileStart).count();
+        if (k != 0)
+        {
+          ++numberOfStolen;
+        }
+      }
+    }
+
+    m_WorkUnitTimes[workUnitId] = std::chrono::duration<double>(ClockType::now() - workUnitStart).count();
+    stolen += numberOfStolen;
+  };
+
+  if (m_ThreadPool)
+  {
+    m_ThreadPool->Run(numberOfWorkUnits, workUnit);
+  }
+  else
+  {
+    m_MultiThreader->SetNumberOfWorkUnits(numberOfWorkUnits);
+    m_MultiThreader->ParallelizeArray(0, numberOfWorkUnits, workUnit, nullptr);
+  }
+
+  m_NumberOfStolenTiles = stolen;
+}
+
+
+template <unsigned int VImageDimension>
+double
+ProjectionTileScheduler<VImageDimension>::GetLoadImbalance() const
+{
+  double maximum = 0.0;
+  double sum = 0.0;
+  for (double time : m_WorkUnitTimes)
+  {
+    maximum = std::max(maximum, time);
+    sum += time;
+  }
+  if (sum <= 0.0)
+  {
+    return 1.0;
+  }
+  return maximum * m_WorkUnitTimes.size() / sum;
+}
+
+
+template <unsigned int VImageDimension>
+void
+ProjectionTileScheduler<VImageDimension>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "TileSize: " << m_TileSize << std::endl;
+  os << indent << "NumberOfWorkUnits: " << m_NumberOfWorkUnits << std::endl;
+  os << indent << "MultiThreader: " << m_MultiThreader.GetPointer() << std::endl;
+  os << indent << "ThreadPool: " << m_ThreadPool.GetPointer() << std::endl;
+  os << indent << "NumberOfTiles: " << m_Tiles.size() << std::endl;
+  os << indent << "NumberOfStolenTiles: " << m_NumberOfStolenTiles << std::endl;
+}
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,343 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionVolumeContext_h
+#define itkProjectionVolumeContext_h
+
+#include "itkImage.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkProjectionAlignedImageContainer.h"
+#include "itkProjectionMappedFile.h"
+#include "itkProjectionNumaTopology.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ProjectionVolumeContext
+ * \brief Data derived from a volume and shared by the projectors of that volume.
+ *
+ * The projectors of a registration all project the same moving image. This
+ * object owns the data they derive from it, so that it is computed and
+ * stored once whatever the number of projectors and views sharing it:
+ *
+ * - the attenuation image: the voxel values minus the Threshold, clamped to
+ *   zero, stored as float with the layout of the volume;
+ * - the bounding box of the voxels above the Threshold, which lets the
+ *   projectors skip the rays missing it;
+ * - with ComputeOccupancyGrid, an occupancy grid with one flag per block of
+ *   OccupancyBlockSize^3 voxels, set when the block has a voxel above the
+ *   Threshold;
+ * - a pyramid of NumberOfPyramidLevels attenuation images, each level
+ *   averaging blocks of 2x2x2 voxels of the previous one.
+ *
+ * The projectors read the full resolution attenuation image and the
+ * bounding box only. The occupancy grid and the coarser levels of the
+ * pyramid are for the callers, and are not computed unless requested:
+ * ComputeOccupancyGrid is off and NumberOfPyramidLevels is 1 by default.
+ *
+ * With ReplicatePerNumaNode, the full resolution attenuation image is
+ * copied once per NUMA node of the machine, each copy written by a thread
+ * bound to its node so that its pages are placed in the memory of that
+ * node. The copy of the first node then replaces the level 0 of the
+ * pyramid, so that the volume is held once per node. GetAttenuationBuffer() returns the copy of the node running the
+ * calling thread, and the projectors read the volume from the local memory
+ * of their socket. Threads bound to a node, see
+ * ProjectionThreadPool::BindThreadsToNumaNodes, keep reading the same copy.
+ * The option has no effect on a machine with a single node.
+ *
+ * The attenuation images are allocated by a ProjectionAlignedImageContainer.
+ * With UseHugePages, they are backed by huge pages where the system grants
+ * them, which cuts the TLB misses of the rays through a large volume;
+ * GetHugePageBytes() reports how much was actually obtained.
+ *
+ * WriteCacheFile() saves the derived data to a versioned binary file, which
+ * ReadCacheFile() maps into memory instead of computing it again: the
+ * images of the context then point into the pages of the file, which are
+ * only read when the rays reach them and are shared by all the processes
+ * mapping the same file. The volume itself is not needed any more; the
+ * input image is replaced by an image with its geometry and no pixels.
+ * The file records the SourceFileName of the volume, with its size and
+ * modification time, and the geometry of the volume, so that a cache file
+ * built from another volume, or from an older version of the file, is
+ * rejected instead of being projected.
+ *
+ * Update() computes the data if the volume or the settings changed since
+ * the last computation. The projectors use the context only while it is
+ * up to date for their input image and Threshold, and fall back to the
+ * volume otherwise.
+ *
+ * \sa ProjectionInterpolateImageFunction
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage>
+class ProjectionVolumeContext : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ProjectionVolumeContext);
+
+  /** Standard class type alias. */
+  using Self = ProjectionVolumeContext;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ProjectionVolumeContext, Object);
+
+  using InputImageType = TInputImage;
+  using InputPixelType = typename InputImageType::PixelType;
+  using RegionType = typename InputImageType::RegionType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  using AttenuationImageType = Image<float, ImageDimension>;
+  using OccupancyGridType = Image<unsigned char, ImageDimension>;
+
+  /** Set and get the volume. */
+  itkSetConstObjectMacro(InputImage, InputImageType);
+  itkGetConstObjectMacro(InputImage, InputImageType);
+
+  /** Set and get the file the volume was read from, which identifies the
+   * volume in the cache files. */
+  itkSetStringMacro(SourceFileName);
+  itkGetStringMacro(SourceFileName);
+
+  /** Set and get the threshold below which the voxels are ignored. */
+  itkSetMacro(Threshold, double);
+  itkGetConstMacro(Threshold, double);
+
+  /** Set and get whether the occupancy grid is computed. */
+  itkSetMacro(ComputeOccupancyGrid, bool);
+  itkGetConstMacro(ComputeOccupancyGrid, bool);
+  itkBooleanMacro(ComputeOccupancyGrid);
+
+  /** Set and get the size, in voxels, of the blocks of the occupancy grid. */
+  itkSetClampMacro(OccupancyBlockSize, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(OccupancyBlockSize, unsigned int);
+
+  /** Set and get the number of levels of the pyramid, including the full
+   * resolution attenuation image. */
+  itkSetClampMacro(NumberOfPyramidLevels, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(NumberOfPyramidLevels, unsigned int);
+
+  /** Set and get whether the attenuation image is copied to the memory of
+   * each NUMA node. */
+  itkSetMacro(ReplicatePerNumaNode, bool);
+  itkGetConstMacro(ReplicatePerNumaNode, bool);
+  itkBooleanMacro(ReplicatePerNumaNode);
+
+  /** Set and get whether the attenuation images are backed by huge pages. */
+  itkSetMacro(UseHugePages, bool);
+  itkGetConstMacro(UseHugePages, bool);
+  itkBooleanMacro(UseHugePages);
+
+  /** Compute the derived data if needed. */
+  void
+  Update();
+
+  /** Whether the derived data matches the current volume and settings. */
+  bool
+  IsUpToDate() const;
+
+  /** Attenuation image at full resolution. */
+  const AttenuationImageType *
+  GetAttenuationImage() const
+  {
+    return this->GetPyramidLevel(0);
+  }
+
+  /** Attenuation image of a level of the pyramid, the level 0 being the
+   * full resolution. */
+  const AttenuationImageType *
+  GetPyramidLevel(unsigned int level) const;
+
+  /** Buffer of the full resolution attenuation image to be read by the
+   * calling thread: the copy of its NUMA node if the image is replicated.
+   * Fetch it on the thread that reads it, once per ray or batch of rays,
+   * rather than sharing one pointer across threads. */
+  const float *
+  GetAttenuationBuffer() const;
+
+  /** Number of copies of the attenuation image, one per NUMA node, or zero
+   * if it is not replicated. */
+  unsigned int
+  GetNumberOfReplicas() const
+  {
+    return static_cast<unsigned int>(m_Replicas.size());
+  }
+
+  /** Smallest region enclosing the voxels above the threshold. Its size is
+   * zero if there is none. */
+  itkGetConstReferenceMacro(BoundingBox, RegionType);
+
+  /** Occupancy grid, or nullptr if ComputeOccupancyGrid is off. */
+  itkGetConstObjectMacro(OccupancyGrid, OccupancyGridType);
+
+  /** Whether the line through source in direction ray, both given in the
+   * coordinate system of the volume, passes at less than margin voxels
+   * from the bounding box. */
+  bool
+  RayIntersectsBoundingBox(const double source[3], const double ray[3], double margin) const;
+
+  /** Save the derived data, which must be up to date, to a cache file.
+   * The file is written under a temporary name and renamed once complete,
+   * so that a process reading it concurrently never sees a partial file. */
+  void
+  WriteCacheFile(const std::string & fileName) const;
+
+  /** Map the derived data saved in a cache file. The Threshold, the
+   * OccupancyBlockSize, the NumberOfPyramidLevels and whether there is an
+   * occupancy grid are those of the file,
+   * and the InputImage is replaced by an image with the geometry of the
+   * cached volume and no buffer, to be projected by the interpolators
+   * sharing the context. The mapped images must not be modified. An
+   * exception is thrown if the file is not a cache file of this version,
+   * if the SourceFileName is set and the file was built from another file
+   * or another version of it, or if the InputImage is set and the size,
+   * spacing, origin or direction of its largest possible region differ
+   * from those of the cached volume. The InputImage only needs its
+   * geometry for this check, e.g. read by ReadImageInformation(). */
+  void
+  ReadCacheFile(const std::string & fileName);
+
+  /** Version of the cache file format written by WriteCacheFile(). */
+  static constexpr std::uint32_t CacheFileVersion = 2;
+
+  /** Memory taken by the derived data, in bytes. */
+  SizeValueType
+  GetMemorySize() const;
+
+  /** Bytes of the attenuation images, replicas included, lying in huge
+   * pages. */
+  SizeValueType
+  GetHugePageBytes() const;
+
+protected:
+  ProjectionVolumeContext();
+  ~ProjectionVolumeContext() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  using AttenuationContainerType = ProjectionAlignedImageContainer<SizeValueType, float>;
+
+  /** Allocate the buffer of an attenuation image, whose regions are set. */
+  void
+  AllocateAttenuationImage(AttenuationImageType * image) const;
+
+  void
+  ComputeAttenuationImage();
+
+  void
+  ComputeBoundingBoxAndOccupancyGrid();
+
+  void
+  ComputePyramid();
+
+  void
+  ComputeReplicas();
+
+  /** Set the bounding box and the box in the coordinates of the volume. */
+  void
+  SetBoundingBox(const RegionType & box, const typename AttenuationImageType::SpacingType & spacing);
+
+  /** Header of a cache file. It is followed by one CacheFileLevel per level
+   * of the pyramid and the SourceFileNameLength characters of the source
+   * file name, then by the occupancy grid, if any, and the attenuation
+   * images, each starting on a multiple of CacheFileAlignment bytes. The
+   * OccupancyGridSize is zero if there is no occupancy grid. */
+  struct CacheFileHeader
+  {
+    char          Magic[8];
+    std::uint32_t Version;
+    std::uint32_t ByteOrder;
+    std::uint32_t Dimension;
+    std::uint32_t NumberOfPyramidLevels;
+    std::uint64_t OccupancyBlockSize;
+    double        Threshold;
+    double        Origin[ImageDimension];
+    double        Direction[ImageDimension * ImageDimension];
+    std::int64_t  BoxIndex[ImageDimension];
+    std::uint64_t BoxSize[ImageDimension];
+    std::uint64_t OccupancyGridSize[ImageDimension];
+    std::uint64_t OccupancyGridOffset;
+    std::uint64_t SourceFileNameLength;
+    std::uint64_t SourceFileSize;
+    std::int64_t  SourceFileTime;
+  };
+
+  struct CacheFileLevel
+  {
+    std::int64_t  Index[ImageDimension];
+    std::uint64_t Size[ImageDimension];
+    double        Spacing[ImageDimension];
+    std::uint64_t Offset;
+  };
+
+  static constexpr std::uint64_t CacheFileAlignment = 4096;
+
+  /** Point the buffer of an image, whose regions are set, to the data at
+   * offset in a mapped cache file. */
+  template <typename TImage>
+  void
+  MapCacheFileImage(TImage * image, const ProjectionMappedFile * mappedFile, std::uint64_t offset) const;
+
+  typename InputImageType::ConstPointer m_InputImage;
+  std::string                           m_SourceFileName;
+
+  double       m_Threshold;
+  bool         m_ComputeOccupancyGrid;
+  unsigned int m_OccupancyBlockSize;
+  unsigned int m_NumberOfPyramidLevels;
+  bool         m_ReplicatePerNumaNode;
+  bool         m_UseHugePages;
+
+  std::vector<typename AttenuationImageType::Pointer> m_Pyramid;
+
+  // Copies of the attenuation image, indexed by NUMA node
+  std::vector<typename AttenuationImageType::Pointer> m_Replicas;
+
+  RegionType                          m_BoundingBox;
+  typename OccupancyGridType::Pointer m_OccupancyGrid;
+
+  // Cache file the data is mapped from, if any
+  ProjectionMappedFile::Pointer m_MappedFile;
+
+  // Box of the voxels above the threshold, in the coordinates of the volume
+  double m_BoxMinimum[ImageDimension];
+  double m_BoxMaximum[ImageDimension];
+
+  TimeStamp m_UpdateTime;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkProjectionVolumeContext.hxx"
+#endif
+
+#endif
@@ -0,0 +1,780 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkProjectionVolumeContext_hxx
+#define itkProjectionVolumeContext_hxx
+
+#include "itkProjectionVolumeContext.h"
+
+#include "itkMultiThreaderBase.h"
+#include "itksys/SystemTools.hxx"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace itk
+{
+
+template <typename TInputImage>
+ProjectionVolumeContext<TInputImage>::ProjectionVolumeContext()
+{
+  m_Threshold = 0.0;
+  m_ComputeOccupancyGrid = false;
+  m_OccupancyBlockSize = 8;
+  m_NumberOfPyramidLevels = 1;
+  m_ReplicatePerNumaNode = false;
+  m_UseHugePages = false;
+
+  std::fill(m_BoxMinimum, m_BoxMinimum + ImageDimension, 0.0);
+  std::fill(m_BoxMaximum, m_BoxMaximum + ImageDimension, 0.0);
+}
+
+
+template <typename TInputImage>
+bool
+ProjectionVolumeContext<TInputImage>::IsUpToDate() const
+{
+  return m_InputImage && !m_Pyramid.empty() && m_UpdateTime.GetMTime() > this->GetMTime() &&
+         m_UpdateTime.GetMTime() >= m_InputImage->GetMTime();
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::Update()
+{
+  if (!m_InputImage)
+  {
+    itkExceptionMacro(<< "InputImage is not present");
+  }
+  if (this->IsUpToDate())
+  {
+    return;
+  }
+  if (!m_InputImage->GetBufferPointer())
+  {
+    itkExceptionMacro(<< "InputImage has no buffer: the derived data cannot be computed");
+  }
+
+  m_Pyramid.clear();
+  m_Replicas.clear();
+  m_MappedFile = nullptr;
+  this->ComputeAttenuationImage();
+  this->ComputeBoundingBoxAndOccupancyGrid();
+  this->ComputePyramid();
+  if (m_ReplicatePerNumaNode && ProjectionNumaTopology::GetNumberOfNodes() > 1)
+  {
+    this->ComputeReplicas();
+  }
+
+  m_UpdateTime.Modified();
+}
+
+
+template <typename TInputImage>
+const typename ProjectionVolumeContext<TInputImage>::AttenuationImageType *
+ProjectionVolumeContext<TInputImage>::GetPyramidLevel(unsigned int level) const
+{
+  if (level >= m_Pyramid.size())
+  {
+    itkExceptionMacro(<< "Pyramid level " << level << " is not available");
+  }
+  return m_Pyramid[level].GetPointer();
+}
+
+
+template <typename TInputImage>
+const float *
+ProjectionVolumeContext<TInputImage>::GetAttenuationBuffer() const
+{
+  if (!m_Replicas.empty())
+  {
+    return m_Replicas[ProjectionNumaTopology::GetCurrentNode() % m_Replicas.size()]->GetBufferPointer();
+  }
+  return this->GetAttenuationImage()->GetBufferPointer();
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::AllocateAttenuationImage(AttenuationImageType * image) const
+{
+  typename AttenuationContainerType::Pointer container = AttenuationContainerType::New();
+  container->SetUseHugePages(m_UseHugePages);
+  image->SetPixelContainer(container);
+  image->Allocate();
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::ComputeAttenuationImage()
+{
+  const RegionType region = m_InputImage->GetBufferedRegion();
+
+  typename AttenuationImageType::Pointer attenuation = AttenuationImageType::New();
+  attenuation->SetRegions(region);
+  attenuation->SetSpacing(m_InputImage->GetSpacing());
+  attenuation->SetOrigin(m_InputImage->GetOrigin());
+  attenuation->SetDirection(m_InputImage->GetDirection());
+  this->AllocateAttenuationImage(attenuation);
+
+  const InputPixelType * input = m_InputImage->GetBufferPointer();
+  float *                output = attenuation->GetBufferPointer();
+  const SizeValueType    sliceSize = region.GetSize()[0] * region.GetSize()[1];
+  const double           threshold = m_Threshold;
+
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  threader->ParallelizeArray(
+    0,
+    region.GetSize()[2],
+    [=](SizeValueType z) {
+      for (SizeValueType k = z * sliceSize; k < (z + 1) * sliceSize; ++k)
+      {
+        output[k] = static_cast<float>(std::max(static_cast<double>(input[k]) - threshold, 0.0));
+      }
+    },
+    nullptr);
+
+  m_Pyramid.push_back(attenuation);
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::ComputeBoundingBoxAndOccupancyGrid()
+{
+  const AttenuationImageType *               attenuation = m_Pyramid[0];
+  const typename RegionType::SizeType        size = attenuation->GetBufferedRegion().GetSize();
+  const typename RegionType::IndexType       start = attenuation->GetBufferedRegion().GetIndex();
+  const float *                              buffer = attenuation->GetBufferPointer();
+  const SizeValueType                        blockSize = m_OccupancyBlockSize;
+  typename OccupancyGridType::SizeType       gridSize;
+  typename OccupancyGridType::SpacingType    gridSpacing;
+  const typename InputImageType::SpacingType spacing = attenuation->GetSpacing();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    gridSize[i] = (size[i] + blockSize - 1) / blockSize;
+    gridSpacing[i] = spacing[i] * blockSize;
+  }
+
+  // The layers of blocks are scanned in parallel, whether the grid is
+  // computed or not.
+  unsigned char * occupancy = nullptr;
+  m_OccupancyGrid = nullptr;
+  if (m_ComputeOccupancyGrid)
+  {
+    m_OccupancyGrid = OccupancyGridType::New();
+    m_OccupancyGrid->SetRegions(gridSize);
+    m_OccupancyGrid->SetSpacing(gridSpacing);
+    m_OccupancyGrid->SetOrigin(attenuation->GetOrigin());
+    m_OccupancyGrid->SetDirection(attenuation->GetDirection());
+    m_OccupancyGrid->Allocate(true);
+    occupancy = m_OccupancyGrid->GetBufferPointer();
+  }
+
+  // Each layer of blocks is scanned separately; the bounds are merged below.
+  std::vector<IndexValueType> lower(gridSize[2] * 3, NumericTraits<IndexValueType>::max());
+  std::vector<IndexValueType> upper(gridSize[2] * 3, NumericTraits<IndexValueType>::NonpositiveMin());
+
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  threader->ParallelizeArray(
+    0,
+    gridSize[2],
+    [&](SizeValueType bz) {
+      IndexValueType *    layerLower = lower.data() + 3 * bz;
+      IndexValueType *    layerUpper = upper.data() + 3 * bz;
+      const SizeValueType lastZ = std::min((bz + 1) * blockSize, static_cast<SizeValueType>(size[2]));
+      for (SizeValueType z = bz * blockSize; z < lastZ; ++z)
+      {
+        for (SizeValueType y = 0; y < size[1]; ++y)
+        {
+          const float * row = buffer + (z * size[1] + y) * size[0];
+          for (SizeValueType x = 0; x < size[0]; ++x)
+          {
+            if (row[x] > 0)
+            {
+              const IndexValueType index[3] = { static_cast<IndexValueType>(x),
+                                                static_cast<IndexValueType>(y),
+                                                static_cast<IndexValueType>(z) };
+              for (unsigned int i = 0; i < 3; ++i)
+              {
+                layerLower[i] = std::min(layerLower[i], index[i]);
+                layerUpper[i] = std::max(layerUpper[i], index[i]);
+              }
+              if (occupancy)
+              {
+                occupancy[(bz * gridSize[1] + y / blockSize) * gridSize[0] + x / blockSize] = 1;
+              }
+            }
+          }
+        }
+      }
+    },
+    nullptr);
+
+  IndexValueType boxLower[3] = { NumericTraits<IndexValueType>::max(),
+                                 NumericTraits<IndexValueType>::max(),
+                                 NumericTraits<IndexValueType>::max() };
+  IndexValueType boxUpper[3] = { NumericTraits<IndexValueType>::NonpositiveMin(),
+                                 NumericTraits<IndexValueType>::NonpositiveMin(),
+                                 NumericTraits<IndexValueType>::NonpositiveMin() };
+  for (SizeValueType bz = 0; bz < gridSize[2]; ++bz)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      boxLower[i] = std::min(boxLower[i], lower[3 * bz + i]);
+      boxUpper[i] = std::max(boxUpper[i], upper[3 * bz + i]);
+    }
+  }
+
+  typename RegionType::IndexType boxIndex;
+  typename RegionType::SizeType  boxSize;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    if (boxLower[0] > boxUpper[0])
+    {
+      // No voxel above the threshold
+      boxIndex[i] = start[i];
+      boxSize[i] = 0;
+    }
+    else
+    {
+      boxIndex[i] = start[i] + boxLower[i];
+      boxSize[i] = static_cast<SizeValueType>(boxUpper[i] - boxLower[i] + 1);
+    }
+  }
+  this->SetBoundingBox(RegionType(boxIndex, boxSize), spacing);
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::SetBoundingBox(const RegionType &                                 box,
+                                                     const typename AttenuationImageType::SpacingType & spacing)
+{
+  m_BoundingBox = box;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    // Voxel i spans [i, i+1) times the spacing, as in the ray casters
+    m_BoxMinimum[i] = box.GetIndex()[i] * spacing[i];
+    m_BoxMaximum[i] = (box.GetIndex()[i] + static_cast<IndexValueType>(box.GetSize()[i])) * spacing[i];
+  }
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::ComputePyramid()
+{
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+
+  for (unsigned int level = 1; level < m_NumberOfPyramidLevels; ++level)
+  {
+    const AttenuationImageType *                  fine = m_Pyramid[level - 1];
+    const typename AttenuationImageType::SizeType fineSize = fine->GetBufferedRegion().GetSize();
+    typename AttenuationImageType::SizeType       coarseSize;
+    typename AttenuationImageType::SpacingType    coarseSpacing;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      coarseSize[i] = (fineSize[i] + 1) / 2;
+      coarseSpacing[i] = 2.0 * fine->GetSpacing()[i];
+    }
+
+    typename AttenuationImageType::Pointer coarse = AttenuationImageType::New();
+    coarse->SetRegions(coarseSize);
+    coarse->SetSpacing(coarseSpacing);
+    coarse->SetOrigin(fine->GetOrigin());
+    coarse->SetDirection(fine->GetDirection());
+    this->AllocateAttenuationImage(coarse);
+
+    const float * fineBuffer = fine->GetBufferPointer();
+    float *       coarseBuffer = coarse->GetBufferPointer();
+
+    // Average of the 2x2x2 fine voxels, those outside of the volume
+    // counting as zero
+    threader->ParallelizeArray(
+      0,
+      coarseSize[2],
+      [&](SizeValueType z) {
+        for (SizeValueType y = 0; y < coarseSize[1]; ++y)
+        {
+          for (SizeValueType x = 0; x < coarseSize[0]; ++x)
+          {
+            double sum = 0.0;
+            for (SizeValueType fz = 2 * z; fz < std::min(2 * z + 2, static_cast<SizeValueType>(fineSize[2])); ++fz)
+            {
+              for (SizeValueType fy = 2 * y; fy < std::min(2 * y + 2, static_cast<SizeValueType>(fineSize[1])); ++fy)
+              {
+                const float * row = fineBuffer + (fz * fineSize[1] + fy) * fineSize[0];
+                for (SizeValueType fx = 2 * x; fx < std::min(2 * x + 2, static_cast<SizeValueType>(fineSize[0])); ++fx)
+                {
+                  sum += row[fx];
+                }
+              }
+            }
+            coarseBuffer[(z * coarseSize[1] + y) * coarseSize[0] + x] = static_cast<float>(sum / 8.0);
+          }
+        }
+      },
+      nullptr);
+
+    m_Pyramid.push_back(coarse);
+  }
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::ComputeReplicas()
+{
+  const AttenuationImageType * attenuation = m_Pyramid[0];
+  const SizeValueType          numberOfPixels = attenuation->GetBufferedRegion().GetNumberOfPixels();
+  const float *                source = attenuation->GetBufferPointer();
+  const unsigned int           numberOfNodes = ProjectionNumaTopology::GetNumberOfNodes();
+
+  // The pages of the buffers are not touched by the allocation, so that
+  // they are placed on the node of the thread writing them first.
+  m_Replicas.resize(numberOfNodes);
+  for (typename AttenuationImageType::Pointer & replica : m_Replicas)
+  {
+    replica = AttenuationImageType::New();
+    replica->CopyInformation(attenuation);
+    replica->SetRegions(attenuation->GetBufferedRegion());
+    this->AllocateAttenuationImage(replica);
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(numberOfNodes);
+  for (unsigned int node = 0; node < numberOfNodes; ++node)
+  {
+    float * destination = m_Replicas[node]->GetBufferPointer();
+    threads.emplace_back([=] {
+      ProjectionNumaTopology::BindCurrentThreadToNode(node);
+      std::copy(source, source + numberOfPixels, destination);
+    });
+  }
+  for (std::thread & thread : threads)
+  {
+    thread.join();
+  }
+
+  // The copy of the first node replaces the attenuation image, which is
+  // released, so that the volume is held once per node and not once more.
+  m_Pyramid[0] = m_Replicas[0];
+}
+
+
+template <typename TInputImage>
+bool
+ProjectionVolumeContext<TInputImage>::RayIntersectsBoundingBox(const double source[3],
+                                                               const double ray[3],
+                                                               double       margin) const
+{
+  if (m_BoundingBox.GetNumberOfPixels() == 0)
+  {
+    return false;
+  }
+
+  // Slab test on the whole line, as the ray casters integrate it all
+  const typename AttenuationImageType::SpacingType spacing = m_Pyramid[0]->GetSpacing();
+  double                                           enter = -NumericTraits<double>::max();
+  double                                           leave = NumericTraits<double>::max();
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    const double minimum = m_BoxMinimum[i] - margin * spacing[i];
+    const double maximum = m_BoxMaximum[i] + margin * spacing[i];
+    if (ray[i] == 0)
+    {
+      if (source[i] < minimum || source[i] > maximum)
+      {
+        return false;
+      }
+      continue;
+    }
+    double alpha1 = (minimum - source[i]) / ray[i];
+    double alpha2 = (maximum - source[i]) / ray[i];
+    if (alpha1 > alpha2)
+    {
+      std::swap(alpha1, alpha2);
+    }
+    enter = std::max(enter, alpha1);
+    leave = std::min(leave, alpha2);
+  }
+  return enter <= leave;
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::WriteCacheFile(const std::string & fileName) const
+{
+  if (!this->IsUpToDate())
+  {
+    itkExceptionMacro(<< "The derived data is not up to date");
+  }
+
+  const auto roundUp = [](std::uint64_t offset) -> std::uint64_t {
+    return (offset + CacheFileAlignment - 1) / CacheFileAlignment * CacheFileAlignment;
+  };
+
+  CacheFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.Magic, "ITKPVCTX", sizeof(header.Magic));
+  header.Version = CacheFileVersion;
+  header.ByteOrder = 0x01020304;
+  header.Dimension = ImageDimension;
+  header.NumberOfPyramidLevels = static_cast<std::uint32_t>(m_Pyramid.size());
+  header.OccupancyBlockSize = m_OccupancyBlockSize;
+  header.Threshold = m_Threshold;
+  const AttenuationImageType * attenuation = m_Pyramid[0];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    header.Origin[i] = attenuation->GetOrigin()[i];
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      header.Direction[i * ImageDimension + j] = attenuation->GetDirection()[i][j];
+    }
+    header.BoxIndex[i] = m_BoundingBox.GetIndex()[i];
+    header.BoxSize[i] = m_BoundingBox.GetSize()[i];
+    header.OccupancyGridSize[i] = m_OccupancyGrid ? m_OccupancyGrid->GetBufferedRegion().GetSize()[i] : 0;
+  }
+
+  // Identity of the file the volume was read from
+  const std::string sourceFileName =
+    m_SourceFileName.empty() ? std::string() : itksys::SystemTools::CollapseFullPath(m_SourceFileName);
+  header.SourceFileNameLength = sourceFileName.size();
+  if (!sourceFileName.empty())
+  {
+    header.SourceFileSize = itksys::SystemTools::FileLength(sourceFileName);
+    header.SourceFileTime = itksys::SystemTools::ModifiedTime(sourceFileName);
+  }
+
+  const std::uint64_t occupancyBytes = m_OccupancyGrid ? m_OccupancyGrid->GetBufferedRegion().GetNumberOfPixels() : 0;
+  header.OccupancyGridOffset =
+    roundUp(sizeof(CacheFileHeader) + m_Pyramid.size() * sizeof(CacheFileLevel) + sourceFileName.size());
+
+  std::vector<CacheFileLevel> levels(m_Pyramid.size());
+  std::uint64_t               end = header.OccupancyGridOffset + occupancyBytes;
+  for (unsigned int level = 0; level < m_Pyramid.size(); ++level)
+  {
+    const RegionType region = m_Pyramid[level]->GetBufferedRegion();
+    std::memset(&levels[level], 0, sizeof(CacheFileLevel));
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      levels[level].Index[i] = region.GetIndex()[i];
+      levels[level].Size[i] = region.GetSize()[i];
+      levels[level].Spacing[i] = m_Pyramid[level]->GetSpacing()[i];
+    }
+    levels[level].Offset = roundUp(end);
+    end = levels[level].Offset + region.GetNumberOfPixels() * sizeof(float);
+  }
+
+  const std::string temporaryName = fileName + ".tmp";
+  {
+    std::ofstream file(temporaryName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+      itkExceptionMacro(<< "Cannot create " << temporaryName);
+    }
+    std::uint64_t position = 0;
+    const auto    write = [&](std::uint64_t offset, const void * data, std::uint64_t size) {
+      const std::vector<char> padding(offset - position, 0);
+      file.write(padding.data(), padding.size());
+      file.write(static_cast<const char *>(data), size);
+      position = offset + size;
+    };
+    write(0, &header, sizeof(header));
+    write(position, levels.data(), levels.size() * sizeof(CacheFileLevel));
+    write(position, sourceFileName.data(), sourceFileName.size());
+    if (m_OccupancyGrid)
+    {
+      write(header.OccupancyGridOffset, m_OccupancyGrid->GetBufferPointer(), occupancyBytes);
+    }
+    for (unsigned int level = 0; level < m_Pyramid.size(); ++level)
+    {
+      write(levels[level].Offset,
+            m_Pyramid[level]->GetBufferPointer(),
+            m_Pyramid[level]->GetBufferedRegion().GetNumberOfPixels() * sizeof(float));
+    }
+    if (!file.flush())
+    {
+      itkExceptionMacro(<< "Cannot write " << temporaryName);
+    }
+  }
+  std::remove(fileName.c_str());
+  if (std::rename(temporaryName.c_str(), fileName.c_str()) != 0)
+  {
+    std::remove(temporaryName.c_str());
+    itkExceptionMacro(<< "Cannot rename " << temporaryName << " to " << fileName);
+  }
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::ReadCacheFile(const std::string & fileName)
+{
+  ProjectionMappedFile::Pointer mappedFile = ProjectionMappedFile::New();
+  mappedFile->Map(fileName);
+  const char * data = static_cast<const char *>(mappedFile->GetData());
+  const auto   fileSize = static_cast<std::uint64_t>(mappedFile->GetSize());
+
+  CacheFileHeader header;
+  if (fileSize < sizeof(header))
+  {
+    itkExceptionMacro(<< fileName << " is not a volume context cache file");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.Magic, "ITKPVCTX", sizeof(header.Magic)) != 0)
+  {
+    itkExceptionMacro(<< fileName << " is not a volume context cache file");
+  }
+  if (header.Version != CacheFileVersion || header.ByteOrder != 0x01020304 || header.Dimension != ImageDimension)
+  {
+    itkExceptionMacro(<< fileName << " has version " << header.Version << " or a byte order or dimension"
+                      << " not supported; expected version " << CacheFileVersion << " and dimension "
+                      << ImageDimension);
+  }
+  const std::uint64_t levelsBytes = header.NumberOfPyramidLevels * sizeof(CacheFileLevel);
+  if (header.NumberOfPyramidLevels == 0 || sizeof(header) + levelsBytes + header.SourceFileNameLength > fileSize)
+  {
+    itkExceptionMacro(<< fileName << " is truncated");
+  }
+  std::vector<CacheFileLevel> levels(header.NumberOfPyramidLevels);
+  std::memcpy(levels.data(), data + sizeof(header), levelsBytes);
+
+  // The cache must have been built from the current version of the source
+  // file, when it is known.
+  const std::string cachedSourceFileName(data + sizeof(header) + levelsBytes, header.SourceFileNameLength);
+  if (!m_SourceFileName.empty())
+  {
+    const std::string sourceFileName = itksys::SystemTools::CollapseFullPath(m_SourceFileName);
+    if (cachedSourceFileName != sourceFileName ||
+        header.SourceFileSize != static_cast<std::uint64_t>(itksys::SystemTools::FileLength(sourceFileName)) ||
+        header.SourceFileTime != static_cast<std::int64_t>(itksys::SystemTools::ModifiedTime(sourceFileName)))
+    {
+      itkExceptionMacro(<< fileName << " was built from "
+                        << (cachedSourceFileName.empty() ? std::string("an unknown file") : cachedSourceFileName)
+                        << ", not from the current version of " << sourceFileName);
+    }
+  }
+
+  typename AttenuationImageType::PointType     origin;
+  typename AttenuationImageType::DirectionType direction;
+  typename OccupancyGridType::SizeType         gridSize;
+  RegionType                                   box;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    origin[i] = header.Origin[i];
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      direction[i][j] = header.Direction[i * ImageDimension + j];
+    }
+    gridSize[i] = header.OccupancyGridSize[i];
+    box.SetIndex(i, header.BoxIndex[i]);
+    box.SetSize(i, header.BoxSize[i]);
+  }
+
+  // The volume the cache is read for must have the geometry of the cached
+  // one, within the tolerances of the ITK filters.
+  if (m_InputImage)
+  {
+    const double     tolerance = 1e-6;
+    const RegionType inputRegion = m_InputImage->GetLargestPossibleRegion();
+    bool             sameGeometry = true;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const double spacing = levels[0].Spacing[i];
+      sameGeometry = sameGeometry && inputRegion.GetIndex(i) == levels[0].Index[i] &&
+                     inputRegion.GetSize(i) == levels[0].Size[i] &&
+                     std::abs(m_InputImage->GetSpacing()[i] - spacing) <= tolerance * spacing &&
+                     std::abs(m_InputImage->GetOrigin()[i] - origin[i]) <= tolerance * spacing;
+      for (unsigned int j = 0; j < ImageDimension; ++j)
+      {
+        sameGeometry = sameGeometry && std::abs(m_InputImage->GetDirection()[i][j] - direction[i][j]) <= tolerance;
+      }
+    }
+    if (!sameGeometry)
+    {
+      itkExceptionMacro(<< fileName << " was built from a volume of another size, spacing, origin or direction than "
+                        << "the InputImage");
+    }
+  }
+
+  std::vector<typename AttenuationImageType::Pointer> pyramid;
+  for (const CacheFileLevel & level : levels)
+  {
+    RegionType                                 region;
+    typename AttenuationImageType::SpacingType spacing;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      region.SetIndex(i, level.Index[i]);
+      region.SetSize(i, level.Size[i]);
+      spacing[i] = level.Spacing[i];
+    }
+    typename AttenuationImageType::Pointer image = AttenuationImageType::New();
+    image->SetRegions(region);
+    image->SetSpacing(spacing);
+    image->SetOrigin(origin);
+    image->SetDirection(direction);
+    this->MapCacheFileImage(image.GetPointer(), mappedFile, level.Offset);
+    pyramid.push_back(image);
+  }
+
+  // The grid has a zero size if it was not computed.
+  typename OccupancyGridType::Pointer occupancyGrid;
+  if (gridSize[0] > 0)
+  {
+    typename OccupancyGridType::SpacingType gridSpacing;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      gridSpacing[i] = pyramid[0]->GetSpacing()[i] * header.OccupancyBlockSize;
+    }
+    occupancyGrid = OccupancyGridType::New();
+    occupancyGrid->SetRegions(gridSize);
+    occupancyGrid->SetSpacing(gridSpacing);
+    occupancyGrid->SetOrigin(origin);
+    occupancyGrid->SetDirection(direction);
+    this->MapCacheFileImage(occupancyGrid.GetPointer(), mappedFile, header.OccupancyGridOffset);
+  }
+
+  // Geometry of the cached volume, without pixels
+  typename InputImageType::Pointer input = InputImageType::New();
+  input->CopyInformation(pyramid[0]);
+  input->SetRegions(pyramid[0]->GetBufferedRegion());
+
+  this->SetInputImage(input);
+  this->SetThreshold(header.Threshold);
+  this->SetComputeOccupancyGrid(occupancyGrid.IsNotNull());
+  this->SetOccupancyBlockSize(static_cast<unsigned int>(header.OccupancyBlockSize));
+  this->SetNumberOfPyramidLevels(header.NumberOfPyramidLevels);
+
+  m_Pyramid = pyramid;
+  m_Replicas.clear();
+  m_OccupancyGrid = occupancyGrid;
+  this->SetBoundingBox(box, pyramid[0]->GetSpacing());
+  m_MappedFile = mappedFile;
+  if (m_ReplicatePerNumaNode && ProjectionNumaTopology::GetNumberOfNodes() > 1)
+  {
+    this->ComputeReplicas();
+  }
+
+  m_UpdateTime.Modified();
+}
+
+
+template <typename TInputImage>
+template <typename TImage>
+void
+ProjectionVolumeContext<TInputImage>::MapCacheFileImage(TImage *                     image,
+                                                        const ProjectionMappedFile * mappedFile,
+                                                        std::uint64_t                offset) const
+{
+  using PixelType = typename TImage::PixelType;
+
+  const SizeValueType numberOfPixels = image->GetBufferedRegion().GetNumberOfPixels();
+  if (offset % alignof(PixelType) != 0 || offset + numberOfPixels * sizeof(PixelType) > mappedFile->GetSize())
+  {
+    itkExceptionMacro(<< mappedFile->GetFileName() << " is truncated");
+  }
+
+  // The image points into the mapping, which it does not own: the
+  // container neither copies nor frees the pages.
+  const char * data = static_cast<const char *>(mappedFile->GetData()) + offset;
+  image->GetPixelContainer()->SetImportPointer(
+    reinterpret_cast<PixelType *>(const_cast<char *>(data)), numberOfPixels, false);
+}
+
+
+template <typename TInputImage>
+SizeValueType
+ProjectionVolumeContext<TInputImage>::GetMemorySize() const
+{
+  SizeValueType size = 0;
+  for (const typename AttenuationImageType::Pointer & level : m_Pyramid)
+  {
+    size += level->GetBufferedRegion().GetNumberOfPixels() * sizeof(float);
+  }
+  // The first replica is the level 0 of the pyramid
+  for (unsigned int node = 1; node < m_Replicas.size(); ++node)
+  {
+    size += m_Replicas[node]->GetBufferedRegion().GetNumberOfPixels() * sizeof(float);
+  }
+  if (m_OccupancyGrid)
+  {
+    size += m_OccupancyGrid->GetBufferedRegion().GetNumberOfPixels();
+  }
+  return size;
+}
+
+
+template <typename TInputImage>
+SizeValueType
+ProjectionVolumeContext<TInputImage>::GetHugePageBytes() const
+{
+  // The first replica is the level 0 of the pyramid
+  std::vector<const AttenuationImageType *> images;
+  for (const typename AttenuationImageType::Pointer & level : m_Pyramid)
+  {
+    images.push_back(level);
+  }
+  for (unsigned int node = 1; node < m_Replicas.size(); ++node)
+  {
+    images.push_back(m_Replicas[node]);
+  }
+
+  SizeValueType bytes = 0;
+  for (const AttenuationImageType * image : images)
+  {
+    const auto * container = dynamic_cast<const AttenuationContainerType *>(image->GetPixelContainer());
+    if (container)
+    {
+      bytes += container->GetHugePageBytes();
+    }
+  }
+  return bytes;
+}
+
+
+template <typename TInputImage>
+void
+ProjectionVolumeContext<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "InputImage: " << m_InputImage.GetPointer() << std::endl;
+  os << indent << "SourceFileName: " << m_SourceFileName << std::endl;
+  os << indent << "Threshold: " << m_Threshold << std::endl;
+  os << indent << "ComputeOccupancyGrid: " << m_ComputeOccupancyGrid << std::endl;
+  os << indent << "OccupancyBlockSize: " << m_OccupancyBlockSize << std::endl;
+  os << indent << "NumberOfPyramidLevels: " << m_NumberOfPyramidLevels << std::endl;
+  os << indent << "ReplicatePerNumaNode: " << m_ReplicatePerNumaNode << std::endl;
+  os << indent << "NumberOfReplicas: " << m_Replicas.size() << std::endl;
+  os << indent << "UseHugePages: " << m_UseHugePages << std::endl;
+  os << indent << "HugePageBytes: " << this->GetHugePageBytes() << std::endl;
+  os << indent << "BoundingBox: " << m_BoundingBox << std::endl;
+  os << indent << "MappedFile: " << m_MappedFile.GetPointer() << std::endl;
+  os << indent << "MemorySize: " << this->GetMemorySize() << std::endl;
+}
+
+} // namespace itk
+
+#endif
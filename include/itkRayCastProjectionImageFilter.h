@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRayCastProjectionImageFilter_h
+#define itkRayCastProjectionImageFilter_h
+
+#include "itkProjectionImageFilter.h"
+#include "itkProjectionTileScheduler.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+
+namespace itk
+{
+
+/** \class RayCastProjectionImageFilter
+ * \brief Compute a DRR by casting the rays of a projection interpolator tile by tile.
+ *
+ * This filter produces the same image as a ResampleImageFilter driven by
+ * the Interpolator, SiddonJacobsRayCastInterpolateImageFunction by
+ * default, but traverses the detector in small square tiles scheduled by a
+ * ProjectionTileScheduler. The rows of a tile are cast with
+ * EvaluateScanline(), so that the rays of a tile share their setup and
+ * cross neighbouring voxels, and the work stealing of the scheduler keeps
+ * all the threads busy however unevenly the rays are spread over the
+ * volume.
+ *
+ * The geometry of the filter is copied to the Interpolator before the
+ * rays are cast. The time spent on each tile is available from the
+ * TileScheduler after an update. A ProjectionThreadPool set on the
+ * TileScheduler runs the tiles on persistent threads, which saves the
+ * dispatch of the threads when many small DRRs are computed in a row.
+ *
+ * The post-processing of a DRR written to a file may be done as the rays
+ * are cast, rather than by a FlipImageFilter and a
+ * RescaleIntensityImageFilter each making a pass over a new image. The
+ * axes of FlipAxes are reversed, as by FlipImageFilter, without changing
+ * the grid of the output. If RescaleIntensity is on, the projections are
+ * mapped linearly from [WindowMinimum, WindowMaximum] onto
+ * [OutputMinimum, OutputMaximum] and clamped to it, as by
+ * IntensityWindowingImageFilter. If AutomaticWindow is on as well, the
+ * window is the range of the projections, as for
+ * RescaleIntensityImageFilter; the rays are then cast into a buffer of
+ * doubles which is mapped onto the output once they are all known. The
+ * projections are finally converted to the pixel type of the output, e.g.
+ * unsigned char.
+ *
+ * Unlike the other projectors, the filter computes only the requested
+ * region of the DRR, so that a large detector may be streamed, e.g. by an
+ * ImageFileWriter with several stream divisions, without holding the
+ * whole projection image in memory. The tiles of each requested region
+ * are still cast in parallel. The whole DRR is computed at once if the
+ * window is the range of the projections, since it is only known once
+ * all the rays are cast.
+ *
+ * \sa ProjectionTileScheduler
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage>
+class RayCastProjectionImageFilter : public ProjectionImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(RayCastProjectionImageFilter);
+
+  /** Standard class type alias. */
+  using Self = RayCastProjectionImageFilter;
+  using Superclass = ProjectionImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(RayCastProjectionImageFilter, ProjectionImageFilter);
+
+  using InputImageType = typename Superclass::InputImageType;
+  using OutputImageType = typename Superclass::OutputImageType;
+  using OutputPixelType = typename Superclass::OutputPixelType;
+  using OutputImageRegionType = typename Superclass::OutputImageRegionType;
+  using TransformType = typename Superclass::TransformType;
+  using PointType = typename Superclass::PointType;
+  using GeometryType = typename Superclass::GeometryType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = Superclass::ImageDimension;
+
+  using FlipAxesArrayType = FixedArray<bool, ImageDimension>;
+
+  /** Projector casting the rays. */
+  using InterpolatorType = GeometryType;
+  using DefaultInterpolatorType = SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
+
+  using TileSchedulerType = ProjectionTileScheduler<ImageDimension>;
+
+  /** Set and get the projector casting the rays. */
+  itkSetObjectMacro(Interpolator, InterpolatorType);
+  itkGetModifiableObjectMacro(Interpolator, InterpolatorType);
+
+  /** Set and get the scheduler distributing the tiles of the detector. */
+  itkSetObjectMacro(TileScheduler, TileSchedulerType);
+  itkGetModifiableObjectMacro(TileScheduler, TileSchedulerType);
+
+  /** Set and get the axes of the detector to flip. */
+  itkSetMacro(FlipAxes, FlipAxesArrayType);
+  itkGetConstReferenceMacro(FlipAxes, FlipAxesArrayType);
+
+  /** Set and get whether the projections are rescaled. */
+  itkSetMacro(RescaleIntensity, bool);
+  itkGetConstMacro(RescaleIntensity, bool);
+  itkBooleanMacro(RescaleIntensity);
+
+  /** Set and get whether the window is the range of the projections. */
+  itkSetMacro(AutomaticWindow, bool);
+  itkGetConstMacro(AutomaticWindow, bool);
+  itkBooleanMacro(AutomaticWindow);
+
+  /** Set and get the window of the projections, used if AutomaticWindow is
+   * off. */
+  itkSetMacro(WindowMinimum, double);
+  itkGetConstMacro(WindowMinimum, double);
+  itkSetMacro(WindowMaximum, double);
+  itkGetConstMacro(WindowMaximum, double);
+
+  /** Set and get the range the window is mapped onto. */
+  itkSetMacro(OutputMinimum, double);
+  itkGetConstMacro(OutputMinimum, double);
+  itkSetMacro(OutputMaximum, double);
+  itkGetConstMacro(OutputMaximum, double);
+
+protected:
+  RayCastProjectionImageFilter();
+  ~RayCastProjectionImageFilter() override = default;
+
+  /** Only the automatic window needs the whole projection image. */
+  void
+  EnlargeOutputRequestedRegion(DataObject * output) override;
+
+  void
+  GenerateData() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  typename InterpolatorType::Pointer  m_Interpolator;
+  typename TileSchedulerType::Pointer m_TileScheduler;
+
+  FlipAxesArrayType m_FlipAxes;
+  bool              m_RescaleIntensity;
+  bool              m_AutomaticWindow;
+  double            m_WindowMinimum;
+  double            m_WindowMaximum;
+  double            m_OutputMinimum;
+  double            m_OutputMaximum;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkRayCastProjectionImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,231 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRayCastProjectionImageFilter_hxx
+#define itkRayCastProjectionImageFilter_hxx
+
+#include "itkRayCastProjectionImageFilter.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+RayCastProjectionImageFilter<TInputImage, TOutputImage>::RayCastProjectionImageFilter()
+{
+  m_Interpolator = DefaultInterpolatorType::New();
+  m_TileScheduler = TileSchedulerType::New();
+
+  m_FlipAxes.Fill(false);
+  m_RescaleIntensity = false;
+  m_AutomaticWindow = true;
+  m_WindowMinimum = 0.0;
+  m_WindowMaximum = 255.0;
+  m_OutputMinimum = 0.0;
+  m_OutputMaximum = 255.0;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+RayCastProjectionImageFilter<TInputImage, TOutputImage>::EnlargeOutputRequestedRegion(DataObject * output)
+{
+  if (m_RescaleIntensity && m_AutomaticWindow)
+  {
+    Superclass::EnlargeOutputRequestedRegion(output);
+    return;
+  }
+  // The rays of a detector pixel do not depend on the other pixels.
+  Superclass::Superclass::EnlargeOutputRequestedRegion(output);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+RayCastProjectionImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  if (!m_Interpolator)
+  {
+    itkExceptionMacro(<< "Interpolator is not present");
+  }
+
+  this->AllocateOutputs();
+  this->UpdateProjectionGeometry();
+
+  // The inverse transform of the interpolator is computed here, once,
+  // rather than by the first ray of each thread.
+  m_Interpolator->SetInputImage(this->GetInput());
+  m_Interpolator->SetTransform(this->GetModifiableTransform());
+  m_Interpolator->SetProjectionAngle(this->GetProjectionAngle());
+  m_Interpolator->SetFocalPointToIsocenterDistance(this->GetFocalPointToIsocenterDistance());
+  m_Interpolator->SetThreshold(this->GetThreshold());
+  m_Interpolator->Initialize();
+
+  OutputImageType *           outputPtr = this->GetOutput();
+  const OutputImageRegionType outputRegion = outputPtr->GetRequestedRegion();
+  const OutputImageRegionType detectorRegion = outputPtr->GetLargestPossibleRegion();
+
+  // Step between two pixels of a detector row
+  typename OutputImageType::PointType     firstPoint, nextPoint;
+  ContinuousIndex<double, ImageDimension> index;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    index[i] = outputRegion.GetIndex()[i];
+  }
+  outputPtr->TransformContinuousIndexToPhysicalPoint(index, firstPoint);
+  index[0] += 1.0;
+  outputPtr->TransformContinuousIndexToPhysicalPoint(index, nextPoint);
+  const typename PointType::VectorType pointStep = nextPoint - firstPoint;
+
+  m_TileScheduler->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  m_TileScheduler->SplitRegion(outputRegion);
+
+  using OutputType = typename InterpolatorType::OutputType;
+  std::vector<std::vector<OutputType>> scanlines(m_TileScheduler->GetNumberOfWorkUnits());
+
+  // The projections are mapped by value * scale + shift and clamped.
+  double lowest = NumericTraits<OutputPixelType>::NonpositiveMin();
+  double highest = NumericTraits<OutputPixelType>::max();
+  double scale = 1.0;
+  double shift = 0.0;
+  auto   setWindow = [&](double windowMinimum, double windowMaximum) {
+    lowest = std::max(lowest, m_OutputMinimum);
+    highest = std::min(highest, m_OutputMaximum);
+    scale = windowMaximum > windowMinimum ? (m_OutputMaximum - m_OutputMinimum) / (windowMaximum - windowMinimum) : 0.0;
+    shift = m_OutputMinimum - windowMinimum * scale;
+  };
+  auto convert = [&](double value) -> OutputPixelType {
+    return static_cast<OutputPixelType>(std::min(std::max(value * scale + shift, lowest), highest));
+  };
+  if (m_RescaleIntensity && !m_AutomaticWindow)
+  {
+    setWindow(m_WindowMinimum, m_WindowMaximum);
+  }
+
+  // With an automatic window, the rays are kept until their range is known.
+  const bool          automaticWindow = m_RescaleIntensity && m_AutomaticWindow;
+  std::vector<double> projections(automaticWindow ? outputRegion.GetNumberOfPixels() : 0);
+  std::vector<double> minima(m_TileScheduler->GetNumberOfWorkUnits(), NumericTraits<double>::max());
+  std::vector<double> maxima(m_TileScheduler->GetNumberOfWorkUnits(), NumericTraits<double>::NonpositiveMin());
+
+  // Index of the detector pixel whose ray is written at an output index
+  auto detectorIndex = [&](typename OutputImageType::IndexType index) {
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      if (m_FlipAxes[i])
+      {
+        const IndexValueType first = detectorRegion.GetIndex(i);
+        index[i] = 2 * first + static_cast<IndexValueType>(detectorRegion.GetSize(i)) - 1 - index[i];
+      }
+    }
+    return index;
+  };
+  const bool flipRows = m_FlipAxes[0];
+
+  const InterpolatorType * interpolator = m_Interpolator;
+  OutputPixelType *        output = outputPtr->GetBufferPointer();
+
+  m_TileScheduler->Execute([&](SizeValueType, const OutputImageRegionType & tile, ThreadIdType workUnit) {
+    const SizeValueType       width = tile.GetSize(0);
+    std::vector<OutputType> & values = scanlines[workUnit];
+    values.resize(std::max<SizeValueType>(values.size(), width));
+
+    typename OutputImageType::IndexType rowIndex = tile.GetIndex();
+    for (SizeValueType row = 0; row < tile.GetNumberOfPixels() / width; ++row)
+    {
+      SizeValueType rest = row;
+      for (unsigned int i = 1; i < ImageDimension; ++i)
+      {
+        rowIndex[i] = tile.GetIndex(i) + static_cast<IndexValueType>(rest % tile.GetSize(i));
+        rest /= tile.GetSize(i);
+      }
+
+      // A flipped row is cast from its last pixel, the first on the detector.
+      typename OutputImageType::IndexType rayIndex = rowIndex;
+      if (flipRows)
+      {
+        rayIndex[0] += static_cast<IndexValueType>(width) - 1;
+      }
+      PointType rowPoint;
+      outputPtr->TransformIndexToPhysicalPoint(detectorIndex(rayIndex), rowPoint);
+      interpolator->EvaluateScanline(rowPoint, pointStep, width, values.data());
+
+      const OffsetValueType offset = outputPtr->ComputeOffset(rowIndex);
+      if (automaticWindow)
+      {
+        double * destination = projections.data() + offset;
+        for (SizeValueType k = 0; k < width; ++k)
+        {
+          const auto value = static_cast<double>(values[flipRows ? width - 1 - k : k]);
+          destination[k] = value;
+          minima[workUnit] = std::min(minima[workUnit], value);
+          maxima[workUnit] = std::max(maxima[workUnit], value);
+        }
+        continue;
+      }
+
+      OutputPixelType * out = output + offset;
+      for (SizeValueType k = 0; k < width; ++k)
+      {
+        out[k] = convert(static_cast<double>(values[flipRows ? width - 1 - k : k]));
+      }
+    }
+  });
+
+  if (automaticWindow && !projections.empty())
+  {
+    setWindow(*std::min_element(minima.begin(), minima.end()), *std::max_element(maxima.begin(), maxima.end()));
+
+    const SizeValueType width = outputRegion.GetSize(0);
+    this->GetMultiThreader()->ParallelizeArray(
+      0,
+      projections.size() / width,
+      [&](SizeValueType row) {
+        const double *    values = projections.data() + row * width;
+        OutputPixelType * out = output + row * width;
+        for (SizeValueType k = 0; k < width; ++k)
+        {
+          out[k] = convert(values[k]);
+        }
+      },
+      nullptr);
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+RayCastProjectionImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Interpolator: " << m_Interpolator.GetPointer() << std::endl;
+  os << indent << "TileScheduler: " << m_TileScheduler.GetPointer() << std::endl;
+  os << indent << "FlipAxes: " << m_FlipAxes << std::endl;
+  os << indent << "RescaleIntensity: " << m_RescaleIntensity << std::endl;
+  os << indent << "AutomaticWindow: " << m_AutomaticWindow << std::endl;
+  os << indent << "WindowMinimum: " << m_WindowMinimum << std::endl;
+  os << indent << "WindowMaximum: " << m_WindowMaximum << std::endl;
+  os << indent << "OutputMinimum: " << m_OutputMinimum << std::endl;
+  os << indent << "OutputMaximum: " << m_OutputMaximum << std::endl;
+}
+
+} // namespace itk
+
+#endif
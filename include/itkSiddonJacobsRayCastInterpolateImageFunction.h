@@ -35,10 +35,7 @@ CIT 6, 89-94 (1998).
 #ifndef itkSiddonJacobsRayCastInterpolateImageFunction_h
 #define itkSiddonJacobsRayCastInterpolateImageFunction_h
 
-#include "itkInterpolateImageFunction.h"
-#include "itkTransform.h"
-#include "itkVector.h"
-#include "itkEuler3DTransform.h"
+#include "itkProjectionInterpolateImageFunction.h"
 
 namespace itk
 {
@@ -47,50 +44,52 @@ namespace itk
  * \brief Projective interpolation of an image at specified positions.
  *
  * SiddonJacobsRayCastInterpolateImageFunction casts rays through a 3-dimensional
- * image
+ * image. The exact radiological path of each ray through the voxels is
+ * computed with the incremental algorithm of Siddon and Jacobs.
+ *
  * \warning This interpolator works for 3-dimensional images only.
  *
+ * \sa JosephRayCastInterpolateImageFunction
+ *
  * \ingroup ImageFunctions
  * \ingroup TwoProjectionRegistration
  */
 template <typename TInputImage, typename TCoordRep = float>
-class SiddonJacobsRayCastInterpolateImageFunction : public InterpolateImageFunction<TInputImage, TCoordRep>
+class SiddonJacobsRayCastInterpolateImageFunction : public ProjectionInterpolateImageFunction<TInputImage, TCoordRep>
 {
 public:
   ITK_DISALLOW_COPY_AND_ASSIGN(SiddonJacobsRayCastInterpolateImageFunction);
 
   /** Standard class type alias. */
   using Self = SiddonJacobsRayCastInterpolateImageFunction;
-  using Superclass = InterpolateImageFunction<TInputImage, TCoordRep>;
+  using Superclass = ProjectionInterpolateImageFunction<TInputImage, TCoordRep>;
   using Pointer = SmartPointer<Self>;
   using ConstPointer = SmartPointer<const Self>;
 
   /** Constants for the image dimensions */
   static constexpr unsigned int InputImageDimension = TInputImage::ImageDimension;
 
+  using TransformType = typename Superclass::TransformType;
+  using TransformPointer = typename Superclass::TransformPointer;
+  using InputPointType = typename Superclass::InputPointType;
+  using OutputPointType = typename Superclass::OutputPointType;
+  using TransformParametersType = typename Superclass::TransformParametersType;
+  using TransformJacobianType = typename Superclass::TransformJacobianType;
 
-  using TransformType = Euler3DTransform<TCoordRep>;
-
-  using TransformPointer = typename TransformType::Pointer;
-  using InputPointType = typename TransformType::InputPointType;
-  using OutputPointType = typename TransformType::OutputPointType;
-  using TransformParametersType = typename TransformType::ParametersType;
-  using TransformJacobianType = typename TransformType::JacobianType;
+  using PixelType = typename Superclass::PixelType;
 
-  using PixelType = typename Superclass::InputPixelType;
+  using SizeType = typename Superclass::SizeType;
 
-  using SizeType = typename TInputImage::SizeType;
-
-  using DirectionType = Vector<TCoordRep, 3>;
+  using DirectionType = typename Superclass::DirectionType;
 
   /**  Type of the Interpolator Base class */
-  using InterpolatorType = InterpolateImageFunction<TInputImage, TCoordRep>;
+  using InterpolatorType = typename Superclass::InterpolatorType;
 
-  using InterpolatorPointer = typename InterpolatorType::Pointer;
+  using InterpolatorPointer = typename Superclass::InterpolatorPointer;
 
 
   /** Run-time type information (and related methods). */
-  itkTypeMacro(SiddonJacobsRayCastInterpolateImageFunction, InterpolateImageFunction);
+  itkTypeMacro(SiddonJacobsRayCastInterpolateImageFunction, ProjectionInterpolateImageFunction);
 
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
@@ -119,6 +118,12 @@ public:
   /** ContinuousIndex type alias support. */
   using ContinuousIndexType = typename Superclass::ContinuousIndexType;
 
+  /** Vector type alias support. */
+  using VectorType = typename Superclass::VectorType;
+
+  using VolumeContextType = typename Superclass::VolumeContextType;
+  using BrickedVolumeType = typename Superclass::BrickedVolumeType;
+
 
   /** \brief
    * Interpolate the image at a point position.
@@ -128,104 +133,92 @@ public:
    * The point is assume to lie within the image buffer.
    *
    * ImageFunction::IsInsideBuffer() can be used to check bounds before
-   * calling the method.
+   * calling the method. This is EvaluateRays() for a single point.
    */
   OutputType
   Evaluate(const PointType & point) const override;
 
-  /** Interpolate the image at a continuous index position
-   *
-   * Returns the interpolated image intensity at a
-   * specified index position. No bounds checking is done.
-   * The point is assume to lie within the image buffer.
+  /** Cast the rays through the numberOfPoints projection points points and
+   * write their projections to values.
    *
-   * Subclasses must override this method.
+   * This is the batch form of Evaluate(), without a virtual call per ray:
+   * the projection geometry, the volume buffer and the inverse transform
+   * are looked up once for the whole batch, and the points are mapped to
+   * the volume with the matrix and offset of the inverse transform. */
+  void
+  EvaluateRays(const PointType * points, SizeValueType numberOfPoints, OutputType * values) const;
+
+  /** Cast the rays of a detector scanline.
    *
-   * ImageFunction::IsInsideBuffer() can be used to check bounds before
-   * calling the method.
-   */
+   * The per-pose setup is done once for the whole scanline and the
+   * world-space ray direction of each pixel is derived from the first one,
+   * which makes this considerably cheaper than calling Evaluate() for each
+   * pixel. */
+  void
+  EvaluateScanline(const PointType &  firstPoint,
+                   const VectorType & pointStep,
+                   SizeValueType      length,
+                   OutputType *       values) const override;
+
+  /** Integrate the volume along the ray leaving sourceWorld in direction
+   * rayVector, both given in the coordinate system of the volume. The
+   * result is scaled as in Evaluate(), by the inverse of the length of
+   * rayVector. The projection geometry is not used. */
   OutputType
-  EvaluateAtContinuousIndex(const ContinuousIndexType & index) const override;
-
-  virtual void
-  Initialize();
-
-  /** Connect the Transform. */
-  itkSetObjectMacro(Transform, TransformType);
-  /** Get a pointer to the Transform.  */
-  itkGetConstObjectMacro(Transform, TransformType);
-
-  /** Set and get the focal point to isocenter distance in mm */
-  itkSetMacro(FocalPointToIsocenterDistance, double);
-  itkGetMacro(FocalPointToIsocenterDistance, double);
-
-  /** Set and get the Lianc grantry rotation angle in radians */
-  itkSetMacro(ProjectionAngle, double);
-  itkGetMacro(ProjectionAngle, double);
-
-  /** Set and get the Threshold */
-  itkSetMacro(Threshold, double);
-  itkGetMacro(Threshold, double);
-
-  /** Check if a point is inside the image buffer.
-   * \warning For efficiency, no validity checking of
-   * the input image pointer is done. */
-  inline bool
-  IsInsideBuffer(const PointType &) const override
-  {
-    return true;
-  }
-  bool
-  IsInsideBuffer(const ContinuousIndexType &) const override
-  {
-    return true;
-  }
-  bool
-  IsInsideBuffer(const IndexType &) const override
-  {
-    return true;
-  }
-
-#if !defined(ITKV4_COMPATIBILITY)
-  SizeType
-  GetRadius() const override
-  {
-    const InputImageType * input = this->GetInputImage();
-    if (!input)
-    {
-      itkExceptionMacro("Input image required!");
-    }
-    return input->GetLargestPossibleRegion().GetSize();
-  }
-#endif
+  EvaluateRay(const PointType & sourceWorld, const VectorType & rayVector) const;
+
+  /** Follow the ray leaving sourceWorld in direction rayVector, both given
+   * in the coordinate system of the volume, and call visitor(index, length)
+   * for each voxel of the volume it crosses, in order. The length of the
+   * intersection is in units of the ray parameter, i.e. scaled by the
+   * inverse of the length of rayVector as in EvaluateRay(). The voxel
+   * values and the Threshold are not used. */
+  template <typename TVisitor>
+  void
+  TraceRay(const PointType & sourceWorld, const VectorType & rayVector, TVisitor && visitor) const;
 
 protected:
-  SiddonJacobsRayCastInterpolateImageFunction();
+  SiddonJacobsRayCastInterpolateImageFunction() = default;
 
   ~SiddonJacobsRayCastInterpolateImageFunction() override = default;
 
+private:
+  /** Quantities shared by all the rays cast for one pose of the volume. */
+  struct RayCastParameters
+  {
+    const PixelType * Buffer;
+    OffsetValueType   Stride[3];
+    double            SourceWorld[3];
+    double            Spacing[3];
+    double            InverseSpacing[3];
+    IndexValueType    Size[3];
+    // Distances from the source to the first and the last plane of the
+    // volume along each axis
+    double PlaneOffsetMin[3];
+    double PlaneOffsetMax[3];
+    // Thresholded volume and bounding box of the volume context, if valid
+    const VolumeContextType * Context;
+    const float *             Attenuation;
+    // Out of core volume, read instead of Buffer if set
+    const BrickedVolumeType * Bricks;
+  };
+
+  /** Update the inverse transform if needed and fill in the per-pose
+   * parameters of the ray casting. */
   void
-  PrintSelf(std::ostream & os, Indent indent) const override;
-
-  /// Transformation used to calculate the new focal point position
-  TransformPointer m_Transform; // Displacement of the volume
-  // Overall inverse transform used to calculate the ray position in the input space
-  TransformPointer m_InverseTransform;
+  InitializeRayCastParameters(RayCastParameters & parameters) const;
+  void
+  InitializeRayCastParameters(RayCastParameters & parameters, const PointType & sourceWorld) const;
 
-  // The threshold above which voxels along the ray path are integrated
-  double m_Threshold;
-  double m_FocalPointToIsocenterDistance; // Focal point to isocenter distance
-  double m_ProjectionAngle;               // Linac gantry rotation angle in radians
+  /** Integrate the volume along one ray leaving the source in direction
+   * rayVector (the vector from the source to the projection pixel). */
+  OutputType
+  CastRay(const RayCastParameters & parameters, const double rayVector[3]) const;
 
-private:
+  /** The Siddon-Jacobs traversal shared by CastRay() and TraceRay() */
+  template <typename TVisitor>
   void
-                   ComputeInverseTransform() const;
-  TransformPointer m_GantryRotTransform; // Gantry rotation transform
-  TransformPointer m_CamShiftTransform;  // Camera shift transform camRotTransform
-  TransformPointer m_CamRotTransform;    // Camera rotation transform
-  TransformPointer m_ComposedTransform;  // Composed transform
-  PointType        m_SourcePoint;        // Coordinate of the source in the standard Z projection geometry
-  PointType        m_SourceWorld;        // Coordinate of the source in the world coordinate system
+  TraverseRay(const RayCastParameters & parameters, const double rayVector[3], TVisitor & visitor) const;
 };
 
 } // namespace itk
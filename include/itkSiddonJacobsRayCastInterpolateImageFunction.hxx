@@ -45,128 +45,289 @@ namespace itk
 {
 
 template <typename TInputImage, typename TCoordRep>
-SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::SiddonJacobsRayCastInterpolateImageFunction()
+typename SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::OutputType
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(const PointType & point) const
 {
-  m_FocalPointToIsocenterDistance = 1000.; // Focal point to isocenter distance in mm.
-  m_ProjectionAngle = 0.;                  // Angle in radians betweeen projection central axis and reference axis
-  m_Threshold = 0.;                        // Intensity threshold, below which is ignored.
-
-  m_SourcePoint[0] = 0.;
-  m_SourcePoint[1] = 0.;
-  m_SourcePoint[2] = 0.;
-
-  m_InverseTransform = TransformType::New();
-  m_InverseTransform->SetComputeZYX(true);
+  OutputType value;
+  this->EvaluateRays(&point, 1, &value);
+  return value;
+}
 
-  m_ComposedTransform = TransformType::New();
-  m_ComposedTransform->SetComputeZYX(true);
 
-  m_GantryRotTransform = TransformType::New();
-  m_GantryRotTransform->SetComputeZYX(true);
-  m_GantryRotTransform->SetIdentity();
+template <typename TInputImage, typename TCoordRep>
+void
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateRays(const PointType * points,
+                                                                                  SizeValueType     numberOfPoints,
+                                                                                  OutputType *      values) const
+{
+  RayCastParameters parameters;
+  this->InitializeRayCastParameters(parameters);
 
-  m_CamShiftTransform = TransformType::New();
-  m_CamShiftTransform->SetComputeZYX(true);
-  m_CamShiftTransform->SetIdentity();
+  // The inverse transform is affine: the world coordinate of a DRR pixel is
+  // matrix * point + offset, computed here without a virtual call.
+  const typename TransformType::MatrixType &       matrix = this->m_InverseTransform->GetMatrix();
+  const typename TransformType::OutputVectorType & offset = this->m_InverseTransform->GetOffset();
 
-  m_CamRotTransform = TransformType::New();
-  m_CamRotTransform->SetComputeZYX(true);
-  m_CamRotTransform->SetIdentity();
-  // constant for converting degrees into radians
-  const float dtr = (atan(1.0) * 4.0) / 180.0;
-  m_CamRotTransform->SetRotation(dtr * (-90.0), 0.0, 0.0);
+  double m[3][3];
+  double t[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      m[i][j] = matrix[i][j];
+    }
+    t[i] = offset[i];
+  }
 
-  m_Threshold = 0;
+  double rayVector[3];
+  for (SizeValueType k = 0; k < numberOfPoints; ++k)
+  {
+    const PointType & point = points[k];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      const double drrPixelWorld = m[i][0] * point[0] + m[i][1] * point[1] + m[i][2] * point[2] + t[i];
+      rayVector[i] = drrPixelWorld - parameters.SourceWorld[i];
+    }
+    values[k] = this->CastRay(parameters, rayVector);
+  }
 }
 
 
 template <typename TInputImage, typename TCoordRep>
 void
-SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::PrintSelf(std::ostream & os, Indent indent) const
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateScanline(const PointType &  firstPoint,
+                                                                                      const VectorType & pointStep,
+                                                                                      SizeValueType      length,
+                                                                                      OutputType *       values) const
 {
-  this->Superclass::PrintSelf(os, indent);
+  RayCastParameters parameters;
+  this->InitializeRayCastParameters(parameters);
+
+  // The inverse transform is affine, so the world-space rays of a scanline
+  // differ from the first one by a multiple of the transformed pixel step.
+  const PointType firstPixelWorld = this->m_InverseTransform->TransformPoint(firstPoint);
+  const typename TransformType::OutputVectorType stepWorld =
+    this->m_InverseTransform->TransformVector(pointStep);
 
-  os << indent << "Threshold: " << m_Threshold << std::endl;
-  os << indent << "Transform: " << m_Transform.GetPointer() << std::endl;
+  double firstRayVector[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    firstRayVector[i] = firstPixelWorld[i] - parameters.SourceWorld[i];
+  }
+
+  double rayVector[3];
+  for (SizeValueType k = 0; k < length; ++k)
+  {
+    rayVector[0] = firstRayVector[0] + k * stepWorld[0];
+    rayVector[1] = firstRayVector[1] + k * stepWorld[1];
+    rayVector[2] = firstRayVector[2] + k * stepWorld[2];
+
+    values[k] = this->CastRay(parameters, rayVector);
+  }
 }
 
 
 template <typename TInputImage, typename TCoordRep>
 typename SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::OutputType
-SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(const PointType & point) const
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateRay(const PointType &  sourceWorld,
+                                                                                 const VectorType & rayVector) const
 {
-  float     rayVector[3];
-  IndexType cIndex;
+  RayCastParameters parameters;
+  this->InitializeRayCastParameters(parameters, sourceWorld);
 
-  PointType  drrPixelWorld; // Coordinate of a DRR pixel in the world coordinate system
-  OutputType pixval;
+  const double ray[3] = { rayVector[0], rayVector[1], rayVector[2] };
+  return this->CastRay(parameters, ray);
+}
 
 
-  float firstIntersection[3];
-  float alphaX1, alphaXN, alphaXmin, alphaXmax;
-  float alphaY1, alphaYN, alphaYmin, alphaYmax;
-  float alphaZ1, alphaZN, alphaZmin, alphaZmax;
-  float alphaMin, alphaMax;
-  float alphaX, alphaY, alphaZ, alphaCmin, alphaCminPrev;
-  float alphaUx, alphaUy, alphaUz;
-  float alphaIntersectionUp[3], alphaIntersectionDown[3];
-  float d12, value;
-  float firstIntersectionIndex[3];
-  int   firstIntersectionIndexUp[3], firstIntersectionIndexDown[3];
-  int   iU, jU, kU;
+template <typename TInputImage, typename TCoordRep>
+void
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::InitializeRayCastParameters(
+  RayCastParameters & parameters) const
+{
+  this->InitializeRayCastParameters(parameters, this->UpdateProjectionGeometry());
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+void
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::InitializeRayCastParameters(
+  RayCastParameters & parameters,
+  const PointType &   sourceWorld) const
+{
+  const InputImageType *    inputPtr = this->GetInputImage();
+  const BrickedVolumeType * bricks = this->GetValidBrickedVolume();
+
+  // The geometry is that of the bricked volume if any, as the input image
+  // may then hold no pixels.
+  const typename InputImageType::SpacingType ctPixelSpacing = bricks ? bricks->GetSpacing() : inputPtr->GetSpacing();
+  const typename InputImageType::SizeType    sizeCT =
+    bricks ? bricks->GetSize() : inputPtr->GetLargestPossibleRegion().GetSize();
+  const OffsetValueType * offsetTable = inputPtr->GetOffsetTable();
+
+  parameters.Buffer = inputPtr->GetBufferPointer();
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    parameters.Stride[i] = offsetTable[i];
+    parameters.SourceWorld[i] = sourceWorld[i];
+    parameters.Spacing[i] = ctPixelSpacing[i];
+    parameters.InverseSpacing[i] = 1.0 / ctPixelSpacing[i];
+    parameters.Size[i] = static_cast<IndexValueType>(sizeCT[i]);
+    parameters.PlaneOffsetMin[i] = 0.0 - sourceWorld[i];
+    parameters.PlaneOffsetMax[i] = sizeCT[i] * ctPixelSpacing[i] - sourceWorld[i];
+  }
 
+  parameters.Bricks = bricks;
+  parameters.Context = bricks ? nullptr : this->GetValidVolumeContext();
+  parameters.Attenuation = parameters.Context ? parameters.Context->GetAttenuationBuffer() : nullptr;
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+template <typename TVisitor>
+void
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::TraceRay(const PointType &  sourceWorld,
+                                                                              const VectorType & rayVector,
+                                                                              TVisitor &&        visitor) const
+{
+  RayCastParameters parameters;
+  this->InitializeRayCastParameters(parameters, sourceWorld);
+
+  const double ray[3] = { rayVector[0], rayVector[1], rayVector[2] };
+  this->TraverseRay(parameters, ray, visitor);
+}
+
+
+template <typename TInputImage, typename TCoordRep>
+typename SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::OutputType
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::CastRay(const RayCastParameters & parameters,
+                                                                             const double rayVector[3]) const
+{
+  OutputType pixval;
 
   // Min/max values of the output pixel type AND these values
   // represented as the output type of the interpolator
   const OutputType minOutputValue = itk::NumericTraits<OutputType>::NonpositiveMin();
   const OutputType maxOutputValue = itk::NumericTraits<OutputType>::max();
 
-  // If the volume was shifted, recalculate the overall inverse transform
-  unsigned long int interpMTime = this->GetMTime();
-  unsigned long int vTransformMTime = m_Transform->GetMTime();
+  const PixelType * const buffer = parameters.Buffer;
+  const OffsetValueType   strideY = parameters.Stride[1];
+  const OffsetValueType   strideZ = parameters.Stride[2];
+  const double            threshold = this->m_Threshold;
+
+  float d12 = 0.0; /* Initialize the sum of the voxel intensities along the ray path to zero. */
 
-  if (interpMTime < vTransformMTime)
+  if (parameters.Bricks)
   {
-    this->ComputeInverseTransform();
-    // The m_SourceWorld should be computed here to avoid the repeatedly calculation
-    // for each projection ray. However, we are in a const function, which prohibits
-    // the modification of class member variables. So the world coordiate of the source
-    // point is calculated for each ray as below. Performance improvement may be made
-    // by using a static variable?
-    // m_SourceWorld = m_InverseTransform->TransformPoint(m_SourcePoint);
+    const BrickedVolumeType *                bricks = parameters.Bricks;
+    typename BrickedVolumeType::BrickPointer brick;
+    SizeValueType                            brickNumber = NumericTraits<SizeValueType>::max();
+
+    auto accumulate = [&](const IndexType & cIndex, float length) {
+      /* The bricks are requested as the ray enters them. Those below the
+       * threshold are not stored. */
+      const SizeValueType number = bricks->ComputeBrickNumber(cIndex);
+      if (number != brickNumber)
+      {
+        brickNumber = number;
+        brick = bricks->GetBrick(number);
+      }
+      if (brick)
+      {
+        d12 += length * (*brick)[bricks->ComputeOffsetInBrick(cIndex)];
+      }
+    };
+    this->TraverseRay(parameters, rayVector, accumulate);
   }
+  else if (parameters.Attenuation)
+  {
+    // The voxels outside of the bounding box are below the threshold. The
+    // margin covers the rounding of the traversal.
+    if (!parameters.Context->RayIntersectsBoundingBox(parameters.SourceWorld, rayVector, 1.0))
+    {
+      return NumericTraits<OutputType>::ZeroValue();
+    }
 
-  PointType SourceWorld = m_InverseTransform->TransformPoint(m_SourcePoint);
+    // The attenuation image has the size of the volume, hence its strides.
+    const float * attenuation = parameters.Attenuation;
 
-  // Get ths input pointers
-  InputImageConstPointer inputPtr = this->GetInputImage();
+    auto accumulate = [&](const IndexType & cIndex, float length) {
+      /* The thresholded voxel intensity is precomputed. */
+      d12 += length * attenuation[cIndex[0] + cIndex[1] * strideY + cIndex[2] * strideZ];
+    };
+    this->TraverseRay(parameters, rayVector, accumulate);
+  }
+  else
+  {
+    auto accumulate = [&](const IndexType & cIndex, float length) {
+      /* Get the voxel intensity. */
+      const auto value = static_cast<float>(buffer[cIndex[0] + cIndex[1] * strideY + cIndex[2] * strideZ]);
+      if (value > threshold) /* Ignore voxels whose intensities are below the threshold. */
+      {
+        d12 += length * (value - threshold);
+      }
+    };
+    this->TraverseRay(parameters, rayVector, accumulate);
+  }
 
-  typename InputImageType::SizeType    sizeCT;
-  typename InputImageType::RegionType  regionCT;
-  typename InputImageType::SpacingType ctPixelSpacing;
-  typename InputImageType::PointType   ctOrigin;
+  if (d12 < minOutputValue)
+  {
+    pixval = minOutputValue;
+  }
+  else if (d12 > maxOutputValue)
+  {
+    pixval = maxOutputValue;
+  }
+  else
+  {
+    pixval = static_cast<OutputType>(d12);
+  }
+  return (pixval);
+}
 
-  ctPixelSpacing = inputPtr->GetSpacing();
-  ctOrigin = inputPtr->GetOrigin();
-  regionCT = inputPtr->GetLargestPossibleRegion();
-  sizeCT = regionCT.GetSize();
 
-  drrPixelWorld = m_InverseTransform->TransformPoint(point);
+template <typename TInputImage, typename TCoordRep>
+template <typename TVisitor>
+void
+SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::TraverseRay(
+  const RayCastParameters & parameters,
+  const double              rayVector[3],
+  TVisitor &                visitor) const
+{
+  IndexType cIndex;
+
+  float firstIntersection[3];
+  float alphaXmin, alphaXmax;
+  float alphaYmin, alphaYmax;
+  float alphaZmin, alphaZmax;
+  float alphaMin, alphaMax;
+  float alphaX, alphaY, alphaZ, alphaCmin, alphaCminPrev;
+  float alphaUx, alphaUy, alphaUz;
+  float firstIntersectionIndex[3];
+  int   firstIntersectionIndexUp[3], firstIntersectionIndexDown[3];
+  int   iU, jU, kU;
 
+  const double *         SourceWorld = parameters.SourceWorld;
+  const double *         ctPixelSpacing = parameters.Spacing;
+  const IndexValueType * sizeCT = parameters.Size;
 
   // The following is the Siddon-Jacob fast ray-tracing algorithm
 
-  rayVector[0] = drrPixelWorld[0] - SourceWorld[0];
-  rayVector[1] = drrPixelWorld[1] - SourceWorld[1];
-  rayVector[2] = drrPixelWorld[2] - SourceWorld[2];
+  // The reciprocals of the ray vector components are shared by all the
+  // parametric computations below.
+  double inverseRay[3];
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    inverseRay[i] = (rayVector[i] != 0) ? 1.0 / rayVector[i] : 0.0;
+  }
 
   /* Calculate the parametric  values of the first  and  the  last
   intersection points of  the  ray  with the X,  Y, and Z-planes  that
   define  the  CT volume. */
   if (rayVector[0] != 0)
   {
-    alphaX1 = (0.0 - SourceWorld[0]) / rayVector[0];
-    alphaXN = (sizeCT[0] * ctPixelSpacing[0] - SourceWorld[0]) / rayVector[0];
+    const float alphaX1 = parameters.PlaneOffsetMin[0] * inverseRay[0];
+    const float alphaXN = parameters.PlaneOffsetMax[0] * inverseRay[0];
     alphaXmin = std::min(alphaX1, alphaXN);
     alphaXmax = std::max(alphaX1, alphaXN);
   }
@@ -178,8 +339,8 @@ SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(co
 
   if (rayVector[1] != 0)
   {
-    alphaY1 = (0.0 - SourceWorld[1]) / rayVector[1];
-    alphaYN = (sizeCT[1] * ctPixelSpacing[1] - SourceWorld[1]) / rayVector[1];
+    const float alphaY1 = parameters.PlaneOffsetMin[1] * inverseRay[1];
+    const float alphaYN = parameters.PlaneOffsetMax[1] * inverseRay[1];
     alphaYmin = std::min(alphaY1, alphaYN);
     alphaYmax = std::max(alphaY1, alphaYN);
   }
@@ -191,8 +352,8 @@ SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(co
 
   if (rayVector[2] != 0)
   {
-    alphaZ1 = (0.0 - SourceWorld[2]) / rayVector[2];
-    alphaZN = (sizeCT[2] * ctPixelSpacing[2] - SourceWorld[2]) / rayVector[2];
+    const float alphaZ1 = parameters.PlaneOffsetMin[2] * inverseRay[2];
+    const float alphaZN = parameters.PlaneOffsetMax[2] * inverseRay[2];
     alphaZmin = std::min(alphaZ1, alphaZN);
     alphaZmax = std::max(alphaZ1, alphaZN);
   }
@@ -216,9 +377,9 @@ SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(co
   firstIntersection[2] = SourceWorld[2] + alphaMin * rayVector[2];
 
   /* Transform world coordinate to the continuous index of the CT volume*/
-  firstIntersectionIndex[0] = firstIntersection[0] / ctPixelSpacing[0];
-  firstIntersectionIndex[1] = firstIntersection[1] / ctPixelSpacing[1];
-  firstIntersectionIndex[2] = firstIntersection[2] / ctPixelSpacing[2];
+  firstIntersectionIndex[0] = firstIntersection[0] * parameters.InverseSpacing[0];
+  firstIntersectionIndex[1] = firstIntersection[1] * parameters.InverseSpacing[1];
+  firstIntersectionIndex[2] = firstIntersection[2] * parameters.InverseSpacing[2];
 
   firstIntersectionIndexUp[0] = (int)ceil(firstIntersectionIndex[0]);
   firstIntersectionIndexUp[1] = (int)ceil(firstIntersectionIndex[1]);
@@ -228,94 +389,57 @@ SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(co
   firstIntersectionIndexDown[1] = (int)floor(firstIntersectionIndex[1]);
   firstIntersectionIndexDown[2] = (int)floor(firstIntersectionIndex[2]);
 
-
+  /* Calculate the parametric values of the next plane crossings and the
+  alpha incremental values when the ray intercepts with x, y, and z-planes */
   if (rayVector[0] == 0)
   {
     alphaX = 2;
+    alphaUx = 999;
   }
   else
   {
-    alphaIntersectionUp[0] = (firstIntersectionIndexUp[0] * ctPixelSpacing[0] - SourceWorld[0]) / rayVector[0];
-    alphaIntersectionDown[0] = (firstIntersectionIndexDown[0] * ctPixelSpacing[0] - SourceWorld[0]) / rayVector[0];
-    alphaX = std::max(alphaIntersectionUp[0], alphaIntersectionDown[0]);
+    const float alphaIntersectionUp =
+      (firstIntersectionIndexUp[0] * ctPixelSpacing[0] - SourceWorld[0]) * inverseRay[0];
+    const float alphaIntersectionDown =
+      (firstIntersectionIndexDown[0] * ctPixelSpacing[0] - SourceWorld[0]) * inverseRay[0];
+    alphaX = std::max(alphaIntersectionUp, alphaIntersectionDown);
+    alphaUx = ctPixelSpacing[0] * std::fabs(inverseRay[0]);
   }
 
   if (rayVector[1] == 0)
   {
     alphaY = 2;
+    alphaUy = 999;
   }
   else
   {
-    alphaIntersectionUp[1] = (firstIntersectionIndexUp[1] * ctPixelSpacing[1] - SourceWorld[1]) / rayVector[1];
-    alphaIntersectionDown[1] = (firstIntersectionIndexDown[1] * ctPixelSpacing[1] - SourceWorld[1]) / rayVector[1];
-    alphaY = std::max(alphaIntersectionUp[1], alphaIntersectionDown[1]);
+    const float alphaIntersectionUp =
+      (firstIntersectionIndexUp[1] * ctPixelSpacing[1] - SourceWorld[1]) * inverseRay[1];
+    const float alphaIntersectionDown =
+      (firstIntersectionIndexDown[1] * ctPixelSpacing[1] - SourceWorld[1]) * inverseRay[1];
+    alphaY = std::max(alphaIntersectionUp, alphaIntersectionDown);
+    alphaUy = ctPixelSpacing[1] * std::fabs(inverseRay[1]);
   }
 
   if (rayVector[2] == 0)
   {
     alphaZ = 2;
-  }
-  else
-  {
-    alphaIntersectionUp[2] = (firstIntersectionIndexUp[2] * ctPixelSpacing[2] - SourceWorld[2]) / rayVector[2];
-    alphaIntersectionDown[2] = (firstIntersectionIndexDown[2] * ctPixelSpacing[2] - SourceWorld[2]) / rayVector[2];
-    alphaZ = std::max(alphaIntersectionUp[2], alphaIntersectionDown[2]);
-  }
-
-  /* Calculate alpha incremental values when the ray intercepts with x, y, and z-planes */
-  if (rayVector[0] != 0)
-  {
-    alphaUx = ctPixelSpacing[0] / fabs(rayVector[0]);
-  }
-  else
-  {
-    alphaUx = 999;
-  }
-  if (rayVector[1] != 0)
-  {
-    alphaUy = ctPixelSpacing[1] / fabs(rayVector[1]);
-  }
-  else
-  {
-    alphaUy = 999;
-  }
-  if (rayVector[2] != 0)
-  {
-    alphaUz = ctPixelSpacing[2] / fabs(rayVector[2]);
-  }
-  else
-  {
     alphaUz = 999;
   }
-  /* Calculate voxel index incremental values along the ray path. */
-  if (SourceWorld[0] < drrPixelWorld[0])
-  {
-    iU = 1;
-  }
   else
   {
-    iU = -1;
-  }
-  if (SourceWorld[1] < drrPixelWorld[1])
-  {
-    jU = 1;
-  }
-  else
-  {
-    jU = -1;
+    const float alphaIntersectionUp =
+      (firstIntersectionIndexUp[2] * ctPixelSpacing[2] - SourceWorld[2]) * inverseRay[2];
+    const float alphaIntersectionDown =
+      (firstIntersectionIndexDown[2] * ctPixelSpacing[2] - SourceWorld[2]) * inverseRay[2];
+    alphaZ = std::max(alphaIntersectionUp, alphaIntersectionDown);
+    alphaUz = ctPixelSpacing[2] * std::fabs(inverseRay[2]);
   }
 
-  if (SourceWorld[2] < drrPixelWorld[2])
-  {
-    kU = 1;
-  }
-  else
-  {
-    kU = -1;
-  }
-
-  d12 = 0.0; /* Initialize the sum of the voxel intensities along the ray path to zero. */
-
+  /* Calculate voxel index incremental values along the ray path. */
+  iU = (rayVector[0] > 0) ? 1 : -1;
+  jU = (rayVector[1] > 0) ? 1 : -1;
+  kU = (rayVector[2] > 0) ? 1 : -1;
 
   /* Initialize the current ray position. */
   alphaCmin = std::min(std::min(alphaX, alphaY), alphaZ);
@@ -352,90 +476,13 @@ SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(co
       alphaZ = alphaZ + alphaUz;
     }
 
-    if ((cIndex[0] >= 0) && (cIndex[0] < static_cast<IndexValueType>(sizeCT[0])) && (cIndex[1] >= 0) &&
-        (cIndex[1] < static_cast<IndexValueType>(sizeCT[1])) && (cIndex[2] >= 0) &&
-        (cIndex[2] < static_cast<IndexValueType>(sizeCT[2])))
+    if ((cIndex[0] >= 0) && (cIndex[0] < sizeCT[0]) && (cIndex[1] >= 0) && (cIndex[1] < sizeCT[1]) &&
+        (cIndex[2] >= 0) && (cIndex[2] < sizeCT[2]))
     {
-      /* If it is a valid index, get the voxel intensity. */
-      value = static_cast<float>(inputPtr->GetPixel(cIndex));
-      if (value > m_Threshold) /* Ignore voxels whose intensities are below the threshold. */
-      {
-        d12 += (alphaCmin - alphaCminPrev) * (value - m_Threshold);
-      }
+      /* If it is a valid index, visit the voxel. */
+      visitor(cIndex, alphaCmin - alphaCminPrev);
     }
   }
-
-  if (d12 < minOutputValue)
-  {
-    pixval = minOutputValue;
-  }
-  else if (d12 > maxOutputValue)
-  {
-    pixval = maxOutputValue;
-  }
-  else
-  {
-    pixval = static_cast<OutputType>(d12);
-  }
-  return (pixval);
-}
-
-
-template <typename TInputImage, typename TCoordRep>
-typename SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::OutputType
-SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateAtContinuousIndex(
-  const ContinuousIndexType & index) const
-{
-  OutputPointType point;
-  this->m_Image->TransformContinuousIndexToPhysicalPoint(index, point);
-
-  return this->Evaluate(point);
-}
-
-
-template <typename TInputImage, typename TCoordRep>
-void
-SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::ComputeInverseTransform() const
-{
-  m_ComposedTransform->SetIdentity();
-  m_ComposedTransform->Compose(m_Transform, 0);
-
-  typename TransformType::InputPointType isocenter;
-  isocenter = m_Transform->GetCenter();
-  // An Euler 3D transform is used to rotate the volume to simulate the roation of the linac gantry.
-  // The rotation is about z-axis. After the transform, a AP projection geometry (projecting
-  // towards positive y direction) is established.
-  m_GantryRotTransform->SetRotation(0.0, 0.0, -m_ProjectionAngle);
-  m_GantryRotTransform->SetCenter(isocenter);
-  m_ComposedTransform->Compose(m_GantryRotTransform, 0);
-
-  // An Euler 3D transfrom is used to shift the source to the origin.
-  typename TransformType::OutputVectorType focalpointtranslation;
-  focalpointtranslation[0] = -isocenter[0];
-  focalpointtranslation[1] = m_FocalPointToIsocenterDistance - isocenter[1];
-  focalpointtranslation[2] = -isocenter[2];
-  m_CamShiftTransform->SetTranslation(focalpointtranslation);
-  m_ComposedTransform->Compose(m_CamShiftTransform, 0);
-
-  // A Euler 3D transform is used to establish the standard negative z-axis projection geometry. (By
-  // default, the camera is situated at the origin, points down the negative z-axis, and has an up-
-  // vector of (0, 1, 0).)
-
-  m_ComposedTransform->Compose(m_CamRotTransform, 0);
-
-  // The overall inverse transform is computed. The inverse transform will be used by the interpolation
-  // procedure.
-  m_ComposedTransform->GetInverse(m_InverseTransform);
-  this->Modified();
-}
-
-
-template <typename TInputImage, typename TCoordRep>
-void
-SiddonJacobsRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Initialize()
-{
-  this->ComputeInverseTransform();
-  m_SourceWorld = m_InverseTransform->TransformPoint(m_SourcePoint);
 }
 
 } // namespace itk
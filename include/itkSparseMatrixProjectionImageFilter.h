@@ -0,0 +1,185 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkSparseMatrixProjectionImageFilter_h
+#define itkSparseMatrixProjectionImageFilter_h
+
+#include "itkProjectionImageFilter.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace itk
+{
+
+/** \class SparseMatrixProjectionImageFilter
+ * \brief Compute a DRR as the product of a cached sparse projection matrix and the volume.
+ *
+ * The first time a pose is projected, the exact Siddon-Jacobs ray paths of
+ * all the detector pixels are recorded as a compressed sparse row matrix:
+ * one row per pixel, holding the offsets in the buffer of the voxels
+ * crossed by the ray and the lengths of the intersections. The DRR is then
+ * the product of that matrix with the thresholded volume. Projecting
+ * another volume with the same geometry (the phases of a 4D-CT, contrast
+ * or density variants) reuses the matrix, and only costs a multithreaded
+ * sparse matrix-vector product without any traversal logic. The result is
+ * the one of SiddonJacobsRayCastInterpolateImageFunction.
+ *
+ * The matrices are kept for the most recently used poses, as long as their
+ * total size stays below MaximumCacheSize bytes; the least recently used
+ * ones are released first. A pose is identified by the parameters of the
+ * Transform, the ProjectionAngle, the FocalPointToIsocenterDistance, the
+ * detector grid and the size and spacing of the volume, but not by the
+ * voxel values nor by the Threshold. A matrix larger than the cache is
+ * used for the current update only.
+ *
+ * A matrix takes 8 bytes per voxel crossed by each ray, which is much more
+ * than the volume: this filter trades memory for speed when the same poses
+ * are projected many times. The volume must have less than 2^32 voxels.
+ *
+ * \sa SiddonJacobsRayCastInterpolateImageFunction
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage>
+class SparseMatrixProjectionImageFilter : public ProjectionImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(SparseMatrixProjectionImageFilter);
+
+  /** Standard class type alias. */
+  using Self = SparseMatrixProjectionImageFilter;
+  using Superclass = ProjectionImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(SparseMatrixProjectionImageFilter, ProjectionImageFilter);
+
+  using InputImageType = typename Superclass::InputImageType;
+  using InputPixelType = typename Superclass::InputPixelType;
+  using OutputImageType = typename Superclass::OutputImageType;
+  using OutputPixelType = typename Superclass::OutputPixelType;
+  using TransformType = typename Superclass::TransformType;
+  using PointType = typename Superclass::PointType;
+  using ParametersType = typename TransformType::ParametersType;
+  using FixedParametersType = typename TransformType::FixedParametersType;
+
+  /** Ray caster used to record the ray paths. */
+  using RayCasterType = SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = Superclass::ImageDimension;
+
+  /** Set and get the maximum size of the cached matrices in bytes. */
+  itkSetMacro(MaximumCacheSize, SizeValueType);
+  itkGetConstMacro(MaximumCacheSize, SizeValueType);
+
+  /** Total size of the cached matrices in bytes. */
+  SizeValueType
+  GetCacheSize() const;
+
+  /** Number of poses whose matrix is cached. */
+  SizeValueType
+  GetNumberOfCachedMatrices() const
+  {
+    return m_Cache.size();
+  }
+
+  /** Release all the cached matrices. */
+  void
+  ClearCache();
+
+  /** Number of updates that reused a cached matrix, and that had to record
+   * a new one. */
+  itkGetConstMacro(NumberOfCacheHits, SizeValueType);
+  itkGetConstMacro(NumberOfCacheMisses, SizeValueType);
+
+protected:
+  SparseMatrixProjectionImageFilter();
+  ~SparseMatrixProjectionImageFilter() override = default;
+
+  void
+  GenerateData() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Everything the ray paths depend on. */
+  struct GeometryKey
+  {
+    ParametersType                          Parameters;
+    FixedParametersType                     FixedParameters;
+    double                                  ProjectionAngle{ 0.0 };
+    double                                  FocalPointToIsocenterDistance{ 0.0 };
+    typename OutputImageType::RegionType    Region;
+    typename OutputImageType::SpacingType   Spacing;
+    typename OutputImageType::PointType     Origin;
+    typename OutputImageType::DirectionType Direction;
+    typename InputImageType::SizeType       VolumeSize;
+    typename InputImageType::SpacingType    VolumeSpacing;
+
+    bool
+    operator==(const GeometryKey & other) const;
+  };
+
+  /** The ray paths of the pixels of one detector row, in compressed sparse
+   * row format: the voxels of pixel u are at [RowStart[u], RowStart[u+1]). */
+  struct MatrixRow
+  {
+    std::vector<SizeValueType> RowStart;
+    std::vector<std::uint32_t> Offsets;
+    std::vector<float>         Lengths;
+  };
+
+  struct ProjectionMatrix
+  {
+    GeometryKey            Key;
+    std::vector<MatrixRow> Rows;
+    SizeValueType          Size{ 0 };
+  };
+
+  using ProjectionMatrixPointer = std::shared_ptr<const ProjectionMatrix>;
+
+  GeometryKey
+  GetCurrentKey() const;
+
+  /** Record the ray paths of the current pose. */
+  ProjectionMatrixPointer
+  ComputeProjectionMatrix(const GeometryKey & key);
+
+  // Most recently used first
+  std::list<ProjectionMatrixPointer> m_Cache;
+
+  SizeValueType m_MaximumCacheSize;
+  SizeValueType m_NumberOfCacheHits{ 0 };
+  SizeValueType m_NumberOfCacheMisses{ 0 };
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkSparseMatrixProjectionImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkSparseMatrixProjectionImageFilter_hxx
+#define itkSparseMatrixProjectionImageFilter_hxx
+
+#include "itkSparseMatrixProjectionImageFilter.h"
+
+#include "itkMultiThreaderBase.h"
+#include <algorithm>
+#include <limits>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::SparseMatrixProjectionImageFilter()
+{
+  m_MaximumCacheSize = 1024 * 1024 * 1024;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+bool
+SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::GeometryKey::operator==(const GeometryKey & other) const
+{
+  return Parameters == other.Parameters && FixedParameters == other.FixedParameters &&
+         ProjectionAngle == other.ProjectionAngle &&
+         FocalPointToIsocenterDistance == other.FocalPointToIsocenterDistance && Region == other.Region &&
+         Spacing == other.Spacing && Origin == other.Origin && Direction == other.Direction &&
+         VolumeSize == other.VolumeSize && VolumeSpacing == other.VolumeSpacing;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+typename SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::GeometryKey
+SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::GetCurrentKey() const
+{
+  const InputImageType *  inputPtr = this->GetInput();
+  const OutputImageType * outputPtr = this->GetOutput();
+
+  GeometryKey key;
+  key.Parameters = this->GetTransform()->GetParameters();
+  key.FixedParameters = this->GetTransform()->GetFixedParameters();
+  key.ProjectionAngle = this->GetProjectionAngle();
+  key.FocalPointToIsocenterDistance = this->GetFocalPointToIsocenterDistance();
+  key.Region = outputPtr->GetRequestedRegion();
+  key.Spacing = outputPtr->GetSpacing();
+  key.Origin = outputPtr->GetOrigin();
+  key.Direction = outputPtr->GetDirection();
+  key.VolumeSize = inputPtr->GetBufferedRegion().GetSize();
+  key.VolumeSpacing = inputPtr->GetSpacing();
+  return key;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+SizeValueType
+SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::GetCacheSize() const
+{
+  SizeValueType size = 0;
+  for (const ProjectionMatrixPointer & matrix : m_Cache)
+  {
+    size += matrix->Size;
+  }
+  return size;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::ClearCache()
+{
+  m_Cache.clear();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+typename SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::ProjectionMatrixPointer
+SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::ComputeProjectionMatrix(const GeometryKey & key)
+{
+  const InputImageType *  inputPtr = this->GetInput();
+  const OutputImageType * outputPtr = this->GetOutput();
+  const TransformType *   inverseTransform = this->GetInverseTransform();
+  const PointType &       sourceWorld = this->GetSourceWorld();
+
+  const typename InputImageType::SizeType sizeCT = inputPtr->GetBufferedRegion().GetSize();
+  if (sizeCT[0] * sizeCT[1] * sizeCT[2] > std::numeric_limits<std::uint32_t>::max())
+  {
+    itkExceptionMacro(<< "The volume is too large for a sparse projection matrix");
+  }
+
+  typename RayCasterType::Pointer rayCaster = RayCasterType::New();
+  rayCaster->SetInputImage(inputPtr);
+
+  const typename OutputImageType::RegionType outputRegion = outputPtr->GetRequestedRegion();
+  const SizeValueType                        sizeU = outputRegion.GetSize()[0];
+  const SizeValueType                        sizeV = outputRegion.GetSize()[1];
+
+  // The rays are an affine function of the pixel index.
+  typename RayCasterType::VectorType firstRay, stepU, stepV;
+  {
+    typename OutputImageType::PointType     p00, p10, p01;
+    ContinuousIndex<double, ImageDimension> index;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      index[i] = outputRegion.GetIndex()[i];
+    }
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p00);
+    index[0] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p10);
+    index[0] -= 1.0;
+    index[1] += 1.0;
+    outputPtr->TransformContinuousIndexToPhysicalPoint(index, p01);
+
+    const PointType w00 = inverseTransform->TransformPoint(p00);
+    const PointType w10 = inverseTransform->TransformPoint(p10);
+    const PointType w01 = inverseTransform->TransformPoint(p01);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      firstRay[i] = w00[i] - sourceWorld[i];
+      stepU[i] = w10[i] - w00[i];
+      stepV[i] = w01[i] - w00[i];
+    }
+  }
+
+  auto matrix = std::make_shared<ProjectionMatrix>();
+  matrix->Key = key;
+  matrix->Rows.resize(sizeV);
+
+  const SizeValueType strideY = sizeCT[0];
+  const SizeValueType strideZ = sizeCT[0] * sizeCT[1];
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    sizeV,
+    [&](SizeValueType v) {
+      MatrixRow & row = matrix->Rows[v];
+      row.RowStart.reserve(sizeU + 1);
+      row.RowStart.push_back(0);
+
+      auto record = [&row, strideY, strideZ](const typename InputImageType::IndexType & index, float length) {
+        row.Offsets.push_back(static_cast<std::uint32_t>(index[0] + index[1] * strideY + index[2] * strideZ));
+        row.Lengths.push_back(length);
+      };
+      for (SizeValueType u = 0; u < sizeU; ++u)
+      {
+        const typename RayCasterType::VectorType ray = firstRay + stepU * static_cast<double>(u) +
+                                                       stepV * static_cast<double>(v);
+        rayCaster->TraceRay(sourceWorld, ray, record);
+        row.RowStart.push_back(row.Offsets.size());
+      }
+      row.Offsets.shrink_to_fit();
+      row.Lengths.shrink_to_fit();
+    },
+    nullptr);
+
+  for (const MatrixRow & row : matrix->Rows)
+  {
+    matrix->Size += row.RowStart.size() * sizeof(SizeValueType) + row.Offsets.size() * sizeof(std::uint32_t) +
+                    row.Lengths.size() * sizeof(float);
+  }
+  return matrix;
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  this->AllocateOutputs();
+  this->UpdateProjectionGeometry();
+
+  const InputImageType * inputPtr = this->GetInput();
+  OutputImageType *      outputPtr = this->GetOutput();
+
+  // Look for the matrix of the current pose, and record it if needed
+  const GeometryKey       key = this->GetCurrentKey();
+  ProjectionMatrixPointer matrix;
+  for (auto it = m_Cache.begin(); it != m_Cache.end(); ++it)
+  {
+    if ((*it)->Key == key)
+    {
+      matrix = *it;
+      m_Cache.erase(it);
+      break;
+    }
+  }
+
+  if (matrix)
+  {
+    ++m_NumberOfCacheHits;
+  }
+  else
+  {
+    ++m_NumberOfCacheMisses;
+    matrix = this->ComputeProjectionMatrix(key);
+  }
+
+  if (matrix->Size <= m_MaximumCacheSize)
+  {
+    SizeValueType cacheSize = this->GetCacheSize();
+    while (!m_Cache.empty() && cacheSize + matrix->Size > m_MaximumCacheSize)
+    {
+      cacheSize -= m_Cache.back()->Size;
+      m_Cache.pop_back();
+    }
+    m_Cache.push_front(matrix);
+  }
+
+  // Sparse matrix-vector product with the thresholded volume, as in the
+  // Siddon-Jacobs ray caster
+  const InputPixelType * volume = inputPtr->GetBufferPointer();
+  const double           threshold = this->GetThreshold();
+  const SizeValueType    sizeU = outputPtr->GetRequestedRegion().GetSize()[0];
+
+  const double minOutputValue = NumericTraits<OutputPixelType>::NonpositiveMin();
+  const double maxOutputValue = NumericTraits<OutputPixelType>::max();
+
+  OutputPixelType * output = outputPtr->GetBufferPointer();
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    matrix->Rows.size(),
+    [&](SizeValueType v) {
+      const MatrixRow &     row = matrix->Rows[v];
+      const std::uint32_t * offsets = row.Offsets.data();
+      const float *         lengths = row.Lengths.data();
+      for (SizeValueType u = 0; u < sizeU; ++u)
+      {
+        double d12 = 0.0;
+        for (SizeValueType k = row.RowStart[u]; k < row.RowStart[u + 1]; ++k)
+        {
+          const double value = static_cast<double>(volume[offsets[k]]) - threshold;
+          if (value > 0)
+          {
+            d12 += lengths[k] * value;
+          }
+        }
+        d12 = std::min(std::max(d12, minOutputValue), maxOutputValue);
+        output[v * sizeU + u] = static_cast<OutputPixelType>(d12);
+      }
+    },
+    nullptr);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+SparseMatrixProjectionImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "MaximumCacheSize: " << m_MaximumCacheSize << std::endl;
+  os << indent << "CacheSize: " << this->GetCacheSize() << std::endl;
+  os << indent << "NumberOfCachedMatrices: " << this->GetNumberOfCachedMatrices() << std::endl;
+  os << indent << "NumberOfCacheHits: " << m_NumberOfCacheHits << std::endl;
+  os << indent << "NumberOfCacheMisses: " << m_NumberOfCacheMisses << std::endl;
+}
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,164 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkStreamingNiftiImageFileWriter_h
+#define itkStreamingNiftiImageFileWriter_h
+
+#include "itkImage.h"
+#include "itkProcessObject.h"
+#include "itkProjectionThreadPool.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class StreamingNiftiImageFileWriter
+ * \brief Write an image as a single file NIfTI-1 image, streamed by slabs and compressed in parallel.
+ *
+ * ImageFileWriter with NiftiImageIO needs the whole buffer of the image,
+ * and a ".nii.gz" file is compressed on a single thread. This writer
+ * requests the image from the pipeline in NumberOfStreamDivisions slabs
+ * along its slowest dimension, so that the filters producing it run on one
+ * slab at a time with bounded memory.
+ *
+ * If FileName ends with ".gz", each slab is cut into blocks of BlockSize
+ * bytes which are compressed in parallel by the threads of the ThreadPool,
+ * each block as a gzip member of its own. The concatenated members form a
+ * valid gzip file, read by any gzip decoder and by NiftiImageIO. The
+ * compression and the writing of a slab overlap the production of the
+ * next one, so that the conversion of a large volume is limited by the
+ * input and the output rather than by the compression. Other files are
+ * written uncompressed.
+ *
+ * The header holds the geometry of the image, converted from the LPS
+ * coordinates of ITK to the RAS coordinates of NIfTI, in both the qform
+ * and the sform. Images of scalar pixels only are supported.
+ *
+ * \sa ProjectionThreadPool
+ *
+ * \ingroup IOFilters
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage>
+class StreamingNiftiImageFileWriter : public ProcessObject
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(StreamingNiftiImageFileWriter);
+
+  /** Standard class type alias. */
+  using Self = StreamingNiftiImageFileWriter;
+  using Superclass = ProcessObject;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingNiftiImageFileWriter, ProcessObject);
+
+  using InputImageType = TInputImage;
+  using PixelType = typename InputImageType::PixelType;
+  using RegionType = typename InputImageType::RegionType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  /** Set and get the image to write. */
+  using Superclass::SetInput;
+  void
+  SetInput(const InputImageType * input);
+  const InputImageType *
+  GetInput() const;
+
+  /** Set and get the name of the file, compressed if it ends with ".gz". */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** Set and get the number of slabs the image is requested in. */
+  itkSetClampMacro(NumberOfStreamDivisions, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(NumberOfStreamDivisions, unsigned int);
+
+  /** Set and get the zlib compression level, from 0 (none) to 9 (best). */
+  itkSetClampMacro(CompressionLevel, int, 0, 9);
+  itkGetConstMacro(CompressionLevel, int);
+
+  /** Set and get the size, in bytes, of the blocks compressed in parallel. */
+  itkSetClampMacro(BlockSize, SizeValueType, 1024, NumericTraits<SizeValueType>::max());
+  itkGetConstMacro(BlockSize, SizeValueType);
+
+  /** Set and get the threads compressing the blocks. */
+  itkSetObjectMacro(ThreadPool, ProjectionThreadPool);
+  itkGetModifiableObjectMacro(ThreadPool, ProjectionThreadPool);
+
+  /** Write the file. */
+  virtual void
+  Write();
+
+  /** Aliases for Write(), as in ImageFileWriter. */
+  void
+  Update() override
+  {
+    this->Write();
+  }
+  void
+  UpdateLargestPossibleRegion() override
+  {
+    this->Write();
+  }
+
+protected:
+  StreamingNiftiImageFileWriter();
+  ~StreamingNiftiImageFileWriter() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Does nothing: the data is written by Write(). */
+  void
+  GenerateData() override
+  {}
+
+private:
+  /** NIfTI-1 header and empty extension of the image. */
+  std::vector<char>
+  MakeHeader(const InputImageType * input) const;
+
+  /** Write bytes to the file, compressed if compress is true. */
+  void
+  WriteBytes(std::FILE * file, const std::vector<char> & bytes, bool compress);
+
+  /** Compress bytes as a single gzip member. */
+  std::vector<char>
+  CompressBlock(const char * bytes, SizeValueType size) const;
+
+  std::string                   m_FileName;
+  unsigned int                  m_NumberOfStreamDivisions;
+  int                           m_CompressionLevel;
+  SizeValueType                 m_BlockSize;
+  ProjectionThreadPool::Pointer m_ThreadPool;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkStreamingNiftiImageFileWriter.hxx"
+#endif
+
+#endif
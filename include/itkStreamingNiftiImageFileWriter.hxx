@@ -0,0 +1,343 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkStreamingNiftiImageFileWriter_hxx
+#define itkStreamingNiftiImageFileWriter_hxx
+
+#include "itkStreamingNiftiImageFileWriter.h"
+
+#include "itkImageRegionSplitterSlowDimension.h"
+#include "itkImageScanlineConstIterator.h"
+#include "itk_zlib.h"
+#include "nifti1_io.h"
+#include <cstring>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace itk
+{
+
+template <typename TInputImage>
+StreamingNiftiImageFileWriter<TInputImage>::StreamingNiftiImageFileWriter()
+{
+  m_NumberOfStreamDivisions = 8;
+  m_CompressionLevel = 6;
+  m_BlockSize = 1 << 20;
+  m_ThreadPool = ProjectionThreadPool::New();
+
+  this->SetNumberOfRequiredInputs(1);
+}
+
+
+template <typename TInputImage>
+void
+StreamingNiftiImageFileWriter<TInputImage>::SetInput(const InputImageType * input)
+{
+  this->ProcessObject::SetNthInput(0, const_cast<InputImageType *>(input));
+}
+
+
+template <typename TInputImage>
+const typename StreamingNiftiImageFileWriter<TInputImage>::InputImageType *
+StreamingNiftiImageFileWriter<TInputImage>::GetInput() const
+{
+  return itkDynamicCastInDebugMode<const InputImageType *>(this->GetPrimaryInput());
+}
+
+
+template <typename TInputImage>
+void
+StreamingNiftiImageFileWriter<TInputImage>::Write()
+{
+  auto * input = const_cast<InputImageType *>(this->GetInput());
+  if (!input)
+  {
+    itkExceptionMacro(<< "No input to writer!");
+  }
+  if (m_FileName.empty())
+  {
+    itkExceptionMacro(<< "No filename was specified");
+  }
+
+  this->InvokeEvent(StartEvent());
+  this->UpdateProgress(0.0f);
+
+  input->UpdateOutputInformation();
+  const RegionType largest = input->GetLargestPossibleRegion();
+
+  const bool compress = m_FileName.size() > 3 && m_FileName.compare(m_FileName.size() - 3, 3, ".gz") == 0;
+
+  std::FILE * file = std::fopen(m_FileName.c_str(), "wb");
+  if (!file)
+  {
+    itkExceptionMacro(<< "Cannot open " << m_FileName << " for writing");
+  }
+
+  // The previous slab is compressed and written while the pipeline
+  // produces the next one.
+  std::future<void> pending;
+  try
+  {
+    this->WriteBytes(file, this->MakeHeader(input), compress);
+
+    ImageRegionSplitterSlowDimension::Pointer splitter = ImageRegionSplitterSlowDimension::New();
+    const unsigned int                        numberOfSlabs =
+      splitter->GetNumberOfSplits(largest, m_NumberOfStreamDivisions);
+    for (unsigned int piece = 0; piece < numberOfSlabs; ++piece)
+    {
+      RegionType slab = largest;
+      splitter->GetSplit(piece, numberOfSlabs, slab);
+
+      input->SetRequestedRegion(slab);
+      input->PropagateRequestedRegion();
+      input->UpdateOutputData();
+
+      // The buffered region may be larger than the slab.
+      const SizeValueType lineSize = slab.GetSize(0) * sizeof(PixelType);
+      auto                bytes = std::make_shared<std::vector<char>>(slab.GetNumberOfPixels() * sizeof(PixelType));
+      char *              destination = bytes->data();
+      for (ImageScanlineConstIterator<InputImageType> it(input, slab); !it.IsAtEnd(); it.NextLine())
+      {
+        std::memcpy(destination, &it.Value(), lineSize);
+        destination += lineSize;
+      }
+
+      if (pending.valid())
+      {
+        pending.get();
+      }
+      pending = std::async(std::launch::async, [this, file, bytes, compress] {
+        this->WriteBytes(file, *bytes, compress);
+      });
+
+      this->UpdateProgress(static_cast<float>(piece + 1) / numberOfSlabs);
+    }
+    if (pending.valid())
+    {
+      pending.get();
+    }
+  }
+  catch (...)
+  {
+    if (pending.valid())
+    {
+      pending.wait();
+    }
+    std::fclose(file);
+    input->SetRequestedRegionToLargestPossibleRegion();
+    throw;
+  }
+
+  input->SetRequestedRegionToLargestPossibleRegion();
+  if (std::fclose(file) != 0)
+  {
+    itkExceptionMacro(<< "Cannot write " << m_FileName);
+  }
+
+  this->InvokeEvent(EndEvent());
+  this->ReleaseInputs();
+}
+
+
+template <typename TInputImage>
+std::vector<char>
+StreamingNiftiImageFileWriter<TInputImage>::MakeHeader(const InputImageType * input) const
+{
+  static_assert(std::is_arithmetic<PixelType>::value, "Only images of scalar pixels may be written");
+  static_assert(ImageDimension <= 7, "NIfTI images have at most 7 dimensions");
+
+  nifti_1_header header;
+  std::memset(&header, 0, sizeof(header));
+  header.sizeof_hdr = sizeof(header);
+  std::strncpy(header.magic, "n+1", sizeof(header.magic));
+  header.vox_offset = sizeof(header) + 4;
+  header.xyzt_units = NIFTI_UNITS_MM;
+
+  if (std::is_floating_point<PixelType>::value)
+  {
+    header.datatype = sizeof(PixelType) == 4 ? DT_FLOAT32 : DT_FLOAT64;
+  }
+  else
+  {
+    const bool isSigned = std::is_signed<PixelType>::value;
+    switch (sizeof(PixelType))
+    {
+      case 1:
+        header.datatype = isSigned ? DT_INT8 : DT_UINT8;
+        break;
+      case 2:
+        header.datatype = isSigned ? DT_INT16 : DT_UINT16;
+        break;
+      case 4:
+        header.datatype = isSigned ? DT_INT32 : DT_UINT32;
+        break;
+      default:
+        header.datatype = isSigned ? DT_INT64 : DT_UINT64;
+    }
+  }
+  header.bitpix = 8 * sizeof(PixelType);
+
+  const typename InputImageType::SizeType      size = input->GetLargestPossibleRegion().GetSize();
+  const typename InputImageType::SpacingType   spacing = input->GetSpacing();
+  const typename InputImageType::PointType     origin = input->GetOrigin();
+  const typename InputImageType::DirectionType direction = input->GetDirection();
+  header.dim[0] = ImageDimension;
+  for (unsigned int i = 1; i < 8; ++i)
+  {
+    header.dim[i] = 1;
+    header.pixdim[i] = 1.0f;
+  }
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    header.dim[i + 1] = static_cast<short>(size[i]);
+    header.pixdim[i + 1] = static_cast<float>(spacing[i]);
+    if (size[i] > static_cast<SizeValueType>(NumericTraits<short>::max()))
+    {
+      itkExceptionMacro(<< "The size " << size << " exceeds the limits of a NIfTI-1 image");
+    }
+  }
+
+  // The spatial dimensions are mapped from LPS to RAS by negating the first
+  // two rows.
+  mat44 transform;
+  std::memset(&transform, 0, sizeof(transform));
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    const float sign = i < 2 ? -1.0f : 1.0f;
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      if (i < ImageDimension && j < ImageDimension)
+      {
+        transform.m[i][j] = sign * static_cast<float>(direction[i][j] * spacing[j]);
+      }
+      else
+      {
+        transform.m[i][j] = i == j ? 1.0f : 0.0f;
+      }
+    }
+    transform.m[i][3] = i < ImageDimension ? sign * static_cast<float>(origin[i]) : 0.0f;
+  }
+  transform.m[3][3] = 1.0f;
+
+  header.sform_code = NIFTI_XFORM_SCANNER_ANAT;
+  for (unsigned int j = 0; j < 4; ++j)
+  {
+    header.srow_x[j] = transform.m[0][j];
+    header.srow_y[j] = transform.m[1][j];
+    header.srow_z[j] = transform.m[2][j];
+  }
+
+  header.qform_code = NIFTI_XFORM_SCANNER_ANAT;
+  float dx;
+  float dy;
+  float dz;
+  nifti_mat44_to_quatern(transform,
+                         &header.quatern_b,
+                         &header.quatern_c,
+                         &header.quatern_d,
+                         &header.qoffset_x,
+                         &header.qoffset_y,
+                         &header.qoffset_z,
+                         &dx,
+                         &dy,
+                         &dz,
+                         &header.pixdim[0]);
+
+  std::vector<char> bytes(sizeof(header) + 4, 0);
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  return bytes;
+}
+
+
+template <typename TInputImage>
+void
+StreamingNiftiImageFileWriter<TInputImage>::WriteBytes(std::FILE *                file,
+                                                        const std::vector<char> & bytes,
+                                                        bool                      compress)
+{
+  if (!compress)
+  {
+    if (std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+    {
+      itkExceptionMacro(<< "Cannot write " << m_FileName);
+    }
+    return;
+  }
+
+  const SizeValueType            numberOfBlocks = (bytes.size() + m_BlockSize - 1) / m_BlockSize;
+  std::vector<std::vector<char>> blocks(numberOfBlocks);
+  m_ThreadPool->Run(numberOfBlocks, [&](SizeValueType block) {
+    const SizeValueType begin = block * m_BlockSize;
+    blocks[block] =
+      this->CompressBlock(bytes.data() + begin, std::min<SizeValueType>(m_BlockSize, bytes.size() - begin));
+  });
+
+  for (const std::vector<char> & block : blocks)
+  {
+    if (std::fwrite(block.data(), 1, block.size(), file) != block.size())
+    {
+      itkExceptionMacro(<< "Cannot write " << m_FileName);
+    }
+  }
+}
+
+
+template <typename TInputImage>
+std::vector<char>
+StreamingNiftiImageFileWriter<TInputImage>::CompressBlock(const char * bytes, SizeValueType size) const
+{
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  // A window of 15 bits, plus 16 for a gzip header and trailer
+  if (deflateInit2(&stream, m_CompressionLevel, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+  {
+    itkExceptionMacro(<< "Cannot initialize the compression");
+  }
+
+  std::vector<char> compressed(deflateBound(&stream, static_cast<uLong>(size)));
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(bytes));
+  stream.avail_in = static_cast<uInt>(size);
+  stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+  stream.avail_out = static_cast<uInt>(compressed.size());
+  const int status = deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END)
+  {
+    itkExceptionMacro(<< "Cannot compress a block of " << size << " bytes");
+  }
+  return compressed;
+}
+
+
+template <typename TInputImage>
+void
+StreamingNiftiImageFileWriter<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "NumberOfStreamDivisions: " << m_NumberOfStreamDivisions << std::endl;
+  os << indent << "CompressionLevel: " << m_CompressionLevel << std::endl;
+  os << indent << "BlockSize: " << m_BlockSize << std::endl;
+  os << indent << "ThreadPool: " << m_ThreadPool.GetPointer() << std::endl;
+}
+
+} // namespace itk
+
+#endif
@@ -24,6 +24,9 @@
 #include "itkSingleValuedCostFunction.h"
 #include "itkGradientRecursiveGaussianImageFilter.h"
 #include "itkSpatialObject.h"
+#include "itkProjectionTileScheduler.h"
+#include "itkProjectionVolumeContext.h"
+#include <type_traits>
 
 namespace itk
 {
@@ -94,6 +97,14 @@ public:
   /**  Type of the Interpolator Base class */
   using InterpolatorType = InterpolateImageFunction<MovingImageType, CoordinateRepresentationType>;
 
+  /** Data derived from the Moving Image, shared by the projection interpolators */
+  using VolumeContextType = ProjectionVolumeContext<MovingImageType>;
+  using VolumeContextPointer = typename VolumeContextType::Pointer;
+
+  /** Scheduler distributing the tiles of the fixed images over the threads */
+  using TileSchedulerType = ProjectionTileScheduler<FixedImageDimension>;
+  using TileSchedulerPointer = typename TileSchedulerType::Pointer;
+
 
   /** Gaussian filter to compute the gradient of the Moving Image */
   using RealType = typename NumericTraits<MovingImagePixelType>::RealType;
@@ -160,6 +171,26 @@ public:
   /** Get a pointer to the Interpolator.  */
   itkGetConstObjectMacro(Interpolator2, InterpolatorType);
 
+  /** Set and get the context shared by the projection interpolators. Setting
+   * one lets its options, such as ReplicatePerNumaNode, be chosen. Its input
+   * image and threshold are set by Initialize(). */
+  itkSetObjectMacro(VolumeContext, VolumeContextType);
+  itkGetConstObjectMacro(VolumeContext, VolumeContextType);
+
+  /** Set and get whether the projection interpolators read the Moving Image
+   * from a VolumeContext, created by Initialize() if none is set. The
+   * context holds a float copy of the volume, so this is off by default
+   * and the interpolators read the Moving Image directly. A VolumeContext
+   * that is set is used whatever this setting. */
+  itkSetMacro(UseVolumeContext, bool);
+  itkGetConstMacro(UseVolumeContext, bool);
+  itkBooleanMacro(UseVolumeContext);
+
+  /** Set and get the scheduler of the tiles of the fixed images. The time
+   * spent on each tile by the last evaluation is available from it. */
+  itkSetObjectMacro(TileScheduler, TileSchedulerType);
+  itkGetModifiableObjectMacro(TileScheduler, TileSchedulerType);
+
   /** Get the number of pixels considered in the computation. */
   itkGetConstReferenceMacro(NumberOfPixelsCounted, unsigned long);
 
@@ -224,6 +255,9 @@ protected:
   mutable TransformPointer m_Transform;
   InterpolatorPointer      m_Interpolator1;
   InterpolatorPointer      m_Interpolator2;
+  VolumeContextPointer     m_VolumeContext;
+  bool                     m_UseVolumeContext;
+  TileSchedulerPointer     m_TileScheduler;
 
   bool                 m_ComputeGradient;
   GradientImagePointer m_GradientImage;
@@ -233,6 +267,14 @@ protected:
   mutable MovingImageMaskPointer m_MovingImageMask;
 
 private:
+  /** Share the data derived from the Moving Image between the projection
+   * interpolators, which work for 3-dimensional images only. */
+  void
+  InitializeVolumeContext(std::true_type);
+  void
+  InitializeVolumeContext(std::false_type)
+  {}
+
   FixedImageRegionType m_FixedImageRegion1;
   FixedImageRegionType m_FixedImageRegion2;
 };
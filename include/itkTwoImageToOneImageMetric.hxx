@@ -19,6 +19,7 @@
 #define itkTwoImageToOneImageMetric_hxx
 
 #include "itkTwoImageToOneImageMetric.h"
+#include "itkProjectionInterpolateImageFunction.h"
 
 
 namespace itk
@@ -37,6 +38,8 @@ TwoImageToOneImageMetric<TFixedImage, TMovingImage>::TwoImageToOneImageMetric()
   m_ComputeGradient = true;    // metric computes gradient by default
   m_NumberOfPixelsCounted = 0; // initialize to zero
   m_GradientImage = nullptr;   // computed at initialization
+  m_UseVolumeContext = false;  // interpolators read the moving image
+  m_TileScheduler = TileSchedulerType::New();
 }
 
 
@@ -130,6 +133,8 @@ TwoImageToOneImageMetric<TFixedImage, TMovingImage>::Initialize()
   m_Interpolator1->SetInputImage(m_MovingImage);
   m_Interpolator2->SetInputImage(m_MovingImage);
 
+  this->InitializeVolumeContext(std::integral_constant<bool, MovingImageDimension == 3>());
+
   if (m_ComputeGradient)
   {
 
@@ -160,6 +165,52 @@ TwoImageToOneImageMetric<TFixedImage, TMovingImage>::Initialize()
 }
 
 
+template <typename TFixedImage, typename TMovingImage>
+void
+TwoImageToOneImageMetric<TFixedImage, TMovingImage>::InitializeVolumeContext(std::true_type)
+{
+  // Both interpolators project the Moving Image: the data they derive from
+  // it is computed once and shared.
+  using ProjectionInterpolatorType = ProjectionInterpolateImageFunction<MovingImageType, CoordinateRepresentationType>;
+  auto * projector1 = dynamic_cast<ProjectionInterpolatorType *>(m_Interpolator1.GetPointer());
+  auto * projector2 = dynamic_cast<ProjectionInterpolatorType *>(m_Interpolator2.GetPointer());
+
+  // The projectors reading a volume stored out of core need no context;
+  // their bricks are written if needed.
+  for (ProjectionInterpolatorType ** projector : { &projector1, &projector2 })
+  {
+    if (*projector && (*projector)->GetBrickedVolume())
+    {
+      typename ProjectionInterpolatorType::BrickedVolumeType * bricks = (*projector)->GetModifiableBrickedVolume();
+      bricks->SetThreshold((*projector)->GetThreshold());
+      bricks->Update();
+      *projector = nullptr;
+    }
+  }
+
+  // Without a context, the projectors read the Moving Image directly.
+  if ((projector1 || projector2) && (m_UseVolumeContext || m_VolumeContext))
+  {
+    if (!m_VolumeContext)
+    {
+      m_VolumeContext = VolumeContextType::New();
+    }
+    m_VolumeContext->SetInputImage(m_MovingImage);
+    m_VolumeContext->SetThreshold(projector1 ? projector1->GetThreshold() : projector2->GetThreshold());
+    m_VolumeContext->Update();
+
+    if (projector1)
+    {
+      projector1->SetVolumeContext(m_VolumeContext);
+    }
+    if (projector2)
+    {
+      projector2->SetVolumeContext(m_VolumeContext);
+    }
+  }
+}
+
+
 template <typename TFixedImage, typename TMovingImage>
 void
 TwoImageToOneImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::ostream & os, Indent indent) const
@@ -174,6 +225,10 @@ TwoImageToOneImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::ostream & os
   os << indent << "Transform:    " << m_Transform.GetPointer() << std::endl;
   os << indent << "Interpolator 1: " << m_Interpolator1.GetPointer() << std::endl;
   os << indent << "Interpolator 2: " << m_Interpolator2.GetPointer() << std::endl;
+  os << indent << "Volume Context: " << m_VolumeContext.GetPointer() << std::endl;
+  os << indent << "UseVolumeContext: " << static_cast<typename NumericTraits<bool>::PrintType>(m_UseVolumeContext)
+     << std::endl;
+  os << indent << "Tile Scheduler: " << m_TileScheduler.GetPointer() << std::endl;
   os << indent << "FixedImageRegion 1: " << m_FixedImageRegion1 << std::endl;
   os << indent << "FixedImageRegion 2: " << m_FixedImageRegion2 << std::endl;
   os << indent << "Moving Image Mask: " << m_MovingImageMask.GetPointer() << std::endl;
@@ -21,6 +21,8 @@
 #include "itkProcessObject.h"
 #include "itkImage.h"
 #include "itkTwoImageToOneImageMetric.h"
+#include "itkProjectionPreprocessImageFilter.h"
+#include "itkProjectionThreadPool.h"
 #include "itkSingleValuedNonLinearOptimizer.h"
 #include "itkDataObjectDecorator.h"
 
@@ -58,6 +60,20 @@ namespace itk
  * image with the Transformed Moving image. This process also requires to
  * interpolate values from the Moving image.
  *
+ * The metric is evaluated on the ThreadPool, created with the registration
+ * method and kept for its lifetime, so that the threads are not woken up
+ * or created anew for each of the many evaluations of the metric. If the
+ * VolumeContext of the metric has ReplicatePerNumaNode on, Initialize()
+ * turns BindThreadsToNumaNodes on for the ThreadPool, so that each thread
+ * reads the copy of the volume in the memory of its node.
+ *
+ * If PreprocessFixedImages is on, the fixed images are the X-ray images as
+ * read, and the registration method prepares them for the metric with its
+ * FixedImagePreprocessor1 and FixedImagePreprocessor2, which flip them,
+ * rescale their intensities and place them in the projection geometry in a
+ * single pass each. The fixed image regions then refer to the
+ * preprocessed images.
+ *
  * \ingroup RegistrationFilters
  * \ingroup TwoProjectionRegistration
  */
@@ -113,6 +129,10 @@ public:
    *  represent the search space of the optimization algorithm */
   using ParametersType = typename MetricType::TransformParametersType;
 
+  /**  Type of the filters preparing the fixed images. */
+  using FixedImagePreprocessorType = ProjectionPreprocessImageFilter<FixedImageType, FixedImageType>;
+  using FixedImagePreprocessorPointer = typename FixedImagePreprocessorType::Pointer;
+
   /** Smart Pointer type to a DataObject. */
   using DataObjectPointer = typename DataObject::Pointer;
 
@@ -135,6 +155,24 @@ public:
   itkGetConstObjectMacro(FixedImage1, FixedImageType);
   itkGetConstObjectMacro(FixedImage2, FixedImageType);
 
+  /** Set/Get whether the fixed images are preprocessed before being
+   * compared by the metric. */
+  itkSetMacro(PreprocessFixedImages, bool);
+  itkGetConstMacro(PreprocessFixedImages, bool);
+  itkBooleanMacro(PreprocessFixedImages);
+
+  /** Get the filters preparing the fixed images, to set their parameters. */
+  itkGetModifiableObjectMacro(FixedImagePreprocessor1, FixedImagePreprocessorType);
+  itkGetModifiableObjectMacro(FixedImagePreprocessor2, FixedImagePreprocessorType);
+
+  /** Get the fixed images compared by the metric: the outputs of the
+   * preprocessors if PreprocessFixedImages is on, the fixed images
+   * otherwise. */
+  const FixedImageType *
+  GetPreprocessedFixedImage1() const;
+  const FixedImageType *
+  GetPreprocessedFixedImage2() const;
+
   /** Set/Get the Moving image. */
   void
   SetMovingImage(const MovingImageType * movingImage);
@@ -158,6 +196,11 @@ public:
   itkGetConstObjectMacro(Interpolator1, InterpolatorType);
   itkGetConstObjectMacro(Interpolator2, InterpolatorType);
 
+  /** Set/Get the persistent pool of threads evaluating the metric. Set it to
+   * nullptr to use the ITK multithreader instead. */
+  itkSetObjectMacro(ThreadPool, ProjectionThreadPool);
+  itkGetModifiableObjectMacro(ThreadPool, ProjectionThreadPool);
+
   /** Set/Get the initial transformation parameters. */
   virtual void
   SetInitialTransformParameters(const ParametersType & param);
@@ -236,6 +279,12 @@ private:
   InterpolatorPointer m_Interpolator1;
   InterpolatorPointer m_Interpolator2;
 
+  ProjectionThreadPool::Pointer m_ThreadPool;
+
+  bool                          m_PreprocessFixedImages;
+  FixedImagePreprocessorPointer m_FixedImagePreprocessor1;
+  FixedImagePreprocessorPointer m_FixedImagePreprocessor2;
+
   ParametersType m_InitialTransformParameters;
   ParametersType m_LastTransformParameters;
 
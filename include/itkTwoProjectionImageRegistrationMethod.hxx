@@ -38,6 +38,11 @@ TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::TwoProjectionIm
   m_Metric = nullptr;        // has to be provided by the user.
   m_Optimizer = nullptr;     // has to be provided by the user.
 
+  m_ThreadPool = ProjectionThreadPool::New();
+
+  m_PreprocessFixedImages = false;
+  m_FixedImagePreprocessor1 = FixedImagePreprocessorType::New();
+  m_FixedImagePreprocessor2 = FixedImagePreprocessorType::New();
 
   m_InitialTransformParameters = ParametersType(1);
   m_LastTransformParameters = ParametersType(1);
@@ -146,17 +151,23 @@ TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::Initialize()
     itkExceptionMacro(<< "Interpolator2 is not present");
   }
 
-  // Store user-defined image origin
-  // typename FixedImageType::PointType fixedOrigin1 = m_FixedImage1->GetOrigin();
-  // typename FixedImageType::PointType fixedOrigin2 = m_FixedImage2->GetOrigin();
+  // Prepare the fixed images, unless they are up to date
+  if (m_PreprocessFixedImages)
+  {
+    m_FixedImagePreprocessor1->Update();
+    m_FixedImagePreprocessor2->Update();
+  }
+  const FixedImageType * fixedImage1 = this->GetPreprocessedFixedImage1();
+  const FixedImageType * fixedImage2 = this->GetPreprocessedFixedImage2();
 
   // Setup the metric
   m_Metric->SetMovingImage(m_MovingImage);
-  m_Metric->SetFixedImage1(m_FixedImage1);
-  m_Metric->SetFixedImage2(m_FixedImage2);
+  m_Metric->SetFixedImage1(fixedImage1);
+  m_Metric->SetFixedImage2(fixedImage2);
   m_Metric->SetTransform(m_Transform);
   m_Metric->SetInterpolator1(m_Interpolator1);
   m_Metric->SetInterpolator2(m_Interpolator2);
+  m_Metric->GetModifiableTileScheduler()->SetThreadPool(m_ThreadPool);
 
   if (m_FixedImageRegionDefined1)
   {
@@ -164,7 +175,7 @@ TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::Initialize()
   }
   else
   {
-    m_Metric->SetFixedImageRegion1(m_FixedImage1->GetBufferedRegion());
+    m_Metric->SetFixedImageRegion1(fixedImage1->GetBufferedRegion());
   }
 
   if (m_FixedImageRegionDefined2)
@@ -173,25 +184,19 @@ TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::Initialize()
   }
   else
   {
-    m_Metric->SetFixedImageRegion2(m_FixedImage2->GetBufferedRegion());
+    m_Metric->SetFixedImageRegion2(fixedImage2->GetBufferedRegion());
   }
 
   m_Metric->Initialize();
 
-  // Recover user-defined image origin
-  /*  const short Dimension = GetImageDimension<FixedImageType>::ImageDimension;
-    double fixedOrg1[Dimension];
-    for(int i = 0; i < Dimension; i++)
-    fixedOrg1[i] = fixedOrigin1[i];
-    m_FixedImage1->SetOrigin(fixedOrg1);
-    m_Metric->GetFixedImage1()->SetOrigin(fixedOrg1);
-
-    double fixedOrg2[Dimension];
-    for(int i = 0; i < Dimension; i++)
-    fixedOrg2[i] = fixedOrigin2[i];
-    m_FixedImage2->SetOrigin(fixedOrg2);
-    m_Metric->GetFixedImage2()->SetOrigin(fixedOrg2);
-  */
+  // The copies of a replicated volume are only local to threads that stay
+  // on the node they read from.
+  const typename MetricType::VolumeContextType * volumeContext = m_Metric->GetVolumeContext();
+  if (m_ThreadPool && volumeContext && volumeContext->GetReplicatePerNumaNode())
+  {
+    m_ThreadPool->BindThreadsToNumaNodesOn();
+  }
+
   // Setup the optimizer
   m_Optimizer->SetCostFunction(m_Metric);
 
@@ -270,8 +275,12 @@ TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::PrintSelf(std::
   os << indent << "Transform: " << m_Transform.GetPointer() << std::endl;
   os << indent << "Interpolator 1: " << m_Interpolator1.GetPointer() << std::endl;
   os << indent << "Interpolator 2: " << m_Interpolator2.GetPointer() << std::endl;
+  os << indent << "Thread Pool: " << m_ThreadPool.GetPointer() << std::endl;
   os << indent << "Fixed Image 1: " << m_FixedImage1.GetPointer() << std::endl;
   os << indent << "Fixed Image 2: " << m_FixedImage2.GetPointer() << std::endl;
+  os << indent << "Preprocess Fixed Images: " << m_PreprocessFixedImages << std::endl;
+  os << indent << "Fixed Image Preprocessor 1: " << m_FixedImagePreprocessor1.GetPointer() << std::endl;
+  os << indent << "Fixed Image Preprocessor 2: " << m_FixedImagePreprocessor2.GetPointer() << std::endl;
   os << indent << "Moving Image: " << m_MovingImage.GetPointer() << std::endl;
   os << indent << "Fixed Image 1 Region Defined: " << m_FixedImageRegionDefined1 << std::endl;
   os << indent << "Fixed Image 2 Region Defined: " << m_FixedImageRegionDefined2 << std::endl;
@@ -323,6 +332,7 @@ TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::SetFixedImage1(
   if (this->m_FixedImage1.GetPointer() != fixedImage1)
   {
     this->m_FixedImage1 = fixedImage1;
+    m_FixedImagePreprocessor1->SetInput(fixedImage1);
 
     // Process object is not const-correct so the const_cast is required here
     this->ProcessObject::SetNthInput(0, const_cast<FixedImageType *>(fixedImage1));
@@ -341,6 +351,7 @@ TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::SetFixedImage2(
   if (this->m_FixedImage2.GetPointer() != fixedImage2)
   {
     this->m_FixedImage2 = fixedImage2;
+    m_FixedImagePreprocessor2->SetInput(fixedImage2);
 
     // Process object is not const-correct so the const_cast is required here
     this->ProcessObject::SetNthInput(0, const_cast<FixedImageType *>(fixedImage2));
@@ -350,6 +361,30 @@ TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::SetFixedImage2(
 }
 
 
+template <typename TFixedImage, typename TMovingImage>
+const typename TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::FixedImageType *
+TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::GetPreprocessedFixedImage1() const
+{
+  if (m_PreprocessFixedImages)
+  {
+    return m_FixedImagePreprocessor1->GetOutput();
+  }
+  return m_FixedImage1.GetPointer();
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+const typename TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::FixedImageType *
+TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::GetPreprocessedFixedImage2() const
+{
+  if (m_PreprocessFixedImages)
+  {
+    return m_FixedImagePreprocessor2->GetOutput();
+  }
+  return m_FixedImage2.GetPointer();
+}
+
+
 template <typename TFixedImage, typename TMovingImage>
 void
 TwoProjectionImageRegistrationMethod<TFixedImage, TMovingImage>::SetMovingImage(const MovingImageType * movingImage)
@@ -0,0 +1,139 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/*=========================================================================
+Calculate DRR from a CT dataset by splatting the voxels above the threshold
+onto the detector.
+
+-------------------------------------------------------------------------
+References:
+
+L. Westover, "Footprint evaluation for volume rendering," Computer
+Graphics (Proceedings of SIGGRAPH) 24, 367-376 (1990).
+
+=========================================================================*/
+#ifndef itkVoxelSplattingProjectionImageFilter_h
+#define itkVoxelSplattingProjectionImageFilter_h
+
+#include "itkProjectionImageFilter.h"
+#include <cstdint>
+#include <vector>
+
+namespace itk
+{
+
+/** \class VoxelSplattingProjectionImageFilter
+ * \brief Compute a DRR by splatting the voxels above the threshold.
+ *
+ * With a bone threshold only a small fraction of the voxels contribute to
+ * the DRR, while a ray caster still walks every voxel along every ray.
+ * This filter extracts the voxels above the Threshold once into a compact
+ * list of points (voxel center and thresholded intensity), sorted along a
+ * Morton curve so that consecutive points are close in space. Each point is
+ * then projected onto the detector and spread over the pixels covered by
+ * its footprint, a box kernel with the size of the projected voxel. The
+ * cost of a projection grows with the number of voxels above the
+ * threshold rather than with the number of rays times the depth of the
+ * volume.
+ *
+ * The amount deposited by a voxel is scaled so that the DRR has the same
+ * units as the line integrals of SiddonJacobsRayCastInterpolateImageFunction.
+ * The list of points is spread over the work units, each one accumulating
+ * into its own detector; only the rows touched by a work unit are merged
+ * into the output.
+ *
+ * The list is built on the first update and kept until the input or the
+ * Threshold changes. It takes 16 bytes per voxel above the threshold.
+ *
+ * \sa DistanceDrivenProjectionImageFilter
+ *
+ * \ingroup TwoProjectionRegistration
+ */
+template <typename TInputImage, typename TOutputImage>
+class VoxelSplattingProjectionImageFilter : public ProjectionImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(VoxelSplattingProjectionImageFilter);
+
+  /** Standard class type alias. */
+  using Self = VoxelSplattingProjectionImageFilter;
+  using Superclass = ProjectionImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(VoxelSplattingProjectionImageFilter, ProjectionImageFilter);
+
+  using InputImageType = typename Superclass::InputImageType;
+  using InputPixelType = typename Superclass::InputPixelType;
+  using OutputImageType = typename Superclass::OutputImageType;
+  using OutputPixelType = typename Superclass::OutputPixelType;
+  using TransformType = typename Superclass::TransformType;
+  using PointType = typename Superclass::PointType;
+
+  /** Constants for the image dimensions */
+  static constexpr unsigned int ImageDimension = Superclass::ImageDimension;
+
+  /** Number of voxels above the threshold, valid after an update. */
+  SizeValueType
+  GetNumberOfSplats() const
+  {
+    return static_cast<SizeValueType>(m_Splats.size());
+  }
+
+protected:
+  VoxelSplattingProjectionImageFilter() = default;
+  ~VoxelSplattingProjectionImageFilter() override = default;
+
+  void
+  GenerateData() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Center of a voxel in the volume and its thresholded intensity. */
+  struct Splat
+  {
+    float Position[3];
+    float Value;
+  };
+
+  /** Extract the voxels above the threshold, sorted along a Morton curve. */
+  void
+  BuildSplats();
+
+  /** Interleave the bits of the voxel index. */
+  static uint64_t
+  MortonCode(SizeValueType x, SizeValueType y, SizeValueType z);
+
+  std::vector<Splat>     m_Splats;
+  double                 m_SplatThreshold{ 0.0 };
+  const InputImageType * m_SplattedInput{ nullptr };
+  TimeStamp              m_SplatsTime;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkVoxelSplattingProjectionImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,285 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkVoxelSplattingProjectionImageFilter_hxx
+#define itkVoxelSplattingProjectionImageFilter_hxx
+
+#include "itkVoxelSplattingProjectionImageFilter.h"
+
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreaderBase.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+uint64_t
+VoxelSplattingProjectionImageFilter<TInputImage, TOutputImage>::MortonCode(SizeValueType x,
+                                                                           SizeValueType y,
+                                                                           SizeValueType z)
+{
+  // Spread the 21 low bits of a coordinate to every third bit.
+  auto spread = [](uint64_t v) -> uint64_t {
+    v &= 0x1fffff;
+    v = (v | (v << 32)) & 0x1f00000000ffffULL;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+    v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+    v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+    v = (v | (v << 2)) & 0x1249249249249249ULL;
+    return v;
+  };
+  return spread(x) | (spread(y) << 1) | (spread(z) << 2);
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+VoxelSplattingProjectionImageFilter<TInputImage, TOutputImage>::BuildSplats()
+{
+  const InputImageType *                     inputPtr = this->GetInput();
+  const typename InputImageType::SizeType    size = inputPtr->GetBufferedRegion().GetSize();
+  const typename InputImageType::SpacingType spacing = inputPtr->GetSpacing();
+  const InputPixelType *                     voxel = inputPtr->GetBufferPointer();
+  const double                               threshold = this->GetThreshold();
+
+  std::vector<std::pair<uint64_t, Splat>> sortedSplats;
+  for (SizeValueType z = 0; z < size[2]; ++z)
+  {
+    for (SizeValueType y = 0; y < size[1]; ++y)
+    {
+      for (SizeValueType x = 0; x < size[0]; ++x, ++voxel)
+      {
+        const double value = static_cast<double>(*voxel) - threshold;
+        if (value > 0.0)
+        {
+          // Voxel i spans [i, i+1) times the spacing, as in the Siddon-Jacobs traversal.
+          Splat splat;
+          splat.Position[0] = static_cast<float>((x + 0.5) * spacing[0]);
+          splat.Position[1] = static_cast<float>((y + 0.5) * spacing[1]);
+          splat.Position[2] = static_cast<float>((z + 0.5) * spacing[2]);
+          splat.Value = static_cast<float>(value);
+          sortedSplats.emplace_back(MortonCode(x, y, z), splat);
+        }
+      }
+    }
+  }
+
+  std::sort(sortedSplats.begin(),
+            sortedSplats.end(),
+            [](const std::pair<uint64_t, Splat> & a, const std::pair<uint64_t, Splat> & b) {
+              return a.first < b.first;
+            });
+
+  m_Splats.resize(sortedSplats.size());
+  for (size_t i = 0; i < sortedSplats.size(); ++i)
+  {
+    m_Splats[i] = sortedSplats[i].second;
+  }
+
+  m_SplatThreshold = threshold;
+  m_SplattedInput = inputPtr;
+  m_SplatsTime.Modified();
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+VoxelSplattingProjectionImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  this->AllocateOutputs();
+  this->UpdateProjectionGeometry();
+
+  const InputImageType * inputPtr = this->GetInput();
+  OutputImageType *      outputPtr = this->GetOutput();
+
+  if (m_SplattedInput != inputPtr || m_SplatThreshold != this->GetThreshold() ||
+      m_SplatsTime.GetMTime() < inputPtr->GetMTime())
+  {
+    this->BuildSplats();
+  }
+
+  const typename InputImageType::SpacingType ctPixelSpacing = inputPtr->GetSpacing();
+
+  const typename OutputImageType::RegionType    outputRegion = outputPtr->GetRequestedRegion();
+  const IndexValueType                          sizeU = static_cast<IndexValueType>(outputRegion.GetSize()[0]);
+  const IndexValueType                          sizeV = static_cast<IndexValueType>(outputRegion.GetSize()[1]);
+  const SizeValueType                           numberOfPixels = sizeU * sizeV;
+  const typename OutputImageType::SpacingType   detectorSpacing = outputPtr->GetSpacing();
+  const typename OutputImageType::PointType     detectorOrigin = outputPtr->GetOrigin();
+  const typename OutputImageType::DirectionType detectorDirection = outputPtr->GetDirection();
+
+  // Map from the volume to the projection geometry, where the source is at
+  // the origin.
+  typename TransformType::Pointer forwardTransform = TransformType::New();
+  this->GetInverseTransform()->GetInverse(forwardTransform);
+  const typename TransformType::MatrixType       matrix = forwardTransform->GetMatrix();
+  const typename TransformType::OutputVectorType offset = forwardTransform->GetOffset();
+
+  // A point q of the projection geometry is seen on the detector at the
+  // continuous index (mag * U.q - u0, mag * V.q - v0), with the
+  // magnification mag = depth(detector) / depth(q) along the normal N of
+  // the detector. The rows U, V and N are folded with the volume transform
+  // so that each voxel only needs three dot products.
+  double rows[3][3];
+  double rowOffsets[3];
+  double detectorOffsets[3];
+  for (unsigned int r = 0; r < 3; ++r)
+  {
+    const double scale = (r < 2) ? 1.0 / detectorSpacing[r] : 1.0;
+    detectorOffsets[r] = 0.0;
+    rowOffsets[r] = 0.0;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      detectorOffsets[r] += detectorDirection[i][r] * scale * detectorOrigin[i];
+      rowOffsets[r] += detectorDirection[i][r] * scale * offset[i];
+    }
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      rows[r][j] = 0.0;
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        rows[r][j] += detectorDirection[i][r] * scale * matrix[i][j];
+      }
+    }
+  }
+  const double detectorDepth = detectorOffsets[2];
+  const double u0 = detectorOffsets[0] - outputRegion.GetIndex()[0];
+  const double v0 = detectorOffsets[1] - outputRegion.GetIndex()[1];
+
+  // Half size of the footprint of a voxel, in pixels, at unit magnification
+  double extentU = 0.0;
+  double extentV = 0.0;
+  for (unsigned int j = 0; j < 3; ++j)
+  {
+    extentU += 0.5 * std::fabs(rows[0][j]) * ctPixelSpacing[j];
+    extentV += 0.5 * std::fabs(rows[1][j]) * ctPixelSpacing[j];
+  }
+
+  // A voxel of volume dV at depth d along the normal contributes
+  // value * dV * L / d^2 to the integral of the DRR over the detector,
+  // where L is the distance from the source to the detector, when the DRR
+  // is in units of the Siddon-Jacobs ray parameter.
+  const double voxelVolume = ctPixelSpacing[0] * ctPixelSpacing[1] * ctPixelSpacing[2];
+  const double depositScale = voxelVolume * std::fabs(detectorDepth) / (detectorSpacing[0] * detectorSpacing[1]);
+
+  const Splat *       splats = m_Splats.data();
+  const SizeValueType numberOfSplats = m_Splats.size();
+
+  const SizeValueType numberOfChunks =
+    std::max<SizeValueType>(1, std::min<SizeValueType>(this->GetNumberOfWorkUnits(), numberOfSplats));
+  std::vector<std::vector<double>> detectors(numberOfChunks);
+  std::vector<IndexValueType>      firstRows(numberOfChunks, sizeV);
+  std::vector<IndexValueType>      lastRows(numberOfChunks, -1);
+
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    numberOfChunks,
+    [&](SizeValueType chunk) {
+      std::vector<double> & detector = detectors[chunk];
+      detector.assign(numberOfPixels, 0.0);
+      IndexValueType firstRow = sizeV;
+      IndexValueType lastRow = -1;
+
+      const SizeValueType first = chunk * numberOfSplats / numberOfChunks;
+      const SizeValueType last = (chunk + 1) * numberOfSplats / numberOfChunks;
+      for (SizeValueType s = first; s < last; ++s)
+      {
+        const Splat & splat = splats[s];
+        double        projected[3];
+        for (unsigned int r = 0; r < 3; ++r)
+        {
+          projected[r] = rows[r][0] * splat.Position[0] + rows[r][1] * splat.Position[1] +
+                         rows[r][2] * splat.Position[2] + rowOffsets[r];
+        }
+        const double depth = projected[2];
+        if (depth * detectorDepth <= 0.0)
+        {
+          // Behind the source
+          continue;
+        }
+        const double magnification = detectorDepth / depth;
+        const double u = magnification * projected[0] - u0;
+        const double v = magnification * projected[1] - v0;
+        const double halfWidthU = extentU * magnification;
+        const double halfWidthV = extentV * magnification;
+
+        // Pixel i covers [i - 0.5, i + 0.5).
+        const IndexValueType firstU = std::max<IndexValueType>(0, std::floor(u - halfWidthU + 0.5));
+        const IndexValueType lastU = std::min<IndexValueType>(sizeU - 1, std::floor(u + halfWidthU + 0.5));
+        const IndexValueType firstV = std::max<IndexValueType>(0, std::floor(v - halfWidthV + 0.5));
+        const IndexValueType lastV = std::min<IndexValueType>(sizeV - 1, std::floor(v + halfWidthV + 0.5));
+        if (firstU > lastU || firstV > lastV)
+        {
+          continue;
+        }
+
+        const double amount = splat.Value * depositScale / (depth * depth) / (4.0 * halfWidthU * halfWidthV);
+        for (IndexValueType j = firstV; j <= lastV; ++j)
+        {
+          const double weightV = std::min(v + halfWidthV, j + 0.5) - std::max(v - halfWidthV, j - 0.5);
+          double *     row = detector.data() + j * sizeU;
+          for (IndexValueType i = firstU; i <= lastU; ++i)
+          {
+            const double weightU = std::min(u + halfWidthU, i + 0.5) - std::max(u - halfWidthU, i - 0.5);
+            row[i] += amount * weightU * weightV;
+          }
+        }
+        firstRow = std::min(firstRow, firstV);
+        lastRow = std::max(lastRow, lastV);
+      }
+      firstRows[chunk] = firstRow;
+      lastRows[chunk] = lastRow;
+    },
+    nullptr);
+
+  // Merge the rows touched by each work unit.
+  std::vector<double> sum(numberOfPixels, 0.0);
+  for (SizeValueType chunk = 0; chunk < numberOfChunks; ++chunk)
+  {
+    for (IndexValueType k = firstRows[chunk] * sizeU; k < (lastRows[chunk] + 1) * sizeU; ++k)
+    {
+      sum[k] += detectors[chunk][k];
+    }
+  }
+
+  const double minOutputValue = NumericTraits<OutputPixelType>::NonpositiveMin();
+  const double maxOutputValue = NumericTraits<OutputPixelType>::max();
+
+  ImageRegionIterator<OutputImageType> it(outputPtr, outputRegion);
+  for (SizeValueType pixel = 0; !it.IsAtEnd(); ++it, ++pixel)
+  {
+    const double d12 = std::min(std::max(sum[pixel], minOutputValue), maxOutputValue);
+    it.Set(static_cast<OutputPixelType>(d12));
+  }
+}
+
+
+template <typename TInputImage, typename TOutputImage>
+void
+VoxelSplattingProjectionImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfSplats: " << m_Splats.size() << std::endl;
+}
+
+} // namespace itk
+
+#endif
@@ -13,19 +13,28 @@ file(READ "${MY_CURRENT_DIR}/README.rst" DOCUMENTATION)
 # define the dependencies of the include module and the tests
 itk_module(TwoProjectionRegistration
   DEPENDS
+    ITKFFT
     ITKImageFunction
     ITKImageGradient
+    ITKNIFTI
     ITKOptimizers
     ITKRegistrationCommon
     ITKSpatialObjects
     ITKTransform
+    ITKZLIB
   TEST_DEPENDS
+    ITKFFT
     ITKImageFunction
     ITKImageGradient
+    ITKImageGrid
+    ITKIOGDCM
+    ITKIONIFTI
+    ITKNIFTI
     ITKOptimizers
     ITKRegistrationCommon
     ITKSpatialObjects
     ITKTransform
+    ITKZLIB
     ITKTestKernel
   DESCRIPTION
     "${DOCUMENTATION}"
@@ -0,0 +1,770 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+/*=========================================================================
+
+ This program compares the projectors computing a whole DRR at once with
+ the exact Siddon-Jacobs ray caster driven by a ResampleImageFilter. Both
+ paths project the same CT volume with the same geometry; the computation
+ times are reported along with the difference between the projections,
+ relative to the root mean square of the Siddon-Jacobs DRR.
+
+=========================================================================*/
+
+#include "itkTimeProbesCollectorBase.h"
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkResampleImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+
+#include "itkEuler3DTransform.h"
+#include "itkVersorRigid3DTransform.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+#include "itkJosephRayCastInterpolateImageFunction.h"
+#include "itkDistanceDrivenProjectionImageFilter.h"
+#include "itkVoxelSplattingProjectionImageFilter.h"
+#include "itkLightFieldProjectionImageFilter.h"
+#include "itkFourierSliceProjectionImageFilter.h"
+#include "itkSparseMatrixProjectionImageFilter.h"
+#include "itkIncrementalProjectionImageFilter.h"
+#include "itkRayCastProjectionImageFilter.h"
+#include "itkProjectionBrickedVolume.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+void
+benchmark_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: DRRProjectorBenchmark <options> [input]\n";
+  std::cerr << "       compares the Digitally Reconstructed Radiograph computed from\n";
+  std::cerr << "       a CT image by a projector with the Siddon-Jacob ray-tracing algorithm. \n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  std::cerr << "       <-v>                     Verbose output [default: no]\n";
+  std::cerr
+    << "       <-res float float>       DRR Pixel spacing in isocenter plane in mm [default: 0.51mm 0.51mm]  \n";
+  std::cerr << "       <-size int int>          Size of DRR in number of pixels [default: 512x512]  \n";
+  std::cerr
+    << "       <-scd float>             Source to isocenter (i.e., 3D image center) distance in mm [default: 1000mm]\n";
+  std::cerr << "       <-t float float float>   CT volume translation in x, y, and z direction in mm \n";
+  std::cerr << "       <-rx float>              CT volume rotation about x axis in degrees \n";
+  std::cerr << "       <-ry float>              CT volume rotation about y axis in degrees \n";
+  std::cerr << "       <-rz float>              CT volume rotation about z axis in degrees \n";
+  std::cerr << "       <-iso float float float> Continous voxel indices of CT isocenter (center of rotation and "
+               "projection center)\n";
+  std::cerr << "       <-rp float>              Projection angle in degrees\n";
+  std::cerr << "       <-threshold float>       CT intensity threshold, below which are ignored [default: 0]\n";
+  std::cerr << "       <-projector name>        Projector compared with Siddon-Jacobs: distancedriven, "
+               "splatting, lightfield, fourier, sparse, incremental, raycast, bricked or joseph "
+               "[default: distancedriven]\n";
+  std::cerr << "       <-budget float>          Memory budget of the light field in MB [default: 128]\n";
+  std::cerr << "       <-padding float>         Padding factor of the volume for the Fourier slice [default: 1.5]\n";
+  std::cerr << "       <-tile int>              Size of the square detector tiles of the ray caster [default: 16]\n";
+  std::cerr << "       <-bricks int float>      Brick size and brick cache in MB of the out of core volume "
+               "[default: 32 64]\n";
+  std::cerr << "       <-n int>                 Number of projections timed for each method [default: 1]\n";
+  std::cerr << "       <-motion float float>    Rotation about each axis in degrees and translation along each axis in "
+               "mm added to the pose before each timed projection [default: 0 0]\n";
+  std::cerr << "       <-inplane>               Apply the motion as a rotation about the central axis and a "
+               "translation across it, leaving the central axis fixed relative to the volume [default: no]\n";
+  std::cerr << "       <-maxrenderings int>     Fail if the incremental projector rendered more references\n";
+  std::cerr << "       <-tolerance float>       Fail if the relative RMS difference exceeds this value\n";
+  std::cerr << "       <-o file>                Output image filename of the projector DRR\n\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int
+DRRProjectorBenchmark(int argc, char * argv[])
+{
+  char * input_name = nullptr;
+  char * output_name = nullptr;
+
+  bool ok;
+  bool verbose = false;
+  bool customized_iso = false; // Flag for customized 3D image isocenter positions
+
+  float rprojection = 0.; // Projection angle in degrees
+
+  // CT volume rotation around isocenter along x,y,z axis in degrees
+  float rx = 0.;
+  float ry = 0.;
+  float rz = 0.;
+
+  // Translation parameter of the isocenter in mm
+  float tx = 0.;
+  float ty = 0.;
+  float tz = 0.;
+
+  // The pixel indices of the isocenter
+  float cx = 0.;
+  float cy = 0.;
+  float cz = 0.;
+
+  float scd = 1000.0; // Source to isocenter distance in mm
+
+  // Default pixel spacing in the iso-center plane in mm
+  float im_sx = 0.51;
+  float im_sy = 0.51;
+
+  // Size of the output image in number of pixels
+  int dx = 512;
+  int dy = 512;
+
+  float threshold = 0.;
+
+  const char * projector = "distancedriven";
+
+  int    repeats = 1;
+  double tolerance = -1.0; // No check by default
+  double budget = 128.0;   // Memory budget of the light field in MB
+  double padding = 1.5;    // Padding factor of the volume for the Fourier slice
+  int    tileSize = 16;    // Size of the detector tiles of the ray caster
+  int    brickSize = 32;   // Size of the bricks of the out of core volume
+  double brickCache = 64.; // Memory of the cached bricks in MB
+
+  // Pose increments between the timed projections, in degrees and mm
+  double rotationStep = 0.0;
+  double translationStep = 0.0;
+  bool   inPlaneMotion = false;
+  int    maxRenderings = -1; // No check by default
+
+  // Create a timer to record calculation time.
+  itk::TimeProbesCollectorBase timer;
+
+  // Parse command line parameters
+
+  while (argc > 1)
+  {
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      benchmark_exe_usage();
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-v") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      verbose = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-rx") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      rx = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-ry") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      ry = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-rz") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      rz = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-threshold") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      threshold = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-projector") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      projector = argv[1];
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-n") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      repeats = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-budget") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      budget = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-motion") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      rotationStep = atof(argv[1]);
+      argc--;
+      argv++;
+      translationStep = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-inplane") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      inPlaneMotion = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-maxrenderings") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      maxRenderings = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-padding") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      padding = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-tile") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      tileSize = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-bricks") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      brickSize = atoi(argv[1]);
+      argc--;
+      argv++;
+      brickCache = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-tolerance") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      tolerance = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-t") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      tx = atof(argv[1]);
+      argc--;
+      argv++;
+      ty = atof(argv[1]);
+      argc--;
+      argv++;
+      tz = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-iso") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      cx = atof(argv[1]);
+      argc--;
+      argv++;
+      cy = atof(argv[1]);
+      argc--;
+      argv++;
+      cz = atof(argv[1]);
+      argc--;
+      argv++;
+      customized_iso = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-rp") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      rprojection = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-res") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      im_sx = atof(argv[1]);
+      argc--;
+      argv++;
+      im_sy = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-size") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      dx = atoi(argv[1]);
+      argc--;
+      argv++;
+      dy = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-scd") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      scd = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-o") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      output_name = argv[1];
+      argc--;
+      argv++;
+    }
+
+    if (ok == false)
+    {
+      if (input_name == nullptr)
+      {
+        input_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else
+      {
+        std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+        benchmark_exe_usage();
+      }
+    }
+  }
+
+  if (input_name == nullptr)
+  {
+    std::cerr << "Input image file missing !" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  constexpr unsigned int Dimension = 3;
+  using InputPixelType = short;
+  using OutputPixelType = float;
+
+  using InputImageType = itk::Image<InputPixelType, Dimension>;
+  using OutputImageType = itk::Image<OutputPixelType, Dimension>;
+
+  InputImageType::Pointer image;
+
+  timer.Start("Loading Input Image");
+  using ReaderType = itk::ImageFileReader<InputImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(input_name);
+
+  try
+  {
+    reader->Update();
+  }
+  catch (itk::ExceptionObject & err)
+  {
+    std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  image = reader->GetOutput();
+  timer.Stop("Loading Input Image");
+
+  // The projection geometry assumes that the origin of the CT image is (0,0,0).
+  InputImageType::PointType ctOrigin;
+  ctOrigin.Fill(0.0);
+  image->SetOrigin(ctOrigin);
+
+  // An Euler transformation is defined to position the input volume.
+  using TransformType = itk::Euler3DTransform<double>;
+
+  TransformType::Pointer transform = TransformType::New();
+  transform->SetComputeZYX(true);
+
+  TransformType::OutputVectorType translation;
+  translation[0] = tx;
+  translation[1] = ty;
+  translation[2] = tz;
+
+  // constant for converting degrees into radians
+  const double dtr = (atan(1.0) * 4.0) / 180.0;
+
+  transform->SetTranslation(translation);
+  transform->SetRotation(dtr * rx, dtr * ry, dtr * rz);
+
+  const InputImageType::SpacingType imRes = image->GetSpacing();
+  const InputImageType::SizeType    imSize = image->GetBufferedRegion().GetSize();
+
+  TransformType::InputPointType isocenter;
+  if (customized_iso)
+  {
+    // Isocenter location given by the user.
+    isocenter[0] = imRes[0] * cx;
+    isocenter[1] = imRes[1] * cy;
+    isocenter[2] = imRes[2] * cz;
+  }
+  else
+  {
+    // Set the center of the image as the isocenter.
+    isocenter[0] = imRes[0] * static_cast<double>(imSize[0]) / 2.0;
+    isocenter[1] = imRes[1] * static_cast<double>(imSize[1]) / 2.0;
+    isocenter[2] = imRes[2] * static_cast<double>(imSize[2]) / 2.0;
+  }
+  transform->SetCenter(isocenter);
+
+  // The grid of the DRR, centred on the central axis.
+  OutputImageType::SizeType size;
+  size[0] = dx;
+  size[1] = dy;
+  size[2] = 1;
+
+  double spacing[Dimension];
+  spacing[0] = im_sx;
+  spacing[1] = im_sy;
+  spacing[2] = 1.0;
+
+  double origin[Dimension];
+  origin[0] = -im_sx * ((double)dx - 1.) / 2.;
+  origin[1] = -im_sy * ((double)dy - 1.) / 2.;
+  origin[2] = -scd;
+
+  // Reference: the exact Siddon-Jacobs ray caster driven by a ResampleImageFilter.
+  using InterpolatorType = itk::SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetProjectionAngle(dtr * rprojection);
+  interpolator->SetFocalPointToIsocenterDistance(scd);
+  interpolator->SetThreshold(threshold);
+  interpolator->SetTransform(transform);
+  interpolator->Initialize();
+
+  using ResampleFilterType = itk::ResampleImageFilter<InputImageType, OutputImageType>;
+  ResampleFilterType::Pointer resampler = ResampleFilterType::New();
+  resampler->SetInput(image);
+  resampler->SetDefaultPixelValue(0);
+  resampler->SetInterpolator(interpolator);
+  resampler->SetSize(size);
+  resampler->SetOutputSpacing(spacing);
+  resampler->SetOutputOrigin(origin);
+
+  // Projector computing the whole DRR at once
+  using ProjectorType = itk::ProjectionImageFilter<InputImageType, OutputImageType>;
+  ProjectorType::Pointer projectorFilter;
+
+  using RayCastFilterType = itk::RayCastProjectionImageFilter<InputImageType, OutputImageType>;
+  RayCastFilterType::Pointer rayCast;
+
+  using BrickedVolumeType = itk::ProjectionBrickedVolume<InputImageType>;
+  BrickedVolumeType::Pointer bricks;
+
+  using IncrementalFilterType = itk::IncrementalProjectionImageFilter<InputImageType, OutputImageType>;
+  IncrementalFilterType::Pointer incremental;
+  if (strcmp(projector, "distancedriven") == 0)
+  {
+    projectorFilter = itk::DistanceDrivenProjectionImageFilter<InputImageType, OutputImageType>::New().GetPointer();
+  }
+  else if (strcmp(projector, "splatting") == 0)
+  {
+    projectorFilter = itk::VoxelSplattingProjectionImageFilter<InputImageType, OutputImageType>::New().GetPointer();
+  }
+  else if (strcmp(projector, "lightfield") == 0)
+  {
+    using LightFieldFilterType = itk::LightFieldProjectionImageFilter<InputImageType, OutputImageType>;
+    LightFieldFilterType::Pointer lightField = LightFieldFilterType::New();
+    lightField->SetMemoryBudget(static_cast<itk::SizeValueType>(budget * 1024 * 1024));
+    projectorFilter = lightField.GetPointer();
+  }
+  else if (strcmp(projector, "fourier") == 0)
+  {
+    using FourierSliceFilterType = itk::FourierSliceProjectionImageFilter<InputImageType, OutputImageType>;
+    FourierSliceFilterType::Pointer fourierSlice = FourierSliceFilterType::New();
+    fourierSlice->SetPaddingFactor(padding);
+    projectorFilter = fourierSlice.GetPointer();
+  }
+  else if (strcmp(projector, "sparse") == 0)
+  {
+    projectorFilter = itk::SparseMatrixProjectionImageFilter<InputImageType, OutputImageType>::New().GetPointer();
+  }
+  else if (strcmp(projector, "incremental") == 0)
+  {
+    incremental = IncrementalFilterType::New();
+    projectorFilter = incremental.GetPointer();
+  }
+  else if (strcmp(projector, "raycast") == 0 || strcmp(projector, "bricked") == 0 || strcmp(projector, "joseph") == 0)
+  {
+    rayCast = RayCastFilterType::New();
+    RayCastFilterType::TileSchedulerType::TileSizeType tile;
+    tile.Fill(tileSize);
+    rayCast->GetModifiableTileScheduler()->SetTileSize(tile);
+    projectorFilter = rayCast.GetPointer();
+
+    if (strcmp(projector, "joseph") == 0)
+    {
+      // The rays are marched slice by slice instead of traced exactly
+      rayCast->SetInterpolator(itk::JosephRayCastInterpolateImageFunction<InputImageType, double>::New());
+    }
+
+    if (strcmp(projector, "bricked") == 0)
+    {
+      // The ray caster reads the volume from bricks stored out of core
+      bricks = BrickedVolumeType::New();
+      bricks->SetInputImage(image);
+      bricks->SetThreshold(threshold);
+      bricks->SetBrickSize(brickSize);
+      bricks->SetMemoryLimit(static_cast<itk::SizeValueType>(brickCache * 1024 * 1024));
+      rayCast->GetModifiableInterpolator()->SetBrickedVolume(bricks);
+    }
+  }
+  else
+  {
+    std::cerr << "ERROR: Unknown projector " << projector << std::endl;
+    benchmark_exe_usage();
+  }
+
+  projectorFilter->SetInput(image);
+  projectorFilter->SetProjectionAngle(dtr * rprojection);
+  projectorFilter->SetFocalPointToIsocenterDistance(scd);
+  projectorFilter->SetThreshold(threshold);
+  projectorFilter->SetTransform(transform);
+  projectorFilter->SetSize(size);
+  projectorFilter->SetOutputSpacing(spacing);
+  projectorFilter->SetOutputOrigin(origin);
+
+  // Motion about and across the central axis, which passes through the
+  // isocenter along the y axis rotated by the projection angle about z.
+  using InPlaneTransformType = itk::VersorRigid3DTransform<double>;
+  InPlaneTransformType::Pointer inPlaneStep = InPlaneTransformType::New();
+  if (inPlaneMotion)
+  {
+    InPlaneTransformType::AxisType centralAxis;
+    centralAxis[0] = -std::sin(dtr * rprojection);
+    centralAxis[1] = std::cos(dtr * rprojection);
+    centralAxis[2] = 0.0;
+
+    InPlaneTransformType::OutputVectorType acrossTranslation;
+    acrossTranslation[0] = translationStep * centralAxis[1];
+    acrossTranslation[1] = -translationStep * centralAxis[0];
+    acrossTranslation[2] = translationStep;
+
+    inPlaneStep->SetCenter(isocenter);
+    inPlaneStep->SetRotation(centralAxis, dtr * rotationStep);
+    inPlaneStep->SetTranslation(acrossTranslation);
+  }
+
+  const std::string projectorLabel = std::string(projector) + " DRR";
+  const std::string preprocessingLabel = std::string(projector) + " preprocessing";
+  try
+  {
+    // The first update includes the preprocessing of the volume, if any.
+    timer.Start(preprocessingLabel.c_str());
+    if (bricks)
+    {
+      bricks->Update();
+    }
+    projectorFilter->Update();
+    timer.Stop(preprocessingLabel.c_str());
+
+    for (int n = 0; n < repeats; ++n)
+    {
+      // Small motion of the volume, as between the frames of a tracking
+      if (inPlaneMotion)
+      {
+        transform->Compose(inPlaneStep, false);
+      }
+      else
+      {
+        TransformType::ParametersType parameters = transform->GetParameters();
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          parameters[i] += dtr * rotationStep;
+          parameters[i + 3] += translationStep;
+        }
+        transform->SetParameters(parameters);
+      }
+
+      resampler->Modified();
+      timer.Start("siddon DRR");
+      resampler->Update();
+      timer.Stop("siddon DRR");
+
+      projectorFilter->Modified();
+      timer.Start(projectorLabel.c_str());
+      projectorFilter->Update();
+      timer.Stop(projectorLabel.c_str());
+    }
+  }
+  catch (itk::ExceptionObject & err)
+  {
+    std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Difference between the projections, relative to the Siddon-Jacobs DRR
+  using IteratorType = itk::ImageRegionConstIterator<OutputImageType>;
+  IteratorType referenceIt(resampler->GetOutput(), resampler->GetOutput()->GetBufferedRegion());
+  IteratorType projectionIt(projectorFilter->GetOutput(), projectorFilter->GetOutput()->GetBufferedRegion());
+
+  double sumSquaredReference = 0.0;
+  double sumSquaredDifference = 0.0;
+  double maxDifference = 0.0;
+  for (; !referenceIt.IsAtEnd(); ++referenceIt, ++projectionIt)
+  {
+    const double reference = referenceIt.Get();
+    const double difference = projectionIt.Get() - reference;
+    sumSquaredReference += reference * reference;
+    sumSquaredDifference += difference * difference;
+    maxDifference = std::max(maxDifference, std::fabs(difference));
+  }
+  const double relativeDifference =
+    sumSquaredReference > 0 ? std::sqrt(sumSquaredDifference / sumSquaredReference) : std::sqrt(sumSquaredDifference);
+
+  std::cout << "Projector: " << projector << std::endl;
+  std::cout << "Relative RMS difference with Siddon-Jacobs: " << relativeDifference << std::endl;
+  std::cout << "Maximum absolute difference: " << maxDifference << std::endl;
+  if (rayCast)
+  {
+    const RayCastFilterType::TileSchedulerType * scheduler = rayCast->GetTileScheduler();
+    std::cout << "Tiles: " << scheduler->GetNumberOfTiles() << ", stolen: " << scheduler->GetNumberOfStolenTiles()
+              << ", load imbalance: " << scheduler->GetLoadImbalance() << std::endl;
+  }
+  if (bricks)
+  {
+    std::cout << "Bricks stored: " << bricks->GetNumberOfStoredBricks() << " of " << bricks->GetNumberOfBricks()
+              << ", read: " << bricks->GetNumberOfBrickReads() << ", cache hits: " << bricks->GetNumberOfCacheHits()
+              << ", cached: " << bricks->GetCachedMemorySize() << " bytes" << std::endl;
+  }
+  if (incremental)
+  {
+    std::cout << "References rendered: " << incremental->GetNumberOfRenderings()
+              << ", warped: " << incremental->GetNumberOfWarps() << std::endl;
+  }
+
+  if (verbose)
+  {
+    std::cout << "Projector filter: " << projectorFilter << std::endl;
+  }
+
+  if (output_name)
+  {
+    using WriterType = itk::ImageFileWriter<OutputImageType>;
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName(output_name);
+    writer->SetInput(projectorFilter->GetOutput());
+
+    try
+    {
+      std::cout << "Writing image: " << output_name << std::endl;
+      writer->Update();
+    }
+    catch (itk::ExceptionObject & err)
+    {
+      std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+      std::cerr << err << std::endl;
+    }
+  }
+
+  timer.Report();
+
+  if (tolerance >= 0 && relativeDifference > tolerance)
+  {
+    std::cerr << "ERROR: The relative RMS difference " << relativeDifference << " exceeds the tolerance "
+              << tolerance << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (incremental && maxRenderings >= 0 &&
+      incremental->GetNumberOfRenderings() > static_cast<itk::SizeValueType>(maxRenderings))
+  {
+    std::cerr << "ERROR: The incremental projector rendered " << incremental->GetNumberOfRenderings()
+              << " references, more than " << maxRenderings << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
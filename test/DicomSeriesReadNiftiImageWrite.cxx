@@ -10,7 +10,11 @@ Author:    Jian Wu (eewujian@hotmail.com)
        Virginia Commonwealth University
 
 This program read a DICOM series into a volume and then save this volume in NIFTI
-file format.
+file format. The slices are decoded in parallel, straight into the buffer of the
+volume, and the time taken by each stage of the conversion is reported. With
+-serial, the series is read by the ImageSeriesReader instead, as a reference.
+NIFTI images are written by the StreamingNiftiImageFileWriter, or with
+-nostreaming by the ImageFileWriter.
 
 This program was modified from the ITK example--DicomSeriesReadSeriesWrite.cxx
 
@@ -44,21 +48,173 @@ This program was modified from the ITK example--DicomSeriesReadSeriesWrite.cxx
 // Software Guide : BeginCodeSnippet
 #include "itkGDCMImageIO.h"
 #include "itkGDCMSeriesFileNames.h"
-#include "itkImageSeriesReader.h"
 #include "itkImageFileWriter.h"
+#include "itkImageSeriesReader.h"
 #include "itkNiftiImageIO.h"
+#include "itkStreamingNiftiImageFileWriter.h"
 // Software Guide : EndCodeSnippet
 
+#include "itkMultiThreaderBase.h"
+#include "itkTimeProbesCollectorBase.h"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace
+{
+
+// Slice of the series, located by its position along the normal of the slices
+struct SeriesSlice
+{
+  std::string FileName;
+  double      Origin[3];
+  double      Position;
+};
+
+
+template <typename TComponent, typename TPixel>
+void
+ConvertComponents(const void * input, TPixel * output, size_t numberOfPixels)
+{
+  const auto * components = static_cast<const TComponent *>(input);
+  for (size_t k = 0; k < numberOfPixels; ++k)
+  {
+    output[k] = static_cast<TPixel>(components[k]);
+  }
+}
+
+
+// Convert a slice decoded in another pixel type than that of the volume
+template <typename TPixel>
+void
+ConvertSlice(itk::ImageIOBase::IOComponentType componentType,
+             const void *                      input,
+             TPixel *                          output,
+             size_t                            numberOfPixels)
+{
+  using ComponentType = itk::ImageIOBase::IOComponentType;
+  switch (componentType)
+  {
+    case ComponentType::UCHAR:
+      ConvertComponents<unsigned char>(input, output, numberOfPixels);
+      break;
+    case ComponentType::CHAR:
+      ConvertComponents<char>(input, output, numberOfPixels);
+      break;
+    case ComponentType::USHORT:
+      ConvertComponents<unsigned short>(input, output, numberOfPixels);
+      break;
+    case ComponentType::SHORT:
+      ConvertComponents<short>(input, output, numberOfPixels);
+      break;
+    case ComponentType::UINT:
+      ConvertComponents<unsigned int>(input, output, numberOfPixels);
+      break;
+    case ComponentType::INT:
+      ConvertComponents<int>(input, output, numberOfPixels);
+      break;
+    case ComponentType::FLOAT:
+      ConvertComponents<float>(input, output, numberOfPixels);
+      break;
+    case ComponentType::DOUBLE:
+      ConvertComponents<double>(input, output, numberOfPixels);
+      break;
+    default:
+      itkGenericExceptionMacro(<< "Unsupported pixel type "
+                               << itk::ImageIOBase::GetComponentTypeAsString(componentType));
+  }
+}
+
+} // namespace
+
+
+void
+dicom_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: DicomSeriesReadNiftiImageWrite <options> DicomDirectory OutputFileName [SeriesName]\n";
+  std::cerr << "       reads a DICOM series into a volume and writes it in NIFTI file format.\n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  std::cerr << "       <-serial>                Read the series with the ImageSeriesReader instead of decoding\n";
+  std::cerr << "                                the slices in parallel\n";
+  std::cerr << "       <-nostreaming>           Write the NIFTI image with the ImageFileWriter instead of the\n";
+  std::cerr << "                                StreamingNiftiImageFileWriter\n";
+  exit(EXIT_FAILURE);
+}
+
 
 int
-main(int argc, char * argv[])
+DicomSeriesReadNiftiImageWrite(int argc, char * argv[])
 {
+  char * dicom_directory = nullptr;
+  char * output_name = nullptr;
+  char * series_name = nullptr;
+
+  bool ok;
+  bool serial = false;
+  bool streaming = true;
 
-  if (argc < 3)
+  while (argc > 1)
   {
-    std::cerr << "Usage: " << std::endl;
-    std::cerr << argv[0] << " DicomDirectory  outputFileName  [seriesName]" << std::endl;
-    return EXIT_FAILURE;
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      dicom_exe_usage();
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-serial") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      serial = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-nostreaming") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      streaming = false;
+    }
+
+    if (ok == false)
+    {
+      if (dicom_directory == nullptr)
+      {
+        dicom_directory = argv[1];
+        argc--;
+        argv++;
+      }
+      else if (output_name == nullptr)
+      {
+        output_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else if (series_name == nullptr)
+      {
+        series_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else
+      {
+        std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+        dicom_exe_usage();
+      }
+    }
+  }
+
+  if (dicom_directory == nullptr || output_name == nullptr)
+  {
+    dicom_exe_usage();
   }
 
 
@@ -80,31 +236,19 @@ main(int argc, char * argv[])
 
   // Software Guide : BeginLatex
   //
-  // We use the image type for instantiating the type of the series reader and
-  // for constructing one object of its type.
-  //
-  // Software Guide : EndLatex
-
-  // Software Guide : BeginCodeSnippet
-  using ReaderType = itk::ImageSeriesReader<ImageType>;
-  ReaderType::Pointer reader = ReaderType::New();
-  // Software Guide : EndCodeSnippet
-
-
-  // Software Guide : BeginLatex
-  //
-  // A GDCMImageIO object is created and connected to the reader. This object is
-  // the one that is aware of the internal intricacies of the DICOM format.
+  // The slices are decoded by GDCMImageIO objects, which are aware of the
+  // internal intricacies of the DICOM format. Each thread uses its own
+  // object, since an ImageIO holds the state of the file it reads.
   //
   // Software Guide : EndLatex
 
   // Software Guide : BeginCodeSnippet
   using ImageIOType = itk::GDCMImageIO;
-  ImageIOType::Pointer dicomIO = ImageIOType::New();
-
-  reader->SetImageIO(dicomIO);
   // Software Guide : EndCodeSnippet
 
+  itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
+  itk::TimeProbesCollectorBase    timer;
+
 
   // Software Guide : BeginLatex
   //
@@ -150,14 +294,15 @@ main(int argc, char * argv[])
   nameGenerator->SetUseSeriesDetails(true);
   nameGenerator->AddSeriesRestriction("0008|0021");
 
-  nameGenerator->SetDirectory(argv[1]);
+  timer.Start("Scan");
+  nameGenerator->SetDirectory(dicom_directory);
   // Software Guide : EndCodeSnippet
 
 
   try
   {
     std::cout << std::endl << "The directory: " << std::endl;
-    std::cout << std::endl << argv[1] << std::endl << std::endl;
+    std::cout << std::endl << dicom_directory << std::endl << std::endl;
     std::cout << "Contains the following DICOM Series: ";
     std::cout << std::endl << std::endl;
 
@@ -202,9 +347,9 @@ main(int argc, char * argv[])
     // Software Guide : BeginCodeSnippet
     std::string seriesIdentifier;
 
-    if (argc > 3) // If no optional series identifier
+    if (series_name) // If no optional series identifier
     {
-      seriesIdentifier = argv[3];
+      seriesIdentifier = series_name;
     }
     else
     {
@@ -236,47 +381,187 @@ main(int argc, char * argv[])
     fileNames = nameGenerator->GetFileNames(seriesIdentifier);
     // Software Guide : EndCodeSnippet
 
-
-    // Software Guide : BeginLatex
-    //
-    //
-    // The list of filenames can now be passed to the \doxygen{ImageSeriesReader}
-    // using the \code{SetFileNames()} method.
-    //
-    //  \index{itk::ImageSeriesReader!SetFileNames()}
-    //
-    // Software Guide : EndLatex
-
-    // Software Guide : BeginCodeSnippet
-    reader->SetFileNames(fileNames);
-    // Software Guide : EndCodeSnippet
+    if (fileNames.empty())
+    {
+      std::cerr << "No DICOM file in the series " << seriesIdentifier << std::endl;
+      return EXIT_FAILURE;
+    }
 
 
     // Software Guide : BeginLatex
     //
-    // Finally we can trigger the reading process by invoking the \code{Update()}
-    // method in the reader. This call as usual is placed inside a \code{try/catch}
-    // block.
+    // With \code{-serial}, the series is read by the \doxygen{ImageSeriesReader},
+    // which decodes the slices one after the other. Its volume is the
+    // reference for the parallel decoding below.
     //
     // Software Guide : EndLatex
 
-    // Software Guide : BeginCodeSnippet
-    try
+    ImageType::Pointer image;
+    if (serial)
     {
+      timer.Stop("Scan");
+
+      // Software Guide : BeginCodeSnippet
+      timer.Start("Decode");
+      using ReaderType = itk::ImageSeriesReader<ImageType>;
+      ReaderType::Pointer reader = ReaderType::New();
+      reader->SetImageIO(ImageIOType::New());
+      reader->SetFileNames(fileNames);
       reader->Update();
+      image = reader->GetOutput();
+      timer.Stop("Decode");
+      // Software Guide : EndCodeSnippet
     }
-    catch (itk::ExceptionObject & ex)
+    else
     {
-      std::cout << ex << std::endl;
-      return EXIT_FAILURE;
+      // Software Guide : BeginLatex
+      //
+      // The headers of the slices are read in parallel. Each slice is located by
+      // the position of its origin along the normal of the slices, and the
+      // slices are sorted by position.
+      //
+      // Software Guide : EndLatex
+
+      // Software Guide : BeginCodeSnippet
+      std::vector<SeriesSlice> slices(fileNames.size());
+      ImageType::DirectionType direction;
+      double                   normal[3];
+      {
+        ImageIOType::Pointer dicomIO = ImageIOType::New();
+        dicomIO->SetFileName(fileNames[0]);
+        dicomIO->ReadImageInformation();
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          for (unsigned int j = 0; j < Dimension; ++j)
+          {
+            direction[i][j] = dicomIO->GetDirection(j)[i];
+          }
+          normal[i] = dicomIO->GetDirection(2)[i];
+        }
+      }
+
+      threader->ParallelizeArray(
+        0,
+        fileNames.size(),
+        [&](itk::SizeValueType k) {
+          ImageIOType::Pointer dicomIO = ImageIOType::New();
+          dicomIO->SetFileName(fileNames[k]);
+          dicomIO->ReadImageInformation();
+          slices[k].FileName = fileNames[k];
+          slices[k].Position = 0.0;
+          for (unsigned int i = 0; i < Dimension; ++i)
+          {
+            slices[k].Origin[i] = dicomIO->GetOrigin(i);
+            slices[k].Position += slices[k].Origin[i] * normal[i];
+          }
+        },
+        nullptr);
+      timer.Stop("Scan");
+      // Software Guide : EndCodeSnippet
+
+
+      // Software Guide : BeginLatex
+      //
+      // The volume is then allocated with the geometry of the sorted slices.
+      // The slice spacing is taken from the positions of the slices, which is
+      // more reliable than the slice thickness recorded in the files.
+      //
+      // Software Guide : EndLatex
+
+      // Software Guide : BeginCodeSnippet
+      timer.Start("Assemble");
+      std::stable_sort(slices.begin(), slices.end(), [](const SeriesSlice & a, const SeriesSlice & b) {
+        return a.Position < b.Position;
+      });
+
+      ImageIOType::Pointer dicomIO = ImageIOType::New();
+      dicomIO->SetFileName(slices[0].FileName);
+      dicomIO->ReadImageInformation();
+
+      ImageType::SizeType    size;
+      ImageType::SpacingType spacing;
+      ImageType::PointType   origin;
+      size[0] = dicomIO->GetDimensions(0);
+      size[1] = dicomIO->GetDimensions(1);
+      size[2] = slices.size();
+      spacing[0] = dicomIO->GetSpacing(0);
+      spacing[1] = dicomIO->GetSpacing(1);
+      spacing[2] = dicomIO->GetSpacing(2);
+      if (slices.size() > 1 && slices.back().Position > slices.front().Position)
+      {
+        spacing[2] = (slices.back().Position - slices.front().Position) / (slices.size() - 1);
+      }
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        origin[i] = slices[0].Origin[i];
+      }
+
+      image = ImageType::New();
+      image->SetRegions(size);
+      image->SetSpacing(spacing);
+      image->SetOrigin(origin);
+      image->SetDirection(direction);
+      image->Allocate();
+      timer.Stop("Assemble");
+      // Software Guide : EndCodeSnippet
+
+
+      // Software Guide : BeginLatex
+      //
+      // Finally the slices are decoded in parallel, each straight into its place
+      // in the buffer of the volume. A slice stored with another pixel type is
+      // decoded into a temporary buffer and converted.
+      //
+      // Software Guide : EndLatex
+
+      // Software Guide : BeginCodeSnippet
+      timer.Start("Decode");
+      const itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::MapPixelType<PixelType>::CType;
+      const itk::SizeValueType                sliceSize = size[0] * size[1];
+      PixelType *                             buffer = image->GetBufferPointer();
+
+      try
+      {
+        threader->ParallelizeArray(
+          0,
+          slices.size(),
+          [&](itk::SizeValueType k) {
+            ImageIOType::Pointer sliceIO = ImageIOType::New();
+            sliceIO->SetFileName(slices[k].FileName);
+            sliceIO->ReadImageInformation();
+            if (sliceIO->GetDimensions(0) != size[0] || sliceIO->GetDimensions(1) != size[1] ||
+                sliceIO->GetImageSizeInPixels() != sliceSize || sliceIO->GetNumberOfComponents() != 1)
+            {
+              itkGenericExceptionMacro(<< slices[k].FileName << " does not match the size of the first slice");
+            }
+
+            PixelType * slice = buffer + k * sliceSize;
+            if (sliceIO->GetComponentType() == componentType)
+            {
+              sliceIO->Read(slice);
+            }
+            else
+            {
+              std::vector<char> decoded(sliceIO->GetImageSizeInBytes());
+              sliceIO->Read(decoded.data());
+              ConvertSlice(sliceIO->GetComponentType(), decoded.data(), slice, sliceSize);
+            }
+          },
+          nullptr);
+      }
+      catch (itk::ExceptionObject & ex)
+      {
+        std::cout << ex << std::endl;
+        return EXIT_FAILURE;
+      }
+      timer.Stop("Decode");
+      // Software Guide : EndCodeSnippet
     }
-    // Software Guide : EndCodeSnippet
 
 
     // Software Guide : BeginLatex
     //
-    // At this point, we have a volumetric image in memory that we can access by
-    // invoking the \code{GetOutput()} method of the reader.
+    // At this point, we have a volumetric image in memory.
     //
     // Software Guide : EndLatex
 
@@ -291,27 +576,49 @@ main(int argc, char * argv[])
     // Software Guide : EndLatex
 
     // Software Guide : BeginCodeSnippet
-    using WriterType = itk::ImageFileWriter<ImageType>;
-    WriterType::Pointer writer = WriterType::New();
+    const std::string outputName = output_name;
+    const auto        hasSuffix = [&outputName](const std::string & suffix) {
+      return outputName.size() > suffix.size() &&
+             outputName.compare(outputName.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    itk::ProcessObject::Pointer writer;
+    if (streaming && (hasSuffix(".nii") || hasSuffix(".nii.gz")))
+    {
+      //  A single file NIfTI image is written by the
+      //  StreamingNiftiImageFileWriter, which compresses the blocks of
+      //  the volume in parallel.
+      using StreamingWriterType = itk::StreamingNiftiImageFileWriter<ImageType>;
+      StreamingWriterType::Pointer streamingWriter = StreamingWriterType::New();
+      streamingWriter->SetFileName(outputName);
+      streamingWriter->SetInput(image);
+      writer = streamingWriter;
+    }
+    else
+    {
+      using WriterType = itk::ImageFileWriter<ImageType>;
+      WriterType::Pointer imageWriter = WriterType::New();
 
-    using ImageIOType = itk::NiftiImageIO;
-    ImageIOType::Pointer niftiIO = ImageIOType::New();
+      using NiftiIOType = itk::NiftiImageIO;
+      NiftiIOType::Pointer niftiIO = NiftiIOType::New();
 
-    //  The NiftiImageIO object is then connected to the
-    //  ImageFileWriter.  This will short-circuit the action of the
-    //  ImageIOFactory mechanism. The ImageFileWriter will
-    //  not attempt to look for other ImageIO objects capable of
-    //  performing the writing tasks. It will simply invoke the one provided by
-    //  the user.
-    writer->SetImageIO(niftiIO);
+      //  The NiftiImageIO object is then connected to the
+      //  ImageFileWriter.  This will short-circuit the action of the
+      //  ImageIOFactory mechanism. The ImageFileWriter will
+      //  not attempt to look for other ImageIO objects capable of
+      //  performing the writing tasks. It will simply invoke the one provided by
+      //  the user.
+      imageWriter->SetImageIO(niftiIO);
 
-    writer->SetFileName(argv[2]);
+      imageWriter->SetFileName(outputName);
 
-    writer->SetInput(reader->GetOutput());
+      imageWriter->SetInput(image);
+      writer = imageWriter;
+    }
     // Software Guide : EndCodeSnippet
 
     std::cout << "Writing the image as " << std::endl << std::endl;
-    std::cout << argv[2] << std::endl << std::endl;
+    std::cout << outputName << std::endl << std::endl;
 
 
     // Software Guide : BeginLatex
@@ -324,7 +631,9 @@ main(int argc, char * argv[])
     try
     {
       // Software Guide : BeginCodeSnippet
+      timer.Start("Write");
       writer->Update();
+      timer.Stop("Write");
       // Software Guide : EndCodeSnippet
     }
     catch (itk::ExceptionObject & ex)
@@ -350,6 +659,7 @@ main(int argc, char * argv[])
   //
   // Software Guide : EndLatex
 
+  timer.Report();
 
   return EXIT_SUCCESS;
 }
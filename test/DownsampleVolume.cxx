@@ -0,0 +1,286 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+/*=========================================================================
+
+ This program downsamples a volume to one or several levels in a single
+ pass over the input with MultiLevelDownsampleImageFilter, and writes each
+ level as an image. The input is streamed by slabs and the levels are
+ reduced with box or Gaussian weights on all the cores. NIfTI images are
+ written with StreamingNiftiImageFileWriter, compressed in parallel if the
+ name ends with ".nii.gz". It replaces ReadResampleWriteNifti, which
+ resampled the volume to a 2 mm grid with linear interpolation.
+
+ With -binshrink, the levels are reduced by BinShrinkImageFilter from the
+ whole volume instead, giving the reference the box reduction is tested
+ against.
+
+=========================================================================*/
+
+#include "itkBinShrinkImageFilter.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkMultiLevelDownsampleImageFilter.h"
+#include "itkStreamingNiftiImageFileWriter.h"
+#include "itkTimeProbesCollectorBase.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+
+void
+downsample_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: DownsampleVolume <options> InputVolume OutputVolume\n";
+  std::cerr << "       downsamples a volume to one or several levels in a single streamed pass.\n";
+  std::cerr << "       With several levels, OutputVolume names the level l as OutputVolume with\n";
+  std::cerr << "       the suffix _level<l> inserted before the extension. \n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  std::cerr << "       <-levels int>            Number of levels, reduced by 2, 4, 8, ... [default: 1]\n";
+  std::cerr << "       <-spacing float>         Single level of the integer factors giving the spacing nearest\n";
+  std::cerr << "                                to float mm along each axis\n";
+  std::cerr << "       <-gaussian>              Gaussian reduction instead of the mean of the blocks\n";
+  std::cerr << "       <-divisions int>         Number of slabs the input is streamed in [default: 16]\n";
+  std::cerr << "       <-binshrink>             Reduce each level with BinShrinkImageFilter from the whole volume\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int
+DownsampleVolume(int argc, char * argv[])
+{
+  char * input_name = nullptr;
+  char * output_name = nullptr;
+
+  bool ok;
+
+  unsigned int levels = 1;
+  double       targetSpacing = 0.0;
+  bool         gaussian = false;
+  unsigned int divisions = 16;
+  bool         binShrink = false;
+
+  while (argc > 1)
+  {
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      downsample_exe_usage();
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-levels") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      levels = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-spacing") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      targetSpacing = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-gaussian") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      gaussian = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-binshrink") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      binShrink = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-divisions") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      divisions = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if (ok == false)
+    {
+      if (input_name == nullptr)
+      {
+        input_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else if (output_name == nullptr)
+      {
+        output_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else
+      {
+        std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+        downsample_exe_usage();
+      }
+    }
+  }
+
+  if (input_name == nullptr || output_name == nullptr || levels < 1 || (binShrink && gaussian))
+  {
+    downsample_exe_usage();
+  }
+
+  constexpr unsigned int Dimension = 3;
+  using PixelType = short;
+  using ImageType = itk::Image<PixelType, Dimension>;
+
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  using FilterType = itk::MultiLevelDownsampleImageFilter<ImageType>;
+  using BinShrinkFilterType = itk::BinShrinkImageFilter<ImageType, ImageType>;
+
+  itk::TimeProbesCollectorBase timer;
+
+  // Only the information is read here: the volume is streamed through the
+  // filter by slabs.
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(input_name);
+  reader->UpdateOutputInformation();
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(reader->GetOutput());
+  filter->SetUseGaussianReduction(gaussian);
+  filter->SetNumberOfStreamDivisions(divisions);
+  if (targetSpacing > 0.0)
+  {
+    const ImageType::SpacingType inputSpacing = reader->GetOutput()->GetSpacing();
+    FilterType::ScheduleType     schedule(1, Dimension);
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      schedule(0, i) = std::max(1u, static_cast<unsigned int>(std::lround(targetSpacing / inputSpacing[i])));
+    }
+    filter->SetSchedule(schedule);
+  }
+  else
+  {
+    filter->SetNumberOfLevels(levels);
+  }
+
+  std::vector<ImageType::ConstPointer> images;
+
+  timer.Start("Downsample");
+  if (binShrink)
+  {
+    // One filter per level, each reading the whole volume
+    const FilterType::ScheduleType & schedule = filter->GetSchedule();
+    for (unsigned int level = 0; level < schedule.rows(); ++level)
+    {
+      BinShrinkFilterType::Pointer shrinker = BinShrinkFilterType::New();
+      shrinker->SetInput(reader->GetOutput());
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        shrinker->SetShrinkFactor(i, schedule(level, i));
+      }
+      shrinker->Update();
+      images.push_back(shrinker->GetOutput());
+    }
+  }
+  else
+  {
+    filter->Update();
+    for (unsigned int level = 0; level < filter->GetNumberOfLevels(); ++level)
+    {
+      images.push_back(filter->GetOutput(level));
+    }
+  }
+  timer.Stop("Downsample");
+
+  // The files of the levels are named after the output file, the suffix
+  // being inserted before the extension.
+  const std::string outputName = output_name;
+  const auto        hasSuffix = [&outputName](const std::string & suffix) {
+    return outputName.size() > suffix.size() &&
+           outputName.compare(outputName.size() - suffix.size(), suffix.size(), suffix) == 0;
+  };
+  std::string::size_type extension = outputName.rfind('.');
+  if (hasSuffix(".nii.gz"))
+  {
+    extension = outputName.size() - 7;
+  }
+  if (extension == std::string::npos || outputName.find('/', extension) != std::string::npos)
+  {
+    extension = outputName.size();
+  }
+  const bool nifti = hasSuffix(".nii") || hasSuffix(".nii.gz");
+
+  timer.Start("Write");
+  for (unsigned int level = 0; level < images.size(); ++level)
+  {
+    std::string fileName = outputName;
+    if (images.size() > 1)
+    {
+      std::ostringstream suffix;
+      suffix << "_level" << level + 1;
+      fileName.insert(extension, suffix.str());
+    }
+
+    const ImageType * image = images[level];
+    std::cout << "Level " << level + 1 << ": " << image->GetLargestPossibleRegion().GetSize() << " voxels of "
+              << image->GetSpacing() << " mm, " << fileName << std::endl;
+
+    if (nifti)
+    {
+      using StreamingWriterType = itk::StreamingNiftiImageFileWriter<ImageType>;
+      StreamingWriterType::Pointer writer = StreamingWriterType::New();
+      writer->SetFileName(fileName);
+      writer->SetInput(image);
+      writer->Update();
+    }
+    else
+    {
+      using WriterType = itk::ImageFileWriter<ImageType>;
+      WriterType::Pointer writer = WriterType::New();
+      writer->SetFileName(fileName);
+      writer->SetInput(image);
+      writer->Update();
+    }
+  }
+  timer.Stop("Write");
+
+  timer.Report();
+
+  return EXIT_SUCCESS;
+}
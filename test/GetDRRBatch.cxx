@@ -0,0 +1,780 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+/*=========================================================================
+
+ This program computes a batch of digitally reconstructed radiographs
+ (DRRs) of a CT volume, one for each pose of a list, as
+ GetDRRSiddonJacobsRayTracing does for a single pose. The volume is read
+ once for the whole batch.
+
+ The poses are read from a CSV file, one pose per line:
+
+   angle, rx, ry, rz, tx, ty, tz [, dx, dy [, sx, sy]]
+
+ or from a JSON file holding an array of objects with these keys. The
+ angle is the projection angle and rx, ry, rz the rotations of the volume
+ in degrees, tx, ty, tz its translation in mm, dx, dy the size of the DRR
+ in pixels and sx, sy its pixel spacing in mm. The size and spacing given
+ on the command line are used when they are missing. Lines starting with
+ '#' and a header line are skipped.
+
+ Several DRRs are computed at once, each by a RayCastProjectionImageFilter
+ casting its tiles on several threads. The DRRs are written by a separate
+ thread while the next ones are computed. The file names are given by a
+ printf-like format of the pose number, e.g. drr_%05d.tif.
+
+=========================================================================*/
+
+#include "itkTimeProbesCollectorBase.h"
+#include "itkTimeProbe.h"
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkNumericSeriesFileNames.h"
+
+#include "itkEuler3DTransform.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+#include "itkJosephRayCastInterpolateImageFunction.h"
+#include "itkRayCastProjectionImageFilter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+
+// Pose of the volume and grid of the detector of one DRR
+struct DRRPose
+{
+  double Angle;
+  double Rotation[3];
+  double Translation[3];
+  double Size[2];
+  double Spacing[2];
+};
+
+constexpr unsigned int NumberOfPoseValues = 11;
+
+
+// Set the values of a pose in the order of a line of the CSV file
+void
+SetPoseValue(DRRPose & pose, unsigned int k, double value)
+{
+  if (k == 0)
+  {
+    pose.Angle = value;
+  }
+  else if (k < 4)
+  {
+    pose.Rotation[k - 1] = value;
+  }
+  else if (k < 7)
+  {
+    pose.Translation[k - 4] = value;
+  }
+  else if (k < 9)
+  {
+    pose.Size[k - 7] = value;
+  }
+  else
+  {
+    pose.Spacing[k - 9] = value;
+  }
+}
+
+
+bool
+ReadPosesCSV(std::istream & stream, const DRRPose & defaultPose, std::vector<DRRPose> & poses)
+{
+  std::string line;
+  bool        firstLine = true;
+  while (std::getline(stream, line))
+  {
+    const size_t comment = line.find('#');
+    if (comment != std::string::npos)
+    {
+      line.erase(comment);
+    }
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::replace(line.begin(), line.end(), ';', ' ');
+
+    std::istringstream  fields(line);
+    std::vector<double> values;
+    double              value;
+    while (fields >> value)
+    {
+      values.push_back(value);
+    }
+    const bool parsed = fields.eof();
+
+    // A header starts with a name rather than a number.
+    if (!parsed && values.empty() && firstLine)
+    {
+      firstLine = false;
+      continue;
+    }
+    if (values.empty() && parsed)
+    {
+      continue;
+    }
+    firstLine = false;
+    if (!parsed || values.size() < 7 || values.size() > NumberOfPoseValues || values.size() % 2 == 0)
+    {
+      std::cerr << "ERROR: Can not parse pose " << poses.size() << ": " << line << std::endl;
+      return false;
+    }
+
+    DRRPose pose = defaultPose;
+    for (unsigned int k = 0; k < values.size(); ++k)
+    {
+      SetPoseValue(pose, k, values[k]);
+    }
+    poses.push_back(pose);
+  }
+  return true;
+}
+
+
+bool
+ReadPosesJSON(const std::string & text, const DRRPose & defaultPose, std::vector<DRRPose> & poses)
+{
+  const char * keys[NumberOfPoseValues] = { "angle", "rx", "ry", "rz", "tx", "ty", "tz", "dx", "dy", "sx", "sy" };
+
+  size_t position = 0;
+  size_t begin;
+  while ((begin = text.find('{', position)) != std::string::npos)
+  {
+    const size_t end = text.find('}', begin);
+    if (end == std::string::npos)
+    {
+      std::cerr << "ERROR: Unterminated pose " << poses.size() << std::endl;
+      return false;
+    }
+    const std::string object = text.substr(begin, end - begin);
+
+    DRRPose pose = defaultPose;
+    for (unsigned int k = 0; k < NumberOfPoseValues; ++k)
+    {
+      const size_t key = object.find(std::string("\"") + keys[k] + "\"");
+      if (key == std::string::npos)
+      {
+        continue;
+      }
+      const size_t colon = object.find(':', key);
+      const char * first = colon == std::string::npos ? nullptr : object.c_str() + colon + 1;
+      char *       last = nullptr;
+      const double value = first ? std::strtod(first, &last) : 0.0;
+      if (!first || last == first)
+      {
+        std::cerr << "ERROR: Can not parse the value of " << keys[k] << " in pose " << poses.size() << std::endl;
+        return false;
+      }
+      SetPoseValue(pose, k, value);
+    }
+    poses.push_back(pose);
+    position = end + 1;
+  }
+  return true;
+}
+
+} // namespace
+
+
+void
+batch_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: GetDRRBatch <options> -poses file -o format [input]\n";
+  std::cerr << "       calculates the Digitally Reconstructed Radiographs of a CT image \n";
+  std::cerr << "       for each pose of a list. \n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  std::cerr << "       <-v>                     Verbose output [default: no]\n";
+  std::cerr << "       <-poses file>            CSV or JSON list of the poses\n";
+  std::cerr << "       <-o format>              Output filenames, printf-like format of the pose number\n";
+  std::cerr << "       <-res float float>       Default DRR pixel spacing in isocenter plane in mm "
+               "[default: 0.51mm 0.51mm]\n";
+  std::cerr << "       <-size int int>          Default size of DRR in number of pixels [default: 512x512]\n";
+  std::cerr
+    << "       <-scd float>             Source to isocenter (i.e., 3D image center) distance in mm [default: 1000mm]\n";
+  std::cerr << "       <-iso float float float> Continous voxel indices of CT isocenter (center of rotation and "
+               "projection center)\n";
+  std::cerr << "       <-threshold float>       CT intensity threshold, below which are ignored [default: 0]\n";
+  std::cerr << "       <-projector name>        Ray casting method, siddon (exact) or joseph (fast) "
+               "[default: siddon]\n";
+  std::cerr << "       <-window float float>    Projection values mapped to 0 and 255 [default: range of each DRR]\n";
+  std::cerr << "       <-jobs int>              Number of DRRs computed at once [default: a quarter of the cores]\n";
+  std::cerr << "       <-threads int>           Number of threads computing each DRR [default: cores / jobs]\n\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int
+GetDRRBatch(int argc, char * argv[])
+{
+  char * input_name = nullptr;
+  char * poses_name = nullptr;
+  char * output_format = nullptr;
+
+  bool ok;
+  bool verbose = false;
+  bool customized_iso = false; // Flag for customized 3D image isocenter positions
+
+  // The pixel indices of the isocenter
+  float cx = 0.;
+  float cy = 0.;
+  float cz = 0.;
+
+  float scd = 1000.; // Source to isocenter distance
+
+  float im_sx = 0.51; // Default pixel spacing of the DRRs in the isocenter plane in mm
+  float im_sy = 0.51;
+
+  int dx = 512; // Default size of the DRRs in number of pixels
+  int dy = 512;
+
+  float threshold = 0.;
+
+  // Window of the projections mapped to the output range
+  bool   customized_window = false;
+  double windowMin = 0.;
+  double windowMax = 0.;
+
+  const char * projector = "siddon";
+
+  int jobs = 0;    // Default from the number of cores
+  int threads = 0; // Default from the number of cores
+
+  // Create a timer to record calculation time.
+  itk::TimeProbesCollectorBase timer;
+
+  while (argc > 1)
+  {
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      batch_exe_usage();
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-v") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      verbose = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-poses") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      poses_name = argv[1];
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-o") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      output_format = argv[1];
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-res") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      im_sx = atof(argv[1]);
+      argc--;
+      argv++;
+      im_sy = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-size") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      dx = atoi(argv[1]);
+      argc--;
+      argv++;
+      dy = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-scd") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      scd = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-iso") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      cx = atof(argv[1]);
+      argc--;
+      argv++;
+      cy = atof(argv[1]);
+      argc--;
+      argv++;
+      cz = atof(argv[1]);
+      argc--;
+      argv++;
+      customized_iso = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-threshold") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      threshold = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-projector") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      projector = argv[1];
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-window") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      windowMin = atof(argv[1]);
+      argc--;
+      argv++;
+      windowMax = atof(argv[1]);
+      argc--;
+      argv++;
+      customized_window = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-jobs") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      jobs = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-threads") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      threads = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if (ok == false)
+    {
+      if (input_name == nullptr)
+      {
+        input_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else
+      {
+        std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+        batch_exe_usage();
+      }
+    }
+  }
+
+  if (input_name == nullptr)
+  {
+    std::cerr << "Input image file missing !" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (poses_name == nullptr || output_format == nullptr)
+  {
+    std::cerr << "Pose list or output filenames missing !" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (strcmp(projector, "siddon") != 0 && strcmp(projector, "joseph") != 0)
+  {
+    std::cerr << "ERROR: Unknown projector " << projector << std::endl;
+    batch_exe_usage();
+  }
+
+  // Read the list of poses
+  DRRPose defaultPose = {};
+  defaultPose.Size[0] = dx;
+  defaultPose.Size[1] = dy;
+  defaultPose.Spacing[0] = im_sx;
+  defaultPose.Spacing[1] = im_sy;
+
+  std::vector<DRRPose> poses;
+  {
+    std::ifstream posesFile(poses_name);
+    if (!posesFile)
+    {
+      std::cerr << "ERROR: Can not open the pose list " << poses_name << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::stringstream text;
+    text << posesFile.rdbuf();
+    const std::string content = text.str();
+
+    const size_t first = content.find_first_not_of(" \t\r\n");
+    const bool   json = first != std::string::npos && (content[first] == '[' || content[first] == '{');
+    bool         parsed;
+    if (json)
+    {
+      parsed = ReadPosesJSON(content, defaultPose, poses);
+    }
+    else
+    {
+      std::istringstream lines(content);
+      parsed = ReadPosesCSV(lines, defaultPose, poses);
+    }
+    if (!parsed)
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  for (const DRRPose & pose : poses)
+  {
+    if (pose.Size[0] < 1 || pose.Size[1] < 1 || pose.Spacing[0] <= 0 || pose.Spacing[1] <= 0)
+    {
+      std::cerr << "ERROR: Invalid detector grid in the pose list" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::cout << "Number of poses: " << poses.size() << std::endl;
+  if (poses.empty())
+  {
+    return EXIT_SUCCESS;
+  }
+
+  // The DRRs computed at once share the cores.
+  const unsigned int numberOfCores = std::max(std::thread::hardware_concurrency(), 1u);
+  const unsigned int numberOfJobs = static_cast<unsigned int>(
+    std::min<size_t>(poses.size(), jobs > 0 ? static_cast<unsigned int>(jobs) : std::max(numberOfCores / 4, 1u)));
+  const unsigned int numberOfThreads =
+    threads > 0 ? static_cast<unsigned int>(threads) : std::max(numberOfCores / numberOfJobs, 1u);
+  if (verbose)
+  {
+    std::cout << "DRRs computed at once: " << numberOfJobs << std::endl;
+    std::cout << "Threads per DRR: " << numberOfThreads << std::endl;
+  }
+
+  constexpr unsigned int Dimension = 3;
+  using InputPixelType = short;
+  using OutputPixelType = unsigned char;
+
+  using InputImageType = itk::Image<InputPixelType, Dimension>;
+  using OutputImageType = itk::Image<OutputPixelType, Dimension>;
+
+  timer.Start("Loading Input Image");
+  using ReaderType = itk::ImageFileReader<InputImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(input_name);
+
+  try
+  {
+    reader->Update();
+  }
+  catch (itk::ExceptionObject & err)
+  {
+    std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  InputImageType::Pointer image = reader->GetOutput();
+  timer.Stop("Loading Input Image");
+
+  // The projection geometry assumes that the origin of the CT image is (0,0,0).
+  InputImageType::PointType ctOrigin;
+  ctOrigin.Fill(0.0);
+  image->SetOrigin(ctOrigin);
+
+  const InputImageType::SpacingType imRes = image->GetSpacing();
+  const InputImageType::SizeType    imSize = image->GetBufferedRegion().GetSize();
+
+  using TransformType = itk::Euler3DTransform<double>;
+
+  // The center of the image is the isocenter unless given by the user.
+  const double                  isocenterIndex[Dimension] = { cx, cy, cz };
+  TransformType::InputPointType isocenter;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    isocenter[i] = customized_iso ? imRes[i] * isocenterIndex[i] : imRes[i] * static_cast<double>(imSize[i]) / 2.0;
+  }
+
+  // The names of the DRRs
+  itk::NumericSeriesFileNames::Pointer fileNames = itk::NumericSeriesFileNames::New();
+  fileNames->SetSeriesFormat(output_format);
+  fileNames->SetStartIndex(0);
+  fileNames->SetEndIndex(poses.size() - 1);
+  fileNames->SetIncrementIndex(1);
+  const std::vector<std::string> & outputNames = fileNames->GetFileNames();
+
+  // constant for converting degrees into radians
+  const double dtr = (atan(1.0) * 4.0) / 180.0;
+
+  // The DRRs wait in a queue for the writing thread, which holds at most
+  // two DRRs per job so that the memory stays bounded.
+  using QueuedImageType = std::pair<std::string, OutputImageType::Pointer>;
+  std::deque<QueuedImageType> queue;
+  const size_t                queueCapacity = 2 * numberOfJobs;
+  std::mutex                  queueMutex;
+  std::condition_variable     queueChanged;
+  unsigned int                runningJobs = numberOfJobs;
+
+  // The first error stops the batch.
+  std::atomic<bool> failed{ false };
+  std::mutex        errorMutex;
+  std::string       error;
+  auto              fail = [&](const std::string & message) {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (!failed)
+    {
+      error = message;
+      failed = true;
+    }
+  };
+
+  std::atomic<size_t> nextPose{ 0 };
+
+  // Each job computes the next pose of the list until there is none left.
+  // The jobs read the CT through images of their own sharing its pixels,
+  // so that their pipelines do not update the same image.
+  auto job = [&]() {
+    try
+    {
+      InputImageType::Pointer volume = InputImageType::New();
+      volume->CopyInformation(image);
+      volume->SetRegions(image->GetBufferedRegion());
+      volume->SetPixelContainer(image->GetPixelContainer());
+
+      using InterpolatorType = itk::ProjectionInterpolateImageFunction<InputImageType, double>;
+      InterpolatorType::Pointer interpolator;
+      if (strcmp(projector, "joseph") == 0)
+      {
+        interpolator = itk::JosephRayCastInterpolateImageFunction<InputImageType, double>::New().GetPointer();
+      }
+      else
+      {
+        interpolator = itk::SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>::New().GetPointer();
+      }
+
+      TransformType::Pointer transform = TransformType::New();
+      transform->SetComputeZYX(true);
+      transform->SetCenter(isocenter);
+
+      using FilterType = itk::RayCastProjectionImageFilter<InputImageType, OutputImageType>;
+      FilterType::Pointer filter = FilterType::New();
+      filter->SetInput(volume);
+      filter->SetInterpolator(interpolator);
+      filter->SetTransform(transform);
+      filter->SetFocalPointToIsocenterDistance(scd);
+      filter->SetThreshold(threshold);
+      filter->SetNumberOfWorkUnits(numberOfThreads);
+
+      // The computed projection is upsided-down, as in GetDRRSiddonJacobsRayTracing.
+      FilterType::FlipAxesArrayType flipArray;
+      flipArray[0] = false;
+      flipArray[1] = true;
+      flipArray[2] = false;
+      filter->SetFlipAxes(flipArray);
+
+      filter->RescaleIntensityOn();
+      filter->SetOutputMinimum(0);
+      filter->SetOutputMaximum(255);
+      if (customized_window)
+      {
+        filter->AutomaticWindowOff();
+        filter->SetWindowMinimum(windowMin);
+        filter->SetWindowMaximum(windowMax);
+      }
+
+      size_t p;
+      while (!failed && (p = nextPose++) < poses.size())
+      {
+        const DRRPose & pose = poses[p];
+
+        TransformType::OutputVectorType translation;
+        translation[0] = pose.Translation[0];
+        translation[1] = pose.Translation[1];
+        translation[2] = pose.Translation[2];
+        transform->SetTranslation(translation);
+        transform->SetRotation(dtr * pose.Rotation[0], dtr * pose.Rotation[1], dtr * pose.Rotation[2]);
+        filter->SetProjectionAngle(dtr * pose.Angle);
+
+        // The central axis passes through the center of the DRR.
+        FilterType::SizeType size;
+        size[0] = static_cast<itk::SizeValueType>(pose.Size[0]);
+        size[1] = static_cast<itk::SizeValueType>(pose.Size[1]);
+        size[2] = 1;
+
+        double spacing[Dimension];
+        spacing[0] = pose.Spacing[0];
+        spacing[1] = pose.Spacing[1];
+        spacing[2] = 1.0;
+
+        double origin[Dimension];
+        origin[0] = -spacing[0] * (static_cast<double>(size[0]) - 1.) / 2.;
+        origin[1] = -spacing[1] * (static_cast<double>(size[1]) - 1.) / 2.;
+        origin[2] = -scd;
+
+        filter->SetSize(size);
+        filter->SetOutputSpacing(spacing);
+        filter->SetOutputOrigin(origin);
+        filter->Update();
+
+        // The filter makes a new output for the next pose.
+        OutputImageType::Pointer drr = filter->GetOutput();
+        drr->DisconnectPipeline();
+
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueChanged.wait(lock, [&] { return queue.size() < queueCapacity || failed; });
+        queue.emplace_back(outputNames[p], drr);
+        queueChanged.notify_all();
+      }
+    }
+    catch (itk::ExceptionObject & err)
+    {
+      std::ostringstream message;
+      message << err;
+      fail(message.str());
+    }
+    catch (std::exception & err)
+    {
+      fail(err.what());
+    }
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    --runningJobs;
+    queueChanged.notify_all();
+  };
+
+  // The writing thread empties the queue until all the jobs are done.
+  auto write = [&]() {
+    using WriterType = itk::ImageFileWriter<OutputImageType>;
+    WriterType::Pointer writer = WriterType::New();
+    for (;;)
+    {
+      QueuedImageType drr;
+      {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueChanged.wait(lock, [&] { return !queue.empty() || runningJobs == 0; });
+        if (queue.empty())
+        {
+          return;
+        }
+        drr = queue.front();
+        queue.pop_front();
+        queueChanged.notify_all();
+      }
+
+      if (failed)
+      {
+        continue;
+      }
+      try
+      {
+        if (verbose)
+        {
+          std::cout << "Writing image: " << drr.first << std::endl;
+        }
+        writer->SetFileName(drr.first);
+        writer->SetInput(drr.second);
+        writer->Update();
+      }
+      catch (itk::ExceptionObject & err)
+      {
+        std::ostringstream message;
+        message << err;
+        fail(message.str());
+        queueChanged.notify_all();
+      }
+    }
+  };
+
+  itk::TimeProbe batchTime;
+  batchTime.Start();
+  timer.Start("DRR batch");
+  std::thread              writingThread(write);
+  std::vector<std::thread> jobThreads;
+  for (unsigned int j = 0; j < numberOfJobs; ++j)
+  {
+    jobThreads.emplace_back(job);
+  }
+  for (std::thread & thread : jobThreads)
+  {
+    thread.join();
+  }
+  writingThread.join();
+  timer.Stop("DRR batch");
+  batchTime.Stop();
+
+  if (failed)
+  {
+    std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+    std::cerr << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "DRRs per second: " << poses.size() / batchTime.GetTotal() << std::endl;
+  timer.Report();
+
+  return EXIT_SUCCESS;
+}
@@ -28,7 +28,7 @@ CIT 6, 89-94 (1998).
 =========================================================================*/
 
 
-// This example illustrates the use of the ResampleImageFilter and
+// This example illustrates the use of the RayCastProjectionImageFilter and
 // SiddonJacobsRayCastInterpolateImageFunction to generate digitally
 // reconstructed radiographs (DRRs) from a 3D CT image volume.
 
@@ -39,13 +39,11 @@ CIT 6, 89-94 (1998).
 #include "itkImage.h"
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
-#include "itkResampleImageFilter.h"
-#include "itkImageRegionIteratorWithIndex.h"
-#include "itkRescaleIntensityImageFilter.h"
-#include "itkFlipImageFilter.h"
+#include "itkRayCastProjectionImageFilter.h"
 
 #include "itkEuler3DTransform.h"
 #include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+#include "itkJosephRayCastInterpolateImageFunction.h"
 
 
 void
@@ -72,6 +70,11 @@ raytracing_exe_usage()
                "projection center)\n";
   std::cerr << "       <-rp float>              Projection angle in degrees";
   std::cerr << "       <-threshold float>       CT intensity threshold, below which are ignored [default: 0]\n";
+  std::cerr << "       <-projector name>        Ray casting method, siddon (exact) or joseph (fast) "
+               "[default: siddon]\n";
+  std::cerr << "       <-window float float>    Projection values mapped to 0 and 255 [default: DRR range]\n";
+  std::cerr << "       <-divisions int>         Number of pieces the DRR is written in, computed piece by piece "
+               "with -window [default: 1]\n";
   std::cerr << "       <-o file>                Output image filename\n\n";
   std::cerr << "                                by  Jian Wu (eewujian@hotmail.com)\n\n";
   exit(EXIT_FAILURE);
@@ -122,6 +125,16 @@ GetDRRSiddonJacobsRayTracing(int argc, char * argv[])
 
   float threshold = 0.;
 
+  // Window of the projections mapped to the output range
+  bool   customized_window = false;
+  double windowMin = 0.;
+  double windowMax = 0.;
+
+  const char * projector = "siddon";
+
+  // Number of pieces the DRR is streamed in
+  unsigned int divisions = 1;
+
   // Create a timer to record calculation time.
   itk::TimeProbesCollectorBase timer;
 
@@ -187,6 +200,40 @@ GetDRRSiddonJacobsRayTracing(int argc, char * argv[])
       argv++;
     }
 
+    if ((ok == false) && (strcmp(argv[1], "-projector") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      projector = argv[1];
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-divisions") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      divisions = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-window") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      windowMin = atof(argv[1]);
+      argc--;
+      argv++;
+      windowMax = atof(argv[1]);
+      argc--;
+      argv++;
+      customized_window = true;
+    }
+
     if ((ok == false) && (strcmp(argv[1], "-t") == 0))
     {
       argc--;
@@ -396,18 +443,19 @@ GetDRRSiddonJacobsRayTracing(int argc, char * argv[])
     std::cout << "]" << std::endl << std::endl;
   }
 
-  // Creation of a {ResampleImageFilter} enables coordinates for
+  // Creation of a {RayCastProjectionImageFilter} enables coordinates for
   // each of the pixels in the DRR image to be generated. These
   // coordinates are used by the {RayCastInterpolateImageFunction}
   // to determine the equation of each corresponding ray which is cast
-  // through the input volume.
+  // through the input volume. The filter also flips and rescales the
+  // projections as the rays are cast, and writes them directly as
+  // pixels of the output type.
 
-  using FilterType = itk::ResampleImageFilter<InputImageType, InputImageType>;
+  using FilterType = itk::RayCastProjectionImageFilter<InputImageType, OutputImageType>;
 
   FilterType::Pointer filter = FilterType::New();
 
   filter->SetInput(image);
-  filter->SetDefaultPixelValue(0);
 
   // An Euler transformation is defined to position the input volume.
 
@@ -464,18 +512,54 @@ GetDRRSiddonJacobsRayTracing(int argc, char * argv[])
               << "Transform: " << transform << std::endl;
   }
 
-  using InterpolatorType = itk::SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
-  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  // The exact Siddon-Jacobs ray caster and the faster Joseph ray marcher
+  // share the same projection geometry.
+  using InterpolatorType = itk::ProjectionInterpolateImageFunction<InputImageType, double>;
+  using SiddonInterpolatorType = itk::SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
+  using JosephInterpolatorType = itk::JosephRayCastInterpolateImageFunction<InputImageType, double>;
 
-  interpolator->SetProjectionAngle(dtr * rprojection); // Set angle between projection central axis and -z axis
-  interpolator->SetFocalPointToIsocenterDistance(scd); // Set source to isocenter distance
-  interpolator->SetThreshold(threshold);               // Set intensity threshold, below which are ignored.
-  interpolator->SetTransform(transform);
+  InterpolatorType::Pointer interpolator;
+  if (strcmp(projector, "siddon") == 0)
+  {
+    interpolator = SiddonInterpolatorType::New().GetPointer();
+  }
+  else if (strcmp(projector, "joseph") == 0)
+  {
+    interpolator = JosephInterpolatorType::New().GetPointer();
+  }
+  else
+  {
+    std::cerr << "ERROR: Unknown projector " << projector << std::endl;
+    raytracing_exe_usage();
+  }
 
-  interpolator->Initialize();
+  // The filter copies its projection geometry to the interpolator.
+  filter->SetProjectionAngle(dtr * rprojection); // Set angle between projection central axis and -z axis
+  filter->SetFocalPointToIsocenterDistance(scd); // Set source to isocenter distance
+  filter->SetThreshold(threshold);               // Set intensity threshold, below which are ignored.
+  filter->SetTransform(transform);
 
   filter->SetInterpolator(interpolator);
 
+  // Out of some reason, the computed projection is upsided-down.
+  // Here the filter flips the images in y direction, and rescales the
+  // projections to 0-255.
+  FilterType::FlipAxesArrayType flipArray;
+  flipArray[0] = false;
+  flipArray[1] = true;
+  flipArray[2] = false;
+  filter->SetFlipAxes(flipArray);
+
+  filter->RescaleIntensityOn();
+  filter->SetOutputMinimum(0);
+  filter->SetOutputMaximum(255);
+  if (customized_window)
+  {
+    filter->AutomaticWindowOff();
+    filter->SetWindowMinimum(windowMin);
+    filter->SetWindowMaximum(windowMax);
+  }
+
 
   // The size and resolution of the output DRR image is specified via the filter.
 
@@ -517,9 +601,13 @@ GetDRRSiddonJacobsRayTracing(int argc, char * argv[])
 
   filter->SetOutputOrigin(origin);
 
-  timer.Start("DRR generation");
-  filter->Update();
-  timer.Stop("DRR generation");
+  // A streamed DRR is computed piece by piece as it is written.
+  if (divisions <= 1 || !output_name)
+  {
+    timer.Start("DRR generation");
+    filter->Update();
+    timer.Stop("DRR generation");
+  }
 
   if (verbose)
   {
@@ -534,42 +622,20 @@ GetDRRSiddonJacobsRayTracing(int argc, char * argv[])
     // The output of the filter can then be passed to a writer to
     // save the DRR image to a file.
 
-    using RescaleFilterType = itk::RescaleIntensityImageFilter<InputImageType, OutputImageType>;
-    RescaleFilterType::Pointer rescaler = RescaleFilterType::New();
-    rescaler->SetOutputMinimum(0);
-    rescaler->SetOutputMaximum(255);
-    rescaler->SetInput(filter->GetOutput());
-
-    timer.Start("DRR post-processing");
-    rescaler->Update();
-
-    // Out of some reason, the computed projection is upsided-down.
-    // Here we use a FilpImageFilter to flip the images in y direction.
-    using FlipFilterType = itk::FlipImageFilter<OutputImageType>;
-    FlipFilterType::Pointer flipFilter = FlipFilterType::New();
-
-    using FlipAxesArrayType = FlipFilterType::FlipAxesArrayType;
-    FlipAxesArrayType flipArray;
-    flipArray[0] = false;
-    flipArray[1] = true;
-
-    flipFilter->SetFlipAxes(flipArray);
-    flipFilter->SetInput(rescaler->GetOutput());
-    flipFilter->Update();
-
-    timer.Stop("DRR post-processing");
-
     using WriterType = itk::ImageFileWriter<OutputImageType>;
     WriterType::Pointer writer = WriterType::New();
 
     // Now we are ready to write the projection image.
     writer->SetFileName(output_name);
-    writer->SetInput(flipFilter->GetOutput());
+    writer->SetInput(filter->GetOutput());
+    writer->SetNumberOfStreamDivisions(divisions);
 
     try
     {
       std::cout << "Writing image: " << output_name << std::endl;
+      timer.Start("DRR writing");
       writer->Update();
+      timer.Stop("DRR writing");
     }
     catch (itk::ExceptionObject & err)
     {
@@ -577,10 +643,6 @@ GetDRRSiddonJacobsRayTracing(int argc, char * argv[])
       std::cerr << err << std::endl;
     }
   }
-  else
-  {
-    filter->Update();
-  }
 
   timer.Report();
 
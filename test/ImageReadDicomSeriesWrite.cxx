@@ -0,0 +1,193 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+/*=========================================================================
+
+ This program writes a volume as a DICOM series, one CT slice per file,
+ with the position and orientation of each slice recorded in its header.
+ It provides the test series read by DicomSeriesReadNiftiImageWrite.
+
+ This program was modified from the ITK example--ImageReadDicomSeriesWrite.cxx
+
+=========================================================================*/
+
+#include "itkGDCMImageIO.h"
+#include "itkImageFileReader.h"
+#include "itkImageSeriesWriter.h"
+#include "itkMetaDataObject.h"
+#include "itkNumericSeriesFileNames.h"
+#include "itksys/SystemTools.hxx"
+
+#include "gdcmUIDGenerator.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+void
+dicom_series_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: ImageReadDicomSeriesWrite <options> InputVolume OutputDirectory\n";
+  std::cerr << "       writes a volume as a DICOM series, one slice per file.\n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int
+ImageReadDicomSeriesWrite(int argc, char * argv[])
+{
+  char * input_name = nullptr;
+  char * output_directory = nullptr;
+
+  bool ok;
+
+  while (argc > 1)
+  {
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      dicom_series_exe_usage();
+    }
+
+    if (ok == false)
+    {
+      if (input_name == nullptr)
+      {
+        input_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else if (output_directory == nullptr)
+      {
+        output_directory = argv[1];
+        argc--;
+        argv++;
+      }
+      else
+      {
+        std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+        dicom_series_exe_usage();
+      }
+    }
+  }
+
+  if (input_name == nullptr || output_directory == nullptr)
+  {
+    dicom_series_exe_usage();
+  }
+
+  using PixelType = signed short;
+  constexpr unsigned int Dimension = 3;
+
+  using ImageType = itk::Image<PixelType, Dimension>;
+  using SliceImageType = itk::Image<PixelType, 2>;
+
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(input_name);
+
+  try
+  {
+    reader->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const ImageType *                image = reader->GetOutput();
+  const ImageType::SizeType        size = image->GetLargestPossibleRegion().GetSize();
+  const ImageType::IndexType       start = image->GetLargestPossibleRegion().GetIndex();
+  const ImageType::DirectionType & direction = image->GetDirection();
+
+  // The slices share the study and series identifiers, and each records
+  // its own position, so that the series is assembled by any DICOM reader.
+  gdcm::UIDGenerator uidGenerator;
+  const std::string  studyUID = uidGenerator.Generate();
+  const std::string  seriesUID = uidGenerator.Generate();
+
+  std::ostringstream orientation;
+  orientation << direction[0][0] << "\\" << direction[1][0] << "\\" << direction[2][0] << "\\" << direction[0][1]
+              << "\\" << direction[1][1] << "\\" << direction[2][1];
+
+  std::vector<itk::MetaDataDictionary>   dictionaries(size[2]);
+  std::vector<itk::MetaDataDictionary *> dictionaryArray(size[2]);
+  for (itk::SizeValueType k = 0; k < size[2]; ++k)
+  {
+    ImageType::IndexType index = start;
+    index[2] += k;
+    ImageType::PointType position;
+    image->TransformIndexToPhysicalPoint(index, position);
+
+    std::ostringstream positionValue;
+    positionValue << position[0] << "\\" << position[1] << "\\" << position[2];
+
+    itk::MetaDataDictionary & dictionary = dictionaries[k];
+    itk::EncapsulateMetaData<std::string>(dictionary, "0008|0060", "CT");
+    itk::EncapsulateMetaData<std::string>(dictionary, "0020|000d", studyUID);
+    itk::EncapsulateMetaData<std::string>(dictionary, "0020|000e", seriesUID);
+    itk::EncapsulateMetaData<std::string>(dictionary, "0008|0018", uidGenerator.Generate());
+    itk::EncapsulateMetaData<std::string>(dictionary, "0020|0013", std::to_string(k + 1));
+    itk::EncapsulateMetaData<std::string>(dictionary, "0020|0032", positionValue.str());
+    itk::EncapsulateMetaData<std::string>(dictionary, "0020|0037", orientation.str());
+    dictionaryArray[k] = &dictionary;
+  }
+
+  itksys::SystemTools::MakeDirectory(output_directory);
+
+  using NamesGeneratorType = itk::NumericSeriesFileNames;
+  NamesGeneratorType::Pointer namesGenerator = NamesGeneratorType::New();
+  namesGenerator->SetSeriesFormat(std::string(output_directory) + "/slice%03d.dcm");
+  namesGenerator->SetStartIndex(1);
+  namesGenerator->SetEndIndex(size[2]);
+  namesGenerator->SetIncrementIndex(1);
+
+  using ImageIOType = itk::GDCMImageIO;
+  ImageIOType::Pointer dicomIO = ImageIOType::New();
+  dicomIO->KeepOriginalUIDOn();
+
+  using SeriesWriterType = itk::ImageSeriesWriter<ImageType, SliceImageType>;
+  SeriesWriterType::Pointer seriesWriter = SeriesWriterType::New();
+  seriesWriter->SetInput(image);
+  seriesWriter->SetImageIO(dicomIO);
+  seriesWriter->SetFileNames(namesGenerator->GetFileNames());
+  seriesWriter->SetMetaDataDictionaryArray(&dictionaryArray);
+
+  try
+  {
+    seriesWriter->Update();
+  }
+  catch (itk::ExceptionObject & ex)
+  {
+    std::cerr << ex << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Wrote " << size[2] << " slices to " << output_directory << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,435 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+/*=========================================================================
+
+ This program measures the time taken to compute a batch of DRRs of a CT
+ volume in random poses by a ProjectionBatchCalculator, writing them into
+ a preallocated image as it would into a NumPy array, and by a
+ RayCastProjectionImageFilter updated for each pose in turn. Both must
+ give the same DRRs. With -context, the batch reads the volume from a
+ ProjectionVolumeContext set on its interpolator, and the filter from the
+ volume itself.
+
+=========================================================================*/
+
+#include "itkTimeProbesCollectorBase.h"
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+
+#include "itkEuler3DTransform.h"
+#include "itkJosephRayCastInterpolateImageFunction.h"
+#include "itkProjectionBatchCalculator.h"
+#include "itkRayCastProjectionImageFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+void
+batchbenchmark_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: ProjectionBatchBenchmark <options> [input]\n";
+  std::cerr << "       compares the computation of a batch of DRRs in random poses at once\n";
+  std::cerr << "       and one pose after the other. \n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  std::cerr << "       <-v>                     Verbose output [default: no]\n";
+  std::cerr << "       <-res float float>       DRR Pixel spacing in isocenter plane in mm [default: 4mm 4mm]  \n";
+  std::cerr << "       <-size int int>          Size of DRR in number of pixels [default: 64x64]  \n";
+  std::cerr
+    << "       <-scd float>             Source to isocenter (i.e., 3D image center) distance in mm [default: 1000mm]\n";
+  std::cerr << "       <-rp float>              Projection angle in degrees [default: 0]\n";
+  std::cerr << "       <-threshold float>       CT intensity threshold, below which are ignored [default: 0]\n";
+  std::cerr << "       <-projector name>        Ray casting method, siddon (exact) or joseph (fast) "
+               "[default: siddon]\n";
+  std::cerr << "       <-context>               Batch projecting the volume context set on its interpolator\n";
+  std::cerr << "       <-n int>                 Number of poses of the batch [default: 100]\n\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int
+ProjectionBatchBenchmark(int argc, char * argv[])
+{
+  char * input_name = nullptr;
+
+  bool ok;
+  bool verbose = false;
+  bool useContext = false;
+
+  float rprojection = 0.; // Projection angle in degrees
+
+  float scd = 1000.; // Source to isocenter distance
+
+  float im_sx = 4.; // Pixel spacing of the DRRs in the isocenter plane in mm
+  float im_sy = 4.;
+
+  int dx = 64; // Size of the DRRs in number of pixels
+  int dy = 64;
+
+  float threshold = 0.;
+
+  const char * projector = "siddon";
+
+  int numberOfPoses = 100;
+
+  // Create a timer to record calculation time.
+  itk::TimeProbesCollectorBase timer;
+
+  while (argc > 1)
+  {
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      batchbenchmark_exe_usage();
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-v") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      verbose = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-context") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      useContext = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-threshold") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      threshold = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-projector") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      projector = argv[1];
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-n") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      numberOfPoses = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-rp") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      rprojection = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-res") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      im_sx = atof(argv[1]);
+      argc--;
+      argv++;
+      im_sy = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-size") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      dx = atoi(argv[1]);
+      argc--;
+      argv++;
+      dy = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-scd") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      scd = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if (ok == false)
+    {
+      if (input_name == nullptr)
+      {
+        input_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else
+      {
+        std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+        batchbenchmark_exe_usage();
+      }
+    }
+  }
+
+  if (input_name == nullptr)
+  {
+    std::cerr << "Input image file missing !" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (strcmp(projector, "siddon") != 0 && strcmp(projector, "joseph") != 0)
+  {
+    std::cerr << "ERROR: Unknown projector " << projector << std::endl;
+    batchbenchmark_exe_usage();
+  }
+
+  constexpr unsigned int Dimension = 3;
+  using InputPixelType = short;
+  using OutputPixelType = float;
+
+  using InputImageType = itk::Image<InputPixelType, Dimension>;
+  using OutputImageType = itk::Image<OutputPixelType, Dimension>;
+
+  using ReaderType = itk::ImageFileReader<InputImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(input_name);
+
+  try
+  {
+    reader->Update();
+  }
+  catch (itk::ExceptionObject & err)
+  {
+    std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  InputImageType::Pointer image = reader->GetOutput();
+
+  // The projection geometry assumes that the origin of the CT image is (0,0,0).
+  InputImageType::PointType ctOrigin;
+  ctOrigin.Fill(0.0);
+  image->SetOrigin(ctOrigin);
+
+  // constant for converting degrees into radians
+  const double dtr = (atan(1.0) * 4.0) / 180.0;
+
+  // Random poses about the center of the volume, as for training data
+  using CalculatorType = itk::ProjectionBatchCalculator<InputImageType, OutputPixelType>;
+  using PoseImageType = CalculatorType::PoseImageType;
+
+  PoseImageType::SizeType poseSize;
+  poseSize[0] = 6;
+  poseSize[1] = numberOfPoses;
+  PoseImageType::Pointer poses = PoseImageType::New();
+  poses->SetRegions(poseSize);
+  poses->Allocate();
+
+  using PoseType = PoseImageType::PixelType;
+  std::mt19937                             generator(42);
+  std::uniform_real_distribution<PoseType> rotation(-10.0 * dtr, 10.0 * dtr);
+  std::uniform_real_distribution<PoseType> translation(-10.0, 10.0);
+  PoseType *                               pose = poses->GetBufferPointer();
+  for (int p = 0; p < numberOfPoses; ++p, pose += 6)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      pose[i] = rotation(generator);
+      pose[3 + i] = translation(generator);
+    }
+  }
+
+  // The DRRs of the batch, preallocated by the caller
+  OutputImageType::SizeType batchSize;
+  batchSize[0] = dx;
+  batchSize[1] = dy;
+  batchSize[2] = numberOfPoses;
+  OutputImageType::Pointer drrs = OutputImageType::New();
+  drrs->SetRegions(batchSize);
+  drrs->Allocate();
+
+  using InterpolatorType = itk::ProjectionInterpolateImageFunction<InputImageType, double>;
+  const auto newInterpolator = [projector]() -> InterpolatorType::Pointer {
+    if (strcmp(projector, "joseph") == 0)
+    {
+      return itk::JosephRayCastInterpolateImageFunction<InputImageType, double>::New().GetPointer();
+    }
+    return itk::SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>::New().GetPointer();
+  };
+  InterpolatorType::Pointer interpolator = newInterpolator();
+
+  // The volume context is set on the interpolator only, so that the batch
+  // must pass it on to the copies casting the rays.
+  InterpolatorType::VolumeContextType::Pointer volumeContext;
+  if (useContext)
+  {
+    volumeContext = InterpolatorType::VolumeContextType::New();
+    volumeContext->SetInputImage(image);
+    volumeContext->SetThreshold(threshold);
+    interpolator->SetVolumeContext(volumeContext);
+  }
+
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetInputImage(image);
+  calculator->SetPoses(poses);
+  calculator->SetOutput(drrs);
+  calculator->SetInterpolator(interpolator);
+  calculator->SetProjectionAngle(dtr * rprojection);
+  calculator->SetFocalPointToIsocenterDistance(scd);
+  calculator->SetThreshold(threshold);
+
+  CalculatorType::DetectorSizeType detectorSize;
+  detectorSize[0] = dx;
+  detectorSize[1] = dy;
+  calculator->SetDetectorSize(detectorSize);
+
+  CalculatorType::DetectorSpacingType detectorSpacing;
+  detectorSpacing[0] = im_sx;
+  detectorSpacing[1] = im_sy;
+  calculator->SetDetectorSpacing(detectorSpacing);
+
+  // The same DRRs one pose after the other
+  using TransformType = itk::Euler3DTransform<double>;
+  TransformType::Pointer transform = TransformType::New();
+  transform->SetComputeZYX(true);
+
+  const InputImageType::SpacingType imRes = image->GetSpacing();
+  const InputImageType::SizeType    imSize = image->GetBufferedRegion().GetSize();
+  TransformType::InputPointType     isocenter;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    isocenter[i] = imRes[i] * static_cast<double>(imSize[i]) / 2.0;
+  }
+  transform->SetCenter(isocenter);
+
+  OutputImageType::SizeType size;
+  size[0] = dx;
+  size[1] = dy;
+  size[2] = 1;
+
+  double spacing[Dimension];
+  spacing[0] = im_sx;
+  spacing[1] = im_sy;
+  spacing[2] = 1.0;
+
+  double origin[Dimension];
+  origin[0] = -im_sx * ((double)dx - 1.) / 2.;
+  origin[1] = -im_sy * ((double)dy - 1.) / 2.;
+  origin[2] = -scd;
+
+  using FilterType = itk::RayCastProjectionImageFilter<InputImageType, OutputImageType>;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetInterpolator(useContext ? newInterpolator() : interpolator);
+  filter->SetTransform(transform);
+  filter->SetProjectionAngle(dtr * rprojection);
+  filter->SetFocalPointToIsocenterDistance(scd);
+  filter->SetThreshold(threshold);
+  filter->SetSize(size);
+  filter->SetOutputSpacing(spacing);
+  filter->SetOutputOrigin(origin);
+
+  double maximumDifference = 0.0;
+  double maximumValue = 0.0;
+  try
+  {
+    timer.Start("batch DRRs");
+    calculator->Compute();
+    timer.Stop("batch DRRs");
+
+    const itk::SizeValueType pixelsPerDRR = static_cast<itk::SizeValueType>(dx) * dy;
+    for (int p = 0; p < numberOfPoses; ++p)
+    {
+      TransformType::ParametersType parameters(6);
+      for (unsigned int i = 0; i < 6; ++i)
+      {
+        parameters[i] = poses->GetBufferPointer()[6 * p + i];
+      }
+      transform->SetParameters(parameters);
+
+      timer.Start("single DRRs");
+      filter->Update();
+      timer.Stop("single DRRs");
+
+      const OutputPixelType * single = filter->GetOutput()->GetBufferPointer();
+      const OutputPixelType * batch = drrs->GetBufferPointer() + p * pixelsPerDRR;
+      for (itk::SizeValueType k = 0; k < pixelsPerDRR; ++k)
+      {
+        maximumDifference = std::max(maximumDifference, std::fabs(static_cast<double>(single[k]) - batch[k]));
+        maximumValue = std::max(maximumValue, std::fabs(static_cast<double>(single[k])));
+      }
+    }
+  }
+  catch (itk::ExceptionObject & err)
+  {
+    std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (verbose)
+  {
+    std::cout << "Calculator: " << calculator << std::endl;
+  }
+
+  std::cout << "Maximum difference: " << maximumDifference << std::endl;
+  timer.Report();
+
+  if (volumeContext && !volumeContext->IsUpToDate())
+  {
+    std::cerr << "ERROR: The batch did not use the volume context of its interpolator" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (maximumDifference > 1e-5 * std::max(maximumValue, 1.0))
+  {
+    std::cerr << "ERROR: The DRRs of the batch differ from those computed one pose after the other" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,243 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+/*=========================================================================
+
+ This program measures the number of rays cast per second through the
+ attenuation volume of a ProjectionVolumeContext allocated on small pages
+ and on huge pages, for synthetic volumes of several sizes. The rays go
+ through random pixels of the detector, so that consecutive rays read
+ distant parts of the volume as in a sparse or masked metric evaluation.
+ Both allocations must give the same projections.
+
+=========================================================================*/
+
+#include "itkTimeProbe.h"
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "itkEuler3DTransform.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+#include "itkProjectionVolumeContext.h"
+
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+
+void
+hugepage_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: ProjectionHugePageBenchmark <options>\n";
+  std::cerr << "       compares the ray casting throughput on volumes allocated on small\n";
+  std::cerr << "       and on huge pages. \n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  std::cerr << "       <-sizes int [int ...]>   Voxels along each side of the volumes [default: 128 256 384]\n";
+  std::cerr << "       <-rays int>              Number of rays cast through each volume [default: 200000]\n";
+  std::cerr << "       <-n int>                 Number of timed repetitions [default: 3]\n";
+  std::cerr
+    << "       <-scd float>             Source to isocenter (i.e., 3D image center) distance in mm [default: 1000mm]\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int
+ProjectionHugePageBenchmark(int argc, char * argv[])
+{
+  bool ok;
+
+  std::vector<int> sizes;
+  int              numberOfRays = 200000;
+  int              repeats = 3;
+  float            scd = 1000.; // Source to isocenter distance
+
+  while (argc > 1)
+  {
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      hugepage_exe_usage();
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-sizes") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      while (argc > 1 && argv[1][0] != '-')
+      {
+        sizes.push_back(atoi(argv[1]));
+        argc--;
+        argv++;
+      }
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-rays") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      numberOfRays = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-n") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      repeats = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-scd") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      scd = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if (ok == false)
+    {
+      std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+      hugepage_exe_usage();
+    }
+  }
+
+  if (sizes.empty())
+  {
+    sizes = { 128, 256, 384 };
+  }
+
+  constexpr unsigned int Dimension = 3;
+  using InputPixelType = short;
+  using InputImageType = itk::Image<InputPixelType, Dimension>;
+
+  using InterpolatorType = itk::SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
+  using VolumeContextType = itk::ProjectionVolumeContext<InputImageType>;
+  using TransformType = itk::Euler3DTransform<double>;
+
+  std::cout << "Huge page size: " << itk::ProjectionHugePageAllocator::GetHugePageSize() << " bytes" << std::endl;
+  std::cout << std::setw(8) << "Size" << std::setw(12) << "Volume MB" << std::setw(12) << "Huge MB" << std::setw(16)
+            << "Small rays/s" << std::setw(16) << "Huge rays/s" << std::setw(10) << "Speedup" << std::endl;
+
+  bool identical = true;
+  for (const int n : sizes)
+  {
+    // Ellipsoid of soft tissue with a denser core, 256 mm across whatever
+    // the number of voxels.
+    InputImageType::SizeType size;
+    size.Fill(n);
+    InputImageType::SpacingType spacing;
+    spacing.Fill(256.0 / n);
+
+    InputImageType::Pointer image = InputImageType::New();
+    image->SetRegions(size);
+    image->SetSpacing(spacing);
+    image->Allocate();
+
+    itk::ImageRegionIteratorWithIndex<InputImageType> it(image, image->GetBufferedRegion());
+    for (; !it.IsAtEnd(); ++it)
+    {
+      double radius = 0.0;
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        const double x = (it.GetIndex()[i] + 0.5) / n - 0.5;
+        radius += x * x / (i == 2 ? 0.2 : 0.16);
+      }
+      it.Set(radius < 0.25 ? 2000 : (radius < 1.0 ? 1000 : 0));
+    }
+
+    TransformType::Pointer transform = TransformType::New();
+    transform->SetComputeZYX(true);
+    TransformType::InputPointType isocenter;
+    isocenter.Fill(128.0);
+    transform->SetCenter(isocenter);
+
+    // Random pixels of a detector covering the volume in the isocenter plane
+    std::mt19937                              generator(n);
+    std::uniform_real_distribution<double>    position(-150.0, 150.0);
+    std::vector<InterpolatorType::PointType>  points(numberOfRays);
+    std::vector<InterpolatorType::OutputType> values[2];
+    for (InterpolatorType::PointType & point : points)
+    {
+      point[0] = position(generator);
+      point[1] = position(generator);
+      point[2] = -scd;
+    }
+
+    double             raysPerSecond[2];
+    itk::SizeValueType hugePageBytes = 0;
+    for (unsigned int k = 0; k < 2; ++k)
+    {
+      VolumeContextType::Pointer context = VolumeContextType::New();
+      context->SetInputImage(image);
+      context->SetUseHugePages(k == 1);
+      context->Update();
+      if (k == 1)
+      {
+        hugePageBytes = context->GetHugePageBytes();
+      }
+
+      InterpolatorType::Pointer interpolator = InterpolatorType::New();
+      interpolator->SetInputImage(image);
+      interpolator->SetFocalPointToIsocenterDistance(scd);
+      interpolator->SetTransform(transform);
+      interpolator->SetVolumeContext(context);
+      interpolator->Initialize();
+
+      values[k].resize(numberOfRays);
+      itk::TimeProbe probe;
+      for (int r = 0; r < repeats; ++r)
+      {
+        probe.Start();
+        interpolator->EvaluateRays(points.data(), numberOfRays, values[k].data());
+        probe.Stop();
+      }
+      raysPerSecond[k] = numberOfRays / probe.GetMinimum();
+    }
+    identical &= values[0] == values[1];
+
+    const double volumeMegabytes = static_cast<double>(image->GetBufferedRegion().GetNumberOfPixels()) * sizeof(float) /
+                                   (1024.0 * 1024.0);
+    std::cout << std::setw(8) << n << std::setw(12) << std::fixed << std::setprecision(1) << volumeMegabytes
+              << std::setw(12) << hugePageBytes / (1024.0 * 1024.0) << std::setw(16) << std::setprecision(0)
+              << raysPerSecond[0] << std::setw(16) << raysPerSecond[1] << std::setw(10) << std::setprecision(2)
+              << raysPerSecond[1] / raysPerSecond[0] << std::endl;
+  }
+
+  if (!identical)
+  {
+    std::cerr << "ERROR: The projections through the huge page volume differ" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,507 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+/*=========================================================================
+
+ This program measures the latency of the parallel loops of a registration
+ with the ITK multithreader and with a persistent ProjectionThreadPool: an
+ empty loop, which is the dispatch overhead alone, a small DRR computed by
+ RayCastProjectionImageFilter, and an evaluation of the normalized
+ correlation metric on two small DRRs. Both paths must give the same DRRs
+ and metric values.
+
+ With -numa, the threads of the pool are spread over the NUMA nodes and the
+ projectors of both paths read the volume from a ProjectionVolumeContext
+ replicated on each node.
+
+=========================================================================*/
+
+#include "itkTimeProbesCollectorBase.h"
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkMultiThreaderBase.h"
+
+#include "itkEuler3DTransform.h"
+#include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+#include "itkRayCastProjectionImageFilter.h"
+#include "itkNormalizedCorrelationTwoImageToOneImageMetric.h"
+#include "itkProjectionThreadPool.h"
+#include "itkProjectionVolumeContext.h"
+
+#include <cmath>
+#include <vector>
+
+
+void
+threadpool_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: ProjectionThreadPoolBenchmark <options> [input]\n";
+  std::cerr << "       compares the latency of the DRR and metric computations on the ITK\n";
+  std::cerr << "       multithreader and on a persistent thread pool. \n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  std::cerr << "       <-v>                     Verbose output [default: no]\n";
+  std::cerr << "       <-res float float>       DRR Pixel spacing in isocenter plane in mm [default: 4mm 4mm]  \n";
+  std::cerr << "       <-size int int>          Size of DRR in number of pixels [default: 64x64]  \n";
+  std::cerr
+    << "       <-scd float>             Source to isocenter (i.e., 3D image center) distance in mm [default: 1000mm]\n";
+  std::cerr << "       <-iso float float float> Continous voxel indices of CT isocenter (center of rotation and "
+               "projection center)\n";
+  std::cerr << "       <-rp float>              Projection angle of the first DRR in degrees [default: 0]\n";
+  std::cerr << "       <-threshold float>       CT intensity threshold, below which are ignored [default: 0]\n";
+  std::cerr << "       <-threads int>           Number of threads of the pool besides the calling thread\n";
+  std::cerr << "       <-spin int>              Number of checks of an idle thread before it sleeps [default: 20000]\n";
+  std::cerr << "       <-pin>                   Bind the threads of the pool to a core each\n";
+  std::cerr << "       <-numa>                  Bind the threads of the pool to NUMA nodes and replicate the volume\n";
+  std::cerr << "       <-n int>                 Number of timed loops for each method [default: 100]\n\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int
+ProjectionThreadPoolBenchmark(int argc, char * argv[])
+{
+  char * input_name = nullptr;
+
+  bool ok;
+  bool verbose = false;
+  bool customized_iso = false; // Flag for customized 3D image isocenter positions
+
+  float rprojection = 0.; // Projection angle in degrees
+
+  // The pixel indices of the isocenter
+  float cx = 0.;
+  float cy = 0.;
+  float cz = 0.;
+
+  float scd = 1000.; // Source to isocenter distance
+
+  float im_sx = 4.; // Pixel spacing of the DRRs in the isocenter plane in mm
+  float im_sy = 4.;
+
+  int dx = 64; // Size of the DRRs in number of pixels
+  int dy = 64;
+
+  float threshold = 0.;
+
+  int  repeats = 100;
+  int  numberOfThreads = -1; // Default of the pool
+  int  spinCount = -1;       // Default of the pool
+  bool pinThreads = false;
+  bool numa = false;
+
+  // Create a timer to record calculation time.
+  itk::TimeProbesCollectorBase timer;
+
+  while (argc > 1)
+  {
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      threadpool_exe_usage();
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-v") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      verbose = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-threshold") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      threshold = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-threads") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      numberOfThreads = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-spin") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      spinCount = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-pin") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      pinThreads = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-numa") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      numa = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-n") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      repeats = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-iso") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      cx = atof(argv[1]);
+      argc--;
+      argv++;
+      cy = atof(argv[1]);
+      argc--;
+      argv++;
+      cz = atof(argv[1]);
+      argc--;
+      argv++;
+      customized_iso = true;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-rp") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      rprojection = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-res") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      im_sx = atof(argv[1]);
+      argc--;
+      argv++;
+      im_sy = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-size") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      dx = atoi(argv[1]);
+      argc--;
+      argv++;
+      dy = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-scd") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      scd = atof(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if (ok == false)
+    {
+      if (input_name == nullptr)
+      {
+        input_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else
+      {
+        std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+        threadpool_exe_usage();
+      }
+    }
+  }
+
+  if (input_name == nullptr)
+  {
+    std::cerr << "Input image file missing !" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  constexpr unsigned int Dimension = 3;
+  using InputPixelType = short;
+  using OutputPixelType = float;
+
+  using InputImageType = itk::Image<InputPixelType, Dimension>;
+  using OutputImageType = itk::Image<OutputPixelType, Dimension>;
+
+  using ReaderType = itk::ImageFileReader<InputImageType>;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(input_name);
+
+  try
+  {
+    reader->Update();
+  }
+  catch (itk::ExceptionObject & err)
+  {
+    std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  InputImageType::Pointer image = reader->GetOutput();
+
+  // The projection geometry assumes that the origin of the CT image is (0,0,0).
+  InputImageType::PointType ctOrigin;
+  ctOrigin.Fill(0.0);
+  image->SetOrigin(ctOrigin);
+
+  // constant for converting degrees into radians
+  const double dtr = (atan(1.0) * 4.0) / 180.0;
+
+  using TransformType = itk::Euler3DTransform<double>;
+  TransformType::Pointer transform = TransformType::New();
+  transform->SetComputeZYX(true);
+
+  const InputImageType::SpacingType imRes = image->GetSpacing();
+  const InputImageType::SizeType    imSize = image->GetBufferedRegion().GetSize();
+
+  // The center of the image is the isocenter unless given by the user.
+  const double                  isocenterIndex[Dimension] = { cx, cy, cz };
+  TransformType::InputPointType isocenter;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    isocenter[i] = customized_iso ? imRes[i] * isocenterIndex[i] : imRes[i] * static_cast<double>(imSize[i]) / 2.0;
+  }
+  transform->SetCenter(isocenter);
+
+  // The persistent pool of threads
+  itk::ProjectionThreadPool::Pointer pool = itk::ProjectionThreadPool::New();
+  if (numberOfThreads >= 0)
+  {
+    pool->SetNumberOfThreads(numberOfThreads);
+  }
+  if (spinCount >= 0)
+  {
+    pool->SetSpinCount(spinCount);
+  }
+  pool->SetPinThreads(pinThreads);
+  pool->SetBindThreadsToNumaNodes(numa);
+
+  std::cout << "NUMA nodes: " << itk::ProjectionNumaTopology::GetNumberOfNodes() << std::endl;
+
+  const unsigned int numberOfWorkUnits = pool->GetNumberOfWorkUnits();
+  std::cout << "Work units: " << numberOfWorkUnits << std::endl;
+
+  // The grid of the DRRs, centred on the central axis.
+  OutputImageType::SizeType size;
+  size[0] = dx;
+  size[1] = dy;
+  size[2] = 1;
+
+  double spacing[Dimension];
+  spacing[0] = im_sx;
+  spacing[1] = im_sy;
+  spacing[2] = 1.0;
+
+  double origin[Dimension];
+  origin[0] = -im_sx * ((double)dx - 1.) / 2.;
+  origin[1] = -im_sy * ((double)dy - 1.) / 2.;
+  origin[2] = -scd;
+
+  // DRRs on the ITK multithreader (projector[0] and [2]) and on the pool
+  // (projector[1]), at the projection angle and 90 degrees further.
+  using ProjectorType = itk::RayCastProjectionImageFilter<InputImageType, OutputImageType>;
+  ProjectorType::Pointer projector[3];
+  for (unsigned int k = 0; k < 3; ++k)
+  {
+    projector[k] = ProjectorType::New();
+    projector[k]->SetInput(image);
+    projector[k]->SetProjectionAngle(dtr * (rprojection + (k == 2 ? 90.0 : 0.0)));
+    projector[k]->SetFocalPointToIsocenterDistance(scd);
+    projector[k]->SetThreshold(threshold);
+    projector[k]->SetTransform(transform);
+    projector[k]->SetSize(size);
+    projector[k]->SetOutputSpacing(spacing);
+    projector[k]->SetOutputOrigin(origin);
+    projector[k]->SetNumberOfWorkUnits(numberOfWorkUnits);
+  }
+  projector[1]->GetModifiableTileScheduler()->SetThreadPool(pool);
+
+  // Volume replicated on each NUMA node, read by the projectors of both
+  // paths so that their results can still be compared.
+  using VolumeContextType = itk::ProjectionVolumeContext<InputImageType>;
+  VolumeContextType::Pointer context;
+  if (numa)
+  {
+    context = VolumeContextType::New();
+    context->SetInputImage(image);
+    context->SetThreshold(threshold);
+    context->ReplicatePerNumaNodeOn();
+    context->Update();
+    std::cout << "Volume replicas: " << context->GetNumberOfReplicas() << std::endl;
+    for (unsigned int k = 0; k < 3; ++k)
+    {
+      projector[k]->GetModifiableInterpolator()->SetVolumeContext(context);
+    }
+  }
+
+  // Metric between the two DRRs and the CT, without change of the pose
+  using MetricType = itk::NormalizedCorrelationTwoImageToOneImageMetric<OutputImageType, InputImageType>;
+  using InterpolatorType = itk::SiddonJacobsRayCastInterpolateImageFunction<InputImageType, double>;
+  MetricType::Pointer       metric = MetricType::New();
+  InterpolatorType::Pointer interpolator[2];
+  for (unsigned int k = 0; k < 2; ++k)
+  {
+    interpolator[k] = InterpolatorType::New();
+    interpolator[k]->SetProjectionAngle(dtr * (rprojection + 90.0 * k));
+    interpolator[k]->SetFocalPointToIsocenterDistance(scd);
+    interpolator[k]->SetThreshold(threshold);
+    interpolator[k]->SetTransform(transform);
+    interpolator[k]->Initialize();
+  }
+  metric->ComputeGradientOff();
+  metric->SetSubtractMean(true);
+  metric->SetTransform(transform);
+  metric->SetMovingImage(image);
+  metric->SetInterpolator1(interpolator[0]);
+  metric->SetInterpolator2(interpolator[1]);
+  metric->SetVolumeContext(context);
+  metric->GetModifiableTileScheduler()->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+  itk::MultiThreaderBase::Pointer multiThreader = itk::MultiThreaderBase::New();
+  multiThreader->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+  bool                identical = true;
+  std::vector<double> values[2];
+  try
+  {
+    // Dispatch of an empty loop
+    for (int n = 0; n < repeats; ++n)
+    {
+      timer.Start("itk empty loop");
+      multiThreader->ParallelizeArray(0, numberOfWorkUnits, [](itk::SizeValueType) {}, nullptr);
+      timer.Stop("itk empty loop");
+
+      timer.Start("pool empty loop");
+      pool->Run(numberOfWorkUnits, [](itk::SizeValueType) {});
+      timer.Stop("pool empty loop");
+    }
+
+    // Small DRRs
+    for (int n = 0; n < repeats; ++n)
+    {
+      projector[0]->Modified();
+      timer.Start("itk DRR");
+      projector[0]->Update();
+      timer.Stop("itk DRR");
+
+      projector[1]->Modified();
+      timer.Start("pool DRR");
+      projector[1]->Update();
+      timer.Stop("pool DRR");
+    }
+    projector[2]->Update();
+
+    using IteratorType = itk::ImageRegionConstIterator<OutputImageType>;
+    IteratorType it0(projector[0]->GetOutput(), projector[0]->GetOutput()->GetBufferedRegion());
+    IteratorType it1(projector[1]->GetOutput(), projector[1]->GetOutput()->GetBufferedRegion());
+    for (; !it0.IsAtEnd(); ++it0, ++it1)
+    {
+      identical &= it0.Get() == it1.Get();
+    }
+
+    // Metric evaluations about the pose of the DRRs
+    metric->SetFixedImage1(projector[0]->GetOutput());
+    metric->SetFixedImage2(projector[2]->GetOutput());
+    metric->SetFixedImageRegion1(projector[0]->GetOutput()->GetBufferedRegion());
+    metric->SetFixedImageRegion2(projector[2]->GetOutput()->GetBufferedRegion());
+    metric->Initialize();
+
+    const MetricType::ParametersType initialParameters = transform->GetParameters();
+    const char * const               labels[2] = { "itk metric", "pool metric" };
+    for (unsigned int k = 0; k < 2; ++k)
+    {
+      metric->GetModifiableTileScheduler()->SetThreadPool(k == 0 ? nullptr : pool.GetPointer());
+      for (int n = 0; n < repeats; ++n)
+      {
+        // Step along the translations, as an optimizer would
+        MetricType::ParametersType parameters = initialParameters;
+        parameters[3 + n % 3] += 0.1 * (n % 7);
+
+        timer.Start(labels[k]);
+        values[k].push_back(metric->GetValue(parameters));
+        timer.Stop(labels[k]);
+      }
+    }
+    transform->SetParameters(initialParameters);
+  }
+  catch (itk::ExceptionObject & err)
+  {
+    std::cerr << "ERROR: ExceptionObject caught !" << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  identical &= values[0] == values[1];
+
+  if (verbose)
+  {
+    std::cout << "Thread pool: " << pool << std::endl;
+    std::cout << "Metric: " << metric << std::endl;
+  }
+
+  timer.Report();
+
+  if (!identical)
+  {
+    std::cerr << "ERROR: The results on the thread pool differ from those on the ITK multithreader" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,269 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+/*=========================================================================
+
+ This program writes a volume as a compressed NIfTI image twice: with
+ ImageFileWriter and NiftiImageIO, which compresses the whole buffer on a
+ single thread, and with StreamingNiftiImageFileWriter, which streams the
+ volume by slabs and compresses blocks of each slab in parallel. It reports
+ the time taken by each writer, and reads both files back to check that
+ they hold the same image.
+
+=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkNiftiImageIO.h"
+#include "itkStreamingNiftiImageFileWriter.h"
+#include "itkTimeProbe.h"
+
+#include <cmath>
+#include <iomanip>
+
+
+void
+niftiwriter_exe_usage()
+{
+  std::cerr << "\n";
+  std::cerr << "Usage: StreamingNiftiWriterBenchmark <options> InputVolume OutputFile\n";
+  std::cerr << "       compares the streaming, parallel NIfTI writer with ImageFileWriter. OutputFile\n";
+  std::cerr << "       is written by the streaming writer, OutputFile with the suffix _reference by\n";
+  std::cerr << "       ImageFileWriter. \n\n";
+  std::cerr << "   where <options> is one or more of the following:\n\n";
+  std::cerr << "       <-h>                     Display (this) usage information\n";
+  std::cerr << "       <-divisions int>         Number of slabs the volume is streamed in [default: 8]\n";
+  std::cerr << "       <-block int>             Size of the blocks compressed in parallel in kB [default: 1024]\n";
+  std::cerr << "       <-level int>             Compression level, 0 to 9 [default: 6]\n";
+  std::cerr << "       <-threads int>           Number of compression threads besides the calling thread "
+               "[default: ITK global default number of threads - 1]\n";
+  std::cerr << "       <-n int>                 Number of timed repetitions [default: 3]\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int
+StreamingNiftiWriterBenchmark(int argc, char * argv[])
+{
+  char * input_name = nullptr;
+  char * output_name = nullptr;
+
+  bool ok;
+
+  unsigned int divisions = 8;
+  int          blockKilobytes = 1024;
+  int          level = 6;
+  int          threads = -1;
+  int          repeats = 3;
+
+  while (argc > 1)
+  {
+    ok = false;
+
+    if ((ok == false) && (strcmp(argv[1], "-h") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      niftiwriter_exe_usage();
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-divisions") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      divisions = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-block") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      blockKilobytes = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-level") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      level = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-threads") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      threads = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-n") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      repeats = atoi(argv[1]);
+      argc--;
+      argv++;
+    }
+
+    if (ok == false)
+    {
+      if (input_name == nullptr)
+      {
+        input_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else if (output_name == nullptr)
+      {
+        output_name = argv[1];
+        argc--;
+        argv++;
+      }
+      else
+      {
+        std::cerr << "ERROR: Can not parse argument " << argv[1] << std::endl;
+        niftiwriter_exe_usage();
+      }
+    }
+  }
+
+  if (input_name == nullptr || output_name == nullptr)
+  {
+    niftiwriter_exe_usage();
+  }
+
+  constexpr unsigned int Dimension = 3;
+  using PixelType = short;
+  using ImageType = itk::Image<PixelType, Dimension>;
+
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  using WriterType = itk::ImageFileWriter<ImageType>;
+  using StreamingWriterType = itk::StreamingNiftiImageFileWriter<ImageType>;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(input_name);
+  reader->Update();
+  ImageType::Pointer image = reader->GetOutput();
+  image->DisconnectPipeline();
+
+  // The reference file is named after the output file, the suffix being
+  // inserted before the extension.
+  std::string       referenceName = output_name;
+  const std::string extension = ".nii.gz";
+  if (referenceName.size() > extension.size() &&
+      referenceName.compare(referenceName.size() - extension.size(), extension.size(), extension) == 0)
+  {
+    referenceName.insert(referenceName.size() - extension.size(), "_reference");
+  }
+  else
+  {
+    referenceName += "_reference.nii.gz";
+  }
+
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(itk::NiftiImageIO::New());
+  writer->SetFileName(referenceName);
+  writer->SetInput(image);
+  writer->SetUseCompression(true);
+
+  StreamingWriterType::Pointer streamingWriter = StreamingWriterType::New();
+  streamingWriter->SetFileName(output_name);
+  streamingWriter->SetInput(image);
+  streamingWriter->SetNumberOfStreamDivisions(divisions);
+  streamingWriter->SetBlockSize(static_cast<itk::SizeValueType>(blockKilobytes) * 1024);
+  streamingWriter->SetCompressionLevel(level);
+  if (threads >= 0)
+  {
+    streamingWriter->GetModifiableThreadPool()->SetNumberOfThreads(threads);
+  }
+
+  itk::TimeProbe referenceProbe;
+  itk::TimeProbe streamingProbe;
+  for (int r = 0; r < repeats; ++r)
+  {
+    referenceProbe.Start();
+    writer->Update();
+    referenceProbe.Stop();
+
+    streamingProbe.Start();
+    streamingWriter->Update();
+    streamingProbe.Stop();
+  }
+
+  const double megabytes =
+    static_cast<double>(image->GetBufferedRegion().GetNumberOfPixels()) * sizeof(PixelType) / (1024.0 * 1024.0);
+  std::cout << std::fixed << std::setprecision(1) << "Volume: " << megabytes << " MB" << std::endl;
+  std::cout << std::setw(20) << "Writer" << std::setw(12) << "Seconds" << std::setw(12) << "MB/s" << std::endl;
+  std::cout << std::setprecision(3) << std::setw(20) << "ImageFileWriter" << std::setw(12)
+            << referenceProbe.GetMinimum() << std::setw(12) << std::setprecision(1)
+            << megabytes / referenceProbe.GetMinimum() << std::endl;
+  std::cout << std::setprecision(3) << std::setw(20) << "Streaming" << std::setw(12) << streamingProbe.GetMinimum()
+            << std::setw(12) << std::setprecision(1) << megabytes / streamingProbe.GetMinimum() << std::endl;
+
+  // Both files must hold the same image.
+  ReaderType::Pointer referenceReader = ReaderType::New();
+  referenceReader->SetFileName(referenceName);
+  referenceReader->Update();
+  ReaderType::Pointer streamingReader = ReaderType::New();
+  streamingReader->SetFileName(output_name);
+  streamingReader->Update();
+
+  const ImageType * reference = referenceReader->GetOutput();
+  const ImageType * streamed = streamingReader->GetOutput();
+  bool              identical = reference->GetLargestPossibleRegion() == streamed->GetLargestPossibleRegion();
+  for (unsigned int i = 0; identical && i < Dimension; ++i)
+  {
+    identical &= std::abs(reference->GetSpacing()[i] - streamed->GetSpacing()[i]) < 1e-4 &&
+                 std::abs(reference->GetOrigin()[i] - streamed->GetOrigin()[i]) < 1e-3;
+    for (unsigned int j = 0; j < Dimension; ++j)
+    {
+      identical &= std::abs(reference->GetDirection()[i][j] - streamed->GetDirection()[i][j]) < 1e-4;
+    }
+  }
+  if (identical)
+  {
+    itk::ImageRegionConstIterator<ImageType> referenceIt(reference, reference->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<ImageType> streamedIt(streamed, streamed->GetLargestPossibleRegion());
+    for (; identical && !referenceIt.IsAtEnd(); ++referenceIt, ++streamedIt)
+    {
+      identical = referenceIt.Get() == streamedIt.Get();
+    }
+  }
+
+  if (!identical)
+  {
+    std::cerr << "ERROR: The image written by the streaming writer differs" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
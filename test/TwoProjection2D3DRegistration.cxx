@@ -52,6 +52,7 @@
 // This is an intensity based registration algorithm so ray casting is
 // used to project the 3D volume onto pixels in the target 2D image.
 #include "itkSiddonJacobsRayCastInterpolateImageFunction.h"
+#include "itkJosephRayCastInterpolateImageFunction.h"
 
 // Finally the Powell optimizer is used to avoid requiring gradient information.
 #include "itkPowellOptimizer.h"
@@ -59,14 +60,14 @@
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
 
-#include "itkResampleImageFilter.h"
+#include "itkRayCastProjectionImageFilter.h"
 #include "itkCastImageFilter.h"
-#include "itkRescaleIntensityImageFilter.h"
-#include "itkFlipImageFilter.h"
 
 #include "itkCommand.h"
 #include "itkTimeProbesCollectorBase.h"
 
+#include <fstream>
+
 
 // First we define the command class to allow us to monitor the registration.
 
@@ -128,6 +129,10 @@ exe_usage()
   std::cerr << "       <-iso float float float> Isocenter location in voxel in indices (center of rotation and "
                "projection center)\n";
   std::cerr << "       <-threshold float>       Intensity threshold below which are ignore [default: 0]\n";
+  std::cerr << "       <-projector name>        Ray casting method, siddon (exact) or joseph (fast) "
+               "[default: siddon]\n";
+  std::cerr << "       <-cache file>            Cache file of the data derived from the volume, written if it does "
+               "not exist or was built from another volume, and mapped instead of reading the volume otherwise\n";
   std::cerr << "       <-o file>                Output image filename\n\n";
   std::cerr << "                                by  Jian Wu\n";
   std::cerr << "                                eewujian@hotmail.com\n";
@@ -181,6 +186,9 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
 
   double threshold = 0.0;
 
+  const char * projector = "siddon";
+  const char * fileCache = nullptr;
+
   // Parse command line parameters
 
   if (argc <= 5)
@@ -337,6 +345,26 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
       argv++;
     }
 
+    if ((ok == false) && (strcmp(argv[1], "-projector") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      projector = argv[1];
+      argc--;
+      argv++;
+    }
+
+    if ((ok == false) && (strcmp(argv[1], "-cache") == 0))
+    {
+      argc--;
+      argv++;
+      ok = true;
+      fileCache = argv[1];
+      argc--;
+      argv++;
+    }
+
     if ((ok == false) && (strcmp(argv[1], "-o") == 0))
     {
       argc--;
@@ -443,7 +471,11 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
   // using MetricType = itk::GradientDifferenceTwoImageToOneImageMetric<
   using MetricType = itk::NormalizedCorrelationTwoImageToOneImageMetric<InternalImageType, InternalImageType>;
 
-  using InterpolatorType = itk::SiddonJacobsRayCastInterpolateImageFunction<InternalImageType, double>;
+  // The exact Siddon-Jacobs ray caster and the faster Joseph ray marcher
+  // share the same projection geometry.
+  using InterpolatorType = itk::ProjectionInterpolateImageFunction<InternalImageType, double>;
+  using SiddonInterpolatorType = itk::SiddonJacobsRayCastInterpolateImageFunction<InternalImageType, double>;
+  using JosephInterpolatorType = itk::JosephRayCastInterpolateImageFunction<InternalImageType, double>;
 
 
   using RegistrationType = itk::TwoProjectionImageRegistrationMethod<InternalImageType, InternalImageType>;
@@ -455,10 +487,26 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
   MetricType::Pointer       metric = MetricType::New();
   TransformType::Pointer    transform = TransformType::New();
   OptimizerType::Pointer    optimizer = OptimizerType::New();
-  InterpolatorType::Pointer interpolator1 = InterpolatorType::New();
-  InterpolatorType::Pointer interpolator2 = InterpolatorType::New();
+  InterpolatorType::Pointer interpolator1;
+  InterpolatorType::Pointer interpolator2;
   RegistrationType::Pointer registration = RegistrationType::New();
 
+  if (strcmp(projector, "siddon") == 0)
+  {
+    interpolator1 = SiddonInterpolatorType::New().GetPointer();
+    interpolator2 = SiddonInterpolatorType::New().GetPointer();
+  }
+  else if (strcmp(projector, "joseph") == 0)
+  {
+    interpolator1 = JosephInterpolatorType::New().GetPointer();
+    interpolator2 = JosephInterpolatorType::New().GetPointer();
+  }
+  else
+  {
+    std::cerr << "ERROR: Unknown projector " << projector << std::endl;
+    exe_usage();
+  }
+
   metric->ComputeGradientOff();
   metric->SetSubtractMean(true);
 
@@ -492,25 +540,40 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
 
   imageReader2D1->SetFileName(fileImage2D1);
   imageReader2D2->SetFileName(fileImage2D2);
-  imageReader3D->SetFileName(fileVolume3D);
-  imageReader3D->Update();
-
-  ImageType3D::Pointer image3DIn = imageReader3D->GetOutput();
 
-  // To simply Siddon-Jacob's fast ray-tracing algorithm, we force the origin of the CT image
-  // to be (0,0,0). Because we align the CT isocenter with the central axis, the projection
-  // geometry is fully defined. The origin of the CT image becomes irrelavent.
-  ImageType3D::PointType image3DOrigin;
-  image3DOrigin[0] = 0.0;
-  image3DOrigin[1] = 0.0;
-  image3DOrigin[2] = 0.0;
-  image3DIn->SetOrigin(image3DOrigin);
+  // The input 2D images were loaded as 3D images. They were considered
+  // as a single slice from a 3D volume. By default, images stored on the
+  // disk are treated as if they have RAI orientation. After view point
+  // transformation, the order of 2D image pixel reading is equivalent to
+  // from inferior to superior. This is contradictory to the traditional
+  // 2D x-ray image storage, in which a typical 2D image reader reads and
+  // writes images from superior to inferior. Thus the loaded 2D DICOM
+  // images should be flipped in y-direction. The input 2D images may also
+  // have 16 bits, so we rescale the pixel value to between 0-255.
+  //
+  // Both are done in a single pass by the preprocessors of the
+  // registration method, which also place the images in the projection
+  // geometry (see below).
+  registration->SetFixedImage1(imageReader2D1->GetOutput());
+  registration->SetFixedImage2(imageReader2D2->GetOutput());
+  registration->PreprocessFixedImagesOn();
+
+  using PreprocessorType = RegistrationType::FixedImagePreprocessorType;
+  PreprocessorType::Pointer preprocessor1 = registration->GetModifiableFixedImagePreprocessor1();
+  PreprocessorType::Pointer preprocessor2 = registration->GetModifiableFixedImagePreprocessor2();
+
+  PreprocessorType::FlipAxesArrayType flipArray;
+  flipArray[0] = false;
+  flipArray[1] = true;
+  flipArray[2] = false;
 
-  InternalImageType::Pointer image_tmp1 = imageReader2D1->GetOutput();
-  InternalImageType::Pointer image_tmp2 = imageReader2D2->GetOutput();
+  preprocessor1->SetFlipAxes(flipArray);
+  preprocessor2->SetFlipAxes(flipArray);
 
-  imageReader2D1->Update();
-  imageReader2D2->Update();
+  preprocessor1->SetOutputMinimum(0);
+  preprocessor1->SetOutputMaximum(255);
+  preprocessor2->SetOutputMinimum(0);
+  preprocessor2->SetOutputMaximum(255);
 
   if (customized_2DRES)
   {
@@ -518,67 +581,103 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
     spacing[0] = image1resX;
     spacing[1] = image1resY;
     spacing[2] = 1.0;
-    image_tmp1->SetSpacing(spacing);
+    preprocessor1->SetOutputSpacing(spacing);
+    preprocessor1->ChangeSpacingOn();
 
     spacing[0] = image2resX;
     spacing[1] = image2resY;
-    image_tmp2->SetSpacing(spacing);
+    preprocessor2->SetOutputSpacing(spacing);
+    preprocessor2->ChangeSpacingOn();
   }
-  // The input 2D images were loaded as 3D images. They were considered
-  // as a single slice from a 3D volume. By default, images stored on the
-  // disk are treated as if they have RAI orientation. After view point
-  // transformation, the order of 2D image pixel reading is equivalent to
-  // from inferior to superior. This is contradictory to the traditional
-  // 2D x-ray image storage, in which a typical 2D image reader reads and
-  // writes images from superior to inferior. Thus the loaded 2D DICOM
-  // images should be flipped in y-direction. This was done by using a.
-  // FilpImageFilter.
-  using FlipFilterType = itk::FlipImageFilter<InternalImageType>;
-  FlipFilterType::Pointer flipFilter1 = FlipFilterType::New();
-  FlipFilterType::Pointer flipFilter2 = FlipFilterType::New();
-
-  using FlipAxesArrayType = FlipFilterType::FlipAxesArrayType;
-  FlipAxesArrayType flipArray;
-  flipArray[0] = false;
-  flipArray[1] = true;
-  flipArray[2] = false;
 
-  flipFilter1->SetFlipAxes(flipArray);
-  flipFilter2->SetFlipAxes(flipArray);
 
-  flipFilter1->SetInput(imageReader2D1->GetOutput());
-  flipFilter2->SetInput(imageReader2D2->GetOutput());
+  //  The 3D CT dataset is casted to the internal image type using
+  //  {CastImageFilters}.
+  //
+  //  With a cache file, the data the projectors derive from the volume is
+  //  written once to the file. The following runs map it instead, without
+  //  reading the volume: the moving image then only holds the geometry of
+  //  the volume. Only the header of the volume is read, to check that the
+  //  cache was built from this version of the file with this geometry;
+  //  otherwise the cache is built again.
 
-  // The input 2D images may have 16 bits. We rescale the pixel value to between 0-255.
-  using Input2DRescaleFilterType = itk::RescaleIntensityImageFilter<InternalImageType, InternalImageType>;
+  using CastFilterType3D = itk::CastImageFilter<ImageType3D, InternalImageType>;
+  using VolumeContextType = MetricType::VolumeContextType;
 
-  Input2DRescaleFilterType::Pointer rescaler2D1 = Input2DRescaleFilterType::New();
-  rescaler2D1->SetOutputMinimum(0);
-  rescaler2D1->SetOutputMaximum(255);
-  rescaler2D1->SetInput(flipFilter1->GetOutput());
+  CastFilterType3D::Pointer       caster3D = CastFilterType3D::New();
+  VolumeContextType::Pointer      volumeContext = VolumeContextType::New();
+  InternalImageType::ConstPointer image3D;
 
-  Input2DRescaleFilterType::Pointer rescaler2D2 = Input2DRescaleFilterType::New();
-  rescaler2D2->SetOutputMinimum(0);
-  rescaler2D2->SetOutputMaximum(255);
-  rescaler2D2->SetInput(flipFilter2->GetOutput());
+  // Create a timer to record calculation time.
+  itk::TimeProbesCollectorBase timer;
 
+  // To simply Siddon-Jacob's fast ray-tracing algorithm, we force the origin of the CT image
+  // to be (0,0,0). Because we align the CT isocenter with the central axis, the projection
+  // geometry is fully defined. The origin of the CT image becomes irrelavent.
+  ImageType3D::PointType image3DOrigin;
+  image3DOrigin[0] = 0.0;
+  image3DOrigin[1] = 0.0;
+  image3DOrigin[2] = 0.0;
 
-  //  The 3D CT dataset is casted to the internal image type using
-  //  {CastImageFilters}.
+  timer.Start("Volume");
+  imageReader3D->SetFileName(fileVolume3D);
+  if (fileCache && std::ifstream(fileCache).good())
+  {
+    imageReader3D->UpdateOutputInformation();
+
+    InternalImageType::Pointer geometry3D = InternalImageType::New();
+    geometry3D->CopyInformation(imageReader3D->GetOutput());
+    geometry3D->SetOrigin(image3DOrigin);
+    volumeContext->SetInputImage(geometry3D);
+    volumeContext->SetSourceFileName(fileVolume3D);
+    try
+    {
+      volumeContext->ReadCacheFile(fileCache);
+      if (volumeContext->GetThreshold() == threshold)
+      {
+        image3D = volumeContext->GetInputImage();
+      }
+      else
+      {
+        std::cerr << "The cache file " << fileCache << " was written with the threshold "
+                  << volumeContext->GetThreshold() << "; it is built again" << std::endl;
+      }
+    }
+    catch (itk::ExceptionObject & err)
+    {
+      std::cerr << "The cache file " << fileCache << " cannot be used; it is built again" << std::endl;
+      std::cerr << err.GetDescription() << std::endl;
+    }
+  }
+  if (!image3D)
+  {
+    imageReader3D->Update();
 
-  using CastFilterType3D = itk::CastImageFilter<ImageType3D, InternalImageType>;
+    ImageType3D::Pointer image3DIn = imageReader3D->GetOutput();
+    image3DIn->SetOrigin(image3DOrigin);
+
+    caster3D->SetInput(image3DIn);
+    caster3D->Update();
+    image3D = caster3D->GetOutput();
 
-  CastFilterType3D::Pointer caster3D = CastFilterType3D::New();
-  caster3D->SetInput(image3DIn);
+    if (fileCache)
+    {
+      volumeContext->SetInputImage(image3D);
+      volumeContext->SetSourceFileName(fileVolume3D);
+      volumeContext->SetThreshold(threshold);
+      volumeContext->Update();
+      volumeContext->WriteCacheFile(fileCache);
+    }
+  }
+  timer.Stop("Volume");
 
-  rescaler2D1->Update();
-  rescaler2D2->Update();
-  caster3D->Update();
+  if (fileCache)
+  {
+    metric->SetVolumeContext(volumeContext);
+  }
 
 
-  registration->SetFixedImage1(rescaler2D1->GetOutput());
-  registration->SetFixedImage2(rescaler2D2->GetOutput());
-  registration->SetMovingImage(caster3D->GetOutput());
+  registration->SetMovingImage(image3D);
 
   // Initialise the transform
   // ~~~~~~~~~~~~~~~~~~~~~~~~
@@ -606,13 +705,13 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
   // volume but can be offset from this position using a command
   // line specified translation [cx,cy,cz]
 
-  ImageType3D::PointType       origin3D = image3DIn->GetOrigin();
-  const itk::Vector<double, 3> resolution3D = image3DIn->GetSpacing();
+  ImageType3D::PointType       origin3D = image3D->GetOrigin();
+  const itk::Vector<double, 3> resolution3D = image3D->GetSpacing();
 
   using ImageRegionType3D = ImageType3D::RegionType;
   using SizeType3D = ImageRegionType3D::SizeType;
 
-  ImageRegionType3D region3D = caster3D->GetOutput()->GetBufferedRegion();
+  ImageRegionType3D region3D = image3D->GetLargestPossibleRegion();
   SizeType3D        size3D = region3D.GetSize();
 
   TransformType::InputPointType isocenter;
@@ -654,54 +753,44 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
   // center of the 2D image but may be modified from this using the
   // command line parameters [image1centerX, image1centerY,
   // image2centerX, image2centerY].
-
-  double origin2D1[Dimension];
-  double origin2D2[Dimension];
-
+  //
   // Note: Two 2D images may have different image sizes and pixel dimensions, although
   // scd are the same.
 
-  const itk::Vector<double, 3> resolution2D1 = imageReader2D1->GetOutput()->GetSpacing();
-  const itk::Vector<double, 3> resolution2D2 = imageReader2D2->GetOutput()->GetSpacing();
-
-  using ImageRegionType2D = InternalImageType::RegionType;
-  using SizeType2D = ImageRegionType2D::SizeType;
+  preprocessor1->SetFocalPointToIsocenterDistance(scd);
+  preprocessor2->SetFocalPointToIsocenterDistance(scd);
 
-  ImageRegionType2D region2D1 = rescaler2D1->GetOutput()->GetBufferedRegion();
-  ImageRegionType2D region2D2 = rescaler2D2->GetOutput()->GetBufferedRegion();
-  SizeType2D        size2D1 = region2D1.GetSize();
-  SizeType2D        size2D2 = region2D2.GetSize();
-
-  if (!customized_2DCX)
-  { // Central axis positions are not given by the user. Use the image centers
-    // as the central axis position.
-    image1centerX = ((double)size2D1[0] - 1.) / 2.;
-    image1centerY = ((double)size2D1[1] - 1.) / 2.;
-    image2centerX = ((double)size2D2[0] - 1.) / 2.;
-    image2centerY = ((double)size2D2[1] - 1.) / 2.;
+  if (customized_2DCX)
+  {
+    PreprocessorType::CentralAxisPositionType centralAxis;
+    centralAxis[0] = image1centerX;
+    centralAxis[1] = image1centerY;
+    preprocessor1->SetCentralAxisPosition(centralAxis);
+    preprocessor1->UseImageCenterOff();
+
+    centralAxis[0] = image2centerX;
+    centralAxis[1] = image2centerY;
+    preprocessor2->SetCentralAxisPosition(centralAxis);
+    preprocessor2->UseImageCenterOff();
   }
 
-  // 2D Image 1
-  origin2D1[0] = -resolution2D1[0] * image1centerX;
-  origin2D1[1] = -resolution2D1[1] * image1centerY;
-  origin2D1[2] = -scd;
-
-  imageReader2D1->GetOutput()->SetOrigin(origin2D1);
-  rescaler2D1->GetOutput()->SetOrigin(origin2D1);
-
-  // 2D Image 2
-  origin2D2[0] = -resolution2D2[0] * image2centerX;
-  origin2D2[1] = -resolution2D2[1] * image2centerY;
-  origin2D2[2] = -scd;
-
-  imageReader2D2->GetOutput()->SetOrigin(origin2D2);
-  rescaler2D2->GetOutput()->SetOrigin(origin2D2);
+  timer.Start("Preprocessing");
+  preprocessor1->Update();
+  preprocessor2->Update();
+  timer.Stop("Preprocessing");
 
-  registration->SetFixedImageRegion1(rescaler2D1->GetOutput()->GetBufferedRegion());
-  registration->SetFixedImageRegion2(rescaler2D2->GetOutput()->GetBufferedRegion());
+  const InternalImageType * fixedImage1 = registration->GetPreprocessedFixedImage1();
+  const InternalImageType * fixedImage2 = registration->GetPreprocessedFixedImage2();
 
   if (verbose)
   {
+    const itk::Vector<double, 3>       resolution2D1 = fixedImage1->GetSpacing();
+    const itk::Vector<double, 3>       resolution2D2 = fixedImage2->GetSpacing();
+    const InternalImageType::SizeType  size2D1 = fixedImage1->GetBufferedRegion().GetSize();
+    const InternalImageType::SizeType  size2D2 = fixedImage2->GetBufferedRegion().GetSize();
+    const InternalImageType::PointType origin2D1 = fixedImage1->GetOrigin();
+    const InternalImageType::PointType origin2D2 = fixedImage2->GetOrigin();
+
     std::cout << "2D image 1 size: " << size2D1[0] << ", " << size2D1[1] << ", " << size2D1[2] << std::endl
               << "   resolution: " << resolution2D1[0] << ", " << resolution2D1[1] << ", " << resolution2D1[2]
               << std::endl
@@ -792,9 +881,6 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
   // Start the registration
   // ~~~~~~~~~~~~~~~~~~~~~~
 
-  // Create a timer to record calculation time.
-  itk::TimeProbesCollectorBase timer;
-
   if (verbose)
   {
     std::cout << "Starting the registration now..." << std::endl;
@@ -847,81 +933,72 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
   finalTransform->SetParameters(finalParameters);
   finalTransform->SetCenter(isocenter);
 
-  using ResampleFilterType = itk::ResampleImageFilter<InternalImageType, InternalImageType>;
+  // The RayCastProjectionImageFilter is the driving force for the projection image generation.
+  // As explained before, the computed projection is upsided-down, so the filter flips the
+  // images in y-direction and rescales their intensity to 0-255 for output as it casts the rays.
+  using ProjectorType = itk::RayCastProjectionImageFilter<InternalImageType, OutputImageType>;
 
-  // The ResampleImageFilter is the driving force for the projection image generation.
-  ResampleFilterType::Pointer resampleFilter1 = ResampleFilterType::New();
+  ProjectorType::Pointer projector1 = ProjectorType::New();
 
-  resampleFilter1->SetInput(caster3D->GetOutput()); // Link the 3D volume.
-  resampleFilter1->SetDefaultPixelValue(0);
+  projector1->SetInput(image3D); // Link the 3D volume.
 
-  // The parameters of interpolator1, such as ProjectionAngle and FocalPointToIsocenterDistance
-  // have been set before registration. Here we only need to replace the initial
-  // transform with the final transform.
-  interpolator1->SetTransform(finalTransform);
-  interpolator1->Initialize();
-  resampleFilter1->SetInterpolator(interpolator1);
+  // The interpolators were set up for the registration. Here we only need
+  // to replace the initial transform with the final transform.
+  projector1->SetInterpolator(interpolator1);
+  projector1->SetTransform(finalTransform);
+  projector1->SetProjectionAngle(dtr * projAngle1);
+  projector1->SetFocalPointToIsocenterDistance(scd);
+  projector1->SetThreshold(threshold);
 
   // The output 2D projection image has the same image size, origin, and the pixel spacing as
   // those of the input 2D image.
-  resampleFilter1->SetSize(rescaler2D1->GetOutput()->GetLargestPossibleRegion().GetSize());
-  resampleFilter1->SetOutputOrigin(rescaler2D1->GetOutput()->GetOrigin());
-  resampleFilter1->SetOutputSpacing(rescaler2D1->GetOutput()->GetSpacing());
+  projector1->SetSize(fixedImage1->GetLargestPossibleRegion().GetSize());
+  projector1->SetOutputOrigin(fixedImage1->GetOrigin());
+  projector1->SetOutputSpacing(fixedImage1->GetSpacing());
+
+  projector1->SetFlipAxes(flipArray);
+  projector1->RescaleIntensityOn();
+  projector1->SetOutputMinimum(0);
+  projector1->SetOutputMaximum(255);
 
   // Do the same thing for the output image 2.
-  ResampleFilterType::Pointer resampleFilter2 = ResampleFilterType::New();
-  resampleFilter2->SetInput(caster3D->GetOutput());
-  resampleFilter2->SetDefaultPixelValue(0);
-
-  // The parameters of interpolator2, such as ProjectionAngle and FocalPointToIsocenterDistance
-  // have been set before registration. Here we only need to replace the initial
-  // transform with the final transform.
-  interpolator2->SetTransform(finalTransform);
-  interpolator2->Initialize();
-  resampleFilter2->SetInterpolator(interpolator2);
+  ProjectorType::Pointer projector2 = ProjectorType::New();
+  projector2->SetInput(image3D);
 
-  resampleFilter2->SetSize(rescaler2D2->GetOutput()->GetLargestPossibleRegion().GetSize());
-  resampleFilter2->SetOutputOrigin(rescaler2D2->GetOutput()->GetOrigin());
-  resampleFilter2->SetOutputSpacing(rescaler2D2->GetOutput()->GetSpacing());
+  projector2->SetInterpolator(interpolator2);
+  projector2->SetTransform(finalTransform);
+  projector2->SetProjectionAngle(dtr * projAngle2);
+  projector2->SetFocalPointToIsocenterDistance(scd);
+  projector2->SetThreshold(threshold);
+
+  projector2->SetSize(fixedImage2->GetLargestPossibleRegion().GetSize());
+  projector2->SetOutputOrigin(fixedImage2->GetOrigin());
+  projector2->SetOutputSpacing(fixedImage2->GetSpacing());
+
+  projector2->SetFlipAxes(flipArray);
+  projector2->RescaleIntensityOn();
+  projector2->SetOutputMinimum(0);
+  projector2->SetOutputMaximum(255);
 
   /////////////////////////////---DEGUG--START----////////////////////////////////////
   if (debug)
   {
-    InternalImageType::PointType outputorigin2D1 = rescaler2D1->GetOutput()->GetOrigin();
+    InternalImageType::PointType outputorigin2D1 = fixedImage1->GetOrigin();
     std::cout << "Output image 1 origin: " << outputorigin2D1[0] << ", " << outputorigin2D1[1] << ", "
               << outputorigin2D1[2] << std::endl;
-    InternalImageType::PointType outputorigin2D2 = rescaler2D2->GetOutput()->GetOrigin();
+    InternalImageType::PointType outputorigin2D2 = fixedImage2->GetOrigin();
     std::cout << "Output image 2 origin: " << outputorigin2D2[0] << ", " << outputorigin2D2[1] << ", "
               << outputorigin2D2[2] << std::endl;
   }
   /////////////////////////////---DEGUG--END----//////////////////////////////////////
 
 
-  // As explained before, the computed projection is upsided-down.
-  // Here we use a FilpImageFilter to flip the images in y-direction.
-  flipFilter1->SetInput(resampleFilter1->GetOutput());
-  flipFilter2->SetInput(resampleFilter2->GetOutput());
-
-  // Rescale the intensity of the projection images to 0-255 for output.
-  using RescaleFilterType = itk::RescaleIntensityImageFilter<InternalImageType, OutputImageType>;
-
-  RescaleFilterType::Pointer rescaler1 = RescaleFilterType::New();
-  rescaler1->SetOutputMinimum(0);
-  rescaler1->SetOutputMaximum(255);
-  rescaler1->SetInput(flipFilter1->GetOutput());
-
-  RescaleFilterType::Pointer rescaler2 = RescaleFilterType::New();
-  rescaler2->SetOutputMinimum(0);
-  rescaler2->SetOutputMaximum(255);
-  rescaler2->SetInput(flipFilter2->GetOutput());
-
-
   using WriterType = itk::ImageFileWriter<OutputImageType>;
   WriterType::Pointer writer1 = WriterType::New();
   WriterType::Pointer writer2 = WriterType::New();
 
   writer1->SetFileName(fileOutput1);
-  writer1->SetInput(rescaler1->GetOutput());
+  writer1->SetInput(projector1->GetOutput());
 
   try
   {
@@ -935,7 +1012,7 @@ TwoProjection2D3DRegistration(int argc, char * argv[])
   }
 
   writer2->SetFileName(fileOutput2);
-  writer2->SetInput(rescaler2->GetOutput());
+  writer2->SetInput(projector2->GetOutput());
 
   try
   {
@@ -0,0 +1,26 @@
+// Compute() runs without the global interpreter lock, so that other Python
+// threads run while the DRRs are computed. Its exceptions are caught with
+// the lock released and raised once it is taken back.
+%exception Compute
+{
+  std::string computeError;
+  Py_BEGIN_ALLOW_THREADS
+  try
+  {
+    $action
+  }
+  catch (const std::exception & e)
+  {
+    computeError = e.what();
+    if (computeError.empty())
+    {
+      computeError = "Compute failed";
+    }
+  }
+  Py_END_ALLOW_THREADS
+  if (!computeError.empty())
+  {
+    PyErr_SetString(PyExc_RuntimeError, computeError.c_str());
+    SWIG_fail;
+  }
+}